@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <memory>
+
+namespace gl {
+	class Texture;
+	class ComputeShader;
+
+	// Adapts the exposure of an HDR image to its average luminance without any readback to the CPU.
+	// A compute pass builds a histogram of the log luminance, a second one averages it and moves the adapted
+	// luminance towards the average over time. The result stays in a shader storage buffer, which shaders read as
+	//     layout(std430, binding = ...) readonly buffer Exposure { float averageLuminance; float exposure; };
+	class AutoExposure {
+	public:
+		AutoExposure();
+		~AutoExposure();
+
+		AutoExposure(const AutoExposure&) = delete;
+		AutoExposure& operator=(const AutoExposure&) = delete;
+
+		// Measures the image and adapts the exposure. dt is the time since the last update in seconds.
+		// Only the lower left cols x rows pixels are measured if given, e.g. the rendered part of a pooled render target
+		void update(gl::Texture& hdr, float dt, int cols = -1, int rows = -1);
+		// Binds the exposure buffer to an indexed shader storage binding
+		void bind(int binding) const;
+		// The next update adopts the luminance of its image right away instead of adapting to it
+		void reset();
+
+		GLuint buffer() const;
+
+		// Luminance range covered by the histogram, in stops (log2)
+		float minLogLuminance;
+		float maxLogLuminance;
+		// Average luminance the image is mapped to (middle gray)
+		float keyValue;
+		// How fast the exposure follows the image. Higher is faster
+		float adaptationSpeed;
+
+	protected:
+		std::unique_ptr<gl::ComputeShader> mHistogramShader;
+		std::unique_ptr<gl::ComputeShader> mExposureShader;
+		GLuint mHistogram;
+		GLuint mExposure;
+	};
+
+}
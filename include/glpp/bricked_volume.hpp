@@ -0,0 +1,103 @@
+#pragma once
+
+#include "glpp/camera.hpp"
+#include "glpp/shadermanager.hpp"
+#include "glpp/texture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gl {
+
+	class MappedFile;
+
+	// Single channel volume that does not have to fit into video memory (or host memory).
+	// The voxels are split into bricks of BrickSize^3 voxels, which overlap by one voxel so they can be filtered
+	// independently, and every level of detail halves the resolution of the previous one until a single brick remains.
+	// All bricks are stored in a cache file, which is memory mapped. Bricks are read on the worker threads of the
+	// texture loader as they are requested by update() and copied into a pool texture of fixed size. A page table
+	// texture points every full resolution brick to the finest resident brick covering it, so coarser levels are
+	// drawn while bricks are loading. When the pool is full, the least recently used bricks are evicted.
+	// Shaders sample the volume with the code in shaders/bricked_volume.glsl.h.
+	class BrickedVolume {
+	public:
+		constexpr static int BrickSize = 32;
+		// Voxels per side of a brick without the overlap
+		constexpr static int BrickPayload = BrickSize - 2;
+
+		// Opens a cache written by BuildBrickCache. The pool holds as many bricks as fit into poolBytes
+		BrickedVolume(const std::string& brickCache, size_t poolBytes = 512 * 1024 * 1024);
+		~BrickedVolume();
+
+		BrickedVolume(const BrickedVolume&) = delete;
+		BrickedVolume& operator=(const BrickedVolume&) = delete;
+
+		// Bricks a raw volume (cols * rows * depth voxels of a single channel without header, x varies fastest) and
+		// writes all levels of detail into cacheFile, unless the cache already exists. An empty cacheFile picks a file
+		// in the temporary directory. UByte, UShort and Float voxels are supported.
+		// This is thread safe, so it can run on a worker thread before constructing the volume. Returns the cache file
+		static std::string BuildBrickCache(const std::string& rawFile, int cols, int rows, int depth, PixelType type, std::string cacheFile = "");
+
+		// Requests the bricks needed to draw the volume this frame. Bricks outside of the view frustum are skipped and
+		// bricks are refined until a voxel covers about a pixel. textureToWorld maps [0, 1]^3 to world space
+		void update(const std::shared_ptr<gl::Camera> camera, const glm::mat4& textureToWorld);
+		// Binds the pool and the page table and sets the uniforms of BRICKED_VOLUME_GLSL. The shader must be in use
+		void bind(gl::Shader& shader, int poolSlot, int tableSlot);
+		void unbind(int poolSlot, int tableSlot);
+
+		// Voxels of the full resolution level
+		glm::ivec3 size() const;
+		PixelType pixelType() const;
+		int numLevels() const;
+		glm::ivec3 bricks(int level = 0) const;
+		// Minimum and maximum of every full resolution brick including its overlap, x varies fastest.
+		// Values are normalized like they are sampled, i.e. integer types are divided by their maximum
+		const std::vector<glm::vec2>& brickRanges() const;
+
+		size_t capacity() const;
+		size_t residentBricks() const;
+
+		// Larger values select coarser levels, 1 halves the resolution
+		float lodBias;
+
+	protected:
+		struct BrickTable;
+		struct Level {
+			glm::ivec3 size;
+			glm::ivec3 bricks;
+			int firstBrick;
+		};
+
+		void request(int level, glm::ivec3 brick);
+		void onBrickLoaded(int brick, std::vector<unsigned char> voxels);
+		// Moves staged bricks that were requested in the current frame into the pool and drops the others
+		void placeStagedBricks();
+		int allocateSlot();
+		void uploadBrick(int slot, const void* voxels);
+		// Points the page table entries covered by the brick to the finest resident brick
+		void updatePages(int level, glm::ivec3 brick);
+		int brickIndex(int level, glm::ivec3 brick) const;
+		std::pair<int, glm::ivec3> brickPosition(int index) const;
+		size_t brickBytes() const;
+
+		std::shared_ptr<MappedFile> mCache;
+		size_t mDataOffset;
+		PixelType mPixelType;
+		std::vector<Level> mLevels;
+		std::vector<glm::vec2> mRanges;
+
+		std::unique_ptr<gl::Texture> mPool;
+		glm::ivec3 mPoolSlots;
+		std::unique_ptr<gl::Texture> mPageTable;
+		std::vector<unsigned char> mPages;
+		bool mPagesDirty;
+
+		std::shared_ptr<BrickTable> mBricks;
+		int mFrame;
+	};
+
+}
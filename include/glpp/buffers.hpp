@@ -259,7 +259,7 @@ namespace gl {
 			if (0 == mId) {
 				glGenVertexArrays(1, &mId);
 			}
-			glBindVertexArray(mId);
+			gl::StateCache::Current().bindVertexArray(mId);
 			buffer.bind();
 			glEnableVertexAttribArray(index);
 			if (type == GL_INT || type == GL_UNSIGNED_INT) {
@@ -271,7 +271,7 @@ namespace gl {
 			glEnableVertexAttribArray(index);
 			// Clean up
 			buffer.unbind();
-			glBindVertexArray(0);
+			gl::StateCache::Current().bindVertexArray(0);
 
 			buffers.push_back(&buffer);
 		}
@@ -289,7 +289,7 @@ namespace gl {
 			if (0 == mId) {
 				glGenVertexArrays(1, &mId);
 			}
-			glBindVertexArray(mId);
+			gl::StateCache::Current().bindVertexArray(mId);
 			buffer->bind();
 			glEnableVertexAttribArray(index);
 			if (type == GL_INT || type == GL_UNSIGNED_INT) {
@@ -301,7 +301,7 @@ namespace gl {
 			glEnableVertexAttribArray(index);
 			// Clean up
 			buffer->unbind();
-			glBindVertexArray(0);
+			gl::StateCache::Current().bindVertexArray(0);
 
 			sharedBuffers.push_back(buffer);
 		}
@@ -319,7 +319,7 @@ namespace gl {
 			if (0 == mId) {
 				glGenVertexArrays(1, &mId);
 			}
-			glBindVertexArray(mId);
+			gl::StateCache::Current().bindVertexArray(mId);
 			buffer->bind();
 			glEnableVertexAttribArray(index);
 			size = size == 0 ? impl::to_size_v<std::tuple_element_t<element, T>> : size;
@@ -339,7 +339,7 @@ namespace gl {
 			glEnableVertexAttribArray(index);
 			// Clean up
 			buffer->unbind();
-			glBindVertexArray(0);
+			gl::StateCache::Current().bindVertexArray(0);
 
 			sharedBuffers.push_back(buffer);
 		}
@@ -354,11 +354,11 @@ namespace gl {
 			if (0 == mId) {
 				glGenVertexArrays(1, &mId);
 			}
-			glBindVertexArray(mId);
+			gl::StateCache::Current().bindVertexArray(mId);
 			buffer->bind();
 			impl::AddVertexAttribute<0, T>(normalize, 0);
 			buffer->unbind();
-			glBindVertexArray(0);
+			gl::StateCache::Current().bindVertexArray(0);
 
 			sharedBuffers.push_back(buffer);
 		}
@@ -368,7 +368,7 @@ namespace gl {
 			if (0 == mId) {
 				glGenVertexArrays(1, &mId);
 			}
-			glBindVertexArray(mId);
+			gl::StateCache::Current().bindVertexArray(mId);
 			buffer->bind();
 
 			for (int i = 0; i < (int)buffer->vertexAttributes.size(); ++i) {
@@ -378,7 +378,7 @@ namespace gl {
 			}
 
 			buffer->unbind();
-			glBindVertexArray(0);
+			gl::StateCache::Current().bindVertexArray(0);
 
 			sharedBuffers.push_back(buffer);
 		}
@@ -389,9 +389,9 @@ namespace gl {
 			if (0 == mId) {
 				glGenVertexArrays(1, &mId);
 			}
-			glBindVertexArray(mId);
+			gl::StateCache::Current().bindVertexArray(mId);
 			buffer->bind();
-			glBindVertexArray(0);
+			gl::StateCache::Current().bindVertexArray(0);
 			buffer->unbind();
 			indices = buffer;
 		}
@@ -403,10 +403,10 @@ namespace gl {
 			if (indices != nullptr) indices->update();
 			for (auto buffer : sharedBuffers)
 				buffer->update();
-			glBindVertexArray(mId);
+			gl::StateCache::Current().bindVertexArray(mId);
 		}
 		inline void unbind() {
-			glBindVertexArray(0);
+			gl::StateCache::Current().bindVertexArray(0);
 		}
 
 		void draw(int n = -1) {
@@ -428,7 +428,7 @@ namespace gl {
 			if (s_dummyId == 0) {
 				glGenVertexArrays(1, &s_dummyId);
 			}
-			glBindVertexArray(s_dummyId);
+			gl::StateCache::Current().bindVertexArray(s_dummyId);
 		}
 	private:
 		GLuint mId;
@@ -7,16 +7,27 @@
 struct GLFWwindow;
 
 namespace gl {
+	class StateCache;
+
+	// Returns true if the current OpenGL context exposes the given extension (e.g. "GL_ARB_buffer_storage")
+	bool hasExtension(const std::string& name);
+	// Returns true if the current OpenGL context has at least the given version
+	bool hasVersion(int major, int minor);
 
 	class Context {
 	public:
 		Context(std::shared_ptr<gl::Context> shared = nullptr);
+		virtual ~Context();
 		virtual void makeCurrent();
 
+		// Shadow copy of the state of this context, see gl::StateCache::Current()
+		gl::StateCache& stateCache();
+
 		static gl::Context* GetCurrentContext();
 
 	protected:
 		std::shared_ptr<gl::Context> mSharedContext;
+		std::unique_ptr<gl::StateCache> mStateCache;
 
 	private:
 		static gl::Context* sCurrentContext;
@@ -47,6 +58,7 @@ namespace gl {
 		bool shouldClose() const;
 		bool isMinified() const;
 		bool isMaximized() const;
+		bool isFocused() const;
 
 		// New getters
 		std::pair<int, int> getWindowSize() const;
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "glpp/buffers.hpp"
+#include "glpp/render_queue.hpp"
 #include "glpp/shadermanager.hpp"
 
 namespace gl {
@@ -16,6 +17,9 @@ namespace gl {
 		template<typename... Args>
 		void execute(gl::Shader& shader, const Args&... uniforms);
 
+		// Uploads pending changes and returns the draw call of the batch for a gl::RenderQueue
+		DrawPacket packet(gl::Shader& shader);
+
 		template<typename T, int d>
 		std::shared_ptr<VertexBufferObject<T, d>> addVertexAttribute(GLuint index);
 
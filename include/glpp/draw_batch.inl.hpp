@@ -51,7 +51,7 @@ namespace gl {
 	{
 		assert(VAO != 0);
 
-		glBindVertexArray(VAO);
+		gl::StateCache::Current().bindVertexArray(VAO);
 		vbo->bind();
 		mBufferIds.push_back(vbo->id());
 
@@ -64,7 +64,7 @@ namespace gl {
 		}
 
 		vbo->unbind();
-		glBindVertexArray(0);
+		gl::StateCache::Current().bindVertexArray(0);
 		mVertexAttributes.push_back(vbo);
 	}
 
@@ -73,7 +73,7 @@ namespace gl {
 	{
 		assert(VAO != 0);
 
-		glBindVertexArray(VAO);
+		gl::StateCache::Current().bindVertexArray(VAO);
 		vbo->bind();
 		mBufferIds.push_back(vbo->id());
 
@@ -86,7 +86,7 @@ namespace gl {
 		glEnableVertexAttribArray(index);
 
 		vbo->unbind();
-		glBindVertexArray(0);
+		gl::StateCache::Current().bindVertexArray(0);
 		mVertexAttributes.push_back(vbo);
 	}
 
@@ -100,12 +100,12 @@ namespace gl {
 		buffer->usage() = GL_DYNAMIC_DRAW;
 		buffer->update();
 
-		glBindVertexArray(VAO);
+		gl::StateCache::Current().bindVertexArray(VAO);
 		buffer->bind();
 		impl::AddVertexAttribute<0, Buffer::value_type>(false, static_cast<int>(initialIndex));
 
 		buffer->unbind();
-		glBindVertexArray(0);
+		gl::StateCache::Current().bindVertexArray(0);
 		mVertexAttributes.push_back(buffer);
 	}
 
@@ -135,14 +135,16 @@ namespace gl {
 			shader.setUniforms(uniforms...);
 		}
 
-		glBindVertexArray(VAO);
+		gl::StateCache& state = gl::StateCache::Current();
+		state.bindVertexArray(VAO);
 		if (primitiveType == GL_PATCHES) {
 			glPatchParameteri(GL_PATCH_VERTICES, patchsize);
 		}
 		glDrawElements(primitiveType, indexBuffer->size(), indexType, reinterpret_cast<void*>(indexOffset * sizeof(GLuint)));
 
-		glBindVertexArray(0);
-		glUseProgram(0);
+		// The program stays in use, but the vertex array is unbound: Index buffers of other batches are bound to
+		// GL_ELEMENT_ARRAY_BUFFER for their uploads, which would replace the one of a bound vertex array
+		state.bindVertexArray(0);
 	}
 }
 
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <array>
+
+namespace gl {
+
+	// Picks the render scale of a viewport so its GPU time stays within a budget.
+	// The commands between begin and end are measured with GL_TIME_ELAPSED queries. Their results are read a few frames
+	// later without waiting for the GPU. Every measurement is converted to the time of a full resolution frame (assuming
+	// the time grows with the number of pixels) and averaged, the scale is the one whose estimated time fits the budget.
+	class DynamicResolution {
+	public:
+		DynamicResolution();
+		~DynamicResolution();
+
+		DynamicResolution(const DynamicResolution&) = delete;
+		DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+		// Measures the commands until end with the current scale. Frames are not measured while every query is in flight
+		void begin();
+		void end();
+		// Reads the finished measurements and updates scale()
+		void update();
+		// Forgets the measurements, e.g. after the scene changed completely
+		void reset();
+
+		// Scale of the width and height, between minScale and maxScale in steps of scaleStep
+		float scale() const;
+		// Latest measured GPU time in milliseconds and the estimated time of a full resolution frame
+		float gpuTime() const;
+		float fullResolutionTime() const;
+
+		bool enabled;
+		// Budget of the measured commands in milliseconds
+		float targetFrameTime;
+		float minScale;
+		float maxScale;
+		// The scale only changes in steps, so the render targets are not resized every frame
+		float scaleStep;
+		// Strength of the sharpening of upscaled images, from zero to one
+		float sharpness;
+
+	protected:
+		struct Query {
+			GLuint id = 0;
+			float scale = 1.0f;
+			bool pending = false;
+		};
+
+		std::array<Query, 4> mQueries;
+		int mNext;
+		int mActive;
+		float mScale;
+		float mGpuTime;
+		float mFullResolutionTime;
+	};
+}
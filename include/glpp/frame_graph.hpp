@@ -0,0 +1,143 @@
+#pragma once
+
+#include "glpp/render_target_pool.hpp"
+#include "glpp/texture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gl {
+
+	// Handle of a virtual texture of a gl::FrameGraph. Handles are only valid until the graph is cleared
+	struct FrameGraphResource {
+		int index = -1;
+
+		bool valid() const { return index >= 0; }
+	};
+
+	// Description of a transient texture, the graph decides which physical texture backs it
+	struct FrameGraphTexture {
+		int width = 0;
+		int height = 0;
+		PixelFormat format = PixelFormat::RGBA;
+		PixelType type = PixelType::UByte;
+	};
+
+	// Describes the passes of a frame and the textures they read and write, then runs them.
+	// Passes run in the order they were added. Passes whose results are never read are culled, unless they write an
+	// imported texture or declared a side effect. Transient textures only exist from the first to the last pass that
+	// uses them: They are taken from a gl::RenderTargetPool right before their first use and returned right after
+	// their last, so transients whose lifetimes do not overlap share the same physical texture if their pool bucket
+	// and format match.
+	class FrameGraph {
+	public:
+		// Declares the accesses of a pass, passed to its setup function
+		class Builder {
+		public:
+			// Creates a transient texture that is written by this pass. Its content is undefined before
+			FrameGraphResource create(const std::string& name, const FrameGraphTexture& desc);
+			FrameGraphResource read(FrameGraphResource resource);
+			FrameGraphResource write(FrameGraphResource resource);
+			// The pass has effects outside of the graph (e.g. it fills a buffer) and is never culled
+			void sideEffect();
+
+		private:
+			friend class FrameGraph;
+			Builder(FrameGraph& graph, int pass);
+
+			FrameGraph& mGraph;
+			int mPass;
+		};
+
+		// Access to the physical textures while a pass executes. Do not keep the textures beyond the pass, they are
+		// reused for other transients
+		class Resources {
+		public:
+			std::shared_ptr<gl::Texture> texture(FrameGraphResource resource) const;
+			const FrameGraphTexture& description(FrameGraphResource resource) const;
+			// Texture coordinates of the upper right corner of the used part, pooled textures can be larger
+			glm::vec2 textureScale(FrameGraphResource resource) const;
+			// Renders into the given textures with a framebuffer of the graph and sets the viewport to their size
+			void bindFramebuffer(std::initializer_list<FrameGraphResource> colors, FrameGraphResource depth = FrameGraphResource());
+
+		private:
+			friend class FrameGraph;
+			Resources(FrameGraph& graph);
+
+			FrameGraph& mGraph;
+		};
+
+		// Resource usage of the last execute
+		struct Report {
+			int passes = 0;
+			int culledPasses = 0;
+			// Transients of passes that were executed and the physical textures they were placed in
+			int transients = 0;
+			int physicalTextures = 0;
+			// Imported textures accessed by passes that were executed, they are not part of the aliasing
+			int imported = 0;
+			// Video memory of the transients with and without aliasing in bytes
+			size_t memory = 0;
+			size_t memoryWithoutAliasing = 0;
+			std::vector<std::string> culled;
+		};
+
+		FrameGraph(gl::RenderTargetPool* pool = &gl::RenderTargetPool::Default());
+		~FrameGraph();
+
+		FrameGraph(const FrameGraph&) = delete;
+		FrameGraph& operator=(const FrameGraph&) = delete;
+
+		// Adds a pass, setup is called right away and declares what the pass accesses
+		void addPass(const std::string& name, std::function<void(Builder&)> setup, std::function<void(Resources&)> execute);
+		// Makes a texture that lives outside of the graph available to its passes. Imported textures are never aliased
+		// and their writers are never culled
+		FrameGraphResource import(const std::string& name, std::shared_ptr<gl::Texture> texture, glm::vec2 textureScale = glm::vec2(1));
+
+		// Culls unused passes and computes the lifetimes of the transients. execute calls this if needed
+		void compile();
+		void execute();
+		// Drops the passes and resources, e.g. to describe the next frame. The report is kept
+		void clear();
+
+		const Report& report() const;
+
+	protected:
+		struct ResourceNode {
+			std::string name;
+			FrameGraphTexture desc;
+			std::shared_ptr<gl::Texture> texture;
+			glm::vec2 textureScale = glm::vec2(1);
+			bool imported = false;
+			std::vector<int> writers;
+			int refCount = 0;
+		};
+
+		struct PassNode {
+			std::string name;
+			std::function<void(Resources&)> execute;
+			std::vector<int> reads;
+			std::vector<int> writes;
+			bool sideEffect = false;
+			bool culled = false;
+			int refCount = 0;
+			// Transients that are acquired before and released after the pass
+			std::vector<int> acquire;
+			std::vector<int> release;
+		};
+
+		std::vector<PassNode> mPasses;
+		std::vector<ResourceNode> mResources;
+		bool mCompiled;
+		Report mReport;
+
+		gl::RenderTargetPool* mPool;
+		GLuint mFramebuffer;
+		int mAttachedColors;
+	};
+}
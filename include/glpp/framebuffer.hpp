@@ -3,18 +3,25 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "glpp/render_target_pool.hpp"
+#include "glpp/texture.hpp"
+
+#include <functional>
+#include <future>
 #include <vector>
 #include <memory>
 #include <unordered_map>
 
 
 namespace gl {
-	class Texture;
-
 	class Framebuffer {
 
 	public:
-		Framebuffer(int width = 0, int height = 0);
+		/// <summary>Creates a framebuffer, its render textures are created by the first bind</summary>
+		/// <param name="pool">If given, render textures created by the framebuffer are taken from the pool and are
+		/// larger than the framebuffer, so resizing rarely reallocates them. Only their lower left width x height pixels
+		/// are rendered, see textureScale()</param>
+		Framebuffer(int width = 0, int height = 0, gl::RenderTargetPool* pool = nullptr);
 		~Framebuffer();
 
 		/// <summary>Set a render texture for the given attachment slot</summary>
@@ -23,11 +30,22 @@ namespace gl {
 		/// <returns>A shared pointer to the buffer texture</returns>
 		std::shared_ptr<gl::Texture> setRenderTexture(int slot, std::shared_ptr<gl::Texture> texture = nullptr);
 
+		/// <summary>Creates a render texture with the given format for the attachment slot</summary>
+		/// <param name="slot">Color attachment slot to bind the texture to.</param>
+		/// <param name="format">Pixel format of the new texture</param>
+		/// <param name="type">Pixel type of the new texture, e.g. PixelType::Half for an RGBA16F target</param>
+		/// <returns>A shared pointer to the buffer texture</returns>
+		std::shared_ptr<gl::Texture> setRenderTexture(int slot, gl::PixelFormat format, gl::PixelType type = gl::PixelType::UByte);
+
 		/// <summary>Create a new color attachment slot and binds a render texture to it</summary>
 		/// <param name="texture">Texture to use as a buffer.  If this is a nullptr a new texture will be created</param>
 		/// <returns>A shared pointer to the buffer texture.</returns>
 		std::shared_ptr<gl::Texture> appendRenderTexture(std::shared_ptr<gl::Texture> texture = nullptr);
 
+		/// <summary>Create a new color attachment slot and binds a new render texture with the given format to it</summary>
+		/// <returns>A shared pointer to the buffer texture.</returns>
+		std::shared_ptr<gl::Texture> appendRenderTexture(gl::PixelFormat format, gl::PixelType type = gl::PixelType::UByte);
+
 		/// <summary>Create a new color attachment slot and binds a renderbuffer to it.</summary>
 		void appendColorBuffer();
 
@@ -37,6 +55,9 @@ namespace gl {
 
 		void clearColorAttachment(int slot, int value);
 
+		/// <summary>Clears an integer attachment, i.e. a render texture of PixelType::UInt</summary>
+		void clearColorAttachment(int slot, glm::uvec4 value);
+
 		void clearDepthBuffer();
 		void clearStencilBuffer();
 		void clearDepthAndStencilBuffer();
@@ -49,18 +70,56 @@ namespace gl {
 
 		void update();
 
+		/// <summary>Renders into multisampled renderbuffers with the given number of samples per pixel, resolve() copies
+		/// them into the render textures. One or zero disables multisampling</summary>
+		/// <remarks>Integer attachments, like the ids used for picking, stay single-sample: They are not part of the
+		/// multisampled framebuffer and can only be rendered after resolve()</remarks>
+		void setSamples(int samples);
+		int samples() const { return mSamples; }
+
+		/// <summary>Resolves the multisampled attachments into the render textures and binds the single-sample
+		/// framebuffer. Without multisampling this only binds the framebuffer</summary>
+		/// <param name="depth">Also resolves depth and stencil, e.g. to depth test overlays drawn afterwards</param>
+		void resolve(bool depth = true);
+
 		/// <summary>Resizes the Framebuffer (meaning all its render buffers and textures)</summary>
+		/// <remarks>With a gl::RenderTargetPool the textures are exchanged right away if they are too small or more
+		/// than twice as large as needed, otherwise they are kept</remarks>
 		void resize(int width, int height);
 
 		void blitToDefaultBuffer();
 
+		/// <summary>Copies the depth of this framebuffer into the depth texture of target and scales it to the size of
+		/// target, e.g. to depth test overlays of a higher resolution. Multisampled framebuffers have to be resolved first</summary>
+		/// <remarks>Both depth textures need the same format</remarks>
+		void blitDepth(gl::Framebuffer& target);
+
+		/// <summary>Reads a pixel as RGBA8, rows are counted from the top. This waits for the GPU to finish rendering</summary>
+		/// <remarks>Integer attachments (PixelType::UInt) are read as they are, e.g. (id, 0, 0, 1) for an R32UI id buffer</remarks>
 		glm::uvec4 readColorPixel(int col, int row, int slot);
 
+		/// <summary>Reads a pixel as RGBA8 without waiting for the GPU</summary>
+		/// <remarks>The pixel is copied into a pixel pack buffer of gl::DownloadQueue::Default() and the future becomes ready
+		/// once the GPU finished, usually a frame or two later</remarks>
+		std::future<glm::uvec4> readColorPixelAsync(int col, int row, int slot, std::function<void(glm::uvec4)> onFinished = nullptr);
+
+		/// <summary>Picking without pipeline stalls: Starts reading the pixel and returns the value of the latest read
+		/// that finished, which lags a frame or two behind. Call this once per frame</summary>
+		/// <remarks>A new read only starts if the pixel changed or the framebuffer was bound since the last one. The reads
+		/// are background reads of gl::DownloadQueue</remarks>
+		/// <returns>The latest pixel value or zero if no read finished yet or the pixel lies outside</returns>
+		glm::uvec4 latestColorPixel(int col, int row, int slot);
+
 		std::shared_ptr<gl::Texture> getRenderTexture(int slot);
 		std::shared_ptr<gl::Texture> getDepthTexture();
 
 		void readColorAttachment(int slot, int x, int y, int width, int height, void* buffer);
 
+		/// <summary>Reads a region of a color attachment in its own format without waiting for the GPU</summary>
+		/// <remarks>dst must stay valid until the future became ready or onFinished was called</remarks>
+		std::future<void> readColorAttachmentAsync(int slot, int x, int y, int width, int height, void* dst, std::function<void()> onFinished = nullptr);
+		std::future<void> readColorAttachmentAsync(int slot, void* dst, std::function<void()> onFinished = nullptr);
+
 		void bind();
 		void unbind();
 
@@ -73,6 +132,10 @@ namespace gl {
 			return mHeight;
 		}
 
+		/// <summary>Texture coordinates of the upper right corner of the rendered part of the render textures</summary>
+		/// <returns>One unless the render textures are taken from a gl::RenderTargetPool</returns>
+		glm::vec2 textureScale() const;
+
 	private:
 		struct FramebufferAttachment {
 			FramebufferAttachment();
@@ -90,15 +153,44 @@ namespace gl {
 			std::shared_ptr<gl::Texture> targetTexture;
 			GLuint targetBuffer;
 			GLenum attachment;
+			// The texture was created from the pool of the framebuffer and is exchanged on resize
+			bool pooled;
+
+		};
 
+		// Latest result of latestColorPixel, the number of its reads in flight and what the last read was issued for
+		struct PixelReadback {
+			glm::uvec4 value = glm::uvec4(0);
+			int pending = 0;
+			glm::ivec3 request = glm::ivec3(-1);
+			uint64_t generation = 0;
 		};
 
+		bool isIntegerAttachment(int slot) const;
+		// Creates the multisampled framebuffer and a renderbuffer for every attachment that is not an integer texture
+		void createMultisampleBuffers();
+		void deleteMultisampleBuffers();
+		// Takes a texture of the storage size from the pool, returns nullptr if the framebuffer has no pool
+		std::shared_ptr<gl::Texture> acquireTexture(gl::PixelFormat format, gl::PixelType type);
+		// Binds the attachment as read buffer and returns the previously bound read framebuffer
+		GLuint bindForReading(int slot);
+		std::future<glm::uvec4> readPixelAsync(int col, int row, int slot, std::function<void(glm::uvec4)> onFinished, bool background);
+
 		GLuint mId;
 		GLint mPreviousFBO;
 		std::vector<FramebufferAttachment> mColorAttachments;
 		FramebufferAttachment mDepthAttachment;
 		int mWidth, mHeight;
+		// Size of the render textures, larger than the framebuffer with a pool
+		int mStorageWidth, mStorageHeight;
+		gl::RenderTargetPool* mPool;
+		int mSamples;
+		GLuint mMultisampleId;
+		std::vector<GLuint> mMultisampleBuffers;
 		bool mRequriesUpdate;
+		std::shared_ptr<PixelReadback> mPixelReadback;
+		// Counts how often the framebuffer was bound for rendering
+		uint64_t mGeneration;
 	};
 
 	struct FBOState {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glad/glad.h>
+#include "glpp/state_cache.hpp"
 #include <cstddef>
 #include <functional>
 #include <iostream>
@@ -10,6 +11,7 @@
 namespace gl {
 
 	class Shader;
+	class TextureAtlas;
 
 	namespace impl {
 		template<typename T, typename... Args>
@@ -22,6 +24,11 @@ namespace gl {
 				shader.bindTexture(location, nextFreeTextureSlot, *value);
 				nextFreeTextureSlot++;
 			}
+			else if constexpr (std::is_same_v<gl::TextureAtlas, T>) {
+				// Images of an atlas share one array texture, so they only occupy a single slot
+				shader.bindTexture(location, nextFreeTextureSlot, value.texture());
+				nextFreeTextureSlot++;
+			}
 			else {
 				shader.setUniform(location, value);
 			}
@@ -83,6 +90,7 @@ namespace gl {
 
 		static inline void VAODeallocator(GLuint id) {
 			glDeleteVertexArrays(1, &id);
+			gl::StateCache::Current().vertexArrayDeleted(id);
 		}
 	}
 
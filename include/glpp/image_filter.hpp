@@ -0,0 +1,58 @@
+#pragma once
+
+#include "glpp/texture.hpp"
+#include "glpp/texture_pool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace gl {
+
+	enum class ResampleFilter {
+		Linear = 0,		// Triangle filter, bilinear when enlarging
+		Lanczos3 = 1	// Sharper, but may ring at hard edges
+	};
+
+	// Chain of compute shader filters on a 2D texture. Every step writes into a texture of the pool and releases the
+	// result of the previous one, so a chain ping-pongs between few textures and never touches host memory:
+	//     auto blurred = gl::ImageFilter(texture).gaussianBlur(8).resize(512, 512).result();
+	// Float, half float and 8 bit textures are supported. RGB data is processed (and returned) as RGBA,
+	// because images cannot be bound with three channels.
+	class ImageFilter {
+	public:
+		ImageFilter(std::shared_ptr<gl::Texture> source, TexturePool& pool = TexturePool::Default());
+
+		// Convolves with a separable kernel. Both kernels must have an odd length, their center is the middle element
+		ImageFilter& convolve(const std::vector<float>& kernelX, const std::vector<float>& kernelY);
+		ImageFilter& boxBlur(int radius);
+		// sigma <= 0 uses radius / 3, so the kernel covers three standard deviations
+		ImageFilter& gaussianBlur(int radius, float sigma = 0.0f);
+		// Minimum / maximum over a square of 2 * radius + 1 pixels
+		ImageFilter& erode(int radius);
+		ImageFilter& dilate(int radius);
+		// Replaces the image by (dx, dy, magnitude, 1) of its luminance. The result is a float texture
+		ImageFilter& sobel();
+		ImageFilter& resize(int cols, int rows, ResampleFilter filter = ResampleFilter::Linear);
+		// Maps values in range through the lookup table (a 1D texture or a 2D texture with a single row).
+		// Unless perChannel is set, the first channel selects an RGBA color of the table
+		ImageFilter& mapLut(gl::Texture& lut, glm::vec2 range = glm::vec2(0, 1), bool perChannel = false);
+
+		// The current image. Hold on to it as long as needed, the pool does not hand it out again before it is released
+		std::shared_ptr<gl::Texture> result() const;
+
+	protected:
+		enum class Operation {
+			Convolve = 0,
+			Min = 1,
+			Max = 2
+		};
+
+		void separable(Operation operation, int axis, const std::vector<float>& kernel);
+
+		std::shared_ptr<gl::Texture> mImage;
+		TexturePool& mPool;
+	};
+
+}
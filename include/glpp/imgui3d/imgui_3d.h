@@ -49,8 +49,11 @@ namespace ImGui3D {
 		std::shared_ptr<gl::CompactVertexBufferObject<glm::vec4, glm::vec4, ImGuiID, glm::vec2>> data;
 		gl::DrawBatch batch;
 		gl::Shader shader;
+		// Writes the ids into the R32UI attachment 1
+		gl::Shader idShader;
 
 		void execute();
+		void executeIds();
 
 		DrawCommand();
 
@@ -195,7 +198,7 @@ namespace ImGui3D {
 		ImGuiID                            ActiveId;
 		ImGuiID	                           ActiveIdPreviousFrame;
 		ImGuiID                            CurrentId;
-		glm::uvec4                         ActiveIdColor;
+		ImGuiID                            HoveredId;
 
 		glm::mat4                          ModelMatrix;
 		glm::mat4                          ViewMatrix;
@@ -210,7 +213,17 @@ namespace ImGui3D {
 		ImGui3DStyle                       Style;
 
 		gl::Shader                         Shader;
-		std::function<glm::uvec4(ImVec2)>  GetHoveredIdImpl;
+		// Maps the mouse position to a pixel of the id attachment, rows are counted from the top. Pixels outside the
+		// attachment skip the id pass
+		std::function<glm::ivec2(ImVec2)>  GetCursorPixelImpl;
+		// Returns the id at a pixel of the id attachment. The renderers read it without stalling, so it lags a frame or
+		// two behind
+		std::function<ImGuiID(glm::ivec2)> GetHoveredIdImpl;
+		// Ids are only rendered into a square of 2 * IdPassRadius + 1 pixels around the cursor
+		int                                IdPassRadius;
+		glm::ivec2                         CursorPixel;
+		// Pixels [x, z) x [y, w) covered by the last id pass
+		glm::ivec4                         IdPassRegion;
 		std::vector<ImGuiID>               SeedStack;
 
 		std::vector<std::shared_ptr<DrawCommand>> drawCommands;
@@ -235,6 +248,8 @@ namespace ImGui3D {
 
 	void NewFrame(glm::mat4 ViewMatrix, glm::mat4 ProjectionMatrix, ImGuiID windowId =  0);
 
+	/// <summary>Draws the widgets into attachment 0 and their ids into the R32UI attachment 1 of the bound framebuffer</summary>
+	/// <remarks>Ids are only rendered in a small region around the cursor and not at all if it is outside the viewport</remarks>
 	void Render();
 
 	bool IsItemActive();
@@ -262,7 +277,7 @@ namespace ImGui3D {
 	ImGuiID GetID(uint64_t i, bool keepFocus = true);
 
 	/// <summary>Converts a color to an id</summary>
-	/// <remarks>This function is more or less depricated since the shader converts the id to a color</remarks>
+	/// <remarks>This function is more or less depricated since ids are rendered into an integer attachment</remarks>
 	/// <param name="r">Red value of the color in range [0, 256]</param>
 	/// <param name="g">Green value of the color in range [0, 256]</param>
 	/// <param name="b">Blue value of the color in range [0, 256]</param>
@@ -40,6 +40,9 @@ namespace ImGui {
 	protected:
 		std::unique_ptr<gl::LargeTexture> mPreviewTexture;
 		std::string mPath;
+		bool mLoading = false;
+		// Replaced on every selection, so callbacks of outdated requests can detect that they expired
+		std::shared_ptr<int> mLoadToken;
 	};
 
 	struct ImFilesystemDialoguePopup {
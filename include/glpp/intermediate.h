@@ -10,6 +10,24 @@ namespace gl {
 	class Texture;
 	class Camera;
 
+	// Value range of a scalar texture that follows its content. The range of the first channel is computed on the GPU
+	// by gl::Reduction and arrives a few frames late, so the last known range is used until the next reduction finished.
+	class AutoRange {
+	public:
+		AutoRange(glm::vec2 initial = glm::vec2(0, 1));
+
+		// Starts a new reduction of the texture unless one is still in flight and returns the last known range
+		glm::vec2 update(gl::Texture& tex);
+		glm::vec2 range() const;
+
+	private:
+		struct State {
+			glm::vec2 range;
+			bool pending = false;
+		};
+		std::shared_ptr<State> mState;
+	};
+
 	std::shared_ptr<gl::Shader> textureDispShader();
 	std::shared_ptr<gl::Shader> scalarDispShader();
 
@@ -25,6 +43,9 @@ namespace gl {
 
 	void displayScalars(int x, int y, int width, int height, std::shared_ptr<gl::Texture> tex, glm::vec2 range, glm::vec4 minColor=glm::vec4(1), glm::vec4 maxColor=glm::vec4(1, 0, 0, 1), glm::vec2 uvmin = glm::vec2(0), glm::vec2 uvmax = glm::vec2(1));
 	void displayScalars(int x, int y, int width, int height, gl::Texture& tex, glm::vec2 range, glm::vec4 minColor = glm::vec4(1), glm::vec4 maxColor = glm::vec4(1, 0, 0, 1), glm::vec2 uvmin = glm::vec2(0), glm::vec2 uvmax = glm::vec2(1));
+	// Maps the range found by range.update(tex) to the colors, so the texture never has to be downloaded
+	void displayScalars(int x, int y, int width, int height, std::shared_ptr<gl::Texture> tex, AutoRange& range, glm::vec4 minColor = glm::vec4(1), glm::vec4 maxColor = glm::vec4(1, 0, 0, 1), glm::vec2 uvmin = glm::vec2(0), glm::vec2 uvmax = glm::vec2(1));
+	void displayScalars(int x, int y, int width, int height, gl::Texture& tex, AutoRange& range, glm::vec4 minColor = glm::vec4(1), glm::vec4 maxColor = glm::vec4(1, 0, 0, 1), glm::vec2 uvmin = glm::vec2(0), glm::vec2 uvmax = glm::vec2(1));
 
 }
 
@@ -9,24 +9,22 @@ void gl::fullscreenTriangle(int x, int y, int width, int height, gl::Shader& sha
 {
 	static_assert(sizeof...(Uniforms) % 2 == 0, "Invalid number of arguments");
 
-	GLboolean depthTestEnabled = glIsEnabled(GL_DEPTH_TEST);
-	GLboolean depthWriteEnabled;
-	glGetBooleanv(GL_DEPTH_WRITEMASK, &depthWriteEnabled);
+	gl::StateCache& state = gl::StateCache::Current();
+	const bool depthTestEnabled = state.isEnabled(GL_DEPTH_TEST);
+	const bool depthWriteEnabled = state.depthMask();
 
 	auto _ = shader.use();
 	if constexpr (sizeof...(Uniforms) > 0) {
 		impl::SetUniforms(shader, uniforms...);
 	}
-	glViewport(x, y, width, height);
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(GL_FALSE);
+	state.viewport(x, y, width, height);
+	state.disable(GL_DEPTH_TEST);
+	state.depthMask(false);
 	gl::VertexArrayObject::bindDummy();
 	glDrawArrays(GL_TRIANGLES, 0, 3);
 
-	if (depthTestEnabled) {
-		glEnable(GL_DEPTH_TEST);
-	}
-	glDepthMask(depthWriteEnabled);
+	state.setEnabled(GL_DEPTH_TEST, depthTestEnabled);
+	state.depthMask(depthWriteEnabled);
 }
 
 template<typename ...Uniforms>
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace gl {
+
+	// Maps a whole file into the address space. The operating system pages the content in on demand, so files larger
+	// than the host memory can be accessed like an array. Reading from several threads at once is safe.
+	class MappedFile {
+	public:
+		// Throws a std::runtime_error if the file could not be opened or mapped
+		MappedFile(const std::string& path, bool writable = false);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const unsigned char* data() const;
+		// Writing is only allowed for writable mappings
+		unsigned char* data();
+		size_t size() const;
+		// Writes modified pages back to the file
+		void flush();
+
+	protected:
+		unsigned char* mData;
+		size_t mSize;
+		bool mWritable;
+		// Platform handles of the file and the mapping
+		intptr_t mFile;
+		intptr_t mMapping;
+
+	private:
+		// Unmaps the file and closes the handles, used by the destructor and when the constructor fails
+		void close();
+	};
+
+}
@@ -3,6 +3,8 @@
 #include "glpp/meshes/triangle_mesh.hpp"
 #include "glpp/meshes/pointcloud.hpp"
 #include "glpp/meshes/splinecurves.hpp"
+#include "glpp/meshes/volume_mesh.hpp"
+#include "glpp/meshes/isosurface_mesh.hpp"
 #ifdef WITH_OPENMESH
 #include "glpp/meshes/openmesh_mesh.hpp"
 #endif
\ No newline at end of file
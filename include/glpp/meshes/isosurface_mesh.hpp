@@ -0,0 +1,100 @@
+#pragma once
+
+#include "glpp/texture.hpp"
+#include "glpp/meshes/mesh.hpp"
+#include "glpp/meshes/triangle_mesh.hpp"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace gl {
+
+	// Isosurface of a 3D texture extracted with marching cubes in compute shaders. The volume fills the box
+	// [-extent/2, extent/2] in model space like in gl::VolumeMesh and its first channel is compared to isoValue.
+	// Vertices and indices are written straight into GPU buffers and drawn with an indirect draw, so the surface is
+	// extracted again whenever isoValue changes without any transfer to the host. The number of vertices and
+	// triangles is read back through gl::DownloadQueue::Default(): If the surface does not fit into the buffers, they
+	// grow and the surface is extracted again, which leaves a single frame without it.
+	class IsosurfaceMesh : public gl::Mesh {
+	public:
+		typedef std::function<void(std::shared_ptr<gl::TriangleMesh> mesh)> Callback;
+
+		IsosurfaceMesh(std::shared_ptr<gl::Texture> volume, float isoValue = 0.5f);
+		~IsosurfaceMesh();
+
+		IsosurfaceMesh(const IsosurfaceMesh&) = delete;
+		IsosurfaceMesh& operator=(const IsosurfaceMesh&) = delete;
+
+		void setVolume(std::shared_ptr<gl::Texture> volume);
+		std::shared_ptr<gl::Texture> getVolume() const;
+
+		// Extracts the surface again during the next render, call this after changing the content of the volume.
+		// Also invalidates the mesh for viewports that render on demand
+		void invalidate();
+		// Extracts the surface right away
+		void extract();
+
+		// Copies the surface into a gl::TriangleMesh without waiting for the GPU. If the counts of the last
+		// extraction are not known yet, the copy is issued as soon as they are. The mesh is created on the GL thread
+		std::future<std::shared_ptr<gl::TriangleMesh>> download(Callback onFinished = nullptr);
+
+		// Counts of the last extraction that was read back
+		size_t numVertices() const;
+		size_t numTriangles() const;
+
+		virtual void render(const std::shared_ptr<gl::Camera> camera) override;
+		virtual void drawOutliner() override;
+
+		float isoValue;
+		// Size of the bounding box in model space. By default the longest side is 1 and voxels are cubes
+		glm::vec3 extent;
+		glm::vec4 color;
+
+	protected:
+		// Shared with the pending reads, which are dropped once the mesh is gone
+		struct Readback {
+			glm::uvec4 counts = glm::uvec4(0);
+			int extraction = 0;
+			std::vector<std::function<void()>> downloads;
+		};
+
+		// Exclusive prefix sum of count uvec4 in buffer, returns the buffer holding the total
+		GLuint scan(GLuint buffer, size_t count, size_t level = 0);
+		void readCounts(GLuint totals);
+		void onCounts(int extraction);
+		void issueDownload(std::shared_ptr<std::promise<std::shared_ptr<gl::TriangleMesh>>> promise, Callback onFinished);
+		void reserve(size_t vertices, size_t triangles);
+
+		std::shared_ptr<gl::Texture> mVolume;
+
+		gl::ComputeShader mCountShader;
+		gl::ComputeShader mScanShader;
+		gl::ComputeShader mScanAddShader;
+		gl::ComputeShader mCompactShader;
+		gl::ComputeShader mGenerateShader;
+		gl::Shader mSurfaceShader;
+
+		GLuint mTriangleTable;
+		GLuint mRows;
+		GLuint mActiveRows;
+		GLuint mCommands;
+		GLuint mVertices;
+		GLuint mIndices;
+		std::vector<GLuint> mScanSums;
+		gl::VAOIndex mVAO;
+		size_t mRowBytes;
+		size_t mActiveRowBytes;
+		std::vector<size_t> mScanBytes;
+		size_t mMaxVertices;
+		size_t mMaxTriangles;
+
+		bool mDirty;
+		float mExtractedIsoValue;
+		glm::vec3 mExtractedExtent;
+		int mExtraction;
+		std::shared_ptr<Readback> mReadback;
+	};
+
+}
@@ -8,6 +8,7 @@
 #include <glpp/camera.hpp>
 
 namespace gl {
+	class RenderQueue;
 
 	class Mesh {
 	public:
@@ -16,6 +17,10 @@ namespace gl {
 		Mesh();
 		virtual void render(const std::shared_ptr<gl::Camera> camera) = 0;
 
+		/// <summary>Override this function to submit the draw calls of render to a render queue instead</summary>
+		/// <returns>False if the mesh has to be drawn with render</returns>
+		virtual bool submit(gl::RenderQueue& queue, const std::shared_ptr<gl::Camera> camera) { return false; }
+
 		template<typename... Args>
 		void render(gl::Shader& shader, const Args&... uniforms) {
 			mBatch.execute(shader, uniforms...);
@@ -42,6 +47,12 @@ namespace gl {
 		/// <remarks>Framebuffer Attachment 0 is for display and Framebuffer Attachment 1 holds ImGuiIDs for io</remarks>
 		virtual void drawViewportUI(const std::shared_ptr<gl::Camera> env) { };
 
+		/// <summary>Call this after changing what the mesh draws (e.g. its buffers, textures or uniforms), so viewports
+		/// that render on demand draw it again</summary>
+		/// <remarks>Changes of ModelMatrix and visible are noticed without it</remarks>
+		void invalidate() { ++mGeneration; }
+		uint64_t generation() const { return mGeneration; }
+
 		std::string name;
 		bool visible;
 		glm::mat4 ModelMatrix;
@@ -52,5 +63,6 @@ namespace gl {
 		gl::DrawBatch mBatch;
 		bool mShowInOutliner;
 		Shader mShader;
+		uint64_t mGeneration;
 	};
 }
\ No newline at end of file
@@ -19,6 +19,7 @@ namespace gl {
 		}
 
 		void render(const std::shared_ptr<gl::Camera> camera);
+		virtual bool submit(gl::RenderQueue& queue, const std::shared_ptr<gl::Camera> camera) override;
 
 		virtual void drawOutliner() override;
 
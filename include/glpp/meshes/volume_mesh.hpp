@@ -0,0 +1,83 @@
+#pragma once
+
+#include "glpp/bricked_volume.hpp"
+#include "glpp/buffers.hpp"
+#include "glpp/framebuffer.hpp"
+#include "glpp/texture.hpp"
+#include "glpp/meshes/mesh.hpp"
+
+#include <memory>
+
+namespace gl {
+
+	// Direct volume rendering of a 3D texture by ray marching. The volume fills the box [-extent/2, extent/2] in model
+	// space and its first channel is mapped to color and opacity by a transfer function.
+	// Rays skip macrocells (bricks of cellSize^3 voxels) in which the transfer function is transparent, stop once they
+	// are opaque and may take larger steps through transparent or hidden regions. The volume is blended over the
+	// framebuffer without depth test, so it should be rendered after the opaque meshes.
+	// Volumes that do not fit into video memory are drawn from a gl::BrickedVolume. Its full resolution bricks are
+	// the macrocells and bricks are streamed in as the view requires them.
+	class VolumeMesh : public gl::Mesh {
+	public:
+		// The transfer function is a 1D texture or a 2D texture with a single row of RGBA entries, whose opacities
+		// are given for a step of one voxel. Without it, values are mapped to gray levels with linear opacity
+		VolumeMesh(std::shared_ptr<gl::Texture> volume, std::shared_ptr<gl::Texture> transferFunction = nullptr, int cellSize = 8);
+		VolumeMesh(std::shared_ptr<gl::BrickedVolume> volume, std::shared_ptr<gl::Texture> transferFunction = nullptr);
+
+		// Rebuilds the macrocells, call this after changing the content of the volume
+		void setVolume(std::shared_ptr<gl::Texture> volume);
+		void setVolume(std::shared_ptr<gl::BrickedVolume> volume);
+		// Call this again after changing the content of the transfer function
+		void setTransferFunction(std::shared_ptr<gl::Texture> transferFunction);
+
+		std::shared_ptr<gl::Texture> getVolume() const;
+		std::shared_ptr<gl::BrickedVolume> getBrickedVolume() const;
+		std::shared_ptr<gl::Texture> getTransferFunction() const;
+
+		virtual void render(const std::shared_ptr<gl::Camera> camera) override;
+		virtual void drawOutliner() override;
+
+		// Size of the bounding box in model space. By default the longest side is 1 and voxels are cubes
+		glm::vec3 extent;
+		// Values mapped to the first and last entry of the transfer function
+		glm::vec2 valueRange;
+		// Distance between samples in voxels
+		float stepSize;
+		// Macrocells in which the transfer function does not exceed this opacity are skipped
+		float emptyOpacity;
+		// Rays stop as soon as their opacity reaches this value
+		float terminationAlpha;
+		// Takes up to four times larger steps through transparent samples and behind dense material
+		bool adaptiveSteps;
+		// Marches at half the resolution of the viewport and upsamples the result
+		bool halfResolution;
+
+	protected:
+		VolumeMesh(int cellSize, std::shared_ptr<gl::Texture> transferFunction);
+
+		void createShader(bool bricked);
+		glm::ivec3 volumeSize() const;
+		void buildMacrocells();
+		void updateOccupancy();
+		void updateDefines();
+		void march(const std::shared_ptr<gl::Camera> camera);
+
+		std::shared_ptr<gl::Texture> mVolume;
+		std::shared_ptr<gl::BrickedVolume> mBrickedVolume;
+		std::shared_ptr<gl::Texture> mTransferFunction;
+		int mCellSize;
+		// Min / max value and whether the transfer function is visible per macrocell
+		std::unique_ptr<gl::Texture> mMacrocells;
+		std::unique_ptr<gl::Texture> mOccupancy;
+
+		gl::ComputeShader mMacrocellShader;
+		gl::ComputeShader mOccupancyShader;
+		gl::Shader mCompositeShader;
+		std::unique_ptr<gl::Framebuffer> mHalfResolutionBuffer;
+
+		// State the occupancy was computed for
+		bool mOccupancyValid;
+		glm::vec2 mOccupancyRange;
+		float mOccupancyThreshold;
+	};
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <vector>
+
+namespace gl {
+
+	// A ring of pixel buffer objects used to stream pixel data between host and device memory.
+	// Every slot is guarded by a fence, so a slot is only handed out again once the GPU
+	// finished working with it. If the context supports GL_ARB_buffer_storage, the buffers
+	// are mapped persistently and no map/unmap calls are issued at all.
+	class PixelBufferRing {
+	public:
+		// target is either GL_PIXEL_UNPACK_BUFFER (uploads) or GL_PIXEL_PACK_BUFFER (downloads)
+		PixelBufferRing(GLenum target = GL_PIXEL_UNPACK_BUFFER, int slots = 3);
+		~PixelBufferRing();
+
+		PixelBufferRing(const PixelBufferRing&) = delete;
+		PixelBufferRing& operator=(const PixelBufferRing&) = delete;
+
+		// Returns the next slot that can hold at least sizeInBytes bytes.
+		// This only blocks if the GPU still uses the buffer of that slot.
+		int acquire(size_t sizeInBytes);
+		// Returns a host pointer to the memory of the slot
+		void* map(int slot);
+		// Must be called before the slot is used as source or target of a GL command
+		void unmap(int slot);
+		// Inserts a fence after all GL commands issued so far that use the slot
+		void fence(int slot);
+		// Returns true if the GPU finished all commands issued before the last fence of the slot
+		bool isSignaled(int slot);
+		// Blocks until the GPU finished all commands issued before the last fence of the slot
+		void wait(int slot);
+
+		void bind(int slot) const;
+		void unbind() const;
+
+		// New getters
+		bool isPersistent() const;
+		GLenum target() const;
+		size_t capacity(int slot) const;
+		int slots() const;
+
+		// Shared ring used by the asynchronous texture uploads
+		static PixelBufferRing& Uploads();
+
+	protected:
+		struct Slot {
+			GLuint id = 0;
+			size_t capacity = 0;
+			void* mapped = nullptr;
+			GLsync fence = nullptr;
+		};
+
+		void allocate(Slot& slot, size_t sizeInBytes);
+		void release(Slot& slot);
+
+		GLenum mTarget;
+		bool mPersistent;
+		int mNext;
+		std::vector<Slot> mSlots;
+	};
+
+	// Reads from the GPU that are still in flight. A read is issued into a slot of a pixel pack ring
+	// and only copied to its destination once the fence of the slot signaled, so the GL thread never waits
+	// for the GPU as long as poll() is called regularly (the renderers call it once per frame).
+	class DownloadQueue {
+	public:
+		DownloadQueue(int slots = 4);
+
+		DownloadQueue(const DownloadQueue&) = delete;
+		DownloadQueue& operator=(const DownloadQueue&) = delete;
+
+		// Returns a slot of the ring that can hold sizeInBytes bytes. If every slot holds a pending read,
+		// the oldest read is finished first, which blocks until the GPU wrote it.
+		int acquire(size_t sizeInBytes);
+		// Registers the read issued into the slot. dst must stay valid until the read finished.
+		// onFinished is called on the GL thread after dst was written. Background reads (e.g. picking) are
+		// not worth rendering another frame for, see pending()
+		std::future<void> push(int slot, size_t sizeInBytes, void* dst, std::function<void()> onFinished = nullptr, bool background = false);
+		// Finishes all reads the GPU is done with
+		void poll();
+		// Finishes all reads, waiting for the GPU if necessary
+		void flush();
+
+		// Number of reads in flight, optionally without the background reads
+		size_t pending(bool includeBackground = true) const;
+		PixelBufferRing& ring();
+
+		// Queue shared by the asynchronous downloads
+		static DownloadQueue& Default();
+
+	protected:
+		struct Read {
+			int slot;
+			size_t size;
+			void* dst;
+			std::function<void()> onFinished;
+			std::promise<void> promise;
+			bool background;
+		};
+
+		void finish(Read& read);
+
+		PixelBufferRing mRing;
+		std::deque<Read> mReads;
+	};
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gl {
+
+	// Expands tightly packed RGB pixels to RGBA pixels with the given alpha value.
+	// src and dst must not overlap. Uses SSSE3 or NEON if available.
+	void expandRGBToRGBA(const unsigned char* src, unsigned char* dst, size_t pixels, unsigned char alpha = 255);
+
+	// Converts floats to IEEE half floats, rounding to nearest even. Uses F16C or NEON if available.
+	void floatToHalf(const float* src, uint16_t* dst, size_t count);
+	// Converts IEEE half floats to floats. Uses F16C or NEON if available.
+	void halfToFloat(const uint16_t* src, float* dst, size_t count);
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "glpp/shadermanager.hpp"
+#include "glpp/texture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gl {
+
+	// A full screen effect of a gl::PostProcessingChain. source defines the GLSL function
+	//     vec4 <name>(vec4 color, vec2 texCoord)
+	// which maps the color of a pixel. Effects that read other pixels (e.g. FXAA) sample the input of their pass with
+	//     vec4 sourceColor(vec2 texCoord)
+	// and step from pixel to pixel with sourceTexelSize.
+	struct PostEffect {
+		// Name of the GLSL function, unique within a chain
+		std::string name;
+		std::string source;
+		// The effect reads the neighbours of a pixel. It starts a new pass, so sourceColor returns the result of the
+		// effects before it
+		bool samplesNeighbours = false;
+		bool enabled = true;
+		// Sets the uniforms of the effect, called with the shader of its pass in use
+		std::function<void(gl::Shader&)> uniforms;
+
+		// Built-in effects
+		// Maps HDR colors with the operator of the define HDR_MAPPING_TYPE (see gl::ToneMapping). With the define
+		// AUTO_EXPOSURE the exposure is read from the buffer of gl::AutoExposure bound to index 3
+		static PostEffect Tonemapping();
+		// Raises the colors to 1 / gamma, the uniform gamma has to be set
+		static PostEffect GammaCorrection();
+		// Sharpens an upscaled input by the uniform sharpness (zero to one, zero disables it). Add it first, so it
+		// reads the input at its own resolution in the first pass
+		static PostEffect Sharpen();
+		static PostEffect FXAA();
+	};
+
+	// Applies a list of effects to an image. Instead of a full screen pass per effect, consecutive effects are fused
+	// into a single generated fragment shader, so the image is only read and written once. A new pass (with an
+	// intermediate half float target of gl::RenderTargetPool::Default()) only starts at effects that sample
+	// neighbouring pixels. Shaders are regenerated whenever the enabled effects or the defines change.
+	// With sRGB output the last pass writes through an sRGB view of the output texture with GL_FRAMEBUFFER_SRGB, so
+	// the hardware gamma encodes the colors as they are written while the texture itself is still sampled as is.
+	class PostProcessingChain {
+	public:
+		PostProcessingChain();
+		~PostProcessingChain();
+
+		PostProcessingChain(const PostProcessingChain&) = delete;
+		PostProcessingChain& operator=(const PostProcessingChain&) = delete;
+
+		// Appends an effect to the end of the chain
+		PostEffect& add(PostEffect effect);
+		// Returns nullptr if there is no effect of that name
+		PostEffect* find(const std::string& name);
+		void setEnabled(const std::string& name, bool enabled);
+
+		// Defines of all generated shaders
+		void setDefine(const std::string& name, int value);
+		void setDefineFlag(const std::string& name, bool set = true);
+
+		// Encode the output as sRGB. This uses GL_FRAMEBUFFER_SRGB if the output is an RGBA8 texture with immutable
+		// storage and the sRGB curve in the shader otherwise
+		void setSRGBOutput(bool enabled);
+		bool sRGBOutput() const;
+
+		// Runs the enabled effects on the lower left width x height pixels of input (texCoordScale is its rendered
+		// part, see gl::Framebuffer::textureScale) and writes them to the lower left pixels of output
+		void execute(gl::Texture& input, glm::vec2 texCoordScale, std::shared_ptr<gl::Texture> output, int width, int height);
+
+		// Number of full screen passes of the last execute
+		int passes() const;
+
+	protected:
+		struct Pass {
+			std::unique_ptr<gl::Shader> shader;
+			std::vector<PostEffect*> effects;
+		};
+
+		void build(bool encodeSRGB);
+		GLuint outputView(const std::shared_ptr<gl::Texture>& output);
+		void releaseOutputView();
+
+		std::vector<std::unique_ptr<PostEffect>> mEffects;
+		std::vector<Pass> mPasses;
+		std::unordered_map<std::string, std::string> mDefines;
+		// Enabled effects and sRGB encoding the passes were built for
+		std::vector<PostEffect*> mBuiltEffects;
+		bool mBuiltSRGB;
+		bool mDirty;
+		bool mSRGBOutput;
+
+		GLuint mFramebuffer;
+		GLuint mSampler;
+		// sRGB view of the output texture and the texture it was made for
+		GLuint mOutputView;
+		std::shared_ptr<gl::Texture> mViewedOutput;
+		GLuint mViewedId;
+	};
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace gl {
+	class Texture;
+	class ComputeShader;
+	class ShaderStorageBuffer;
+
+	// Statistics of a reduction. Every component holds the result of one channel, channels the source
+	// does not have are left empty. NaN and infinite values are skipped and not counted
+	struct ReductionResult {
+		glm::vec4 min;
+		glm::vec4 max;
+		glm::vec4 sum;
+		glm::vec4 mean;
+		glm::uvec4 nonZero;
+		glm::uvec4 count;
+	};
+
+	// Computes min, max, sum, mean and the number of non-zero values of every channel of a texture or buffer on the GPU.
+	// Every workgroup reduces a chunk of the input in shared memory and writes a partial result, which is reduced again
+	// until a single result is left. That result is copied into a pixel pack buffer and handed back through
+	// gl::DownloadQueue::Default(), so the GL thread never waits for the GPU. Call DownloadQueue::Default().flush()
+	// before waiting on a returned future, otherwise it only becomes ready during the next poll().
+	class Reduction {
+	public:
+		typedef std::function<void(const ReductionResult& result)> Callback;
+
+		Reduction();
+		~Reduction();
+
+		Reduction(const Reduction&) = delete;
+		Reduction& operator=(const Reduction&) = delete;
+
+		// Reduces a mip level of a 2D float, half float or normalized 8 bit texture
+		std::future<ReductionResult> reduce(gl::Texture& texture, int level = 0, Callback onFinished = nullptr);
+		// Reduces count elements of a buffer of floats. An element consists of channels floats and starts
+		// stride floats after the previous one (0 packs them tightly). offset is the index of the first float
+		std::future<ReductionResult> reduce(GLuint buffer, size_t count, int channels = 1, size_t offset = 0, size_t stride = 0, Callback onFinished = nullptr);
+		std::future<ReductionResult> reduce(gl::ShaderStorageBuffer& buffer, size_t count, int channels = 1, size_t offset = 0, size_t stride = 0, Callback onFinished = nullptr);
+
+		// Instance shared by the framework
+		static Reduction& Default();
+
+	protected:
+		gl::ComputeShader& shader(const std::string& source, int channels);
+		// Reduces the partial results in mPartials[0] until one is left and starts the download
+		std::future<ReductionResult> finish(size_t partials, Callback onFinished);
+		void reserve(int buffer, size_t sizeInBytes);
+
+		GLuint mPartials[2];
+		size_t mCapacity[2];
+		std::unordered_map<std::string, std::unique_ptr<gl::ComputeShader>> mShaders;
+	};
+
+}
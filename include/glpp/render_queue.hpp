@@ -0,0 +1,112 @@
+#pragma once
+
+#include "glpp/shadermanager.hpp"
+#include "glpp/texture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace gl {
+
+	enum class RenderPass {
+		Opaque = 0,
+		// Drawn back to front after the opaque packets
+		Transparent = 1
+	};
+
+	// A single indexed draw call. gl::DrawBatch::packet fills in the geometry, meshes add their shader uniforms,
+	// textures and sort criteria
+	struct DrawPacket {
+		static constexpr int MaxTextures = 4;
+
+		RenderPass pass = RenderPass::Opaque;
+		// Packets of the same shader and material are drawn next to each other. Use the same value for packets that
+		// share their textures
+		uint32_t material = 0;
+		// Distance to the camera. Opaque packets of a shader and material are drawn front to back, transparent
+		// packets back to front
+		float depth = 0.0f;
+
+		gl::Shader* shader = nullptr;
+		// Sets the per draw uniforms, called with the shader in use. Bind textures through textures instead,
+		// the queue would not notice bindings made in here
+		std::function<void(gl::Shader&)> uniforms;
+		// Bound to the unit of their index if they are not bound there already
+		gl::Texture* textures[MaxTextures] = {};
+
+		GLuint vao = 0;
+		GLenum primitiveType = GL_TRIANGLES;
+		GLsizei count = 0;
+		GLenum indexType = GL_UNSIGNED_INT;
+		// In bytes
+		size_t indexOffset = 0;
+		int patchSize = 0;
+
+		// Draws the packet into the depth pre-pass with MVP. This requires the position at attribute 0 and a
+		// vertex shader that computes an invariant gl_Position as MVP * vec4(position, 1.0)
+		bool depthPrepass = false;
+		glm::mat4 MVP = glm::mat4(1);
+	};
+
+	// Collects the draw calls of a frame and issues them sorted by a 64 bit key, so shaders, vertex arrays and
+	// textures are only switched when they actually change. Opaque keys are ordered by shader, material and depth,
+	// transparent keys by depth first. The queue keeps its memory between frames.
+	// With a depth pre-pass, the opaque packets that allow it are first drawn with a depth only shader, so the
+	// expensive shaders only run once per pixel.
+	class RenderQueue {
+	public:
+		struct Statistics {
+			int draws = 0;
+			int programs = 0;
+			int vertexArrays = 0;
+			int textures = 0;
+		};
+
+		RenderQueue();
+
+		RenderQueue(const RenderQueue&) = delete;
+		RenderQueue& operator=(const RenderQueue&) = delete;
+
+		// Drops the packets and statistics of the last frame
+		void clear();
+		void submit(DrawPacket packet);
+
+		// Radix sorts the packets by their key. execute calls this if packets were submitted since the last sort
+		void sort();
+		// Draws the depth of the opaque packets that set depthPrepass with colors masked out
+		void executeDepthPrepass();
+		// Draws the packets of the pass. After a depth pre-pass the opaque packets are tested with GL_LEQUAL and
+		// the ones that were part of it do not write depth again
+		void execute(RenderPass pass);
+
+		size_t size() const;
+		// State changes and draw calls since the last clear
+		const Statistics& statistics() const;
+
+		static uint64_t makeKey(const DrawPacket& packet);
+
+	protected:
+		struct SortEntry {
+			uint64_t key;
+			uint32_t index;
+		};
+
+		// Sorted entries of the given pass
+		std::pair<size_t, size_t> range(RenderPass pass) const;
+
+		std::vector<DrawPacket> mPackets;
+		std::vector<SortEntry> mEntries;
+		std::vector<SortEntry> mScratch;
+		bool mSorted;
+		bool mPrepassed;
+		Statistics mStatistics;
+
+		std::unique_ptr<gl::Shader> mDepthShader;
+		GLint mDepthMVPLocation;
+	};
+}
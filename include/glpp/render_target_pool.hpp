@@ -0,0 +1,55 @@
+#pragma once
+
+#include "glpp/texture.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace gl {
+
+	// Keeps render targets of resizable framebuffers around for reuse. Sizes are rounded up to buckets (steps of at
+	// most 1/8 of the next power of two), so a framebuffer that is resized by a few pixels keeps its textures and only
+	// renders into a smaller part of them. Textures have immutable storage and, like in gl::TexturePool, are free
+	// again as soon as the pool holds the only reference to them.
+	// Free textures are not deleted right away: They are kept for shrinkDelay frames in case a resize storm brings
+	// the same size back, e.g. while a docking splitter is dragged back and forth.
+	class RenderTargetPool {
+	public:
+		RenderTargetPool(int shrinkDelay = 60);
+
+		RenderTargetPool(const RenderTargetPool&) = delete;
+		RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+		// Returns a free target of the bucket of the given size or creates a new one. Its content is undefined
+		std::shared_ptr<gl::Texture> acquire(int width, int height, PixelFormat pixelFormat, PixelType dataType);
+		// Call this once per frame, deletes the targets that were not used for shrinkDelay frames
+		void update();
+		// Deletes all targets that are not in use
+		void trim();
+
+		// Number of targets owned by the pool and the number of those in use
+		size_t size() const;
+		size_t inUse() const;
+		// Video memory of all targets owned by the pool in bytes
+		size_t memory() const;
+
+		// Size of the bucket the given size falls into. Buckets are their own bucket
+		static int bucketSize(int size);
+
+		// Pool shared by the framework
+		static RenderTargetPool& Default();
+
+		// Number of frames free targets are kept
+		int shrinkDelay;
+
+	protected:
+		struct Target {
+			std::shared_ptr<gl::Texture> texture;
+			int lastUsed;
+		};
+
+		std::vector<Target> mTargets;
+		int mFrame;
+	};
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -40,6 +41,7 @@ namespace gl {
 		Editor();
 		Editor(int width, int height, const std::string& title = "Title", EditorFlags flags = 0);
 		Editor(const std::string& title, EditorFlags flags = 0);
+		~Editor();
 
 		/// <summary>This function initializes a new frame and polls for user input.</summary>
 		/// <remarks>Call this function as soon as possible in your render loop. 
@@ -61,9 +63,23 @@ namespace gl {
 		///		...
 		///		endFrame();
 		/// }
+		/// With eventDriven set it sleeps until there is something to draw (see waitForFrame).
 		/// </summary>
 		void run();
 
+		/// <summary>Blocks until the next frame of run() is due.</summary>
+		/// <remarks>
+		/// Frames are due right away while viewports redraw (e.g. continuous rendering or auto exposure adaption),
+		/// after requestAnimationFrame, while textures or downloads are waiting and for a few frames after input so
+		/// ImGui can settle. Otherwise it waits for input, postInvalidation or idleTimeout (forever if it is zero).
+		/// Frames are limited to maxFrameRate, or backgroundFrameRate while the window is unfocused or minimized.
+		/// </remarks>
+		void waitForFrame();
+		/// <summary>Renders the next frame without waiting for input. Call it every frame while animating.</summary>
+		void requestAnimationFrame();
+		/// <summary>Wakes up the render loop and redraws all viewports. Can be called from any thread.</summary>
+		void postInvalidation();
+
 		bool shouldClose() const;
 
 		size_t numObjects() const;
@@ -79,6 +95,8 @@ namespace gl {
 		}
 		void removeObject(size_t id);
 		void removeObjectIf(std::function<bool(std::shared_ptr<gl::Mesh>)> condition);
+		// Makes all viewports render their next frame, e.g. after render hooks changed what they draw
+		void invalidateViewports(const char* reason = "Invalidated");
 
 		// Getters
 		const std::vector<std::shared_ptr<Mesh>>& getObjects() const;
@@ -136,7 +154,18 @@ namespace gl {
 		bool hdr;
 		float gamma;
 		ToneMapping toneMapping;
+		// Adapts the exposure of the viewports to the brightness of the scene (see gl::AutoExposure)
+		bool autoExposure;
+		// Average luminance auto exposure maps the scene to
+		float exposureKey;
 		glm::vec4 clearColor;
+		// Render loop of run()
+		bool eventDriven;
+		// Frame caps in frames per second, 0 disables them (vsync still applies)
+		float maxFrameRate;
+		float backgroundFrameRate;
+		// Seconds an idle loop sleeps at most, so e.g. blinking text cursors still update. Zero sleeps until an event
+		float idleTimeout;
 
 		EventSystem& eventSystem;
 
@@ -157,9 +186,19 @@ namespace gl {
 		/// This function initializes ImGui and ImGui3D
 		/// </summary>
 		void initialize(EditorFlags flags);
+		/// <summary>Handles posted invalidations and lets ImGui settle after input events</summary>
+		void handleEvents();
 
 	private:
 		bool                    mForceUiResetOnNextDraw;
+		bool                    mAnimationRequested;
+		std::atomic<bool>       mInvalidationPosted;
+		int                     mSettleFrames;
+		double                  mLastFrameTime;
+		// Input and window events counted by the GLFW callbacks and the count handleEvents has seen
+		uint64_t                mInputEvents;
+		uint64_t                mHandledInputEvents;
+		std::function<void()>   mPreviousOnJobReady;
 		//ToneMapping             mLastTonemapping;
 		//std::unique_ptr<Shader> mTonemappingShader;
 
@@ -5,10 +5,16 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <glpp/renderer.hpp>
 #include <glpp/imgui.hpp>
+#include <glpp/dynamic_resolution.hpp>
+#include <glpp/frame_graph.hpp>
 #include <glpp/logging.hpp>
+#include <glpp/post_processing.hpp>
+#include <glpp/render_queue.hpp>
+#include <glpp/texture.hpp>
 
 namespace ImGui3D {
 	struct ImGui3DContext;
@@ -18,8 +24,10 @@ namespace gl {
 
 	class Camera;
 	class Control;
+	class AutoExposure;
 	class Editor;
 	class Framebuffer;
+	class Mesh;
 	class Shader;
 
 	/// <summary>
@@ -81,11 +89,62 @@ namespace gl {
 		virtual void onDraw(Editor* editor) override;
 	};
 
+	// Textures of a viewport frame that frame graph hooks can add passes for
+	struct ViewportFrameResources {
+		// HDR color and depth of the meshes, already resolved
+		FrameGraphResource hdr;
+		FrameGraphResource depth;
+		// Tone mapped color the viewport displays
+		FrameGraphResource display;
+	};
+
+	typedef typename std::function<void(const gl::ViewportEditorWindow*, gl::FrameGraph&, const ViewportFrameResources&)> FrameGraphHookFn;
+
 	class ViewportEditorWindow : public EditorWindow {
 	public:
 		ViewportEditorWindow(const std::string& title = "Viewport", EditorWindowRegion defaultRegion = EditorWindowRegion::Center);
+		~ViewportEditorWindow();
 
 		void registerRenderHook(gl::RenderHook hook, gl::RenderHookFn fn);
+		// Adds passes to the frame graph of every frame. They run after the meshes were drawn and before the auto
+		// exposure and post processing passes. Intermediate textures should be created as transients of the graph,
+		// so passes that are not alive at the same time share them
+		void registerFrameGraphHook(gl::FrameGraphHookFn fn);
+
+		// Pixel type of the HDR color target the meshes are rendered to before tone mapping.
+		// Half floats (RGBA16F) take half the bandwidth of PixelType::Float and keep enough range for tone mapping
+		void setGeometryPixelType(gl::PixelType type);
+		// Samples per pixel the meshes are rendered with. The HDR target is resolved before tone mapping
+		void setGeometrySamples(int samples);
+		// Draws the depth of the opaque meshes before shading them, so expensive shaders run once per pixel
+		void setDepthPrepass(bool enabled);
+
+		// Only renders frames in which something the image depends on changed: The camera, the size, the meshes,
+		// their model matrices and generations (see gl::Mesh::invalidate), the display settings, loaded textures or
+		// the user interacting with the viewport or the UI. Otherwise the last image is displayed again.
+		// Render hooks only run when the viewport renders, call invalidate() when what they draw changes
+		void setRenderOnDemand(bool enabled);
+		// Renders the next frame. reason has to outlive the frame, it is shown in the debug overlay
+		void invalidate(const char* reason = "Invalidated");
+		// Why the current frame was rendered or nullptr if the last image was reused
+		const char* redrawReason() const;
+		// The viewport wants another frame, e.g. because it redraws or has to return to full resolution
+		bool needsFrame() const;
+		// Shows the redraw reason in a corner of the viewport
+		bool showRedrawReason;
+
+		// Effects applied to the HDR image, the last pass writes the texture the viewport displays. The chain starts
+		// with the effects "sharpen" (see dynamicResolution()), "tonemapping", "gammaCorrection" and "fxaa" (disabled),
+		// further effects are appended
+		gl::PostProcessingChain& postProcessing();
+
+		// Renders the meshes at a lower resolution while the camera moves, so the GPU time of a frame stays within
+		// the budget of the controller. The image is upscaled with the effect "sharpen" at the start of the post
+		// processing chain. Once the camera stood still for a moment the viewport renders at full resolution again.
+		// Disabled by default
+		gl::DynamicResolution& dynamicResolution();
+		// Scale of the resolution the meshes of the current image were rendered with
+		float renderScale() const;
 
 	protected:
 		friend class DebugEditorWindow;
@@ -93,10 +152,64 @@ namespace gl {
 		void onResize(ImVec2 position, ImVec2 windowSize, Editor* editor) override;
 		void initialize(Editor* editor) override;
 
-		ToneMapping                              mLastTonemapping;
+		// Compares the state the last image was rendered with to the current one and remembers the current one
+		const char* findRedrawReason(Editor* editor);
+		// Render scale the next image should have
+		float targetRenderScale() const;
+		// Resizes the geometry framebuffer to the scaled size of the viewport
+		void resizeGeometry();
+		// Overlays share the depth of the geometry if both have the same size, otherwise they get a depth texture of
+		// their own that the geometry depth is scaled into
+		void updateOverlayDepth();
+
+		struct DisplaySettings {
+			ToneMapping toneMapping;
+			bool        gammaCorrection;
+			float       gamma;
+			bool        autoExposure;
+			float       exposureKey;
+			glm::vec4   clearColor;
+
+			bool operator==(const DisplaySettings& other) const;
+		};
+
+		struct MeshState {
+			const Mesh* mesh;
+			uint64_t    generation;
+			glm::mat4   model;
+			bool        visible;
+
+			bool operator==(const MeshState& other) const;
+		};
+
+		gl::PixelType                            mGeometryPixelType;
+		int                                      mGeometrySamples;
+		bool                                     mDepthPrepass;
+		bool                                     mRenderOnDemand;
+		const char*                              mInvalidation;
+		const char*                              mRedrawReason;
+		int                                      mFramesSinceRedraw;
+		int                                      mFramesSinceChange;
+		glm::mat4                                mLastView;
+		glm::mat4                                mLastProjection;
+		DisplaySettings                          mLastSettings;
+		std::vector<MeshState>                   mLastMeshes;
+		std::vector<MeshState>                   mMeshes;
+		size_t                                   mLastFinishedJobs;
+		ImGuiID                                  mLastHoveredId;
+		bool                                     mLastUIActive;
+		bool                                     mLastAutoExposure;
+		gl::DynamicResolution                    mDynamicResolution;
+		float                                    mRenderScale;
+		double                                   mLastCameraMove;
+		std::unique_ptr<AutoExposure>            mAutoExposure;
 		std::shared_ptr<Framebuffer>             mGeometryFrameBuffer;
 		std::shared_ptr<Framebuffer>             mFrameBuffer;
-		std::unique_ptr<Shader>                  mTonemappingShader;
+		gl::PostProcessingChain                  mPostProcessing;
+		gl::FrameGraph                           mFrameGraph;
+		std::vector<gl::FrameGraphHookFn>        mFrameGraphHooks;
+		gl::RenderQueue                          mRenderQueue;
+		std::vector<std::shared_ptr<Mesh>>       mUnqueuedMeshes;
 		std::shared_ptr<ImGui3D::ImGui3DContext> mImGui3DContext;
 		std::unordered_map<gl::RenderHook, std::vector<gl::RenderHookFn>> mRenderHoodks;
 
@@ -12,7 +12,8 @@ namespace gl {
 	
 	class OffscreenRenderer {
 	public:
-		OffscreenRenderer(int width, int height);
+		// With more than one sample per pixel the framebuffer is multisampled, call endRender before reading it
+		OffscreenRenderer(int width, int height, int samples = 1);
 
 		/// <summary>
 		/// Prepares the bound framebuffer for a new render by resizing and clearing it
@@ -21,6 +22,11 @@ namespace gl {
 		/// <param name="height"></param>
 		void startRender(int width, int height, bool clear=true);
 
+		/// <summary>
+		/// Resolves a multisampled framebuffer into its render textures
+		/// </summary>
+		void endRender();
+
 		std::shared_ptr<gl::Framebuffer> framebuffer;
 		std::vector<glm::vec4> clearColors;
 	protected:
@@ -25,6 +25,8 @@ namespace gl {
 		void bind(int slot);
 		void unbind();
 
+		GLuint id() const { return mId; }
+
 	protected:
 		
 		GLuint mId;
@@ -11,6 +11,7 @@
 #include <filesystem>
 
 #include "glpp/buffers.hpp"
+#include "glpp/state_cache.hpp"
 #include "glpp/texture.hpp"
 
 #ifdef INTELLISENSE
@@ -37,10 +38,15 @@ namespace gl {
 	struct ShaderRequirements {
 		std::vector<GLenum> requirements;
 		std::vector<Layout> vertexAttributes;
-		ShaderRequirements(const std::vector<GLenum>& requirements,
-			const std::vector<Layout>& vattrs) : requirements(requirements), vertexAttributes(vattrs) {
-			for (GLenum requirement : requirements) {
-				glEnable(requirement);
+		ShaderRequirements(const std::vector<GLenum>& capabilities,
+			const std::vector<Layout>& vattrs) : requirements(), vertexAttributes(vattrs) {
+			// Only capabilities that are not enabled yet are enabled and later disabled again
+			gl::StateCache& state = gl::StateCache::Current();
+			for (GLenum capability : capabilities) {
+				if (!state.isEnabled(capability)) {
+					state.enable(capability);
+					requirements.push_back(capability);
+				}
 			}
 			for (auto attribute : vertexAttributes) {
 				glEnableVertexAttribArray(attribute.index);
@@ -55,8 +61,9 @@ namespace gl {
 		}
 
 		~ShaderRequirements() {
+			gl::StateCache& state = gl::StateCache::Current();
 			for (GLenum requirement : requirements) {
-				glDisable(requirement);
+				state.disable(requirement);
 			}
 			for (auto attribute : vertexAttributes) {
 				glDisableVertexAttribArray(attribute.index);
@@ -180,9 +187,12 @@ namespace gl {
 	protected:
 		bool requiresUpdate() const;
 		virtual bool compileFromFile();
+		// Compiles the stages passed as strings with the current defines
+		bool compileFromStages();
 
 		GLuint mProgram;
 		std::vector<std::string> mSourceFiles;
+		std::vector<std::pair<GLenum, std::string>> mStages;
 		std::vector<GLenum> mEnables;
 		std::vector<Layout> mVertexAttributes;
 		std::unordered_map<std::string, std::string> mDefines;
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+namespace gl {
+
+	// Shadow copy of the GL state that the framework changes most often: The bound program, vertex array,
+	// framebuffers and textures, enabled capabilities, the blend function, depth and color masks and the viewport.
+	// Calls that would not change the state are skipped and queries are answered from the copy, so neither reaches
+	// the driver. GL state belongs to a context, so every gl::Context has its own cache.
+	// Values are read from GL the first time they are needed. Code that changes this state without the cache has to
+	// call invalidate() afterwards; the editor and the immediate renderer do so at the start of every frame.
+	class StateCache {
+	public:
+		static constexpr int MaxDrawBuffers = 8;
+
+		struct Statistics {
+			// State changes requested through the cache and how many of them were skipped
+			size_t calls = 0;
+			size_t skipped = 0;
+			// Queries answered without asking GL
+			size_t queries = 0;
+		};
+
+		StateCache();
+
+		StateCache(const StateCache&) = delete;
+		StateCache& operator=(const StateCache&) = delete;
+
+		// Forgets the shadowed state, it is read from GL again once it is needed
+		void invalidate();
+
+		void useProgram(GLuint program);
+		GLuint program();
+
+		void bindVertexArray(GLuint vertexArray);
+		GLuint vertexArray();
+
+		// GL_FRAMEBUFFER binds both the draw and the read framebuffer
+		void bindFramebuffer(GLenum target, GLuint framebuffer);
+		GLuint framebuffer(GLenum target = GL_DRAW_FRAMEBUFFER);
+
+		void activeTexture(int unit);
+		int activeTexture();
+		// Binds to the given unit or to the active one if unit is negative. The active unit changes only if needed
+		void bindTexture(GLenum target, GLuint texture, int unit = -1);
+		GLuint texture(GLenum target, int unit = -1);
+
+		void enable(GLenum cap);
+		void disable(GLenum cap);
+		void setEnabled(GLenum cap, bool enabled);
+		bool isEnabled(GLenum cap);
+
+		void blendFunc(GLenum src, GLenum dst);
+		std::pair<GLenum, GLenum> blendFunc();
+
+		void depthFunc(GLenum func);
+		GLenum depthFunc();
+		void depthMask(bool enabled);
+		bool depthMask();
+
+		// Sets the mask of all draw buffers
+		void colorMask(bool r, bool g, bool b, bool a);
+		void colorMask(GLuint buffer, bool r, bool g, bool b, bool a);
+		glm::bvec4 colorMask(GLuint buffer = 0);
+
+		void viewport(int x, int y, int width, int height);
+		glm::ivec4 viewport();
+
+		// Call these after deleting objects, GL unbinds them on deletion and their names may be reused
+		void textureDeleted(GLuint texture);
+		void vertexArrayDeleted(GLuint vertexArray);
+		void framebufferDeleted(GLuint framebuffer);
+
+		const Statistics& statistics() const;
+		void resetStatistics();
+
+		// Cache of the current gl::Context. Without one a cache shared by all contexts is returned
+		static StateCache& Current();
+
+	protected:
+		template<typename T>
+		struct Cached {
+			T value;
+			bool known = false;
+		};
+
+		// Returns true and counts the skipped call if the cached value is known and equal
+		template<typename T>
+		bool unchanged(Cached<T>& cached, const T& value) {
+			++mStatistics.calls;
+			if (cached.known && cached.value == value) {
+				++mStatistics.skipped;
+				return true;
+			}
+			cached.value = value;
+			cached.known = true;
+			return false;
+		}
+
+		static uint64_t textureKey(GLenum target, int unit) {
+			return (static_cast<uint64_t>(unit) << 32) | target;
+		}
+
+		Cached<GLuint> mProgram;
+		Cached<GLuint> mVertexArray;
+		Cached<GLuint> mDrawFramebuffer;
+		Cached<GLuint> mReadFramebuffer;
+		Cached<int> mActiveTexture;
+		std::unordered_map<uint64_t, Cached<GLuint>> mTextures;
+		std::unordered_map<GLenum, Cached<bool>> mCapabilities;
+		Cached<std::pair<GLenum, GLenum>> mBlendFunc;
+		Cached<GLenum> mDepthFunc;
+		Cached<bool> mDepthMask;
+		Cached<glm::bvec4> mColorMasks[MaxDrawBuffers];
+		Cached<glm::ivec4> mViewport;
+		Statistics mStatistics;
+	};
+}
@@ -3,7 +3,19 @@
 #include <glad/glad.h>
 #include "glpp/imgui.hpp"
 
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
+
+// S3TC is not part of core OpenGL, so a loader generated for the core profile may lack its tokens
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
 
 namespace gl {
 	typedef int TextureFlags;
@@ -16,7 +28,9 @@ namespace gl {
 
 	enum class PixelType {
 		Float = GL_FLOAT,
+		Half = GL_HALF_FLOAT,
 		UByte = GL_UNSIGNED_BYTE,
+		UShort = GL_UNSIGNED_SHORT,	// Normalized like UByte, e.g. for 16 bit scans
 		UInt  = GL_UNSIGNED_INT,
 		UIntByte = GL_UNSIGNED_INT_24_8,
 	};
@@ -33,10 +47,21 @@ namespace gl {
 		Default = 0
 	};
 
+	// Block compressed formats. Every format stores blocks of 4x4 pixels
+	enum class CompressedFormat {
+		BC1 = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,		// RGB, 8 bytes per block
+		BC3 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,		// RGBA, 16 bytes per block
+		BC4 = GL_COMPRESSED_RED_RGTC1,				// Red, 8 bytes per block
+		BC5 = GL_COMPRESSED_RG_RGTC2,				// RG, 16 bytes per block
+		BC7 = GL_COMPRESSED_RGBA_BPTC_UNORM,		// RGBA, 16 bytes per block
+		None = 0
+	};
+
 	enum class TextureType {
 		D1 = GL_TEXTURE_1D,
 		D2 = GL_TEXTURE_2D,
-		D3 = GL_TEXTURE_3D
+		D3 = GL_TEXTURE_3D,
+		D2Array = GL_TEXTURE_2D_ARRAY
 	};
 
 	enum class WrapType {
@@ -74,15 +99,46 @@ namespace gl {
 		TextureFlags_Force_Init             = (0x0 << 6),
 		TextureFlags_Lazy_Init              = (0x1 << 6),
 
+		TextureFlags_Deferred_Mipmap        = (0x1 << 7), // Mipmaps are generated the next time the texture is bound to a texture unit
+		TextureFlags_Compress               = (0x1 << 8), // Images loaded from a file are block compressed (see texture_compression.hpp)
+		TextureFlags_Immutable_Storage      = (0x1 << 9), // Storage is allocated with glTexStorage, resizing replaces the texture object (and its id)
+
 		TextureFlags_FrameBuffer_Texture    = TextureFlags_No_Mipmap | TextureFlags_Filter_Nearest  // This is a shorthand to create textures ready to use in a framebuffer
 	};
 
 	constexpr GLenum getGLFormat(PixelFormat format) {
 		return static_cast<GLenum>(format);
 	}
+	// Format of pixel transfers, UInt textures are integer textures and are transferred with the *_INTEGER formats
+	constexpr GLenum getGLFormat(PixelFormat format, PixelType type) {
+		if (type != PixelType::UInt) {
+			return getGLFormat(format);
+		}
+		switch (format) {
+		case PixelFormat::Red:
+			return GL_RED_INTEGER;
+		case PixelFormat::RG:
+			return GL_RG_INTEGER;
+		case PixelFormat::RGB:
+			return GL_RGB_INTEGER;
+		case PixelFormat::BGR:
+			return GL_BGR_INTEGER;
+		case PixelFormat::RGBA:
+			return GL_RGBA_INTEGER;
+		case PixelFormat::BGRA:
+			return GL_BGRA_INTEGER;
+		default:
+			return getGLFormat(format);
+		}
+	}
 	GLenum getGlSizedFormat(PixelFormat format, PixelType type);
+	constexpr GLenum getGlSizedFormat(CompressedFormat format) {
+		return static_cast<GLenum>(format);
+	}
 
 	int getChannelsForFormat(PixelFormat format);
+	// Returns the size of a single pixel in bytes
+	size_t getPixelSize(PixelFormat format, PixelType type);
 
 	class TextureBase {
 	public:
@@ -99,6 +155,8 @@ namespace gl {
 		virtual gl::WrapType wrap(int dim) const;
 		virtual gl::FilterType magFilter() const;
 		virtual gl::FilterType minFilter() const;
+		gl::CompressedFormat compression() const;
+		bool isCompressed() const;
 
 		// Properties
 		const int& rows;
@@ -121,6 +179,7 @@ namespace gl {
 		TextureType mTextureType;
 		PixelType mDataType;
 		PixelFormat mPixelFormat;
+		CompressedFormat mCompression;
 	};
 
 	class Texture : public TextureBase {
@@ -129,9 +188,15 @@ namespace gl {
 		Texture(int cols, PixelFormat pixelFormat, gl::PixelType dataType, TextureFlags flags = 0);
 		// Creates a 2D-Texture
 		Texture(int cols, int rows, PixelFormat pixelFormat = gl::PixelFormat::RGBA, gl::PixelType dataType = gl::PixelType::UByte, TextureFlags flags = 0);
+		// Loads an image file. DDS and KTX files are uploaded as they are (they are stored top row first, so flipY is ignored).
+		// Other images are block compressed if TextureFlags_Compress is set
 		Texture(std::string path, bool flipY = true, TextureFlags flags = 0);
+		// Creates a block compressed 2D-Texture. setData compresses the pixels on the CPU
+		Texture(int cols, int rows, CompressedFormat compression, TextureFlags flags = 0);
 		// Creates a 3D-Texture
 		Texture(int cols, int rows, int depth, PixelFormat pixelFormat, gl::PixelType dataType, TextureFlags flags = 0);
+		// Creates a texture of any type. depth is the number of layers for TextureType::D2Array
+		Texture(TextureType type, int cols, int rows, int depth, PixelFormat pixelFormat, gl::PixelType dataType, TextureFlags flags = 0);
 		
 		~Texture();
 
@@ -141,12 +206,31 @@ namespace gl {
 		// Implemented and new Setter functions
 		void createMipmap(bool shouldCreate);
 		virtual void setData(const void* data, PixelFormat format = PixelFormat::Default) override;
+		// Replaces a region of a 2D texture or of a single layer z of an array texture
+		void setSubData(const void* data, int x, int y, int z, int w, int h, PixelFormat format = PixelFormat::Default);
+		// Uploads float data, converting it to half floats first if the texture stores PixelType::Half
+		void setFloatData(const float* data, PixelFormat format = PixelFormat::Default);
+		// Copies data into a pixel unpack buffer and returns without waiting for the upload to finish
+		void setDataAsync(const void* data, PixelFormat format = PixelFormat::Default);
 		virtual void setFilters(gl::FilterType minFilter, gl::FilterType magFilter) override;
 		virtual void setWrapping(gl::WrapType s, gl::WrapType t = gl::WrapType::None, gl::WrapType r = gl::WrapType::None) override;
 		void resize(int cols, int rows = -1, int depth = -1);
+		// Resizes the texture and changes its pixel format and type. The content is undefined afterwards
+		void reallocate(int cols, int rows, PixelFormat pixelFormat, gl::PixelType dataType);
+		// Generates mipmaps that were deferred by an earlier upload (see TextureFlags_Deferred_Mipmap)
+		void updateMipmap();
+		// Uploads block compressed data of a single mip level (the texture must have been created compressed)
+		void setCompressedData(const void* blocks, size_t sizeInBytes, int level = 0);
 
 		// Download functions
 		void download(void* dst, gl::PixelFormat format = gl::PixelFormat::Default, int level = 0);
+		// Downloads a float or half float texture as floats
+		void downloadFloat(float* dst, gl::PixelFormat format = gl::PixelFormat::Default, int level = 0);
+		// Reads a mip level (or a region of a 2D mip level) into a pixel pack buffer without waiting for the GPU.
+		// dst is filled once gl::DownloadQueue::Default() noticed that the GPU finished, then the future becomes ready
+		// and onFinished is called. dst must stay valid until then
+		std::future<void> downloadAsync(void* dst, int level = 0, gl::PixelFormat format = gl::PixelFormat::Default, std::function<void()> onFinished = nullptr);
+		std::future<void> downloadAsync(void* dst, int x, int y, int w, int h, int level = 0, gl::PixelFormat format = gl::PixelFormat::Default, std::function<void()> onFinished = nullptr);
 
 		void bind(int slot = -1);
 		void bindAsImage(int slot, gl::Access access = gl::Access::ReadAndWrite);
@@ -154,19 +238,36 @@ namespace gl {
 
 		// New getters
 		bool hasMipmap() const;
+		// Storage allocated with glTexStorage, e.g. to create texture views of it
+		bool hasImmutableStorage() const;
 
 		const GLuint& id;
 
 	protected:
 		Texture(TextureType type, PixelFormat pixelFormat, gl::PixelType dataType, TextureFlags flags);
 		void init();
+		void loadCompressed(const std::string& path, bool flipY, TextureFlags flags);
+		int numLevels() const;
+		// Allocates immutable storage of the current size for the bound texture
+		void allocateStorage();
+		// Issues the glTexSubImage call for the bound texture. data is an offset if a pixel unpack buffer is bound
+		void upload(const void* data, PixelFormat format);
 
 		GLuint mId;
 		bool mCreateMipmap;
+		bool mDeferMipmap;
+		bool mMipmapDirty;
+		bool mImmutable;
 	};
 
 	// Implements a texture that is too large to be stored in a single OpenGL texture
 	// Currently only implemented for 2D-Textures
+	// Besides the full resolution tiles, a pyramid of downsampled levels is kept (each level halves the resolution)
+	// until a level fits into a single tile. Drawing code should pick the level matching the on-screen size.
+	// If created with TextureFlags_Lazy_Init the texture is paged: The pixels are kept in a tiled cache file on disk
+	// and a tile only becomes resident once it is requested (e.g. because it is visible). The memory of all resident
+	// tiles is bound by a budget and the least recently used tiles are evicted first. The coarsest level is always
+	// resident and can be used in place of missing tiles.
 	class LargeTexture : public TextureBase {
 	public:
 		constexpr static int MaxTileSize = 2048;
@@ -182,22 +283,69 @@ namespace gl {
 		virtual void setWrapping(gl::WrapType s, gl::WrapType t = gl::WrapType::None, gl::WrapType r = gl::WrapType::None) override;
 		virtual int dimensions() const override;
 
+		// Streams every tile through a pixel unpack buffer and returns without waiting for the uploads to finish.
+		// The coarser levels are filtered on a worker of gl::TextureLoader::Default() and uploaded once they are done
+		void setDataAsync(const void* data, PixelFormat format = PixelFormat::Default);
+
 		// New getters
 		size_t numTiles() const;
-		std::pair<int, int> tileSize(int i, int j) const;
-
-		ImTextureID getTileID(int i, int j) const;
-		ImVec2 getRelativePos(int i, int j) const;
+		std::pair<int, int> tileSize(int i, int j, int level = 0) const;
+
+		ImTextureID getTileID(int i, int j, int level = 0) const;
+		ImVec2 getRelativePos(int i, int j, int level = 0) const;
+
+		// Pyramid levels
+		int numLevels() const;
+		int levelColTiles(int level) const;
+		int levelRowTiles(int level) const;
+		// Returns the finest level that is not sampled below the resolution needed to draw the texture with the given size
+		int selectLevel(ImVec2 screenSize) const;
+
+		// Paged textures
+		bool isPaged() const;
+		bool isTileResident(int i, int j, int level = 0) const;
+		// Marks the tile as used in the current frame and schedules loading it if it is not resident
+		void requestTile(int i, int j, int level = 0);
+		// Requests all tiles of a level intersecting the region given in relative coordinates
+		void requestRegion(ImVec2 min, ImVec2 max, int level = 0);
+		// The single tile of the coarsest level. It is always resident
+		ImTextureID getOverviewID() const;
+		void setResidencyBudget(size_t bytes);
+		size_t residencyBudget() const;
+		size_t residentBytes() const;
+
+		// Decodes the image and writes the tiled cache file used by paged textures unless it already exists.
+		// This is thread safe, so it can run on a worker thread before constructing the texture. Returns the cache file
+		static std::string BuildTileCache(const std::string& path, bool flipY = true);
 
 		// Properties
 		int& rowTiles;
 		int& colTiles;
 
 	protected:
-		void init();
+		struct PageTable;
+		struct Level {
+			int cols, rows;
+			int colTiles, rowTiles;
+			int firstTile;	// Index of the first tile of this level in mIds
+		};
 
-		std::vector<GLuint> mIds;
+		void init();
+		void initPages(const std::string& cacheFile, bool ownsCacheFile);
+		void uploadLevels(const void* data, PixelFormat format, bool async);
+		void uploadLevel(int level, const unsigned char* data, PixelFormat format, bool async);
+		void uploadTile(int tile, const void* data, size_t rowLength, PixelFormat format, bool async);
+		void onTileLoaded(int tile, const std::vector<unsigned char>& pixels);
+		void evictTiles();
+		GLuint createTile(int w, int h);
+		int tileIndex(int i, int j, int level) const;
+		std::pair<int, int> tileSize(int tile) const;
+
+		std::vector<Level> mLevels;
+		std::vector<GLuint> mIds;	// Tiles of all levels, starting with the full resolution level
 		int mRowTiles, mColTiles;
-
+		std::shared_ptr<PageTable> mPages;
+		// Replaced by every upload, so levels that are still filtered in the background for an older one are dropped
+		std::shared_ptr<int> mLevelsToken;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "glpp/texture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace gl {
+
+	// Packs many small images of the same format into the layers of a single GL_TEXTURE_2D_ARRAY,
+	// so draws using different images can be merged into one. Every image is referenced by a handle
+	// whose layer and uv rectangle are passed to the shader, which samples with
+	//     texture(atlas, vec3(mix(uvRect.xy, uvRect.zw, uv), layer))
+	// Images are placed on shelves (rows of images with a common height) and can be inserted and removed at any time.
+	// If all layers are full, the number of layers is doubled until maxLayers is reached.
+	// With mipmaps enabled in the flags they are generated the next time the texture is bound to a unit, not per insert.
+	class TextureAtlas {
+	public:
+		typedef int Handle;
+		constexpr static Handle InvalidHandle = -1;
+
+		// padding is the number of pixels around every image that repeat its border, so linear filtering does not bleed
+		TextureAtlas(int pageSize = 2048, PixelFormat pixelFormat = PixelFormat::RGBA, PixelType dataType = PixelType::UByte,
+			int maxLayers = 16, int padding = 1, TextureFlags flags = TextureFlags_No_Mipmap);
+
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		// Copies the image into the atlas. Returns InvalidHandle if it does not fit
+		Handle insert(int cols, int rows, const void* data, PixelFormat format = PixelFormat::Default);
+		// Frees the space of the image. The handle may be handed out again afterwards
+		void remove(Handle handle);
+		bool contains(Handle handle) const;
+
+		// Returns (u0, v0, u1, v1) of the image within its layer
+		glm::vec4 uvRect(Handle handle) const;
+		int layer(Handle handle) const;
+
+		// The array texture. It is replaced when the atlas grows, so do not hold on to it across inserts
+		std::shared_ptr<gl::Texture> texture() const;
+		int pageSize() const;
+		int layers() const;
+		int size() const;
+		// Ratio of the area used by images (including their padding) to the area of all layers
+		float occupancy() const;
+
+	protected:
+		struct Slot {
+			int x, width;
+			Handle handle;	// InvalidHandle for free space
+		};
+		struct Shelf {
+			int y, height;
+			int end;	// Everything right of end is free
+			std::vector<Slot> slots;
+		};
+		struct Entry {
+			int layer = -1, shelf = -1;
+			int x = 0, y = 0, cols = 0, rows = 0;
+		};
+
+		bool place(int layer, int width, int height, Handle handle);
+		void grow();
+		void upload(const Entry& entry, const void* data, PixelFormat format);
+
+		int mPageSize;
+		int mMaxLayers;
+		int mPadding;
+		TextureFlags mFlags;
+		PixelFormat mPixelFormat;
+		PixelType mDataType;
+		std::shared_ptr<gl::Texture> mTexture;
+		std::vector<std::vector<Shelf>> mShelves;	// Shelves of every layer sorted by y
+		std::vector<Entry> mEntries;
+		std::vector<Handle> mFreeHandles;
+		size_t mUsedArea;
+		int mSize;
+	};
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "glpp/texture.hpp"
+
+#include <string>
+#include <vector>
+
+namespace gl {
+
+	// Block compressed image living in host memory
+	struct CompressedImage {
+		CompressedFormat format = CompressedFormat::None;
+		int cols = 0;
+		int rows = 0;
+		std::vector<std::vector<unsigned char>> levels;	// Blocks of every mip level, starting with the full resolution
+	};
+
+	// Returns the size of a single 4x4 block in bytes
+	size_t getBlockSize(CompressedFormat format);
+	// Returns the size of an image with the given size in bytes
+	size_t getCompressedSize(CompressedFormat format, int cols, int rows);
+	// Returns the pixel format a compressed format decodes to
+	PixelFormat getDecodedFormat(CompressedFormat format);
+	// Picks the compressed format used for images of the given format (BC4 for Red, BC5 for RG and BC7 otherwise)
+	CompressedFormat getDefaultCompression(PixelFormat format);
+
+	// Compresses 8 bit pixels. Missing channels are treated as 0 (and alpha as 255).
+	// mipmaps adds the full mip chain, which is downsampled with a box filter before compressing.
+	// The blocks are encoded on numThreads threads (<= 0 uses all hardware threads).
+	// BC1 and BC3 use a bounding box fit, BC7 only uses mode 6 (a single RGBA subset), which is fast and good enough for most textures.
+	CompressedImage compressImage(const void* pixels, int cols, int rows, PixelFormat format, CompressedFormat compression, bool mipmaps = true, int numThreads = 0);
+	// Same as compressImage but the result is stored in a cache on disk, which is keyed by a hash of the content.
+	// Encoding the same pixels again only costs hashing them and reading the cached file
+	CompressedImage compressImageCached(const void* pixels, int cols, int rows, PixelFormat format, CompressedFormat compression, bool mipmaps = true);
+
+	// Loads a DDS or KTX (version 1) file containing a 2D image in one of the supported formats.
+	// Throws a std::runtime_error if the file can not be read or uses an unsupported format.
+	CompressedImage loadCompressedImage(const std::string& path);
+	// Writes the image as DDS file with a DX10 header
+	void saveDDS(const std::string& path, const CompressedImage& image);
+}
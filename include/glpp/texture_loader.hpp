@@ -0,0 +1,94 @@
+#pragma once
+
+#include "glpp/texture.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace gl {
+
+	// Decoded image living in host memory
+	struct ImageData {
+		int cols = 0;
+		int rows = 0;
+		PixelFormat format = PixelFormat::RGBA;
+		PixelType type = PixelType::UByte;
+		std::vector<unsigned char> pixels;
+	};
+
+	// Decodes an image file using stb_image. 8 bit RGB images are expanded to RGBA,
+	// so every row is 4 byte aligned and can be uploaded with the default unpack alignment.
+	// Throws a std::runtime_error if the file could not be decoded. This function is thread safe.
+	ImageData decodeImage(const std::string& path, bool flipY = true);
+
+	// Decodes images on a pool of worker threads and hands the results back to the GL thread.
+	// Finished jobs are only uploaded during update(), which should be called once per frame.
+	class TextureLoader {
+	public:
+		typedef std::function<void(std::shared_ptr<gl::Texture> texture, bool success)> TextureCallback;
+		typedef std::function<void(std::shared_ptr<gl::ImageData> image)> ImageCallback;
+
+		// numThreads <= 0 uses all but one hardware thread
+		TextureLoader(int numThreads = 0);
+		~TextureLoader();
+
+		// Returns a 1x1 placeholder texture right away. The image is decoded in the background
+		// and replaces the placeholder once it was uploaded. onLoaded is called on the GL thread.
+		std::shared_ptr<gl::Texture> load(const std::string& path, bool flipY = true, TextureFlags flags = 0, TextureCallback onLoaded = nullptr);
+		// Decodes the image in the background. onDecoded is called on the GL thread with nullptr if decoding failed.
+		void loadImage(const std::string& path, bool flipY, ImageCallback onDecoded);
+		// Runs work on a worker thread and onFinished on the GL thread during update().
+		// work returns the number of bytes onFinished will upload, which is charged against the upload budget.
+		void enqueue(std::function<size_t()> work, std::function<void()> onFinished);
+
+		// Runs finished jobs on the GL thread until the upload budget of this frame is used up.
+		// At least one job is finished per call, so large images do not get stuck.
+		void update();
+
+		// Number of jobs that have not been finished on the GL thread yet
+		size_t pending() const;
+		// Number of jobs finished on the GL thread so far, e.g. to notice that textures changed
+		size_t finished() const;
+		// Number of jobs the workers are done with that wait for update()
+		size_t ready() const;
+
+		// Sets the function a worker thread calls whenever a job is ready to be finished (e.g. to wake up an idle
+		// render loop) and returns the previous one. Calls of the previous one that already started may still be running
+		std::function<void()> setOnJobReady(std::function<void()> onJobReady);
+
+		// Bytes that may be uploaded per call of update()
+		size_t uploadBudget;
+
+		// Loader shared by the framework. Its update() is called by the renderers once per frame.
+		static TextureLoader& Default();
+
+	protected:
+		struct Job {
+			std::function<size_t()> work;
+			std::function<void()> onFinished;
+			size_t uploadSize = 0;
+		};
+
+		void startWorkers();
+		void workerLoop();
+
+		int mNumThreads;
+		std::vector<std::thread> mWorkers;
+		std::deque<Job> mQueued;
+		std::deque<Job> mFinished;
+		mutable std::mutex mMutex;
+		std::condition_variable mCondition;
+		std::function<void()> mOnJobReady;
+		std::atomic<size_t> mPending;
+		size_t mFinishedJobs;
+		bool mShutdown;
+	};
+
+}
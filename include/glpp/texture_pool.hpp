@@ -0,0 +1,36 @@
+#pragma once
+
+#include "glpp/texture.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace gl {
+
+	// Keeps textures around for reuse, e.g. as intermediate results of a chain of filters.
+	// A texture is free again as soon as the pool holds the only reference to it, so textures never have to be returned.
+	class TexturePool {
+	public:
+		TexturePool(TextureFlags flags = TextureFlags_FrameBuffer_Texture);
+
+		TexturePool(const TexturePool&) = delete;
+		TexturePool& operator=(const TexturePool&) = delete;
+
+		// Returns a free texture of the given size and format or creates a new one. Its content is undefined
+		std::shared_ptr<gl::Texture> acquire(int cols, int rows, PixelFormat pixelFormat, PixelType dataType);
+		// Deletes all textures that are not in use
+		void trim();
+
+		// Number of textures owned by the pool and the number of those in use
+		size_t size() const;
+		size_t inUse() const;
+
+		// Pool shared by the framework
+		static TexturePool& Default();
+
+	protected:
+		TextureFlags mFlags;
+		std::vector<std::shared_ptr<gl::Texture>> mTextures;
+	};
+
+}
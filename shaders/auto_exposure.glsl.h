@@ -0,0 +1,89 @@
+#pragma once
+
+// Sorts the pixels of an HDR image into 256 bins of log luminance. Bin 0 holds pixels that are (nearly) black.
+// Every workgroup counts its pixels in shared memory first, so only one global atomic per bin and group is needed.
+static const char* LUMINANCE_HISTOGRAM_CS = R"(
+#version 430
+layout(local_size_x = 16, local_size_y = 16) in;
+
+uniform sampler2D hdrTexture;
+uniform float minLogLuminance;
+uniform float inverseLogLuminanceRange;
+uniform vec2 size;		// Measured part of the texture
+
+layout(std430, binding = 0) buffer Histogram { uint bins[256]; };
+
+shared uint localBins[256];
+
+uint luminanceBin(vec3 color) {
+	float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+	// Written this way round so NaN ends up in the black bin as well
+	if (!(luminance >= 1e-5)) {
+		return 0;
+	}
+	float t = clamp((log2(luminance) - minLogLuminance) * inverseLogLuminanceRange, 0.0, 1.0);
+	return uint(t * 254.0 + 1.0);
+}
+
+void main() {
+	localBins[gl_LocalInvocationIndex] = 0;
+	barrier();
+
+	ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	if (all(lessThan(pixel, ivec2(size)))) {
+		atomicAdd(localBins[luminanceBin(texelFetch(hdrTexture, pixel, 0).rgb)], 1);
+	}
+	barrier();
+
+	uint count = localBins[gl_LocalInvocationIndex];
+	if (count > 0) {
+		atomicAdd(bins[gl_LocalInvocationIndex], count);
+	}
+}
+)";
+
+// Averages the histogram, moves the adapted luminance towards it and clears the histogram for the next frame.
+// Black pixels are ignored, otherwise a mostly empty viewport would be overexposed.
+static const char* EXPOSURE_CS = R"(
+#version 430
+layout(local_size_x = 256) in;
+
+uniform float minLogLuminance;
+uniform float logLuminanceRange;
+uniform float pixelCount;
+uniform float adaptation;
+uniform float keyValue;
+
+layout(std430, binding = 0) buffer Histogram { uint bins[256]; };
+layout(std430, binding = 1) buffer Exposure { float averageLuminance; float exposure; };
+
+shared float weighted[256];
+
+void main() {
+	uint i = gl_LocalInvocationIndex;
+	uint count = bins[i];
+	weighted[i] = float(count) * float(i);
+	bins[i] = 0;
+	barrier();
+
+	for (uint s = 128; s > 0; s >>= 1) {
+		if (i < s) {
+			weighted[i] += weighted[i + s];
+		}
+		barrier();
+	}
+
+	if (i == 0) {
+		float lit = pixelCount - float(count);
+		if (lit < 1.0) {
+			return;
+		}
+		float logAverage = (weighted[0] / lit - 1.0) / 254.0 * logLuminanceRange + minLogLuminance;
+		float luminance = exp2(logAverage);
+		float previous = averageLuminance;
+		float adapted = previous > 0.0 ? previous + (luminance - previous) * adaptation : luminance;
+		averageLuminance = adapted;
+		exposure = keyValue / adapted;
+	}
+}
+)";
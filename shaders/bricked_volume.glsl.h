@@ -0,0 +1,25 @@
+#pragma once
+
+// Samples a gl::BrickedVolume. Insert the code right after the #version directive and set the uniforms with
+// gl::BrickedVolume::bind. Every full resolution brick has an entry in the page table, which points to the finest
+// resident brick covering it, so missing bricks are replaced by coarser levels of detail.
+static const char* BRICKED_VOLUME_GLSL = R"(
+#define BRICK_SIZE 32
+#define BRICK_PAYLOAD 30
+
+uniform sampler3D brickPool;
+uniform sampler3D brickTable;	// Pool slot (rgb) and level of detail (a) of every full resolution brick
+uniform vec3 volumeSize;		// Voxels of the full resolution level
+uniform vec3 brickPoolSize;		// Voxels of the pool
+
+// p is given in texture space
+float sampleBrickedVolume(vec3 p) {
+	vec3 voxel = clamp(p, 0.0, 1.0) * volumeSize;
+	ivec3 entry = min(ivec3(voxel) / BRICK_PAYLOAD, textureSize(brickTable, 0) - 1);
+	ivec4 page = ivec4(texelFetch(brickTable, entry, 0) * 255.0 + 0.5);
+	// Position inside the payload of the brick on its level. The apron of one voxel keeps the filter inside the brick
+	vec3 local = voxel / float(1 << page.a) - vec3((entry >> page.a) * BRICK_PAYLOAD);
+	local = clamp(local, vec3(0.0), vec3(BRICK_PAYLOAD));
+	return texture(brickPool, (vec3(page.rgb * BRICK_SIZE) + 1.0 + local) / brickPoolSize).r;
+}
+)";
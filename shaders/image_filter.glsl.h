@@ -0,0 +1,190 @@
+#pragma once
+
+// Compute shaders of gl::ImageFilter. IMAGE_FORMAT (the format qualifier of the target image) and, where needed,
+// AXIS (0 = rows, 1 = columns) are defined in front of the code. The source is always read with texelFetch.
+
+// Separable 1D pass along AXIS. OPERATION 0 convolves with the weights, 1 takes the minimum and 2 the maximum
+// of the window (erosion / dilation). If TILED is defined, every workgroup loads the pixels it needs into shared
+// memory once, instead of every invocation fetching 2 * radius + 1 texels.
+static const char* SEPARABLE_FILTER_CS = R"(
+#define GROUP_SIZE 256
+#define MAX_TILED_RADIUS 256
+
+#if AXIS == 0
+layout(local_size_x = GROUP_SIZE, local_size_y = 1) in;
+#else
+layout(local_size_x = 1, local_size_y = GROUP_SIZE) in;
+#endif
+
+uniform sampler2D source;
+layout(IMAGE_FORMAT, binding = 0) writeonly uniform image2D target;
+layout(std430, binding = 0) readonly buffer Kernel { float weights[]; };
+uniform int radius;
+
+#ifdef TILED
+shared vec4 tile[GROUP_SIZE + 2 * MAX_TILED_RADIUS];
+#endif
+
+vec4 fetch(ivec2 p, ivec2 size) {
+	return texelFetch(source, clamp(p, ivec2(0), size - 1), 0);
+}
+
+void main() {
+	ivec2 size = textureSize(source, 0);
+	ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 axis = AXIS == 0 ? ivec2(1, 0) : ivec2(0, 1);
+	int local = int(gl_LocalInvocationIndex);
+
+#ifdef TILED
+	ivec2 first = ivec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy) - axis * radius;
+	for (int i = local; i < GROUP_SIZE + 2 * radius; i += GROUP_SIZE) {
+		tile[i] = fetch(first + axis * i, size);
+	}
+	barrier();
+#endif
+	if (any(greaterThanEqual(pixel, size))) {
+		return;
+	}
+
+#if OPERATION == 0
+	vec4 result = vec4(0);
+#elif OPERATION == 1
+	vec4 result = vec4(3.402823466e+38);
+#else
+	vec4 result = vec4(-3.402823466e+38);
+#endif
+	for (int k = -radius; k <= radius; ++k) {
+#ifdef TILED
+		vec4 v = tile[local + radius + k];
+#else
+		vec4 v = fetch(pixel + axis * k, size);
+#endif
+#if OPERATION == 0
+		result += v * weights[k + radius];
+#elif OPERATION == 1
+		result = min(result, v);
+#else
+		result = max(result, v);
+#endif
+	}
+	imageStore(target, pixel, result);
+}
+)";
+
+// Resamples along AXIS. When shrinking, the filter is widened by the scale factor, so every source pixel contributes.
+// FILTER 0 is a triangle (bilinear), 1 is Lanczos with three lobes.
+static const char* RESAMPLE_CS = R"(
+#define PI 3.14159265359
+layout(local_size_x = 16, local_size_y = 16) in;
+
+uniform sampler2D source;
+layout(IMAGE_FORMAT, binding = 0) writeonly uniform image2D target;
+uniform float scale;
+
+#if FILTER == 0
+#define SUPPORT 1.0
+float kernel(float x) {
+	return max(1.0 - abs(x), 0.0);
+}
+#else
+#define SUPPORT 3.0
+float kernel(float x) {
+	x = abs(x);
+	if (x < 1e-5) {
+		return 1.0;
+	}
+	if (x >= 3.0) {
+		return 0.0;
+	}
+	return 3.0 * sin(PI * x) * sin(PI * x / 3.0) / (PI * PI * x * x);
+}
+#endif
+
+void main() {
+	ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(pixel, imageSize(target)))) {
+		return;
+	}
+	ivec2 size = textureSize(source, 0);
+	float center = (float(pixel[AXIS]) + 0.5) * scale;
+	float stretch = max(scale, 1.0);
+	int first = int(floor(center - SUPPORT * stretch));
+	int last = int(ceil(center + SUPPORT * stretch));
+
+	vec4 sum = vec4(0);
+	float weightSum = 0.0;
+	for (int i = first; i <= last; ++i) {
+		float w = kernel((float(i) + 0.5 - center) / stretch);
+		ivec2 p = pixel;
+		p[AXIS] = clamp(i, 0, size[AXIS] - 1);
+		sum += texelFetch(source, p, 0) * w;
+		weightSum += w;
+	}
+	imageStore(target, pixel, weightSum != 0.0 ? sum / weightSum : vec4(0));
+}
+)";
+
+// Writes (dx, dy, magnitude, 1) of the Sobel operator applied to the luminance (or the only channel) of the source
+static const char* SOBEL_CS = R"(
+layout(local_size_x = 16, local_size_y = 16) in;
+
+uniform sampler2D source;
+uniform int channels;
+layout(IMAGE_FORMAT, binding = 0) writeonly uniform image2D target;
+
+float value(ivec2 p, ivec2 size) {
+	vec4 v = texelFetch(source, clamp(p, ivec2(0), size - 1), 0);
+	return channels < 3 ? v.r : dot(v.rgb, vec3(0.2126, 0.7152, 0.0722));
+}
+
+void main() {
+	ivec2 size = textureSize(source, 0);
+	ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(pixel, size))) {
+		return;
+	}
+	float v[9];
+	for (int j = 0; j < 3; ++j) {
+		for (int i = 0; i < 3; ++i) {
+			v[j * 3 + i] = value(pixel + ivec2(i - 1, j - 1), size);
+		}
+	}
+	float dx = (v[2] + 2.0 * v[5] + v[8]) - (v[0] + 2.0 * v[3] + v[6]);
+	float dy = (v[6] + 2.0 * v[7] + v[8]) - (v[0] + 2.0 * v[1] + v[2]);
+	imageStore(target, pixel, vec4(dx, dy, length(vec2(dx, dy)), 1.0));
+}
+)";
+
+// Maps the source through a lookup table. Without PER_CHANNEL the first channel selects a color of the table,
+// otherwise every channel is looked up in the matching channel of the table. LUT_1D selects a sampler1D table.
+static const char* LUT_CS = R"(
+layout(local_size_x = 16, local_size_y = 16) in;
+
+uniform sampler2D source;
+#ifdef LUT_1D
+uniform sampler1D lut;
+#define LOOKUP(t) texture(lut, t)
+#else
+uniform sampler2D lut;
+#define LOOKUP(t) texture(lut, vec2(t, 0.5))
+#endif
+uniform vec2 range;
+uniform int lutSize;
+layout(IMAGE_FORMAT, binding = 0) writeonly uniform image2D target;
+
+void main() {
+	ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+	if (any(greaterThanEqual(pixel, imageSize(target)))) {
+		return;
+	}
+	vec4 v = texelFetch(source, pixel, 0);
+	// Hit the centers of the first and last entry at the ends of the range
+	vec4 t = clamp((v - range.x) / (range.y - range.x), 0.0, 1.0);
+	t = (t * float(lutSize - 1) + 0.5) / float(lutSize);
+#ifdef PER_CHANNEL
+	imageStore(target, pixel, vec4(LOOKUP(t.r).r, LOOKUP(t.g).g, LOOKUP(t.b).b, v.a));
+#else
+	imageStore(target, pixel, LOOKUP(t.r));
+#endif
+}
+)";
@@ -9,18 +9,16 @@ layout (location = 3) in vec2 uv;
 
 uniform mat4 VP;
 
+invariant gl_Position;
+
 out vec4 fcol;
-out vec4 idcol;
+flat out uint fid;
 out vec2 fuv;
 
-vec4 id2col(uint id) {
-	return vec4(float(id % 256) / 255, float((id / 256) % 256) / 255, float(id / (256*256)) / 255, 1.0);
-}
-
 void main() {
 	gl_Position = VP * position;
     fcol = color;
-	idcol = id2col(id);
+	fid = id;
 	fuv = uv;
 }
 )";
@@ -28,12 +26,18 @@ void main() {
 static const char* IMGUI3D_FS = R"(
 #version 430 core
 in vec4 fcol;
-in vec4 idcol;
+flat in uint fid;
 in vec2 fuv;
+#ifdef ID_PASS
+layout(location = 1) out uint Id;
+#else
 layout(location = 0) out vec4 FragColor;
-layout(location = 1) out vec4 IdColor;
+#endif
 
 void main() {
+#ifdef ID_PASS
+	Id = fid;
+#else
 	FragColor = fcol;
-	IdColor = idcol;
-})";
\ No newline at end of file
+#endif
+})";
@@ -0,0 +1,352 @@
+#pragma once
+
+// Marching cubes on the GPU (see gl::IsosurfaceMesh). The work is split into voxel rows along x, which are walked by
+// a single invocation each. Every voxel owns the edges towards its neighbors in +x, +y and +z, so vertices are shared
+// by all triangles using them. The vertices of a row are ordered by voxel and then by axis, which lets triangles
+// compute the index of a vertex from the first vertex of its row and the crossing edges in front of it.
+// Rows are counted, the counts are turned into offsets with an exclusive prefix sum and the rows that contain any
+// vertex or triangle are compacted into a list, which is all the generation pass is dispatched for.
+
+// Code shared by the passes reading the volume, inserted behind the #version directive
+static const char* ISOSURFACE_COMMON_GLSL = R"(
+layout(local_size_x = 64) in;
+
+uniform sampler3D volume;
+uniform float isoValue;
+
+// Corners of a cell relative to its first voxel. Bit i of the case is set if corner i lies above the iso value
+const ivec3 CORNERS[8] = ivec3[8](
+	ivec3(0, 0, 0), ivec3(1, 0, 0), ivec3(1, 1, 0), ivec3(0, 1, 0),
+	ivec3(0, 0, 1), ivec3(1, 0, 1), ivec3(1, 1, 1), ivec3(0, 1, 1));
+
+// Up to five triangles per case given by cell edges, padded with -1
+layout(std430, binding = 1) readonly buffer Triangles { int triangleTable[]; };
+
+float value(ivec3 v) {
+	return texelFetch(volume, v, 0).r;
+}
+
+// Crossing edges owned by a voxel, bit 0 along x, bit 1 along y and bit 2 along z
+uint edgeFlags(ivec3 v, ivec3 size) {
+	bool above = value(v) > isoValue;
+	uint flags = 0u;
+	for (int axis = 0; axis < 3; ++axis) {
+		ivec3 w = v;
+		w[axis] += 1;
+		if (w[axis] < size[axis] && (value(w) > isoValue) != above) {
+			flags |= 1u << axis;
+		}
+	}
+	return flags;
+}
+
+uint cellCase(ivec3 v) {
+	uint c = 0u;
+	for (int i = 0; i < 8; ++i) {
+		if (value(v + CORNERS[i]) > isoValue) {
+			c |= 1u << i;
+		}
+	}
+	return c;
+}
+
+uint numTriangles(uint c) {
+	uint n = 0u;
+	while (n < 5u && triangleTable[c * 16u + n * 3u] >= 0) {
+		++n;
+	}
+	return n;
+}
+)";
+
+// Counts the vertices and triangles of every voxel row (y + z * rows) and marks rows that have any of them
+static const char* ISOSURFACE_COUNT_CS = R"(
+layout(std430, binding = 0) writeonly buffer Rows { uvec4 rows[]; };
+
+void main() {
+	ivec3 size = textureSize(volume, 0);
+	uint row = gl_GlobalInvocationID.x;
+	if (row >= uint(size.y * size.z)) {
+		return;
+	}
+	ivec3 v = ivec3(0, int(row) % size.y, int(row) / size.y);
+	bool cells = v.y < size.y - 1 && v.z < size.z - 1;
+
+	uint vertices = 0u;
+	uint triangles = 0u;
+	for (; v.x < size.x; ++v.x) {
+		vertices += uint(bitCount(edgeFlags(v, size)));
+		if (cells && v.x < size.x - 1) {
+			triangles += numTriangles(cellCase(v));
+		}
+	}
+	rows[row] = uvec4(vertices, triangles, vertices + triangles > 0u ? 1u : 0u, 0u);
+}
+)";
+
+// Exclusive prefix sum of uvec4 values in place. Every workgroup scans ITEMS_PER_GROUP values and writes their total,
+// the totals are scanned the same way and added back by ISOSURFACE_SCAN_ADD_CS until a single group is left
+static const char* ISOSURFACE_SCAN_CS = R"(
+#version 430
+#define GROUP_SIZE 256
+#define ITEMS 4
+
+layout(local_size_x = GROUP_SIZE) in;
+
+layout(std430, binding = 0) buffer Values { uvec4 values[]; };
+layout(std430, binding = 1) writeonly buffer Sums { uvec4 sums[]; };
+
+uniform uint count;
+
+shared uvec4 sTotals[GROUP_SIZE];
+
+void main() {
+	uint lid = gl_LocalInvocationID.x;
+	uint first = (gl_WorkGroupID.x * GROUP_SIZE + lid) * ITEMS;
+
+	uvec4 items[ITEMS];
+	uvec4 total = uvec4(0);
+	for (uint i = 0u; i < ITEMS; ++i) {
+		items[i] = first + i < count ? values[first + i] : uvec4(0);
+		total += items[i];
+	}
+	sTotals[lid] = total;
+	barrier();
+
+	// Inclusive scan of the totals of all invocations
+	for (uint offset = 1u; offset < GROUP_SIZE; offset <<= 1) {
+		uvec4 v = lid >= offset ? sTotals[lid - offset] : uvec4(0);
+		barrier();
+		sTotals[lid] += v;
+		barrier();
+	}
+
+	uvec4 sum = sTotals[lid] - total;
+	for (uint i = 0u; i < ITEMS; ++i) {
+		if (first + i < count) {
+			values[first + i] = sum;
+		}
+		sum += items[i];
+	}
+	if (lid == GROUP_SIZE - 1u) {
+		sums[gl_WorkGroupID.x] = sTotals[lid];
+	}
+}
+)";
+
+static const char* ISOSURFACE_SCAN_ADD_CS = R"(
+#version 430
+#define ITEMS_PER_GROUP 1024u
+
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) buffer Values { uvec4 values[]; };
+layout(std430, binding = 1) readonly buffer Sums { uvec4 sums[]; };
+
+uniform uint count;
+
+void main() {
+	uint i = gl_GlobalInvocationID.x;
+	if (i < count) {
+		values[i] += sums[i / ITEMS_PER_GROUP];
+	}
+}
+)";
+
+// Lists the rows with vertices or triangles and writes the indirect dispatch of the generation pass and the
+// indirect draw. Surfaces that exceed the capacity of the buffers are not drawn
+static const char* ISOSURFACE_COMPACT_CS = R"(
+#version 430
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer Rows { uvec4 rows[]; };
+layout(std430, binding = 1) readonly buffer Totals { uvec4 totals; };
+layout(std430, binding = 2) writeonly buffer ActiveRows { uint activeRows[]; };
+layout(std430, binding = 3) writeonly buffer Commands {
+	uint dispatchCommand[4];
+	uint drawCommand[5];
+};
+
+uniform uint count;
+uniform uint maxVertices;
+uniform uint maxTriangles;
+
+void main() {
+	uint row = gl_GlobalInvocationID.x;
+	if (row == 0u) {
+		bool fits = totals.x <= maxVertices && totals.y <= maxTriangles;
+		dispatchCommand[0] = (totals.z + 63u) / 64u;
+		dispatchCommand[1] = 1u;
+		dispatchCommand[2] = 1u;
+		drawCommand[0] = fits ? totals.y * 3u : 0u;
+		drawCommand[1] = 1u;
+		drawCommand[2] = 0u;
+		drawCommand[3] = 0u;
+		drawCommand[4] = 0u;
+	}
+	if (row >= count) {
+		return;
+	}
+	// The offsets are exclusive, so a row is active if the next one starts further
+	uint next = row + 1u < count ? rows[row + 1u].z : totals.z;
+	if (next != rows[row].z) {
+		activeRows[rows[row].z] = row;
+	}
+}
+)";
+
+// Writes the vertices (position and normal in model space) and triangles of the active rows
+static const char* ISOSURFACE_GENERATE_CS = R"(
+layout(std430, binding = 0) readonly buffer Rows { uvec4 rows[]; };
+layout(std430, binding = 2) readonly buffer ActiveRows { uint activeRows[]; };
+layout(std430, binding = 3) readonly buffer Totals { uvec4 totals; };
+layout(std430, binding = 4) writeonly buffer Vertices { float vertices[]; };
+layout(std430, binding = 5) writeonly buffer Indices { uint indices[]; };
+
+uniform uint maxVertices;
+uniform uint maxTriangles;
+uniform vec3 extent;
+
+// Owner of every cell edge: The voxel row relative to the cell (dy + 2 * dz), the voxel offset along x and the axis
+const ivec3 EDGE_OWNERS[12] = ivec3[12](
+	ivec3(0, 0, 0), ivec3(0, 1, 1), ivec3(1, 0, 0), ivec3(0, 0, 1),
+	ivec3(2, 0, 0), ivec3(2, 1, 1), ivec3(3, 0, 0), ivec3(2, 0, 1),
+	ivec3(0, 0, 2), ivec3(0, 1, 2), ivec3(1, 1, 2), ivec3(1, 0, 2));
+
+vec3 gradient(ivec3 v, ivec3 size) {
+	ivec3 lower = max(v - 1, ivec3(0));
+	ivec3 upper = min(v + 1, size - 1);
+	return vec3(
+		value(ivec3(upper.x, v.y, v.z)) - value(ivec3(lower.x, v.y, v.z)),
+		value(ivec3(v.x, upper.y, v.z)) - value(ivec3(v.x, lower.y, v.z)),
+		value(ivec3(v.x, v.y, upper.z)) - value(ivec3(v.x, v.y, lower.z))) / vec3(max(upper - lower, ivec3(1)));
+}
+
+void emitVertex(uint index, ivec3 v, int axis, ivec3 size) {
+	if (index >= maxVertices) {
+		return;
+	}
+	ivec3 w = v;
+	w[axis] += 1;
+	float a = value(v);
+	float b = value(w);
+	float t = clamp((isoValue - a) / (b - a), 0.0, 1.0);
+	vec3 voxel = mix(vec3(v), vec3(w), t);
+	vec3 position = (voxel + 0.5) / vec3(size) * extent - 0.5 * extent;
+	// The gradient points towards larger values, i.e. into the surface
+	vec3 g = mix(gradient(v, size), gradient(w, size), t) * vec3(size) / extent;
+	vec3 normal = -g / max(length(g), 1e-20);
+
+	uint i = index * 6u;
+	vertices[i] = position.x;
+	vertices[i + 1u] = position.y;
+	vertices[i + 2u] = position.z;
+	vertices[i + 3u] = normal.x;
+	vertices[i + 4u] = normal.y;
+	vertices[i + 5u] = normal.z;
+}
+
+// Position of an edge among the crossing edges owned by its voxel
+uint edgeRank(uint flags, int axis) {
+	return uint(bitCount(flags & ((1u << axis) - 1u)));
+}
+
+void main() {
+	if (gl_GlobalInvocationID.x >= totals.z) {
+		return;
+	}
+	ivec3 size = textureSize(volume, 0);
+	uint row = activeRows[gl_GlobalInvocationID.x];
+	ivec3 v = ivec3(0, int(row) % size.y, int(row) / size.y);
+	bool cells = v.y < size.y - 1 && v.z < size.z - 1;
+
+	// Next vertex index and the crossing edges of the current and the next voxel in this row (0) and the rows
+	// above it (1 along y, 2 along z, 3 along both), which own the remaining edges of the cells
+	uint base[4];
+	uint flags[4];
+	uint nextFlags[4];
+	for (int r = 0; r < 4; ++r) {
+		ivec3 w = ivec3(0, v.y + (r & 1), v.z + (r >> 1));
+		bool touched = r == 0 || cells;
+		base[r] = touched ? rows[w.y + w.z * size.y].x : 0u;
+		flags[r] = touched ? edgeFlags(w, size) : 0u;
+	}
+	uint triangle = rows[row].y;
+
+	for (; v.x < size.x; ++v.x) {
+		for (int r = 0; r < 4; ++r) {
+			ivec3 w = ivec3(v.x + 1, v.y + (r & 1), v.z + (r >> 1));
+			nextFlags[r] = (r == 0 || cells) && w.x < size.x ? edgeFlags(w, size) : 0u;
+		}
+
+		uint index = base[0];
+		for (int axis = 0; axis < 3; ++axis) {
+			if ((flags[0] & (1u << axis)) != 0u) {
+				emitVertex(index++, v, axis, size);
+			}
+		}
+
+		if (cells && v.x < size.x - 1) {
+			uint c = cellCase(v);
+			for (uint t = 0u; t < 5u && triangleTable[c * 16u + t * 3u] >= 0; ++t, ++triangle) {
+				if (triangle >= maxTriangles) {
+					continue;
+				}
+				for (uint j = 0u; j < 3u; ++j) {
+					ivec3 owner = EDGE_OWNERS[triangleTable[c * 16u + t * 3u + j]];
+					uint vertex = owner.y == 0
+						? base[owner.x] + edgeRank(flags[owner.x], owner.z)
+						: base[owner.x] + uint(bitCount(flags[owner.x])) + edgeRank(nextFlags[owner.x], owner.z);
+					indices[triangle * 3u + j] = vertex;
+				}
+			}
+		}
+
+		for (int r = 0; r < 4; ++r) {
+			base[r] += uint(bitCount(flags[r]));
+			flags[r] = nextFlags[r];
+		}
+	}
+}
+)";
+
+// Headlight shading of both sides of the surface
+static const char* ISOSURFACE_VS = R"(
+#version 430
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+
+uniform mat4 MVP;
+uniform mat4 M;
+
+out vec3 worldPosition;
+out vec3 worldNormal;
+
+void main() {
+	gl_Position = MVP * vec4(position, 1.0);
+	worldPosition = (M * vec4(position, 1.0)).xyz;
+	worldNormal = transpose(inverse(mat3(M))) * normal;
+}
+)";
+
+static const char* ISOSURFACE_FS = R"(
+#version 430
+in vec3 worldPosition;
+in vec3 worldNormal;
+
+uniform vec4 color;
+uniform vec3 cameraPosition;
+
+out vec4 FragColor;
+
+void main() {
+	vec3 N = normalize(worldNormal);
+	vec3 L = normalize(cameraPosition - worldPosition);
+	if (dot(N, L) < 0.0) {
+		N = -N;
+	}
+	float diffuse = max(dot(N, L), 0.0);
+	float specular = pow(max(dot(reflect(-L, N), L), 0.0), 30.0);
+	FragColor = vec4(color.rgb * (0.25 + 0.75 * diffuse) + vec3(0.2 * specular), color.a);
+}
+)";
@@ -0,0 +1,140 @@
+#pragma once
+
+// Start of the fragment shaders generated by gl::PostProcessingChain (the version and defines are put in front).
+// The effects and main follow
+static const char* POST_PROCESSING_FS = R"(
+in vec2 texCoord;
+
+uniform sampler2D sourceTexture;
+// Rendered part of a pooled render target, see gl::Framebuffer::textureScale
+uniform vec2 texCoordScale = vec2(1.0);
+uniform vec2 sourceTexelSize;
+
+layout(location = 0) out vec4 FragColor;
+
+// Input of the pass. Samples stay inside the rendered part of the texture
+vec4 sourceColor(vec2 uv) {
+    return texture(sourceTexture, clamp(uv, 0.5 * sourceTexelSize, texCoordScale - 0.5 * sourceTexelSize));
+}
+
+vec3 linearToSRGB(vec3 color) {
+    color = max(color, vec3(0.0));
+    return mix(12.92 * color, 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055, step(vec3(0.0031308), color));
+}
+)";
+
+// HDR Mapping like http://filmicworlds.com/blog/filmic-tonemapping-operators/
+static const char* TONEMAPPING_EFFECT = R"(
+#ifdef AUTO_EXPOSURE
+// Written by gl::AutoExposure
+layout(std430, binding = 3) readonly buffer Exposure { float averageLuminance; float exposure; };
+#else
+const float exposure = 1.0;
+#endif
+
+#if HDR_MAPPING_TYPE == 4
+float A = 0.15;
+float B = 0.50;
+float C = 0.10;
+float D = 0.20;
+float E = 0.02;
+float F = 0.30;
+float W = 11.2;
+
+vec3 Uncharted2Tonemap(vec3 x)
+{
+   return ((x*(A*x+C*B)+D*E)/(x*(A*x+B)+D*F))-E/F;
+}
+#endif
+
+vec4 tonemapping(vec4 color, vec2 texCoord)
+{
+    vec3 texColor = color.rgb * exposure;
+#if HDR_MAPPING_TYPE == 1
+    // Reinhard mapping
+    vec3 mapped = texColor / (texColor + vec3(1.0));
+#elif HDR_MAPPING_TYPE == 3
+    // Jim Hejl and Richard Burgess-Dawson, the gamma is part of the curve
+    vec3 x = max(vec3(0.),texColor-0.004);
+    vec3 mapped = (x*(6.2*x+.5))/(x*(6.2*x+1.7)+0.06);
+#elif HDR_MAPPING_TYPE == 4
+    // Unchartered 2
+    float ExposureBias = 2.0f;
+    vec3 curr = Uncharted2Tonemap(ExposureBias*texColor);
+
+    vec3 whiteScale = vec3(1.0f/Uncharted2Tonemap(vec3(W)));
+    vec3 mapped = curr*whiteScale;
+#else
+    // Linear and Haarm-Peter Duiker, which needs a film LUT that is missing
+    vec3 mapped = texColor;
+#endif
+    return vec4(mapped, 1.0);
+}
+)";
+
+static const char* GAMMA_EFFECT = R"(
+uniform float gamma;
+
+vec4 gammaCorrection(vec4 color, vec2 texCoord)
+{
+    return vec4(pow(max(color.rgb, vec3(0.0)), vec3(1.0 / gamma)), color.a);
+}
+)";
+
+// Sharpens the upscaled image of a lower resolution input after AMD's contrast adaptive sharpening. The cross
+// neighbours are weighted less where the local contrast is high and the result stays within their range, so edges
+// do not ring. The contrast is relative to the brightest neighbour, which keeps it working on HDR colors
+static const char* SHARPEN_EFFECT = R"(
+uniform float sharpness = 0.0;
+
+vec4 sharpen(vec4 color, vec2 texCoord)
+{
+    if (sharpness <= 0.0) {
+        return color;
+    }
+    vec3 north = sourceColor(texCoord + vec2( 0.0,  1.0) * sourceTexelSize).rgb;
+    vec3 south = sourceColor(texCoord + vec2( 0.0, -1.0) * sourceTexelSize).rgb;
+    vec3 east  = sourceColor(texCoord + vec2( 1.0,  0.0) * sourceTexelSize).rgb;
+    vec3 west  = sourceColor(texCoord + vec2(-1.0,  0.0) * sourceTexelSize).rgb;
+    vec3 minColor = min(color.rgb, min(min(north, south), min(east, west)));
+    vec3 maxColor = max(color.rgb, max(max(north, south), max(east, west)));
+
+    vec3 amount = sqrt(clamp(minColor / max(maxColor, vec3(1e-4)), 0.0, 1.0));
+    vec3 weight = -amount * mix(1.0 / 8.0, 1.0 / 5.0, sharpness);
+    vec3 sharpened = (color.rgb + weight * (north + south + east + west)) / (1.0 + 4.0 * weight);
+    return vec4(clamp(sharpened, minColor, maxColor), color.a);
+}
+)";
+
+// FXAA after Timothy Lottes: Blends along the edge direction estimated from the luma of the diagonal neighbours
+static const char* FXAA_EFFECT = R"(
+float fxaaLuma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+vec4 fxaa(vec4 color, vec2 texCoord)
+{
+    const float reduceMin = 1.0 / 128.0;
+    const float reduceMul = 1.0 / 8.0;
+    const float spanMax = 8.0;
+
+    float lumaNW = fxaaLuma(sourceColor(texCoord + vec2(-1.0, -1.0) * sourceTexelSize).rgb);
+    float lumaNE = fxaaLuma(sourceColor(texCoord + vec2( 1.0, -1.0) * sourceTexelSize).rgb);
+    float lumaSW = fxaaLuma(sourceColor(texCoord + vec2(-1.0,  1.0) * sourceTexelSize).rgb);
+    float lumaSE = fxaaLuma(sourceColor(texCoord + vec2( 1.0,  1.0) * sourceTexelSize).rgb);
+    float lumaM  = fxaaLuma(color.rgb);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * reduceMul, reduceMin);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-spanMax), vec2(spanMax)) * sourceTexelSize;
+
+    vec3 rgbA = 0.5 * (sourceColor(texCoord + dir * (1.0 / 3.0 - 0.5)).rgb + sourceColor(texCoord + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (sourceColor(texCoord - dir * 0.5).rgb + sourceColor(texCoord + dir * 0.5).rgb);
+    float lumaB = fxaaLuma(rgbB);
+    return vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, color.a);
+}
+)";
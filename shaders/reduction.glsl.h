@@ -0,0 +1,102 @@
+#pragma once
+
+// Hierarchical reduction of textures and buffers (see gl::Reduction). Every workgroup reduces a chunk of
+// itemsPerGroup items in shared memory and writes one partial result. The source is selected by one of
+// SOURCE_TEXTURE, SOURCE_BUFFER or SOURCE_PARTIALS and CHANNELS (1-4) must be defined in front of this code.
+static const char* REDUCTION_CS = R"(
+#define GROUP_SIZE 256
+#define FLT_MAX 3.402823466e+38
+
+layout(local_size_x = GROUP_SIZE) in;
+
+struct Partial {
+	vec4 minValue;
+	vec4 maxValue;
+	vec4 sum;
+	uvec4 nonZero;
+	uvec4 count;
+};
+
+layout(std430, binding = 1) writeonly buffer Output { Partial partials[]; };
+
+#if defined(SOURCE_TEXTURE)
+uniform sampler2D source;
+uniform int level;
+#elif defined(SOURCE_BUFFER)
+layout(std430, binding = 0) readonly buffer Input { float values[]; };
+uniform uint firstValue;
+uniform uint stride;
+#else
+layout(std430, binding = 0) readonly buffer Input { Partial inputs[]; };
+#endif
+
+uniform uint count;
+uniform uint itemsPerGroup;
+
+shared vec4 sMin[GROUP_SIZE];
+shared vec4 sMax[GROUP_SIZE];
+shared vec4 sSum[GROUP_SIZE];
+shared uvec4 sNonZero[GROUP_SIZE];
+shared uvec4 sCount[GROUP_SIZE];
+
+Partial emptyPartial() {
+	return Partial(vec4(FLT_MAX), vec4(-FLT_MAX), vec4(0), uvec4(0), uvec4(0));
+}
+
+Partial combine(Partial a, Partial b) {
+	return Partial(min(a.minValue, b.minValue), max(a.maxValue, b.maxValue), a.sum + b.sum, a.nonZero + b.nonZero, a.count + b.count);
+}
+
+Partial load(uint i) {
+#if defined(SOURCE_PARTIALS)
+	return inputs[i];
+#else
+#if defined(SOURCE_TEXTURE)
+	ivec2 size = textureSize(source, level);
+	vec4 v = texelFetch(source, ivec2(i % uint(size.x), i / uint(size.x)), level);
+#else
+	vec4 v = vec4(0);
+	for (int c = 0; c < CHANNELS; ++c) {
+		v[c] = values[firstValue + i * stride + uint(c)];
+	}
+#endif
+	// NaN and infinite values are skipped, as are channels the source does not have
+	uvec4 valid = uvec4(lessThanEqual(abs(v), vec4(FLT_MAX))) * uvec4(lessThan(uvec4(0, 1, 2, 3), uvec4(CHANNELS)));
+	bvec4 mask = bvec4(valid);
+	return Partial(mix(vec4(FLT_MAX), v, mask), mix(vec4(-FLT_MAX), v, mask), mix(vec4(0), v, mask),
+		valid * uvec4(notEqual(v, vec4(0))), valid);
+#endif
+}
+
+void main() {
+	uint lid = gl_LocalInvocationID.x;
+	uint begin = gl_WorkGroupID.x * itemsPerGroup;
+	uint end = min(begin + itemsPerGroup, count);
+
+	Partial acc = emptyPartial();
+	for (uint i = begin + lid; i < end; i += GROUP_SIZE) {
+		acc = combine(acc, load(i));
+	}
+	sMin[lid] = acc.minValue;
+	sMax[lid] = acc.maxValue;
+	sSum[lid] = acc.sum;
+	sNonZero[lid] = acc.nonZero;
+	sCount[lid] = acc.count;
+	barrier();
+
+	for (uint s = GROUP_SIZE / 2; s > 0; s >>= 1) {
+		if (lid < s) {
+			sMin[lid] = min(sMin[lid], sMin[lid + s]);
+			sMax[lid] = max(sMax[lid], sMax[lid + s]);
+			sSum[lid] += sSum[lid + s];
+			sNonZero[lid] += sNonZero[lid + s];
+			sCount[lid] += sCount[lid + s];
+		}
+		barrier();
+	}
+
+	if (lid == 0) {
+		partials[gl_WorkGroupID.x] = Partial(sMin[0], sMax[0], sSum[0], sNonZero[0], sCount[0]);
+	}
+}
+)";
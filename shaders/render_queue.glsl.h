@@ -0,0 +1,23 @@
+#pragma once
+
+// Depth only shader of the depth pre-pass of gl::RenderQueue. gl_Position is invariant, so the depth matches the
+// one of shaders that compute MVP * vec4(position, 1.0) the same way
+static const char* DEPTH_PREPASS_VS = R"(
+#version 430
+layout(location = 0) in vec3 position;
+
+uniform mat4 MVP;
+
+invariant gl_Position;
+
+void main() {
+	gl_Position = MVP * vec4(position, 1.0);
+}
+)";
+
+static const char* DEPTH_PREPASS_FS = R"(
+#version 430
+
+void main() {
+}
+)";
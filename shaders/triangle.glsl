@@ -10,6 +10,9 @@ uniform mat4 M;
 out vec3 N;
 out vec3 pos;
 
+// Matches the depth pre-pass of gl::RenderQueue
+invariant gl_Position;
+
 void main() {
 	gl_Position = MVP * vec4(vPosition, 1.0);
 	pos = gl_Position.xyz;
@@ -0,0 +1,195 @@
+#pragma once
+
+// Shaders of gl::VolumeMesh. Positions inside the volume are given in texture space ([0, 1]^3), the volume is
+// always read from its first channel.
+
+// Minimum and maximum of the voxels covered by a macrocell of cellSize^3 voxels. The cell is extended by one voxel
+// towards its lower neighbors, so the range also bounds every trilinear sample taken inside the cell.
+static const char* MACROCELL_CS = R"(
+#version 430
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+uniform sampler3D volume;
+uniform int cellSize;
+layout(rg32f, binding = 0) writeonly uniform image3D macrocells;
+
+void main() {
+	ivec3 cell = ivec3(gl_GlobalInvocationID);
+	if (any(greaterThanEqual(cell, imageSize(macrocells)))) {
+		return;
+	}
+	ivec3 size = textureSize(volume, 0);
+	ivec3 first = max(cell * cellSize - 1, ivec3(0));
+	ivec3 last = min((cell + 1) * cellSize, size - 1);
+
+	float minimum = 3.402823466e+38;
+	float maximum = -3.402823466e+38;
+	for (int z = first.z; z <= last.z; ++z) {
+		for (int y = first.y; y <= last.y; ++y) {
+			for (int x = first.x; x <= last.x; ++x) {
+				float v = texelFetch(volume, ivec3(x, y, z), 0).r;
+				minimum = min(minimum, v);
+				maximum = max(maximum, v);
+			}
+		}
+	}
+	imageStore(macrocells, cell, vec4(minimum, maximum, 0, 0));
+}
+)";
+
+// Marks every macrocell in which the transfer function reaches an opacity above threshold. Has to be rerun whenever
+// the transfer function or the value range changes, but only touches one texel per cell.
+static const char* OCCUPANCY_CS = R"(
+#version 430
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+uniform sampler3D macrocells;
+#ifdef LUT_1D
+uniform sampler1D transferFunction;
+#define FETCH_LUT(i) texelFetch(transferFunction, i, 0)
+#else
+uniform sampler2D transferFunction;
+#define FETCH_LUT(i) texelFetch(transferFunction, ivec2(i, 0), 0)
+#endif
+uniform int lutSize;
+uniform vec2 range;
+uniform float threshold;
+layout(r8, binding = 0) writeonly uniform image3D occupancy;
+
+void main() {
+	ivec3 cell = ivec3(gl_GlobalInvocationID);
+	if (any(greaterThanEqual(cell, imageSize(occupancy)))) {
+		return;
+	}
+	vec2 bounds = clamp((texelFetch(macrocells, cell, 0).rg - range.x) / (range.y - range.x), 0.0, 1.0);
+	// The table is sampled linearly, so both entries around each end of the range may contribute
+	int first = int(floor(bounds.x * float(lutSize - 1)));
+	int last = int(ceil(bounds.y * float(lutSize - 1)));
+	float opacity = 0.0;
+	for (int i = first; i <= last; ++i) {
+		opacity = max(opacity, FETCH_LUT(i).a);
+	}
+	imageStore(occupancy, cell, vec4(opacity > threshold ? 1.0 : 0.0));
+}
+)";
+
+// Draws the back faces of the bounding box, so rays also start correctly if the camera is inside the volume
+static const char* VOLUME_VS = R"(
+#version 430
+layout(location = 0) in vec3 position;
+
+uniform mat4 MVP;
+
+out vec3 texPosition;
+
+void main() {
+	texPosition = position;
+	gl_Position = MVP * vec4(position, 1.0);
+}
+)";
+
+// Front to back compositing along the view ray. Empty macrocells are skipped in a single step, rays stop as soon as
+// the accumulated opacity exceeds terminationAlpha and, with ADAPTIVE defined, transparent samples and samples
+// behind already dense material are taken with larger steps. The result has premultiplied alpha.
+static const char* VOLUME_FS = R"(
+#version 430
+#define MAX_STEPS 8192
+#define MAX_STEP_SCALE 4.0
+
+in vec3 texPosition;
+
+#ifdef BRICKED
+// Defined together with inserting BRICKED_VOLUME_GLSL behind the #version directive
+#define SAMPLE_VOLUME(p) sampleBrickedVolume(p)
+#else
+uniform sampler3D volume;
+#define SAMPLE_VOLUME(p) texture(volume, p).r
+#endif
+uniform sampler3D occupancy;
+#ifdef LUT_1D
+uniform sampler1D transferFunction;
+#define LOOKUP(t) texture(transferFunction, t)
+#else
+uniform sampler2D transferFunction;
+#define LOOKUP(t) texture(transferFunction, vec2(t, 0.5))
+#endif
+uniform int lutSize;
+uniform vec2 range;
+uniform vec3 cameraPosition;	// In texture space
+uniform vec3 cellExtent;		// Size of a macrocell in texture space
+uniform vec3 cells;
+uniform float stepSize;			// In texture space
+uniform float referenceStep;	// Step length the opacities of the transfer function are given for
+uniform float terminationAlpha;
+
+out vec4 FragColor;
+
+vec4 classify(vec3 p) {
+	float t = clamp((SAMPLE_VOLUME(p) - range.x) / (range.y - range.x), 0.0, 1.0);
+	return LOOKUP((t * float(lutSize - 1) + 0.5) / float(lutSize));
+}
+
+void main() {
+	vec3 origin = cameraPosition;
+	vec3 dir = normalize(texPosition - origin);
+	vec3 invDir = 1.0 / mix(dir, vec3(1e-8), equal(dir, vec3(0.0)));
+
+	vec3 t0 = (vec3(0.0) - origin) * invDir;
+	vec3 t1 = (vec3(1.0) - origin) * invDir;
+	vec3 tMin = min(t0, t1);
+	vec3 tMax = max(t0, t1);
+	float tNear = max(max(tMin.x, tMin.y), max(tMin.z, 0.0));
+	float tFar = min(tMax.x, min(tMax.y, tMax.z));
+
+	// Jitter the first sample per pixel, which turns wood grain artifacts into noise
+	float jitter = fract(sin(dot(gl_FragCoord.xy, vec2(12.9898, 78.233))) * 43758.5453);
+	float t = tNear + stepSize * jitter;
+	ivec3 lastCell = ivec3(cells) - 1;
+	vec4 result = vec4(0);
+
+	for (int i = 0; i < MAX_STEPS && t < tFar; ++i) {
+		vec3 p = origin + dir * t;
+		ivec3 cell = clamp(ivec3(p / cellExtent), ivec3(0), lastCell);
+		if (texelFetch(occupancy, cell, 0).r == 0.0) {
+			// Continue on the sampling grid right behind the exit of the empty cell
+			vec3 exits = (vec3(cell) * cellExtent + step(0.0, dir) * cellExtent - origin) * invDir;
+			float exit = min(exits.x, min(exits.y, exits.z));
+			t += max(ceil((exit - t) / stepSize), 1.0) * stepSize;
+			continue;
+		}
+
+		vec4 color = classify(p);
+		float dt = stepSize;
+#ifdef ADAPTIVE
+		if (color.a == 0.0) {
+			dt *= 2.0;
+		}
+		dt *= mix(1.0, MAX_STEP_SCALE, result.a);
+#endif
+		// Opacity correction, so the image does not depend on the step size
+		color.a = 1.0 - pow(1.0 - clamp(color.a, 0.0, 1.0), dt / referenceStep);
+		result.rgb += (1.0 - result.a) * color.a * color.rgb;
+		result.a += (1.0 - result.a) * color.a;
+		if (result.a >= terminationAlpha) {
+			break;
+		}
+		t += dt;
+	}
+	FragColor = result;
+}
+)";
+
+// Upsamples a volume rendered at half resolution. Drawn with gl::fullscreenTriangle and DISPLAY_VS, the texture
+// has premultiplied alpha
+static const char* VOLUME_COMPOSITE_FS = R"(
+#version 430
+in vec2 texCoord;
+
+uniform sampler2D image;
+
+out vec4 FragColor;
+
+void main() {
+	FragColor = texture(image, texCoord);
+}
+)";
@@ -0,0 +1,90 @@
+#include "glpp/auto_exposure.hpp"
+#include "glpp/shadermanager.hpp"
+#include "glpp/texture.hpp"
+
+#include "../shaders/auto_exposure.glsl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+gl::AutoExposure::AutoExposure() :
+	minLogLuminance(-10.0f),
+	maxLogLuminance(4.0f),
+	keyValue(0.18f),
+	adaptationSpeed(1.5f),
+	mHistogramShader(std::make_unique<gl::ComputeShader>(LUMINANCE_HISTOGRAM_CS)),
+	mExposureShader(std::make_unique<gl::ComputeShader>(EXPOSURE_CS)),
+	mHistogram(0),
+	mExposure(0)
+{
+	const GLuint bins[256] = {};
+	glGenBuffers(1, &mHistogram);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mHistogram);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(bins), bins, GL_DYNAMIC_COPY);
+
+	const float exposure[2] = { 0.0f, 1.0f };
+	glGenBuffers(1, &mExposure);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mExposure);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(exposure), exposure, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+gl::AutoExposure::~AutoExposure()
+{
+	glDeleteBuffers(1, &mHistogram);
+	glDeleteBuffers(1, &mExposure);
+}
+
+void gl::AutoExposure::update(gl::Texture& hdr, float dt, int cols, int rows)
+{
+	if (hdr.type != TextureType::D2) {
+		throw std::invalid_argument("Auto exposure needs a 2D texture");
+	}
+	cols = cols < 0 ? hdr.cols : std::min(cols, hdr.cols);
+	rows = rows < 0 ? hdr.rows : std::min(rows, hdr.rows);
+	const float range = std::max(maxLogLuminance - minLogLuminance, 1e-3f);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mHistogram);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mExposure);
+
+	mHistogramShader->use();
+	hdr.bind(0);
+	mHistogramShader->setUniform("hdrTexture", 0);
+	mHistogramShader->setUniform("minLogLuminance", minLogLuminance);
+	mHistogramShader->setUniform("inverseLogLuminanceRange", 1.0f / range);
+	mHistogramShader->setUniform("size", glm::vec2(cols, rows));
+	glDispatchCompute((cols + 15) / 16, (rows + 15) / 16, 1);
+	hdr.unbind();
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	mExposureShader->use();
+	mExposureShader->setUniform("minLogLuminance", minLogLuminance);
+	mExposureShader->setUniform("logLuminanceRange", range);
+	mExposureShader->setUniform("pixelCount", static_cast<float>(cols) * rows);
+	// Exponential decay, so the adaptation does not depend on the frame rate
+	mExposureShader->setUniform("adaptation", 1.0f - std::exp(-std::max(dt, 0.0f) * adaptationSpeed));
+	mExposureShader->setUniform("keyValue", keyValue);
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+}
+
+void gl::AutoExposure::bind(int binding) const
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mExposure);
+}
+
+void gl::AutoExposure::reset()
+{
+	const float exposure[2] = { 0.0f, 1.0f };
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mExposure);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(exposure), exposure);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+GLuint gl::AutoExposure::buffer() const
+{
+	return mExposure;
+}
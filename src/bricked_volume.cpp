@@ -0,0 +1,608 @@
+#include "glpp/bricked_volume.hpp"
+#include "glpp/mapped_file.hpp"
+#include "glpp/pixel_buffer.hpp"
+#include "glpp/state_cache.hpp"
+#include "glpp/texture_loader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+struct gl::BrickedVolume::BrickTable {
+	// Staged bricks were read but found no free slot, their voxels wait in staged until one frees up
+	enum class BrickState : unsigned char { Missing, Loading, Staged, Resident };
+
+	std::vector<BrickState> states;
+	std::vector<int> slots;			// Pool slot of every resident brick
+	std::vector<int> lastUsed;
+	std::vector<int> slotBricks;	// Brick held by every pool slot or -1
+	int pinned = 0;					// Bricks starting at this index belong to the coarsest level and are never evicted
+	std::map<int, std::vector<unsigned char>> staged;
+};
+
+namespace impl {
+	// Bricks kept on the host while the pool is full of bricks used in the current frame
+	constexpr size_t MaxStagedBricks = 64;
+
+	// Layout of a brick cache file: header, the value range of every brick (two floats) and the bricks of all levels,
+	// starting with the full resolution level. The bricks of a level are stored with x varying fastest and every brick
+	// is stored tightly packed as BrickSize^3 voxels of the type given by the header.
+	struct BrickCacheHeader {
+		char magic[8];
+		int32_t cols, rows, depth;
+		uint32_t type;
+		int32_t brickSize;
+		int32_t levels;
+	};
+	constexpr char BrickCacheMagic[8] = { 'G', 'L', 'B', 'R', 'I', 'C', 'K', '1' };
+	constexpr int S = gl::BrickedVolume::BrickSize;
+	constexpr int P = gl::BrickedVolume::BrickPayload;
+
+	// Sizes of all levels. Every level halves the previous one until it fits into a single brick
+	std::vector<glm::ivec3> levelSizes(glm::ivec3 size) {
+		std::vector<glm::ivec3> sizes = { size };
+		while (std::max({ size.x, size.y, size.z }) > P) {
+			size = (size + 1) / 2;
+			sizes.push_back(size);
+		}
+		return sizes;
+	}
+
+	glm::ivec3 brickCount(glm::ivec3 size) {
+		return (size + P - 1) / P;
+	}
+
+	size_t product(glm::ivec3 v) {
+		return (size_t)v.x * v.y * v.z;
+	}
+
+	bool readBrickCacheHeader(const std::string& file, BrickCacheHeader& header) {
+		std::ifstream in(file, std::ios::binary);
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(BrickCacheHeader))) {
+			return false;
+		}
+		return std::memcmp(header.magic, BrickCacheMagic, sizeof(BrickCacheMagic)) == 0;
+	}
+
+	std::string brickCacheFile(const std::string& path, glm::ivec3 size, gl::PixelType type) {
+		// The key changes whenever the source file changes, so outdated caches are never used
+		std::error_code ec;
+		const fs::path file = fs::absolute(path, ec);
+		const auto bytes = fs::file_size(file, ec);
+		const auto time = fs::last_write_time(file, ec).time_since_epoch().count();
+		const size_t key = std::hash<std::string>()(file.string() + "|" + std::to_string(bytes) + "|" + std::to_string(time) + "|" +
+			std::to_string(size.x) + "x" + std::to_string(size.y) + "x" + std::to_string(size.z) + "|" + std::to_string(static_cast<int>(type)));
+		return (fs::temp_directory_path() / "glpp_brick_cache" / (std::to_string(key) + ".bricks")).string();
+	}
+
+	template<typename T>
+	float normalized(T v) {
+		return std::is_floating_point<T>::value ? static_cast<float>(v) : static_cast<float>(v) / std::numeric_limits<T>::max();
+	}
+
+	// Writes all bricks of a level. voxel(x, y, z) returns the voxel of the level at a position inside of it.
+	// Slabs of bricks are distributed over all hardware threads
+	template<typename T, typename Voxel>
+	void writeBricks(T* bricks, glm::vec2* ranges, glm::ivec3 size, glm::ivec3 count, const Voxel& voxel) {
+		std::atomic<int> nextSlab(0);
+		auto work = [&]() {
+			for (int bz = nextSlab++; bz < count.z; bz = nextSlab++) {
+				for (int by = 0; by < count.y; ++by) {
+					for (int bx = 0; bx < count.x; ++bx) {
+						const size_t index = ((size_t)bz * count.y + by) * count.x + bx;
+						T* dst = bricks + index * S * S * S;
+						float minimum = std::numeric_limits<float>::max();
+						float maximum = std::numeric_limits<float>::lowest();
+						// Bricks start one voxel early, so they overlap with their neighbors
+						for (int z = 0; z < S; ++z) {
+							const int vz = std::clamp(bz * P - 1 + z, 0, size.z - 1);
+							for (int y = 0; y < S; ++y) {
+								const int vy = std::clamp(by * P - 1 + y, 0, size.y - 1);
+								for (int x = 0; x < S; ++x) {
+									const T v = voxel(std::clamp(bx * P - 1 + x, 0, size.x - 1), vy, vz);
+									*dst++ = v;
+									minimum = std::min(minimum, normalized(v));
+									maximum = std::max(maximum, normalized(v));
+								}
+							}
+						}
+						ranges[index] = glm::vec2(minimum, maximum);
+					}
+				}
+			}
+		};
+		std::vector<std::thread> workers;
+		for (unsigned int i = 1; i < std::thread::hardware_concurrency(); ++i) {
+			workers.emplace_back(work);
+		}
+		work();
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	}
+
+	template<typename T>
+	void writeLevels(const T* raw, T* bricks, glm::vec2* ranges, const std::vector<glm::ivec3>& levels) {
+		typedef typename std::conditional<std::is_floating_point<T>::value, double, uint64_t>::type Accumulator;
+
+		const glm::ivec3 size = levels[0];
+		writeBricks(bricks, ranges, size, brickCount(size), [raw, size](int x, int y, int z) {
+			return raw[((size_t)z * size.y + y) * size.x + x];
+		});
+
+		// Every other level is averaged from the bricks of the previous one, which were just written
+		for (size_t k = 1; k < levels.size(); ++k) {
+			const glm::ivec3 fineSize = levels[k - 1];
+			const glm::ivec3 fineCount = brickCount(fineSize);
+			const T* fine = bricks;
+			bricks += product(fineCount) * S * S * S;
+			ranges += product(fineCount);
+
+			auto fineVoxel = [fine, fineSize, fineCount](int x, int y, int z) {
+				x = std::min(x, fineSize.x - 1);
+				y = std::min(y, fineSize.y - 1);
+				z = std::min(z, fineSize.z - 1);
+				const size_t index = ((size_t)(z / P) * fineCount.y + y / P) * fineCount.x + x / P;
+				return fine[index * S * S * S + ((size_t)(z % P + 1) * S + (y % P + 1)) * S + (x % P + 1)];
+			};
+			writeBricks(bricks, ranges, levels[k], brickCount(levels[k]), [&fineVoxel](int x, int y, int z) {
+				Accumulator sum = 0;
+				for (int i = 0; i < 8; ++i) {
+					sum += fineVoxel(2 * x + (i & 1), 2 * y + ((i >> 1) & 1), 2 * z + (i >> 2));
+				}
+				return static_cast<T>(std::is_floating_point<T>::value ? sum / 8 : (sum + 4) / 8);
+			});
+		}
+	}
+
+	// Returns true if the box (given in texture space) intersects the view frustum
+	bool isVisible(const glm::mat4& MVP, glm::vec3 lo, glm::vec3 hi) {
+		int outside[6] = { 0, 0, 0, 0, 0, 0 };
+		for (int c = 0; c < 8; ++c) {
+			const glm::vec4 p = MVP * glm::vec4(c & 1 ? hi.x : lo.x, c & 2 ? hi.y : lo.y, c & 4 ? hi.z : lo.z, 1.0f);
+			outside[0] += p.x < -p.w;
+			outside[1] += p.x > p.w;
+			outside[2] += p.y < -p.w;
+			outside[3] += p.y > p.w;
+			outside[4] += p.z < -p.w;
+			outside[5] += p.z > p.w;
+		}
+		return std::none_of(outside, outside + 6, [](int n) { return n == 8; });
+	}
+}
+
+gl::BrickedVolume::BrickedVolume(const std::string& brickCache, size_t poolBytes) :
+	lodBias(0.0f),
+	mDataOffset(0),
+	mPixelType(PixelType::UByte),
+	mPoolSlots(0),
+	mPagesDirty(true),
+	mFrame(0)
+{
+	::impl::BrickCacheHeader header;
+	if (!::impl::readBrickCacheHeader(brickCache, header) || header.brickSize != BrickSize) {
+		throw std::runtime_error("\"" + brickCache + "\" is not a brick cache");
+	}
+	mCache = std::make_shared<MappedFile>(brickCache);
+	mPixelType = static_cast<PixelType>(header.type);
+
+	int firstBrick = 0;
+	for (glm::ivec3 size : ::impl::levelSizes(glm::ivec3(header.cols, header.rows, header.depth))) {
+		Level level;
+		level.size = size;
+		level.bricks = ::impl::brickCount(size);
+		level.firstBrick = firstBrick;
+		firstBrick += static_cast<int>(::impl::product(level.bricks));
+		mLevels.push_back(level);
+	}
+	const int numBricks = firstBrick;
+	mDataOffset = sizeof(::impl::BrickCacheHeader) + numBricks * sizeof(glm::vec2);
+	if (mCache->size() < mDataOffset + numBricks * brickBytes()) {
+		throw std::runtime_error("The brick cache \"" + brickCache + "\" is truncated");
+	}
+	const glm::vec2* ranges = reinterpret_cast<const glm::vec2*>(mCache->data() + sizeof(::impl::BrickCacheHeader));
+	mRanges.assign(ranges, ranges + ::impl::product(mLevels[0].bricks));
+
+	// The pool holds as many bricks as the budget allows, but at least the coarsest level and one more brick
+	GLint maxSize;
+	glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+	// The page table stores the slot coordinates in 8 bit channels
+	const long long perAxis = std::clamp(maxSize / BrickSize, 1, 256);
+	const long long slots = std::max<long long>(poolBytes / brickBytes(), ::impl::product(mLevels.back().bricks) + 1);
+	mPoolSlots.x = static_cast<int>(std::min(perAxis, slots));
+	mPoolSlots.y = static_cast<int>(std::min(perAxis, std::max(slots / mPoolSlots.x, 1LL)));
+	mPoolSlots.z = static_cast<int>(std::min(perAxis, std::max(slots / ((long long)mPoolSlots.x * mPoolSlots.y), 1LL)));
+	mPool = std::make_unique<gl::Texture>(mPoolSlots.x * BrickSize, mPoolSlots.y * BrickSize, mPoolSlots.z * BrickSize,
+		PixelFormat::Red, mPixelType, TextureFlags_No_Mipmap);
+
+	const glm::ivec3 pages = mLevels[0].bricks;
+	mPageTable = std::make_unique<gl::Texture>(pages.x, pages.y, pages.z, PixelFormat::RGBA, PixelType::UByte, TextureFlags_FrameBuffer_Texture);
+	mPages.assign(4 * ::impl::product(pages), 0);
+
+	mBricks = std::make_shared<BrickTable>();
+	BrickTable& table = *mBricks;
+	table.states.assign(numBricks, BrickTable::BrickState::Missing);
+	table.slots.assign(numBricks, -1);
+	table.lastUsed.assign(numBricks, -1);
+	table.slotBricks.assign(capacity(), -1);
+	table.pinned = mLevels.back().firstBrick;
+
+	// The coarsest level is loaded right away, so every page always has a brick to point to
+	for (int brick = table.pinned; brick < numBricks; ++brick) {
+		onBrickLoaded(brick, std::vector<unsigned char>(mCache->data() + mDataOffset + brick * brickBytes(),
+			mCache->data() + mDataOffset + (brick + 1) * brickBytes()));
+	}
+}
+
+gl::BrickedVolume::~BrickedVolume()
+{
+}
+
+std::string gl::BrickedVolume::BuildBrickCache(const std::string& rawFile, int cols, int rows, int depth, PixelType type, std::string cacheFile)
+{
+	if (type != PixelType::UByte && type != PixelType::UShort && type != PixelType::Float) {
+		throw std::invalid_argument("Bricked volumes only support 8 bit, 16 bit and float voxels");
+	}
+	const glm::ivec3 size(cols, rows, depth);
+	if (cacheFile.empty()) {
+		cacheFile = ::impl::brickCacheFile(rawFile, size, type);
+	}
+	::impl::BrickCacheHeader header;
+	if (::impl::readBrickCacheHeader(cacheFile, header)) {
+		return cacheFile;
+	}
+
+	const size_t voxelSize = getPixelSize(PixelFormat::Red, type);
+	MappedFile raw(rawFile);
+	if (raw.size() < ::impl::product(size) * voxelSize) {
+		throw std::runtime_error("\"" + rawFile + "\" is smaller than a volume of the given size");
+	}
+
+	const std::vector<glm::ivec3> levels = ::impl::levelSizes(size);
+	size_t numBricks = 0;
+	for (glm::ivec3 level : levels) {
+		numBricks += ::impl::product(::impl::brickCount(level));
+	}
+	const size_t dataOffset = sizeof(::impl::BrickCacheHeader) + numBricks * sizeof(glm::vec2);
+	const size_t fileSize = dataOffset + numBricks * BrickSize * BrickSize * BrickSize * voxelSize;
+
+	std::memcpy(header.magic, ::impl::BrickCacheMagic, sizeof(::impl::BrickCacheMagic));
+	header.cols = cols;
+	header.rows = rows;
+	header.depth = depth;
+	header.type = static_cast<uint32_t>(type);
+	header.brickSize = BrickSize;
+	header.levels = static_cast<int32_t>(levels.size());
+
+	std::error_code ec;
+	fs::create_directories(fs::path(cacheFile).parent_path(), ec);
+	// Write to a temporary file first, so a partially written cache is never picked up
+	const std::string partial = cacheFile + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".part";
+	{
+		std::ofstream out(partial, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(::impl::BrickCacheHeader));
+		if (!out) {
+			throw std::runtime_error("Could not write brick cache \"" + cacheFile + "\"");
+		}
+	}
+	// The bricks are written through a mapping, so coarser levels can be built from finer ones without holding them in memory
+	fs::resize_file(partial, fileSize, ec);
+	if (ec) {
+		fs::remove(partial, ec);
+		throw std::runtime_error("Could not write brick cache \"" + cacheFile + "\"");
+	}
+	{
+		MappedFile out(partial, true);
+		glm::vec2* ranges = reinterpret_cast<glm::vec2*>(out.data() + sizeof(::impl::BrickCacheHeader));
+		unsigned char* bricks = out.data() + dataOffset;
+		switch (type) {
+		case PixelType::UByte:
+			::impl::writeLevels(raw.data(), bricks, ranges, levels);
+			break;
+		case PixelType::UShort:
+			::impl::writeLevels(reinterpret_cast<const uint16_t*>(raw.data()), reinterpret_cast<uint16_t*>(bricks), ranges, levels);
+			break;
+		default:
+			::impl::writeLevels(reinterpret_cast<const float*>(raw.data()), reinterpret_cast<float*>(bricks), ranges, levels);
+			break;
+		}
+		out.flush();
+	}
+	fs::rename(partial, cacheFile, ec);
+	if (ec) {
+		fs::remove(partial, ec);
+	}
+	return cacheFile;
+}
+
+void gl::BrickedVolume::update(const std::shared_ptr<gl::Camera> camera, const glm::mat4& textureToWorld)
+{
+	++mFrame;
+	const glm::mat4 MVP = camera->GetProjectionMatrix() * camera->viewMatrix * textureToWorld;
+	const glm::vec3 cameraPosition = camera->position();
+	const glm::vec3 volumeSize = glm::vec3(mLevels[0].size);
+	// Size of a pixel at a distance of one
+	const float pixelAngle = 2.0f * std::tan(glm::radians(camera->fov) * 0.5f) / camera->ScreenHeight * std::exp2(lodBias);
+
+	// Bricks are requested level by level, starting with the coarsest, so the loader reads coarse bricks first
+	std::vector<glm::ivec3> current = { glm::ivec3(0) };
+	for (int level = numLevels() - 1; level >= 0 && !current.empty(); --level) {
+		std::vector<glm::ivec3> finer;
+		const float scale = static_cast<float>(BrickPayload * (1 << level));
+		const float voxel = glm::length(glm::vec3(textureToWorld * glm::vec4(static_cast<float>(1 << level) / volumeSize.x, 0.0f, 0.0f, 0.0f)));
+		for (glm::ivec3 brick : current) {
+			const glm::vec3 lo = glm::vec3(brick) * scale / volumeSize;
+			const glm::vec3 hi = glm::min(glm::vec3(brick + 1) * scale / volumeSize, glm::vec3(1.0f));
+			if (!::impl::isVisible(MVP, lo, hi)) {
+				continue;
+			}
+			request(level, brick);
+			if (level == 0) {
+				continue;
+			}
+
+			// Refine while a voxel of this level covers more than a pixel
+			const glm::vec3 center = glm::vec3(textureToWorld * glm::vec4(0.5f * (lo + hi), 1.0f));
+			const float radius = 0.5f * glm::length(glm::vec3(textureToWorld * glm::vec4(hi - lo, 0.0f)));
+			const float distance = std::max(glm::length(center - cameraPosition) - radius, 1e-4f);
+			if (voxel <= distance * pixelAngle) {
+				continue;
+			}
+			const glm::ivec3 children = mLevels[level - 1].bricks;
+			for (int i = 0; i < 8; ++i) {
+				const glm::ivec3 child = 2 * brick + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2);
+				if (child.x < children.x && child.y < children.y && child.z < children.z) {
+					finer.push_back(child);
+				}
+			}
+		}
+		current = std::move(finer);
+	}
+	placeStagedBricks();
+}
+
+void gl::BrickedVolume::bind(gl::Shader& shader, int poolSlot, int tableSlot)
+{
+	if (mPagesDirty) {
+		mPageTable->setData(mPages.data());
+		mPagesDirty = false;
+	}
+	mPool->bind(poolSlot);
+	shader.setUniform("brickPool", poolSlot);
+	mPageTable->bind(tableSlot);
+	shader.setUniform("brickTable", tableSlot);
+	shader.setUniform("volumeSize", glm::vec3(mLevels[0].size));
+	shader.setUniform("brickPoolSize", glm::vec3(mPoolSlots * BrickSize));
+}
+
+void gl::BrickedVolume::unbind(int poolSlot, int tableSlot)
+{
+	gl::StateCache& state = gl::StateCache::Current();
+	state.activeTexture(tableSlot);
+	mPageTable->unbind();
+	state.activeTexture(poolSlot);
+	mPool->unbind();
+	state.activeTexture(0);
+}
+
+glm::ivec3 gl::BrickedVolume::size() const
+{
+	return mLevels[0].size;
+}
+
+gl::PixelType gl::BrickedVolume::pixelType() const
+{
+	return mPixelType;
+}
+
+int gl::BrickedVolume::numLevels() const
+{
+	return static_cast<int>(mLevels.size());
+}
+
+glm::ivec3 gl::BrickedVolume::bricks(int level) const
+{
+	return mLevels[level].bricks;
+}
+
+const std::vector<glm::vec2>& gl::BrickedVolume::brickRanges() const
+{
+	return mRanges;
+}
+
+size_t gl::BrickedVolume::capacity() const
+{
+	return ::impl::product(mPoolSlots);
+}
+
+size_t gl::BrickedVolume::residentBricks() const
+{
+	return std::count_if(mBricks->slotBricks.begin(), mBricks->slotBricks.end(), [](int brick) { return brick >= 0; });
+}
+
+void gl::BrickedVolume::request(int level, glm::ivec3 brick)
+{
+	BrickTable& table = *mBricks;
+	const int index = brickIndex(level, brick);
+	table.lastUsed[index] = mFrame;
+	if (table.states[index] != BrickTable::BrickState::Missing) {
+		return;
+	}
+
+	table.states[index] = BrickTable::BrickState::Loading;
+	const size_t size = brickBytes();
+	const size_t offset = mDataOffset + index * size;
+	std::shared_ptr<MappedFile> cache = mCache;
+	std::shared_ptr<std::vector<unsigned char>> voxels = std::make_shared<std::vector<unsigned char>>();
+	// The table is replaced together with the volume, so loads finishing after that can detect that they expired
+	std::weak_ptr<BrickTable> token = mBricks;
+	TextureLoader::Default().enqueue(
+		[cache, offset, size, voxels]() -> size_t {
+			// Copying here moves the page faults (and thereby the disk reads) to the worker thread
+			voxels->assign(cache->data() + offset, cache->data() + offset + size);
+			return size;
+		},
+		[this, token, index, voxels]() {
+			if (token.expired()) { return; }
+			onBrickLoaded(index, std::move(*voxels));
+		});
+}
+
+void gl::BrickedVolume::onBrickLoaded(int brick, std::vector<unsigned char> voxels)
+{
+	BrickTable& table = *mBricks;
+	const int slot = allocateSlot();
+	if (slot < 0) {
+		// Every slot holds a brick needed for the current frame. Keep the voxels until a slot frees up instead of
+		// reading the brick again in every frame
+		if (table.staged.size() < ::impl::MaxStagedBricks) {
+			table.states[brick] = BrickTable::BrickState::Staged;
+			table.staged[brick] = std::move(voxels);
+		}
+		else {
+			table.states[brick] = BrickTable::BrickState::Missing;
+		}
+		return;
+	}
+	uploadBrick(slot, voxels.data());
+	table.states[brick] = BrickTable::BrickState::Resident;
+	table.slots[brick] = slot;
+	table.slotBricks[slot] = brick;
+	auto [level, position] = brickPosition(brick);
+	updatePages(level, position);
+}
+
+void gl::BrickedVolume::placeStagedBricks()
+{
+	BrickTable& table = *mBricks;
+	for (auto it = table.staged.begin(); it != table.staged.end();) {
+		const int brick = it->first;
+		if (table.lastUsed[brick] != mFrame) {
+			// Not needed anymore, a later request reads it again
+			table.states[brick] = BrickTable::BrickState::Missing;
+			it = table.staged.erase(it);
+			continue;
+		}
+		const int slot = allocateSlot();
+		if (slot < 0) {
+			return;
+		}
+		uploadBrick(slot, it->second.data());
+		table.states[brick] = BrickTable::BrickState::Resident;
+		table.slots[brick] = slot;
+		table.slotBricks[slot] = brick;
+		auto [level, position] = brickPosition(brick);
+		updatePages(level, position);
+		it = table.staged.erase(it);
+	}
+}
+
+int gl::BrickedVolume::allocateSlot()
+{
+	BrickTable& table = *mBricks;
+	auto free = std::find(table.slotBricks.begin(), table.slotBricks.end(), -1);
+	if (free != table.slotBricks.end()) {
+		return static_cast<int>(free - table.slotBricks.begin());
+	}
+
+	// Evict the least recently used brick. Bricks used in the current frame and the coarsest level stay resident
+	int victim = -1;
+	for (int slot = 0; slot < (int)table.slotBricks.size(); ++slot) {
+		const int brick = table.slotBricks[slot];
+		if (brick < table.pinned && table.lastUsed[brick] != mFrame &&
+			(victim < 0 || table.lastUsed[brick] < table.lastUsed[table.slotBricks[victim]])) {
+			victim = slot;
+		}
+	}
+	if (victim < 0) {
+		return -1;
+	}
+	const int brick = table.slotBricks[victim];
+	table.states[brick] = BrickTable::BrickState::Missing;
+	table.slots[brick] = -1;
+	table.slotBricks[victim] = -1;
+	auto [level, position] = brickPosition(brick);
+	updatePages(level, position);
+	return victim;
+}
+
+void gl::BrickedVolume::uploadBrick(int slot, const void* voxels)
+{
+	const glm::ivec3 position(slot % mPoolSlots.x, (slot / mPoolSlots.x) % mPoolSlots.y, slot / (mPoolSlots.x * mPoolSlots.y));
+	const size_t size = brickBytes();
+
+	// Stream the brick through the upload ring, so the render thread does not wait for the driver copy
+	PixelBufferRing& ring = PixelBufferRing::Uploads();
+	const int ringSlot = ring.acquire(size);
+	std::memcpy(ring.map(ringSlot), voxels, size);
+	ring.unmap(ringSlot);
+
+	mPool->bind();
+	ring.bind(ringSlot);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, position.x * BrickSize, position.y * BrickSize, position.z * BrickSize,
+		BrickSize, BrickSize, BrickSize, GL_RED, static_cast<GLenum>(mPixelType), nullptr);
+	ring.unbind();
+	ring.fence(ringSlot);
+	mPool->unbind();
+}
+
+void gl::BrickedVolume::updatePages(int level, glm::ivec3 brick)
+{
+	const BrickTable& table = *mBricks;
+	const glm::ivec3 pages = mLevels[0].bricks;
+	const glm::ivec3 first = brick * (1 << level);
+	const glm::ivec3 last = glm::min(first + (1 << level), pages);
+	for (int z = first.z; z < last.z; ++z) {
+		for (int y = first.y; y < last.y; ++y) {
+			for (int x = first.x; x < last.x; ++x) {
+				unsigned char* page = &mPages[4 * (((size_t)z * pages.y + y) * pages.x + x)];
+				for (int l = 0; l < numLevels(); ++l) {
+					const int index = brickIndex(l, glm::ivec3(x >> l, y >> l, z >> l));
+					if (table.states[index] == BrickTable::BrickState::Resident) {
+						const int slot = table.slots[index];
+						page[0] = static_cast<unsigned char>(slot % mPoolSlots.x);
+						page[1] = static_cast<unsigned char>((slot / mPoolSlots.x) % mPoolSlots.y);
+						page[2] = static_cast<unsigned char>(slot / (mPoolSlots.x * mPoolSlots.y));
+						page[3] = static_cast<unsigned char>(l);
+						break;
+					}
+				}
+			}
+		}
+	}
+	mPagesDirty = true;
+}
+
+int gl::BrickedVolume::brickIndex(int level, glm::ivec3 brick) const
+{
+	const Level& l = mLevels[level];
+	return l.firstBrick + (brick.z * l.bricks.y + brick.y) * l.bricks.x + brick.x;
+}
+
+std::pair<int, glm::ivec3> gl::BrickedVolume::brickPosition(int index) const
+{
+	int level = 0;
+	while (level + 1 < numLevels() && mLevels[level + 1].firstBrick <= index) {
+		++level;
+	}
+	const glm::ivec3 bricks = mLevels[level].bricks;
+	const int local = index - mLevels[level].firstBrick;
+	return { level, glm::ivec3(local % bricks.x, (local / bricks.x) % bricks.y, local / (bricks.x * bricks.y)) };
+}
+
+size_t gl::BrickedVolume::brickBytes() const
+{
+	return BrickSize * BrickSize * BrickSize * getPixelSize(PixelFormat::Red, mPixelType);
+}
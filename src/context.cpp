@@ -1,22 +1,61 @@
 #include "glpp/context.hpp"
+#include "glpp/state_cache.hpp"
 
 #include <cassert>
 #include <stdexcept>
+#include <unordered_set>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
 gl::Context* gl::Context::sCurrentContext = nullptr;
 
+bool gl::hasExtension(const std::string& name)
+{
+	static std::unordered_set<std::string> extensions;
+	if (extensions.empty()) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+			if (extension != nullptr) {
+				extensions.insert(reinterpret_cast<const char*>(extension));
+			}
+		}
+	}
+	return extensions.count(name) > 0;
+}
+
+bool gl::hasVersion(int major, int minor)
+{
+	GLint contextMajor = 0, contextMinor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+	glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+	return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
 gl::Context::Context(std::shared_ptr<gl::Context> shared) :
-	mSharedContext(shared)
+	mSharedContext(shared),
+	mStateCache(std::make_unique<gl::StateCache>())
+{
+}
+
+gl::Context::~Context()
 {
+	if (sCurrentContext == this) {
+		sCurrentContext = nullptr;
+	}
 }
 
 void gl::Context::makeCurrent() {
 	sCurrentContext = this;
 }
 
+gl::StateCache& gl::Context::stateCache()
+{
+	return *mStateCache;
+}
+
 gl::Context* gl::Context::GetCurrentContext()
 {
 	return sCurrentContext;
@@ -133,6 +172,12 @@ bool gl::GLFWContext::isMaximized() const
 	return glfwGetWindowAttrib(mWindow, GLFW_MAXIMIZED);
 }
 
+bool gl::GLFWContext::isFocused() const
+{
+	assert(mWindow != nullptr);
+	return glfwGetWindowAttrib(mWindow, GLFW_FOCUSED);
+}
+
 std::pair<int, int> gl::GLFWContext::getWindowSize() const
 {
 	assert(mWindow != nullptr);
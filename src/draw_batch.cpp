@@ -11,12 +11,30 @@ gl::DrawBatch::DrawBatch() :
 {
 	indexBuffer->target() = GL_ELEMENT_ARRAY_BUFFER;
 	
-	glBindVertexArray(VAO);
+	gl::StateCache::Current().bindVertexArray(VAO);
 	indexBuffer->bind();
-	glBindVertexArray(0);
+	gl::StateCache::Current().bindVertexArray(0);
 	indexBuffer->unbind();
 }
 
 gl::DrawBatch::~DrawBatch()
 {
 }
+
+gl::DrawPacket gl::DrawBatch::packet(gl::Shader& shader)
+{
+	for (auto vbo : mVertexAttributes) {
+		vbo->update();
+	}
+	indexBuffer->update();
+
+	DrawPacket packet;
+	packet.shader = &shader;
+	packet.vao = VAO;
+	packet.primitiveType = primitiveType;
+	packet.count = static_cast<GLsizei>(indexBuffer->size());
+	packet.indexType = indexType;
+	packet.indexOffset = indexOffset * sizeof(GLuint);
+	packet.patchSize = patchsize;
+	return packet;
+}
@@ -0,0 +1,119 @@
+#include "glpp/dynamic_resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace impl {
+	// Weight of a new measurement in the average of the full resolution time
+	constexpr float TimeSmoothing = 0.25f;
+}
+
+gl::DynamicResolution::DynamicResolution() :
+	enabled(false),
+	targetFrameTime(1000.0f / 60.0f),
+	minScale(0.5f),
+	maxScale(1.0f),
+	scaleStep(0.05f),
+	sharpness(0.5f),
+	mNext(0),
+	mActive(-1),
+	mScale(1.0f),
+	mGpuTime(0.0f),
+	mFullResolutionTime(0.0f)
+{
+}
+
+gl::DynamicResolution::~DynamicResolution()
+{
+	for (Query& query : mQueries) {
+		if (query.id != 0) {
+			glDeleteQueries(1, &query.id);
+		}
+	}
+}
+
+void gl::DynamicResolution::begin()
+{
+	Query& query = mQueries[mNext];
+	if (query.pending) {
+		return;
+	}
+	if (query.id == 0) {
+		glGenQueries(1, &query.id);
+	}
+	query.scale = mScale;
+	glBeginQuery(GL_TIME_ELAPSED, query.id);
+	mActive = mNext;
+}
+
+void gl::DynamicResolution::end()
+{
+	if (mActive < 0) {
+		return;
+	}
+	glEndQuery(GL_TIME_ELAPSED);
+	mQueries[mActive].pending = true;
+	mNext = (mActive + 1) % static_cast<int>(mQueries.size());
+	mActive = -1;
+}
+
+void gl::DynamicResolution::update()
+{
+	// Queries finish in the order they were issued, the oldest one is right after the latest
+	bool measured = false;
+	for (size_t i = 0; i < mQueries.size(); ++i) {
+		Query& query = mQueries[(mNext + i) % mQueries.size()];
+		if (!query.pending) {
+			continue;
+		}
+		GLint available = 0;
+		glGetQueryObjectiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			break;
+		}
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &nanoseconds);
+		query.pending = false;
+
+		mGpuTime = static_cast<float>(nanoseconds) * 1e-6f;
+		const float fullResolutionTime = mGpuTime / (query.scale * query.scale);
+		mFullResolutionTime = mFullResolutionTime > 0.0f
+			? mFullResolutionTime + (fullResolutionTime - mFullResolutionTime) * ::impl::TimeSmoothing
+			: fullResolutionTime;
+		measured = true;
+	}
+	if (!measured || mFullResolutionTime <= 0.0f) {
+		return;
+	}
+
+	const float step = std::max(scaleStep, 0.01f);
+	const float desired = std::sqrt(targetFrameTime / mFullResolutionTime);
+	float scale = std::floor(desired / step) * step;
+	// Growing needs some headroom, otherwise the scale flips between two steps
+	if (scale > mScale && desired < mScale + 1.5f * step) {
+		scale = mScale;
+	}
+	mScale = std::clamp(scale, minScale, std::max(minScale, maxScale));
+}
+
+void gl::DynamicResolution::reset()
+{
+	mFullResolutionTime = 0.0f;
+	mGpuTime = 0.0f;
+	mScale = maxScale;
+}
+
+float gl::DynamicResolution::scale() const
+{
+	return mScale;
+}
+
+float gl::DynamicResolution::gpuTime() const
+{
+	return mGpuTime;
+}
+
+float gl::DynamicResolution::fullResolutionTime() const
+{
+	return mFullResolutionTime;
+}
@@ -0,0 +1,307 @@
+#include "glpp/frame_graph.hpp"
+
+#include "glpp/state_cache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace impl {
+	void addUnique(std::vector<int>& indices, int index) {
+		if (std::find(indices.begin(), indices.end(), index) == indices.end()) {
+			indices.push_back(index);
+		}
+	}
+
+	size_t textureBytes(const gl::Texture& texture) {
+		return gl::getPixelSize(texture.pixelFormat, texture.pixelType) * texture.cols * texture.rows;
+	}
+}
+
+gl::FrameGraph::Builder::Builder(FrameGraph& graph, int pass) :
+	mGraph(graph),
+	mPass(pass)
+{
+}
+
+gl::FrameGraphResource gl::FrameGraph::Builder::create(const std::string& name, const FrameGraphTexture& desc)
+{
+	ResourceNode node;
+	node.name = name;
+	node.desc = desc;
+	mGraph.mResources.push_back(std::move(node));
+	return write({ static_cast<int>(mGraph.mResources.size()) - 1 });
+}
+
+gl::FrameGraphResource gl::FrameGraph::Builder::read(FrameGraphResource resource)
+{
+	if (resource.index < 0 || resource.index >= static_cast<int>(mGraph.mResources.size())) {
+		throw std::runtime_error("Pass " + mGraph.mPasses[mPass].name + " reads an invalid frame graph resource");
+	}
+	::impl::addUnique(mGraph.mPasses[mPass].reads, resource.index);
+	return resource;
+}
+
+gl::FrameGraphResource gl::FrameGraph::Builder::write(FrameGraphResource resource)
+{
+	if (resource.index < 0 || resource.index >= static_cast<int>(mGraph.mResources.size())) {
+		throw std::runtime_error("Pass " + mGraph.mPasses[mPass].name + " writes an invalid frame graph resource");
+	}
+	::impl::addUnique(mGraph.mPasses[mPass].writes, resource.index);
+	::impl::addUnique(mGraph.mResources[resource.index].writers, mPass);
+	return resource;
+}
+
+void gl::FrameGraph::Builder::sideEffect()
+{
+	mGraph.mPasses[mPass].sideEffect = true;
+}
+
+gl::FrameGraph::Resources::Resources(FrameGraph& graph) :
+	mGraph(graph)
+{
+}
+
+std::shared_ptr<gl::Texture> gl::FrameGraph::Resources::texture(FrameGraphResource resource) const
+{
+	return mGraph.mResources[resource.index].texture;
+}
+
+const gl::FrameGraphTexture& gl::FrameGraph::Resources::description(FrameGraphResource resource) const
+{
+	return mGraph.mResources[resource.index].desc;
+}
+
+glm::vec2 gl::FrameGraph::Resources::textureScale(FrameGraphResource resource) const
+{
+	return mGraph.mResources[resource.index].textureScale;
+}
+
+void gl::FrameGraph::Resources::bindFramebuffer(std::initializer_list<FrameGraphResource> colors, FrameGraphResource depth)
+{
+	gl::StateCache& state = gl::StateCache::Current();
+	if (mGraph.mFramebuffer == 0) {
+		glGenFramebuffers(1, &mGraph.mFramebuffer);
+	}
+	state.bindFramebuffer(GL_FRAMEBUFFER, mGraph.mFramebuffer);
+
+	std::vector<GLenum> drawBuffers;
+	FrameGraphTexture size;
+	for (FrameGraphResource color : colors) {
+		const ResourceNode& node = mGraph.mResources[color.index];
+		const GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(drawBuffers.size());
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, node.texture->id, 0);
+		drawBuffers.push_back(attachment);
+		size = node.desc;
+	}
+	// Detach what the previous pass left behind
+	for (int i = static_cast<int>(drawBuffers.size()); i < mGraph.mAttachedColors; ++i) {
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, 0, 0);
+	}
+	mGraph.mAttachedColors = static_cast<int>(drawBuffers.size());
+	glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+	if (depth.valid()) {
+		const ResourceNode& node = mGraph.mResources[depth.index];
+		const GLenum attachment = node.desc.format == PixelFormat::DEPTH_STENCIL ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, node.texture->id, 0);
+		if (drawBuffers.empty()) {
+			size = node.desc;
+		}
+	}
+	state.viewport(0, 0, size.width, size.height);
+}
+
+gl::FrameGraph::FrameGraph(gl::RenderTargetPool* pool) :
+	mCompiled(false),
+	mPool(pool),
+	mFramebuffer(0),
+	mAttachedColors(0)
+{
+}
+
+gl::FrameGraph::~FrameGraph()
+{
+	if (mFramebuffer != 0) {
+		glDeleteFramebuffers(1, &mFramebuffer);
+		gl::StateCache::Current().framebufferDeleted(mFramebuffer);
+	}
+}
+
+void gl::FrameGraph::addPass(const std::string& name, std::function<void(Builder&)> setup, std::function<void(Resources&)> execute)
+{
+	PassNode pass;
+	pass.name = name;
+	pass.execute = std::move(execute);
+	mPasses.push_back(std::move(pass));
+	Builder builder(*this, static_cast<int>(mPasses.size()) - 1);
+	if (setup) {
+		setup(builder);
+	}
+	mCompiled = false;
+}
+
+gl::FrameGraphResource gl::FrameGraph::import(const std::string& name, std::shared_ptr<gl::Texture> texture, glm::vec2 textureScale)
+{
+	ResourceNode node;
+	node.name = name;
+	node.desc = { static_cast<int>(texture->cols * textureScale.x + 0.5f), static_cast<int>(texture->rows * textureScale.y + 0.5f),
+		texture->pixelFormat, texture->pixelType };
+	node.texture = std::move(texture);
+	node.textureScale = textureScale;
+	node.imported = true;
+	mResources.push_back(std::move(node));
+	mCompiled = false;
+	return { static_cast<int>(mResources.size()) - 1 };
+}
+
+void gl::FrameGraph::compile()
+{
+	// Reference counts: Resources count their readers (imported ones are read outside of the graph), passes the
+	// resources they write that are still read
+	for (ResourceNode& resource : mResources) {
+		resource.refCount = resource.imported ? 1 : 0;
+	}
+	for (PassNode& pass : mPasses) {
+		pass.culled = false;
+		pass.acquire.clear();
+		pass.release.clear();
+		pass.refCount = static_cast<int>(pass.writes.size());
+		for (int read : pass.reads) {
+			++mResources[read].refCount;
+		}
+	}
+
+	// Cull passes without readers and whatever they alone were reading, starting at the unread resources
+	std::vector<int> unread;
+	auto cull = [&](PassNode& pass) {
+		pass.culled = true;
+		for (int read : pass.reads) {
+			if (--mResources[read].refCount == 0) {
+				unread.push_back(read);
+			}
+		}
+	};
+	for (PassNode& pass : mPasses) {
+		if (pass.refCount == 0 && !pass.sideEffect) {
+			cull(pass);
+		}
+	}
+	// This also covers the resources that were only read by passes culled above
+	unread.clear();
+	for (size_t i = 0; i < mResources.size(); ++i) {
+		if (mResources[i].refCount == 0) {
+			unread.push_back(static_cast<int>(i));
+		}
+	}
+	while (!unread.empty()) {
+		const int resource = unread.back();
+		unread.pop_back();
+		for (int writer : mResources[resource].writers) {
+			PassNode& pass = mPasses[writer];
+			if (!pass.culled && --pass.refCount == 0 && !pass.sideEffect) {
+				cull(pass);
+			}
+		}
+	}
+
+	// Lifetimes of the transients that are used by the remaining passes
+	std::vector<int> first(mResources.size(), -1);
+	std::vector<int> last(mResources.size(), -1);
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i) {
+		const PassNode& pass = mPasses[i];
+		if (pass.culled) {
+			continue;
+		}
+		for (const std::vector<int>* accesses : { &pass.reads, &pass.writes }) {
+			for (int resource : *accesses) {
+				if (first[resource] < 0) {
+					first[resource] = i;
+				}
+				last[resource] = std::max(last[resource], i);
+			}
+		}
+	}
+
+	mReport = Report();
+	mReport.passes = static_cast<int>(mPasses.size());
+	for (size_t i = 0; i < mResources.size(); ++i) {
+		const ResourceNode& resource = mResources[i];
+		if (resource.imported && first[i] >= 0) {
+			++mReport.imported;
+		}
+		if (resource.imported || first[i] < 0) {
+			continue;
+		}
+		mPasses[first[i]].acquire.push_back(static_cast<int>(i));
+		mPasses[last[i]].release.push_back(static_cast<int>(i));
+		++mReport.transients;
+		mReport.memoryWithoutAliasing += getPixelSize(resource.desc.format, resource.desc.type)
+			* RenderTargetPool::bucketSize(resource.desc.width) * RenderTargetPool::bucketSize(resource.desc.height);
+	}
+	for (const PassNode& pass : mPasses) {
+		if (pass.culled) {
+			++mReport.culledPasses;
+			mReport.culled.push_back(pass.name);
+		}
+	}
+	mCompiled = true;
+}
+
+void gl::FrameGraph::execute()
+{
+	if (!mCompiled) {
+		compile();
+	}
+
+	gl::StateCache& state = gl::StateCache::Current();
+	const GLuint previousFramebuffer = state.framebuffer(GL_DRAW_FRAMEBUFFER);
+	Resources resources(*this);
+	std::unordered_set<const gl::Texture*> physical;
+	for (PassNode& pass : mPasses) {
+		if (pass.culled) {
+			continue;
+		}
+		for (int index : pass.acquire) {
+			ResourceNode& resource = mResources[index];
+			resource.texture = mPool->acquire(resource.desc.width, resource.desc.height, resource.desc.format, resource.desc.type);
+			resource.textureScale = glm::vec2(resource.desc.width / static_cast<float>(resource.texture->cols),
+				resource.desc.height / static_cast<float>(resource.texture->rows));
+			if (physical.insert(resource.texture.get()).second) {
+				mReport.memory += ::impl::textureBytes(*resource.texture);
+			}
+		}
+		if (pass.execute) {
+			pass.execute(resources);
+		}
+		// Back to the pool, the next transient of the same bucket and format takes its place
+		for (int index : pass.release) {
+			mResources[index].texture = nullptr;
+		}
+	}
+	mReport.physicalTextures = static_cast<int>(physical.size());
+
+	// Attachments would keep the storage of released transients alive
+	if (mFramebuffer != 0) {
+		state.bindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+		for (int i = 0; i < mAttachedColors; ++i) {
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, 0, 0);
+		}
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+		mAttachedColors = 0;
+		state.bindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer == mFramebuffer ? 0 : previousFramebuffer);
+	}
+}
+
+void gl::FrameGraph::clear()
+{
+	mPasses.clear();
+	mResources.clear();
+	mCompiled = false;
+}
+
+const gl::FrameGraph::Report& gl::FrameGraph::report() const
+{
+	return mReport;
+}
@@ -5,13 +5,20 @@
 
 #include "glpp/texture.hpp"
 #include "glpp/logging.hpp"
+#include "glpp/pixel_buffer.hpp"
+#include "glpp/state_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
 
 
 namespace internal {
-	std::shared_ptr<gl::Texture> createAndCheckColorTexture(int width, int height, std::shared_ptr<gl::Texture> texture) {
+	std::shared_ptr<gl::Texture> createAndCheckColorTexture(int width, int height, std::shared_ptr<gl::Texture> texture,
+		gl::PixelFormat format = gl::PixelFormat::RGBA, gl::PixelType type = gl::PixelType::UByte) {
 		if (texture == nullptr) {
 			// Create a new texture
-			texture = std::make_shared<gl::Texture>(height, width, gl::PixelFormat::RGBA, gl::PixelType::UByte, gl::TextureFlags_FrameBuffer_Texture);
+			texture = std::make_shared<gl::Texture>(width, height, format, type, gl::TextureFlags_FrameBuffer_Texture);
 		}
 
 		// Check texture attributes
@@ -36,7 +43,7 @@ namespace internal {
 
 		if (texture == nullptr) {
 			// Create a new texture
-			texture = std::make_shared<gl::Texture>(height, width, pixelFormat, dataType, gl::TextureFlags_FrameBuffer_Texture);
+			texture = std::make_shared<gl::Texture>(width, height, pixelFormat, dataType, gl::TextureFlags_FrameBuffer_Texture);
 		}
 
 		// Check texture attributes
@@ -65,6 +72,39 @@ namespace internal {
 			return GL_RGBA;
 		}
 	}
+
+	size_t bytesPerPixel(GLenum format, GLenum type) {
+		size_t channels = 4;
+		switch (format) {
+		case GL_RED:
+		case GL_RED_INTEGER:
+		case GL_DEPTH_COMPONENT:
+		case GL_DEPTH_STENCIL:
+			channels = 1;
+			break;
+		case GL_RG:
+		case GL_RG_INTEGER:
+			channels = 2;
+			break;
+		case GL_RGB:
+		case GL_BGR:
+		case GL_RGB_INTEGER:
+		case GL_BGR_INTEGER:
+			channels = 3;
+			break;
+		}
+		switch (type) {
+		case GL_UNSIGNED_BYTE:
+		case GL_BYTE:
+			return channels;
+		case GL_HALF_FLOAT:
+		case GL_UNSIGNED_SHORT:
+		case GL_SHORT:
+			return 2 * channels;
+		default:
+			return 4 * channels;
+		}
+	}
 }
 
 std::shared_ptr<gl::Texture> gl::Framebuffer::setRenderTexture(int attachment, std::shared_ptr<gl::Texture> texture)
@@ -72,9 +112,29 @@ std::shared_ptr<gl::Texture> gl::Framebuffer::setRenderTexture(int attachment, s
 	assert(attachment < mColorAttachments.size());
 	assert(attachment >= 0 && attachment < GL_MAX_COLOR_ATTACHMENTS);
 
-	texture = internal::createAndCheckColorTexture(mWidth, mHeight, texture);
+	const bool pooled = texture == nullptr && mPool != nullptr;
+	if (pooled) {
+		texture = acquireTexture(gl::PixelFormat::RGBA, gl::PixelType::UByte);
+	}
+	texture = internal::createAndCheckColorTexture(mStorageWidth, mStorageHeight, texture);
 
 	mColorAttachments[attachment] = std::move(FramebufferAttachment(GL_COLOR_ATTACHMENT0 + attachment, texture));
+	mColorAttachments[attachment].pooled = pooled;
+
+	mRequriesUpdate = true;
+
+	return texture;
+}
+
+std::shared_ptr<gl::Texture> gl::Framebuffer::setRenderTexture(int attachment, gl::PixelFormat format, gl::PixelType type)
+{
+	assert(attachment < mColorAttachments.size());
+	assert(attachment >= 0 && attachment < GL_MAX_COLOR_ATTACHMENTS);
+
+	std::shared_ptr<gl::Texture> texture = internal::createAndCheckColorTexture(mStorageWidth, mStorageHeight, acquireTexture(format, type), format, type);
+
+	mColorAttachments[attachment] = std::move(FramebufferAttachment(GL_COLOR_ATTACHMENT0 + attachment, texture));
+	mColorAttachments[attachment].pooled = mPool != nullptr;
 
 	mRequriesUpdate = true;
 
@@ -85,9 +145,28 @@ std::shared_ptr<gl::Texture> gl::Framebuffer::appendRenderTexture(std::shared_pt
 {
 	assert(mColorAttachments.size() < GL_MAX_COLOR_ATTACHMENTS - 1);
 	
-	texture = internal::createAndCheckColorTexture(mWidth, mHeight, texture);
+	const bool pooled = texture == nullptr && mPool != nullptr;
+	if (pooled) {
+		texture = acquireTexture(gl::PixelFormat::RGBA, gl::PixelType::UByte);
+	}
+	texture = internal::createAndCheckColorTexture(mStorageWidth, mStorageHeight, texture);
+
+	mColorAttachments.emplace_back(FramebufferAttachment(GL_COLOR_ATTACHMENT0 + mColorAttachments.size(), texture));
+	mColorAttachments.back().pooled = pooled;
+
+	mRequriesUpdate = true;
+
+	return texture;
+}
+
+std::shared_ptr<gl::Texture> gl::Framebuffer::appendRenderTexture(gl::PixelFormat format, gl::PixelType type)
+{
+	assert(mColorAttachments.size() < GL_MAX_COLOR_ATTACHMENTS - 1);
+
+	std::shared_ptr<gl::Texture> texture = internal::createAndCheckColorTexture(mStorageWidth, mStorageHeight, acquireTexture(format, type), format, type);
 
 	mColorAttachments.emplace_back(FramebufferAttachment(GL_COLOR_ATTACHMENT0 + mColorAttachments.size(), texture));
+	mColorAttachments.back().pooled = mPool != nullptr;
 
 	mRequriesUpdate = true;
 
@@ -127,6 +206,11 @@ void gl::Framebuffer::clearColorAttachment(int slot, int value)
 	glClearBufferiv(GL_COLOR, slot, &value);
 }
 
+void gl::Framebuffer::clearColorAttachment(int slot, glm::uvec4 value)
+{
+	glClearBufferuiv(GL_COLOR, slot, &value[0]);
+}
+
 void gl::Framebuffer::clearDepthBuffer()
 {
 	glClear(GL_DEPTH_BUFFER_BIT);
@@ -142,13 +226,20 @@ void gl::Framebuffer::clearDepthAndStencilBuffer()
 	glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
-gl::Framebuffer::Framebuffer(int width, int height) :
+gl::Framebuffer::Framebuffer(int width, int height, gl::RenderTargetPool* pool) :
 	mId(0),
 	mPreviousFBO(-1),
 	mWidth(width),
 	mHeight(height),
+	mStorageWidth(pool != nullptr ? RenderTargetPool::bucketSize(width) : width),
+	mStorageHeight(pool != nullptr ? RenderTargetPool::bucketSize(height) : height),
+	mPool(pool),
+	mSamples(1),
+	mMultisampleId(0),
 	mDepthAttachment(GL_DEPTH_ATTACHMENT),
-	mRequriesUpdate(true)
+	mRequriesUpdate(true),
+	mPixelReadback(std::make_shared<PixelReadback>()),
+	mGeneration(0)
 {
 	mColorAttachments.emplace_back(FramebufferAttachment(GL_COLOR_ATTACHMENT0));
 }
@@ -157,15 +248,24 @@ gl::Framebuffer::~Framebuffer()
 {
 	if (mId != 0) {
 		glDeleteFramebuffers(1, &mId);
+		gl::StateCache::Current().framebufferDeleted(mId);
 		mId = 0;
 	}
+	deleteMultisampleBuffers();
 }
 
 std::shared_ptr<gl::Texture> gl::Framebuffer::setDepthTexture(std::shared_ptr<gl::Texture> texture, bool depthAndStencil)
 {
-	texture = internal::createAndCheckDepthTexture(mWidth, mHeight, texture, depthAndStencil);
+	const bool pooled = texture == nullptr && mPool != nullptr;
+	if (pooled) {
+		texture = depthAndStencil
+			? acquireTexture(gl::PixelFormat::DEPTH_STENCIL, gl::PixelType::UIntByte)
+			: acquireTexture(gl::PixelFormat::DEPTH, gl::PixelType::Float);
+	}
+	texture = internal::createAndCheckDepthTexture(mStorageWidth, mStorageHeight, texture, depthAndStencil);
 	const GLenum attachment = depthAndStencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
 	mDepthAttachment = FramebufferAttachment(attachment, texture);
+	mDepthAttachment.pooled = pooled;
 	mRequriesUpdate = true;
 	return texture;
 }
@@ -178,21 +278,22 @@ void gl::Framebuffer::update()
 	// Destroy the fbo and the attached depth buffer
 	if (mId != 0) {
 		glDeleteFramebuffers(1, &mId);
+		gl::StateCache::Current().framebufferDeleted(mId);
 	}
 
 	// Recreate fbo
 	glGenFramebuffers(1, &mId);
 	
-	mDepthAttachment.attach(mId, mWidth, mHeight);
+	mDepthAttachment.attach(mId, mStorageWidth, mStorageHeight);
 	
 	// Resize all color textures
 	std::vector<GLenum> drawBuffers;
 	for (int i = 0; i < (int)mColorAttachments.size(); ++i) {
-		mColorAttachments[i].attach(mId, mWidth, mHeight);
+		mColorAttachments[i].attach(mId, mStorageWidth, mStorageHeight);
 		drawBuffers.push_back(mColorAttachments[i].attachment);
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, mId);
+	gl::StateCache::Current().bindFramebuffer(GL_FRAMEBUFFER, mId);
 	glDrawBuffers(drawBuffers.size(), drawBuffers.data());
 
 	GLenum framebufferState = glCheckFramebufferStatus(GL_FRAMEBUFFER);
@@ -200,11 +301,112 @@ void gl::Framebuffer::update()
 		LOG_ERROR("Error creating framebuffer");
 		throw std::runtime_error("Error creating framebuffer");
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	gl::StateCache::Current().bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	deleteMultisampleBuffers();
+	if (mSamples > 1) {
+		createMultisampleBuffers();
+	}
 
 	mRequriesUpdate = false;
 }
 
+void gl::Framebuffer::setSamples(int samples)
+{
+	GLint maxSamples;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	samples = std::max(1, std::min(samples, (int)maxSamples));
+	if (samples != mSamples) {
+		mSamples = samples;
+		mRequriesUpdate = true;
+	}
+}
+
+void gl::Framebuffer::resolve(bool depth)
+{
+	if (mRequriesUpdate) {
+		update();
+	}
+	++mGeneration;
+	gl::StateCache& state = gl::StateCache::Current();
+	if (mSamples > 1) {
+		state.bindFramebuffer(GL_READ_FRAMEBUFFER, mMultisampleId);
+		state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, mId);
+		// Only the rendered part is copied, render textures of a pool are larger than the framebuffer
+		std::vector<GLenum> drawBuffers;
+		for (int i = 0; i < (int)mColorAttachments.size(); ++i) {
+			drawBuffers.push_back(mColorAttachments[i].attachment);
+			if (isIntegerAttachment(i)) {
+				continue;
+			}
+			glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
+			glDrawBuffer(GL_COLOR_ATTACHMENT0 + i);
+			glBlitFramebuffer(0, 0, mWidth, mHeight, 0, 0, mWidth, mHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+		if (depth) {
+			const GLbitfield mask = mDepthAttachment.attachment == GL_DEPTH_STENCIL_ATTACHMENT
+				? GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT
+				: GL_DEPTH_BUFFER_BIT;
+			glBlitFramebuffer(0, 0, mWidth, mHeight, 0, 0, mWidth, mHeight, mask, GL_NEAREST);
+		}
+		glReadBuffer(GL_COLOR_ATTACHMENT0);
+		glDrawBuffers(drawBuffers.size(), drawBuffers.data());
+	}
+	state.bindFramebuffer(GL_FRAMEBUFFER, mId);
+	state.viewport(0, 0, mWidth, mHeight);
+}
+
+void gl::Framebuffer::createMultisampleBuffers()
+{
+	glGenFramebuffers(1, &mMultisampleId);
+	gl::StateCache::Current().bindFramebuffer(GL_FRAMEBUFFER, mMultisampleId);
+
+	auto createBuffer = [&](const FramebufferAttachment& attachment) {
+		const GLenum format = attachment.targetTexture != nullptr
+			? attachment.targetTexture->glSizedFormat()
+			: internal::getRenderBufferStorageDataType(attachment.attachment);
+		GLuint buffer;
+		glGenRenderbuffers(1, &buffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, buffer);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, mSamples, format, mStorageWidth, mStorageHeight);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment.attachment, GL_RENDERBUFFER, buffer);
+		mMultisampleBuffers.push_back(buffer);
+	};
+
+	createBuffer(mDepthAttachment);
+	std::vector<GLenum> drawBuffers;
+	for (int i = 0; i < (int)mColorAttachments.size(); ++i) {
+		if (isIntegerAttachment(i)) {
+			drawBuffers.push_back(GL_NONE);
+			continue;
+		}
+		createBuffer(mColorAttachments[i]);
+		drawBuffers.push_back(mColorAttachments[i].attachment);
+	}
+	glDrawBuffers(drawBuffers.size(), drawBuffers.data());
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	GLenum framebufferState = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (framebufferState != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_ERROR("Error creating multisampled framebuffer");
+		throw std::runtime_error("Error creating multisampled framebuffer");
+	}
+	gl::StateCache::Current().bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void gl::Framebuffer::deleteMultisampleBuffers()
+{
+	if (mMultisampleId != 0) {
+		glDeleteFramebuffers(1, &mMultisampleId);
+		gl::StateCache::Current().framebufferDeleted(mMultisampleId);
+		mMultisampleId = 0;
+	}
+	if (!mMultisampleBuffers.empty()) {
+		glDeleteRenderbuffers((GLsizei)mMultisampleBuffers.size(), mMultisampleBuffers.data());
+		mMultisampleBuffers.clear();
+	}
+}
+
 void gl::Framebuffer::resize(int width, int height)
 {
 	if (height == mHeight && width == mWidth)
@@ -212,12 +414,60 @@ void gl::Framebuffer::resize(int width, int height)
 
 	mHeight = height;
 	mWidth = width;
-	mRequriesUpdate = true;	
+	if (mPool == nullptr) {
+		mStorageWidth = width;
+		mStorageHeight = height;
+		mRequriesUpdate = true;
+		return;
+	}
+
+	// Grow right away, but keep rendering into a part of the textures until they are more than twice as large
+	const int cols = RenderTargetPool::bucketSize(width);
+	const int rows = RenderTargetPool::bucketSize(height);
+	const bool grow = cols > mStorageWidth || rows > mStorageHeight;
+	const bool shrink = 2 * cols <= mStorageWidth || 2 * rows <= mStorageHeight;
+	if (!grow && !shrink) {
+		return;
+	}
+	mStorageWidth = cols;
+	mStorageHeight = rows;
+	// The previous textures return to the pool, which keeps them for a while in case the old size comes back
+	for (FramebufferAttachment& attachment : mColorAttachments) {
+		if (attachment.pooled) {
+			attachment.targetTexture = acquireTexture(attachment.targetTexture->pixelFormat, attachment.targetTexture->pixelType);
+		}
+	}
+	if (mDepthAttachment.pooled) {
+		mDepthAttachment.targetTexture = acquireTexture(mDepthAttachment.targetTexture->pixelFormat, mDepthAttachment.targetTexture->pixelType);
+	}
+	mRequriesUpdate = true;
+}
+
+glm::vec2 gl::Framebuffer::textureScale() const
+{
+	return glm::vec2(mWidth, mHeight) / glm::vec2(std::max(mStorageWidth, 1), std::max(mStorageHeight, 1));
+}
+
+void gl::Framebuffer::blitDepth(gl::Framebuffer& target)
+{
+	if (mRequriesUpdate) {
+		update();
+	}
+	if (target.mRequriesUpdate) {
+		target.update();
+	}
+	gl::StateCache& state = gl::StateCache::Current();
+	state.bindFramebuffer(GL_READ_FRAMEBUFFER, mId);
+	state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, target.mId);
+	const GLbitfield mask = mDepthAttachment.attachment == GL_DEPTH_STENCIL_ATTACHMENT
+		? GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT : GL_DEPTH_BUFFER_BIT;
+	glBlitFramebuffer(0, 0, mWidth, mHeight, 0, 0, target.mWidth, target.mHeight, mask, GL_NEAREST);
+	state.bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void gl::Framebuffer::blitToDefaultBuffer()
 {
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	gl::StateCache::Current().bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 	glDrawBuffer(GL_BACK);
 
 	bind();
@@ -235,13 +485,87 @@ void gl::Framebuffer::blitToDefaultBuffer()
 glm::uvec4 gl::Framebuffer::readColorPixel(int col, int row, int slot)
 {
 	assert(slot < mColorAttachments.size());
-	bind();
-	std::vector<unsigned char> buffer(4);
-	glReadBuffer(GL_COLOR_ATTACHMENT0 + slot);
-	glReadPixels(col, mHeight - row, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
-	glReadBuffer(GL_COLOR_ATTACHMENT0);
-	return glm::vec4(buffer[0], buffer[1], buffer[2], buffer[3]);
-	unbind();
+	const GLuint oldFramebuffer = bindForReading(slot);
+	glm::uvec4 value;
+	if (isIntegerAttachment(slot)) {
+		glReadPixels(col, mHeight - 1 - row, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_INT, &value[0]);
+	}
+	else {
+		std::vector<unsigned char> buffer(4);
+		glReadPixels(col, mHeight - 1 - row, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+		value = glm::uvec4(buffer[0], buffer[1], buffer[2], buffer[3]);
+	}
+	gl::StateCache::Current().bindFramebuffer(GL_READ_FRAMEBUFFER, oldFramebuffer);
+	return value;
+}
+
+std::future<glm::uvec4> gl::Framebuffer::readColorPixelAsync(int col, int row, int slot, std::function<void(glm::uvec4)> onFinished)
+{
+	return readPixelAsync(col, row, slot, onFinished, false);
+}
+
+std::future<glm::uvec4> gl::Framebuffer::readPixelAsync(int col, int row, int slot, std::function<void(glm::uvec4)> onFinished, bool background)
+{
+	assert(slot < mColorAttachments.size());
+	const bool integer = isIntegerAttachment(slot);
+	const size_t size = integer ? sizeof(glm::uvec4) : 4;
+	DownloadQueue& queue = DownloadQueue::Default();
+	const int bufferSlot = queue.acquire(size);
+	// Only the read binding is touched, so this can be called while rendering into another framebuffer
+	const GLuint oldFramebuffer = bindForReading(slot);
+	queue.ring().bind(bufferSlot);
+	if (integer) {
+		glReadPixels(col, mHeight - 1 - row, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
+	}
+	else {
+		glReadPixels(col, mHeight - 1 - row, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+	queue.ring().unbind();
+	gl::StateCache::Current().bindFramebuffer(GL_READ_FRAMEBUFFER, oldFramebuffer);
+
+	std::shared_ptr<std::array<unsigned char, sizeof(glm::uvec4)>> pixel = std::make_shared<std::array<unsigned char, sizeof(glm::uvec4)>>();
+	std::shared_ptr<std::promise<glm::uvec4>> promise = std::make_shared<std::promise<glm::uvec4>>();
+	std::future<glm::uvec4> future = promise->get_future();
+	queue.push(bufferSlot, size, pixel->data(), [pixel, promise, integer, onFinished]() {
+		glm::uvec4 value;
+		if (integer) {
+			std::memcpy(&value[0], pixel->data(), sizeof(value));
+		}
+		else {
+			value = glm::uvec4((*pixel)[0], (*pixel)[1], (*pixel)[2], (*pixel)[3]);
+		}
+		promise->set_value(value);
+		if (onFinished) {
+			onFinished(value);
+		}
+	}, background);
+	return future;
+}
+
+glm::uvec4 gl::Framebuffer::latestColorPixel(int col, int row, int slot)
+{
+	if (col < 0 || row < 0 || col >= mWidth || row >= mHeight) {
+		return glm::uvec4(0);
+	}
+	// Nothing changed since the last read, so it already holds the value
+	const glm::ivec3 request(col, row, slot);
+	if (request == mPixelReadback->request && mGeneration == mPixelReadback->generation) {
+		return mPixelReadback->value;
+	}
+	// Skip reads while the previous ones are still in flight, so slow frames do not fill the download queue
+	if (mPixelReadback->pending < 2) {
+		++mPixelReadback->pending;
+		mPixelReadback->request = request;
+		mPixelReadback->generation = mGeneration;
+		std::weak_ptr<PixelReadback> readback = mPixelReadback;
+		readPixelAsync(col, row, slot, [readback](glm::uvec4 value) {
+			if (std::shared_ptr<PixelReadback> state = readback.lock()) {
+				state->value = value;
+				--state->pending;
+			}
+		}, true);
+	}
+	return mPixelReadback->value;
 }
 
 std::shared_ptr<gl::Texture> gl::Framebuffer::getRenderTexture(int slot)
@@ -256,13 +580,66 @@ std::shared_ptr<gl::Texture> gl::Framebuffer::getDepthTexture()
 
 void gl::Framebuffer::readColorAttachment(int slot, int x, int y, int width, int height, void* buffer)
 {
-	bind();
-	glReadBuffer(GL_COLOR_ATTACHMENT0 + slot);
+	const GLuint oldFramebuffer = bindForReading(slot);
 	glReadPixels(x, y, width, height,
 		mColorAttachments[slot].dataFormat(),
 		mColorAttachments[slot].dataType(),
 		buffer);
-	unbind();
+	gl::StateCache::Current().bindFramebuffer(GL_READ_FRAMEBUFFER, oldFramebuffer);
+}
+
+std::future<void> gl::Framebuffer::readColorAttachmentAsync(int slot, int x, int y, int width, int height, void* dst, std::function<void()> onFinished)
+{
+	assert(slot < mColorAttachments.size());
+	const GLenum format = mColorAttachments[slot].dataFormat();
+	const GLenum type = mColorAttachments[slot].dataType();
+	const size_t rowSize = internal::bytesPerPixel(format, type) * width;
+	const size_t size = rowSize * height;
+
+	DownloadQueue& queue = DownloadQueue::Default();
+	const int bufferSlot = queue.acquire(size);
+	GLint oldAlign;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &oldAlign);
+	glPixelStorei(GL_PACK_ALIGNMENT, rowSize % 4 == 0 ? 4 : 1);
+	const GLuint oldFramebuffer = bindForReading(slot);
+	queue.ring().bind(bufferSlot);
+	glReadPixels(x, y, width, height, format, type, nullptr);
+	queue.ring().unbind();
+	gl::StateCache::Current().bindFramebuffer(GL_READ_FRAMEBUFFER, oldFramebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, oldAlign);
+	return queue.push(bufferSlot, size, dst, onFinished);
+}
+
+std::future<void> gl::Framebuffer::readColorAttachmentAsync(int slot, void* dst, std::function<void()> onFinished)
+{
+	return readColorAttachmentAsync(slot, 0, 0, mWidth, mHeight, dst, onFinished);
+}
+
+std::shared_ptr<gl::Texture> gl::Framebuffer::acquireTexture(gl::PixelFormat format, gl::PixelType type)
+{
+	if (mPool == nullptr) {
+		return nullptr;
+	}
+	return mPool->acquire(mStorageWidth, mStorageHeight, format, type);
+}
+
+bool gl::Framebuffer::isIntegerAttachment(int slot) const
+{
+	const std::shared_ptr<gl::Texture>& texture = mColorAttachments[slot].targetTexture;
+	return texture != nullptr && texture->glType() == GL_UNSIGNED_INT;
+}
+
+GLuint gl::Framebuffer::bindForReading(int slot)
+{
+	if (mRequriesUpdate) {
+		FBOStateGuard guard;
+		update();
+	}
+	gl::StateCache& state = gl::StateCache::Current();
+	const GLuint oldFramebuffer = state.framebuffer(GL_READ_FRAMEBUFFER);
+	state.bindFramebuffer(GL_READ_FRAMEBUFFER, mId);
+	glReadBuffer(GL_COLOR_ATTACHMENT0 + slot);
+	return oldFramebuffer;
 }
 
 void gl::Framebuffer::bind()
@@ -270,42 +647,41 @@ void gl::Framebuffer::bind()
 	if (mRequriesUpdate)
 		update();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, mId);
-	glViewport(0, 0, mWidth, mHeight);
+	++mGeneration;
+	gl::StateCache& state = gl::StateCache::Current();
+	state.bindFramebuffer(GL_FRAMEBUFFER, mSamples > 1 ? mMultisampleId : mId);
+	state.viewport(0, 0, mWidth, mHeight);
 }
 
 void gl::Framebuffer::unbind()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	gl::StateCache::Current().bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 gl::Framebuffer::FramebufferAttachment::FramebufferAttachment() :
 	targetBuffer(0),
 	targetTexture(nullptr),
-	attachment(0)
+	attachment(0),
+	pooled(false)
 {
 }
 
 gl::Framebuffer::FramebufferAttachment::FramebufferAttachment(GLenum attachment, std::shared_ptr<gl::Texture> texture) :
 	targetTexture(texture),
 	targetBuffer(0),
-	attachment(attachment)
+	attachment(attachment),
+	pooled(false)
 {
 }
 
-gl::Framebuffer::FramebufferAttachment::FramebufferAttachment(FramebufferAttachment&& other)
+gl::Framebuffer::FramebufferAttachment::FramebufferAttachment(FramebufferAttachment&& other) :
+	targetTexture(std::move(other.targetTexture)),
+	targetBuffer(other.targetBuffer),
+	attachment(other.attachment),
+	pooled(other.pooled)
 {
-	if (&other != this) {
-		if (targetBuffer != 0) {
-			glDeleteRenderbuffers(1, &targetBuffer);
-		}
-		targetBuffer = other.targetBuffer;
-		targetTexture = other.targetTexture;
-		attachment = other.attachment;
-
-		other.targetTexture = nullptr;
-		other.targetBuffer = 0;
-	}
+	// The renderbuffer now belongs to this attachment
+	other.targetBuffer = 0;
 }
 
 gl::Framebuffer::FramebufferAttachment::~FramebufferAttachment()
@@ -327,16 +703,21 @@ gl::Framebuffer::FramebufferAttachment& gl::Framebuffer::FramebufferAttachment::
 	targetBuffer = other.targetBuffer;
 	targetTexture = other.targetTexture;
 	attachment = other.attachment;
+	pooled = other.pooled;
 
 	other.targetBuffer = 0;
 	other.targetTexture = nullptr;
+
+	return *this;
 }
 
 void gl::Framebuffer::FramebufferAttachment::attach(GLuint framebuffer, int width, int height)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	gl::StateCache::Current().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 	if (targetTexture != nullptr) {
-		targetTexture->resize(width, height);
+		if (targetTexture->cols != width || targetTexture->rows != height) {
+			targetTexture->resize(width, height);
+		}
 		// Ensure that resize actually is updated
 		targetTexture->bind();
 		glFramebufferTexture(GL_FRAMEBUFFER, attachment, targetTexture->id, 0);
@@ -350,7 +731,7 @@ void gl::Framebuffer::FramebufferAttachment::attach(GLuint framebuffer, int widt
 		glRenderbufferStorage(GL_RENDERBUFFER, internal::getRenderBufferStorageDataType(attachment), width, height);
 		glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, targetBuffer);
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	gl::StateCache::Current().bindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 GLenum gl::Framebuffer::FramebufferAttachment::dataType() const
@@ -381,14 +762,12 @@ GLenum gl::Framebuffer::FramebufferAttachment::dataFormat() const
 
 gl::FBOState gl::FBOState::Current()
 {
-	GLint id;
-	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &id);
-	return { GLuint(id) };
+	return { gl::StateCache::Current().framebuffer(GL_DRAW_FRAMEBUFFER) };
 }
 
 void gl::FBOState::restore()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, id);
+	gl::StateCache::Current().bindFramebuffer(GL_FRAMEBUFFER, id);
 }
 
 gl::FBOStateGuard::FBOStateGuard() :
@@ -0,0 +1,254 @@
+#include "glpp/image_filter.hpp"
+#include "glpp/shadermanager.hpp"
+
+#include "../shaders/image_filter.glsl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace impl {
+	// Images can only be bound with one, two or four channels
+	gl::PixelFormat imageFormat(gl::PixelFormat format) {
+		switch (format) {
+		case gl::PixelFormat::Red:
+		case gl::PixelFormat::RG:
+			return format;
+		default:
+			return gl::PixelFormat::RGBA;
+		}
+	}
+
+	std::string formatQualifier(gl::PixelFormat format, gl::PixelType type) {
+		std::string qualifier = format == gl::PixelFormat::Red ? "r" : format == gl::PixelFormat::RG ? "rg" : "rgba";
+		switch (type) {
+		case gl::PixelType::Float:
+			return qualifier + "32f";
+		case gl::PixelType::Half:
+			return qualifier + "16f";
+		case gl::PixelType::UByte:
+			return qualifier + "8";
+		default:
+			throw std::invalid_argument("Filters only support float, half float and 8 bit textures");
+		}
+	}
+
+	gl::ComputeShader& filterShader(const char* code, const std::string& defines) {
+		// Compiled once per filter and define set and kept for the rest of the program, deleting the programs at exit
+		// would need a current context
+		static std::unordered_map<std::string, gl::ComputeShader*>* shaders = new std::unordered_map<std::string, gl::ComputeShader*>();
+		const std::string key = std::to_string(reinterpret_cast<uintptr_t>(code)) + defines;
+		auto it = shaders->find(key);
+		if (it == shaders->end()) {
+			it = shaders->emplace(key, new gl::ComputeShader("#version 430\n" + defines + code)).first;
+		}
+		return *it->second;
+	}
+
+	GLuint kernelBuffer() {
+		// Shared by all filters, every run replaces its content. It is released together with the context
+		static GLuint buffer = 0;
+		if (buffer == 0) {
+			glGenBuffers(1, &buffer);
+		}
+		return buffer;
+	}
+
+	void dispatch(gl::ComputeShader& shader, gl::Texture& source, gl::Texture& target, GLuint groupsX, GLuint groupsY) {
+		source.bind(0);
+		shader.setUniform("source", 0);
+		target.bindAsImage(0, gl::Access::WriteOnly);
+		glDispatchCompute(groupsX, groupsY, 1);
+		// The result is read by the next filter, but may also be drawn, downloaded or attached to a framebuffer
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+		glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+		source.unbind();
+	}
+
+	// Internal linkage, other translation units define the same helper
+	static GLuint groups(int size, int groupSize) {
+		return static_cast<GLuint>((size + groupSize - 1) / groupSize);
+	}
+}
+
+gl::ImageFilter::ImageFilter(std::shared_ptr<gl::Texture> source, TexturePool& pool) :
+	mImage(source),
+	mPool(pool)
+{
+	if (source == nullptr || source->type != TextureType::D2) {
+		throw std::invalid_argument("Filters can only be applied to 2D textures");
+	}
+	// Throws for unsupported types
+	::impl::formatQualifier(source->pixelFormat, source->pixelType);
+}
+
+gl::ImageFilter& gl::ImageFilter::convolve(const std::vector<float>& kernelX, const std::vector<float>& kernelY)
+{
+	if (kernelX.size() % 2 == 0 || kernelY.size() % 2 == 0) {
+		throw std::invalid_argument("Convolution kernels must have an odd number of weights");
+	}
+	separable(Operation::Convolve, 0, kernelX);
+	separable(Operation::Convolve, 1, kernelY);
+	return *this;
+}
+
+gl::ImageFilter& gl::ImageFilter::boxBlur(int radius)
+{
+	if (radius <= 0) {
+		return *this;
+	}
+	const std::vector<float> kernel(2 * radius + 1, 1.0f / (2 * radius + 1));
+	return convolve(kernel, kernel);
+}
+
+gl::ImageFilter& gl::ImageFilter::gaussianBlur(int radius, float sigma)
+{
+	if (radius <= 0) {
+		return *this;
+	}
+	if (sigma <= 0.0f) {
+		sigma = std::max(radius / 3.0f, 0.5f);
+	}
+	std::vector<float> kernel(2 * radius + 1);
+	float sum = 0.0f;
+	for (int i = -radius; i <= radius; ++i) {
+		kernel[i + radius] = std::exp(-0.5f * i * i / (sigma * sigma));
+		sum += kernel[i + radius];
+	}
+	for (float& weight : kernel) {
+		weight /= sum;
+	}
+	return convolve(kernel, kernel);
+}
+
+gl::ImageFilter& gl::ImageFilter::erode(int radius)
+{
+	if (radius > 0) {
+		const std::vector<float> window(2 * radius + 1, 1.0f);
+		separable(Operation::Min, 0, window);
+		separable(Operation::Min, 1, window);
+	}
+	return *this;
+}
+
+gl::ImageFilter& gl::ImageFilter::dilate(int radius)
+{
+	if (radius > 0) {
+		const std::vector<float> window(2 * radius + 1, 1.0f);
+		separable(Operation::Max, 0, window);
+		separable(Operation::Max, 1, window);
+	}
+	return *this;
+}
+
+gl::ImageFilter& gl::ImageFilter::sobel()
+{
+	// Gradients are signed, so 8 bit images get a half float result
+	const PixelType type = mImage->pixelType == PixelType::Float ? PixelType::Float : PixelType::Half;
+	std::shared_ptr<gl::Texture> result = mPool.acquire(mImage->cols, mImage->rows, PixelFormat::RGBA, type);
+
+	gl::ComputeShader& shader = ::impl::filterShader(SOBEL_CS, "#define IMAGE_FORMAT " + ::impl::formatQualifier(PixelFormat::RGBA, type) + "\n");
+	shader.use();
+	shader.setUniform("channels", mImage->channels());
+	::impl::dispatch(shader, *mImage, *result, ::impl::groups(result->cols, 16), ::impl::groups(result->rows, 16));
+	mImage = result;
+	return *this;
+}
+
+gl::ImageFilter& gl::ImageFilter::resize(int cols, int rows, ResampleFilter filter)
+{
+	if (cols <= 0 || rows <= 0) {
+		throw std::invalid_argument("Images can not be resized to zero pixels");
+	}
+	const PixelFormat format = ::impl::imageFormat(mImage->pixelFormat);
+	const std::string defines = "#define IMAGE_FORMAT " + ::impl::formatQualifier(format, mImage->pixelType) +
+		"\n#define FILTER " + std::to_string(static_cast<int>(filter)) + "\n";
+	const int size[2] = { cols, rows };
+
+	// One pass per axis, which only costs (2 * support) instead of (2 * support)^2 fetches per pixel
+	for (int axis = 0; axis < 2; ++axis) {
+		const int current = axis == 0 ? mImage->cols : mImage->rows;
+		if (current == size[axis]) {
+			continue;
+		}
+		std::shared_ptr<gl::Texture> result = axis == 0
+			? mPool.acquire(cols, mImage->rows, format, mImage->pixelType)
+			: mPool.acquire(mImage->cols, rows, format, mImage->pixelType);
+		gl::ComputeShader& shader = ::impl::filterShader(RESAMPLE_CS, defines + "#define AXIS " + std::to_string(axis) + "\n");
+		shader.use();
+		shader.setUniform("scale", static_cast<float>(current) / size[axis]);
+		::impl::dispatch(shader, *mImage, *result, ::impl::groups(result->cols, 16), ::impl::groups(result->rows, 16));
+		mImage = result;
+	}
+	return *this;
+}
+
+gl::ImageFilter& gl::ImageFilter::mapLut(gl::Texture& lut, glm::vec2 range, bool perChannel)
+{
+	if (lut.type != TextureType::D1 && lut.type != TextureType::D2) {
+		throw std::invalid_argument("Lookup tables must be 1D or 2D textures");
+	}
+	const PixelFormat format = perChannel ? ::impl::imageFormat(mImage->pixelFormat) : PixelFormat::RGBA;
+	std::shared_ptr<gl::Texture> result = mPool.acquire(mImage->cols, mImage->rows, format, mImage->pixelType);
+
+	std::string defines = "#define IMAGE_FORMAT " + ::impl::formatQualifier(format, mImage->pixelType) + "\n";
+	if (perChannel) {
+		defines += "#define PER_CHANNEL\n";
+	}
+	if (lut.type == TextureType::D1) {
+		defines += "#define LUT_1D\n";
+	}
+	gl::ComputeShader& shader = ::impl::filterShader(LUT_CS, defines);
+	shader.use();
+	lut.bind(1);
+	shader.setUniform("lut", 1);
+	shader.setUniform("lutSize", lut.cols);
+	shader.setUniform("range", range);
+	::impl::dispatch(shader, *mImage, *result, ::impl::groups(result->cols, 16), ::impl::groups(result->rows, 16));
+	gl::StateCache::Current().activeTexture(1);
+	lut.unbind();
+	gl::StateCache::Current().activeTexture(0);
+	mImage = result;
+	return *this;
+}
+
+std::shared_ptr<gl::Texture> gl::ImageFilter::result() const
+{
+	return mImage;
+}
+
+void gl::ImageFilter::separable(Operation operation, int axis, const std::vector<float>& kernel)
+{
+	const int radius = static_cast<int>(kernel.size() / 2);
+	const PixelFormat format = ::impl::imageFormat(mImage->pixelFormat);
+	std::shared_ptr<gl::Texture> result = mPool.acquire(mImage->cols, mImage->rows, format, mImage->pixelType);
+
+	std::string defines = "#define IMAGE_FORMAT " + ::impl::formatQualifier(format, mImage->pixelType) +
+		"\n#define AXIS " + std::to_string(axis) +
+		"\n#define OPERATION " + std::to_string(static_cast<int>(operation)) + "\n";
+	// Larger windows do not fit into shared memory and are read from the texture cache instead
+	if (radius <= 256) {
+		defines += "#define TILED\n";
+	}
+	gl::ComputeShader& shader = ::impl::filterShader(SEPARABLE_FILTER_CS, defines);
+
+	const GLuint buffer = ::impl::kernelBuffer();
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, kernel.size() * sizeof(float), kernel.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+
+	shader.use();
+	shader.setUniform("radius", radius);
+	if (axis == 0) {
+		::impl::dispatch(shader, *mImage, *result, ::impl::groups(result->cols, 256), result->rows);
+	}
+	else {
+		::impl::dispatch(shader, *mImage, *result, result->cols, ::impl::groups(result->rows, 256));
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	mImage = result;
+}
@@ -64,15 +64,21 @@ namespace ImGui3D {
 			g.ActiveId = 0;
 		}
 
-		// Look for ids under the mouse cursor if neccessary
+		// Look for ids under the mouse cursor if neccessary. Otherwise the id pass is skipped
 		ImRect windowRect = ImRect(g.ScreenPosition, g.ScreenPosition + g.ScreenSize);
 		bool imguiUsesIO = windowID == 0
 			? io.WantCaptureMouse || io.WantCaptureKeyboard
 			: false;	// FIXME: This should not always be true!
+		g.CursorPixel = glm::ivec2(-1);
 		if (!g.KeepCaptureFocus && !imguiUsesIO && windowRect.Contains(io.MousePos)) {
-			g.ActiveIdColor = g.GetHoveredIdImpl(io.MousePos);
+			g.CursorPixel = g.GetCursorPixelImpl(io.MousePos);
+			// Only the region around the cursor of the last frame holds valid ids
+			const glm::ivec2& p = g.CursorPixel;
+			const glm::ivec4& r = g.IdPassRegion;
+			const bool rendered = p.x >= r.x && p.y >= r.y && p.x < r.z && p.y < r.w;
+			g.HoveredId = rendered ? g.GetHoveredIdImpl(p) : 0;
 			g.ActiveIdPreviousFrame = g.ActiveId;
-			g.ActiveId = ColorToID(g.ActiveIdColor.r, g.ActiveIdColor.g, g.ActiveIdColor.b);
+			g.ActiveId = g.HoveredId;
 		}
 
 
@@ -83,12 +89,43 @@ namespace ImGui3D {
 		IM_ASSERT(GImGui3D != nullptr && "No current context. Did you call ImGui3D::CreateContext() or ImGui3D::SetCurrentContext()?");
 		ImGui3DContext& g = *GImGui3D;
 
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		gl::StateCache& state = gl::StateCache::Current();
+		state.enable(GL_BLEND);
+		state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		state.colorMask(1, false, false, false, false);
 		for (auto cmd : g.drawCommands) {
 			cmd->execute();
 		}
-		glDisable(GL_BLEND);
+		state.colorMask(1, true, true, true, true);
+		state.disable(GL_BLEND);
+
+		// The id pass only has to answer what is under the cursor, so it is scissored to a few pixels around it
+		const glm::ivec4 viewport = state.viewport();
+		const glm::ivec2 pixel = g.CursorPixel;
+		if (pixel.x < 0 || pixel.y < 0 || pixel.x >= viewport[2] || pixel.y >= viewport[3]) {
+			g.IdPassRegion = glm::ivec4(0);
+			return;
+		}
+		const int radius = g.IdPassRadius;
+		g.IdPassRegion = glm::ivec4(pixel - radius, pixel + radius + 1);
+
+		const GLenum depthFunc = state.depthFunc();
+		const bool depthMask = state.depthMask();
+		state.enable(GL_SCISSOR_TEST);
+		glScissor(viewport[0] + pixel.x - radius, viewport[1] + viewport[3] - 1 - pixel.y - radius, 2 * radius + 1, 2 * radius + 1);
+		const GLuint noId[4] = { 0, 0, 0, 0 };
+		glClearBufferuiv(GL_COLOR, 1, noId);
+		// Widgets already wrote their depth, so only the front most ids pass
+		state.colorMask(0, false, false, false, false);
+		state.depthFunc(GL_LEQUAL);
+		state.depthMask(false);
+		for (auto cmd : g.drawCommands) {
+			cmd->executeIds();
+		}
+		state.depthMask(depthMask);
+		state.depthFunc(depthFunc);
+		state.colorMask(0, true, true, true, true);
+		state.disable(GL_SCISSOR_TEST);
 	}
 
 	bool IsItemActive()
@@ -203,6 +240,7 @@ namespace ImGui3D {
 		KeepCaptureFocus(false),
 		ActiveId(0),
 		ActiveIdPreviousFrame(0),
+		HoveredId(0),
 		//Shader(std::initializer_list<std::pair<GLenum, std::string>>{
 		//	{ GL_VERTEX_SHADER, IMGUI3D_VS },
 		//	{ GL_FRAGMENT_SHADER, IMGUI3D_FS }}),
@@ -211,6 +249,9 @@ namespace ImGui3D {
 		ViewMatrix(0),
 		ProjectionMatrix(0),
 		ViewProjectionMatrix(0),
+		IdPassRadius(8),
+		CursorPixel(-1),
+		IdPassRegion(0),
 		Style()
 	{
 	}
@@ -21,6 +21,12 @@ namespace ImGui3D {
 		batch.execute(shader, "VP", g.ViewProjectionMatrix);
 	}
 
+	void DrawCommand::executeIds()
+	{
+		ImGui3DContext& g = *GImGui3D;
+		batch.execute(idShader, "VP", g.ViewProjectionMatrix);
+	}
+
 	DrawCommand::DrawCommand()
 	{
 		data = batch.addVertexAttributes<glm::vec4, glm::vec4, ImGuiID, glm::vec2>();
@@ -28,6 +34,8 @@ namespace ImGui3D {
 		//	{ GL_VERTEX_SHADER, IMGUI3D_VS },
 		//	{ GL_FRAGMENT_SHADER, IMGUI3D_FS }});
 		shader = gl::Shader(std::string(GL_FRAMEWORK_SHADER_DIR) + "imgui3d.glsl");
+		idShader = gl::Shader(std::string(GL_FRAMEWORK_SHADER_DIR) + "imgui3d.glsl");
+		idShader.setDefineFlag("ID_PASS");
 	}
 
 	void DrawCommand::AddFilledScreenAlignedQuad(glm::vec4 pos, ImVec2 size, glm::vec4 color, ImGuiID id)
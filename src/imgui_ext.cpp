@@ -8,6 +8,86 @@
 #include <cmath>
 #include <iostream>
 
+namespace impl {
+	// Adds the visible tiles of a large texture to the draw list. The pyramid level is chosen from the size on screen
+	// and tiles outside of the clip rectangle are skipped, so the cost only depends on the covered screen area.
+	// Paged tiles that are not resident yet are requested and replaced by the closest coarser resident tile.
+	void AddLargeTextureTiles(ImDrawList* dl, gl::LargeTexture* tex, const ImVec2& min, const ImVec2& max, ImU32 col)
+	{
+		const ImVec2 size = max - min;
+		if (size.x <= 0.0f || size.y <= 0.0f) {
+			return;
+		}
+		const int level = tex->selectLevel(size);
+
+		// Visible region in relative texture coordinates. v points upwards
+		const ImVec2 clipMin = dl->GetClipRectMin();
+		const ImVec2 clipMax = dl->GetClipRectMax();
+		const float u0 = std::clamp((clipMin.x - min.x) / size.x, 0.0f, 1.0f);
+		const float u1 = std::clamp((clipMax.x - min.x) / size.x, 0.0f, 1.0f);
+		const float v0 = std::clamp((max.y - clipMax.y) / size.y, 0.0f, 1.0f);
+		const float v1 = std::clamp((max.y - clipMin.y) / size.y, 0.0f, 1.0f);
+		if (u0 >= u1 || v0 >= v1) {
+			return;
+		}
+
+		const ImVec2 tileExtent = tex->getRelativePos(1, 1, level);
+		const int i0 = std::clamp((int)(u0 / tileExtent.x), 0, tex->levelColTiles(level) - 1);
+		const int i1 = std::clamp((int)(u1 / tileExtent.x), 0, tex->levelColTiles(level) - 1);
+		const int j0 = std::clamp((int)(v0 / tileExtent.y), 0, tex->levelRowTiles(level) - 1);
+		const int j1 = std::clamp((int)(v1 / tileExtent.y), 0, tex->levelRowTiles(level) - 1);
+
+		auto lerp = [](float a, float b, float t) {
+			return (a + (b - a) * std::min(1.0f, t));
+		};
+
+		for (int j = j0; j <= j1; ++j) {
+			for (int i = i0; i <= i1; ++i) {
+				const ImVec2 start = tex->getRelativePos(i, j, level);
+				const ImVec2 end = tex->getRelativePos(i + 1, j + 1, level);
+				const float x0 = lerp(min.x, max.x, start.x);
+				const float x1 = lerp(min.x, max.x, end.x);
+				const float y0 = lerp(max.y, min.y, end.y);
+				const float y1 = lerp(max.y, min.y, start.y);
+				const ImVec2 q0(x0, y0); // top left
+				const ImVec2 q1(x1, y0); // top right
+				const ImVec2 q2(x1, y1); // bottom right
+				const ImVec2 q3(x0, y1); // bottom left
+
+				// Every level halves the previous one, so the parent of a tile is found by halving its indices
+				int k = level, I = i, J = j;
+				tex->requestTile(I, J, k);
+				while (!tex->isTileResident(I, J, k) && k + 1 < tex->numLevels()) {
+					k++;
+					I /= 2;
+					J /= 2;
+					tex->requestTile(I, J, k);
+				}
+				if (!tex->isTileResident(I, J, k)) {
+					continue;
+				}
+
+				// Region of the tile within the tile that is actually drawn
+				const ImVec2 parentStart = tex->getRelativePos(I, J, k);
+				const ImVec2 parentEnd = tex->getRelativePos(I + 1, J + 1, k);
+				const float pw = std::min(1.0f, parentEnd.x) - parentStart.x;
+				const float ph = std::min(1.0f, parentEnd.y) - parentStart.y;
+				const float tu0 = (start.x - parentStart.x) / pw;
+				const float tu1 = (std::min(1.0f, end.x) - parentStart.x) / pw;
+				const float tv0 = (start.y - parentStart.y) / ph;
+				const float tv1 = (std::min(1.0f, end.y) - parentStart.y) / ph;
+
+				dl->AddImageQuad(
+					tex->getTileID(I, J, k),
+					q0, q1, q2, q3,
+					ImVec2(tu0, tv1), ImVec2(tu1, tv1), ImVec2(tu1, tv0), ImVec2(tu0, tv0),
+					col
+				);
+			}
+		}
+	}
+}
+
 void ImGui::Image(std::shared_ptr<gl::Texture> tex, const ImVec2& size, const ImVec2& uv0, const ImVec2& uv1, const ImVec4& tint_col, const ImVec4& border_col)
 {
 	ImGui::Image(*tex, size, uv0, uv1, tint_col, border_col);
@@ -38,38 +118,11 @@ void ImGui::Image(gl::LargeTexture* tex, const ImVec2& size, const ImVec4& tint_
 	}
 
 	// Add the image
-	auto lerp = [](float a, float b, float t) {
-		return (a + (b - a) * std::min(1.0f, t));
-	};
-
 	if (border_col.w > 0.0f);
 	bb.Min = bb.Min + ImVec2(1, 1);
 	bb.Max = bb.Max - ImVec2(1, 1);
 
-	for (int j = 0; j < tex->rowTiles; ++j) {
-		for (int i = 0; i < tex->colTiles; ++i) {
-			const ImVec2 start = tex->getRelativePos(i, j);
-			const ImVec2 end = tex->getRelativePos(i + 1, j + 1);
-			const float x0 = lerp(bb.Min.x, bb.Max.x, start.x);
-			const float x1 = lerp(bb.Min.x, bb.Max.x, end.x);
-			const float y0 = lerp(bb.Max.y, bb.Min.y, end.y);
-			const float y1 = lerp(bb.Max.y, bb.Min.y, start.y);
-			const ImVec2 q0(x0, y0); // top left
-			const ImVec2 q1(x1, y0); // top right
-			const ImVec2 q2(x1, y1); // bottom right
-			const ImVec2 q3(x0, y1); // bottom left
-
-			float umax = 1.0f;
-			float vmax = 1.0f;
-
-			window->DrawList->AddImageQuad(
-				tex->getTileID(i, j),
-				q0, q1, q2, q3,
-				ImVec2(0, vmax), ImVec2(umax, vmax), ImVec2(umax, 0), ImVec2(0, 0),
-				GetColorU32(tint_col)
-			);
-		}
-	}
+	impl::AddLargeTextureTiles(window->DrawList, tex, bb.Min, bb.Max, GetColorU32(tint_col));
 }
 
 bool ImGui::InputUInt(const char* label, uint32_t* v, int step, int step_fast, ImGuiInputTextFlags flags)
@@ -322,35 +375,7 @@ bool ImGui::Rotation(const char* id, float* angle, float pivot[2], float radius,
 
 void ImGui::AddImage(ImDrawList* dl, gl::LargeTexture* tex, const ImVec2 min, const ImVec2& size, const ImVec4& tint_col)
 {
-	auto lerp = [](float a, float b, float t) {
-		return (a + (b - a) * std::min(1.0f, t));
-	};
-	const ImVec2 max = min + size;
-
-	for (int j = 0; j < tex->rowTiles; ++j) {
-		for (int i = 0; i < tex->colTiles; ++i) {
-			const ImVec2 start = tex->getRelativePos(i, j);
-			const ImVec2 end = tex->getRelativePos(i + 1, j + 1);
-			const float x0 = lerp(min.x, max.x, start.x);
-			const float x1 = lerp(min.x, max.x, end.x);
-			const float y0 = lerp(max.y, min.y, end.y);
-			const float y1 = lerp(max.y, min.y, start.y);
-			const ImVec2 q0(x0, y0); // top left
-			const ImVec2 q1(x1, y0); // top right
-			const ImVec2 q2(x1, y1); // bottom right
-			const ImVec2 q3(x0, y1); // bottom left
-
-			float umax = 1.0f;
-			float vmax = 1.0f;
-
-			dl->AddImageQuad(
-				tex->getTileID(i, j),
-				q0, q1, q2, q3,
-				ImVec2(0, vmax), ImVec2(umax, vmax), ImVec2(umax, 0), ImVec2(0, 0),
-				GetColorU32(tint_col)
-			);
-		}
-	}
+	impl::AddLargeTextureTiles(dl, tex, min, min + size, GetColorU32(tint_col));
 }
 
 bool ImGui::BeginCanvas(const char* name, ImVec2 position, ImVec2 size)
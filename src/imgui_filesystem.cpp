@@ -15,6 +15,9 @@
 
 #include <GLFW/glfw3.h>
 
+#include "glpp/texture_loader.hpp"
+#include "3rdparty/stb_image.h"
+
 namespace fs = std::filesystem;
 using namespace std::chrono_literals;
 
@@ -655,12 +658,48 @@ void ImGui::ImFilesystemDialoguePopup::RemoveBookmark(std::string path)
 
 void ImGui::ImagePreview::selected(std::string path)
 {
-	try {
-		mPreviewTexture = std::make_unique<gl::LargeTexture>(path, gl::TextureFlags_No_Mipmap);
-	} catch(std::exception& ex) {
-		mPreviewTexture = nullptr;
-	}
+	mPreviewTexture = nullptr;
+	mLoading = true;
 	mPath = path;
+	mLoadToken = std::make_shared<int>(0);
+	std::weak_ptr<int> token = mLoadToken;
+
+	// Images larger than a single tile are paged from a tile cache, which is built on a worker thread
+	int cols = 0, rows = 0, channels = 0;
+	if (stbi_info(path.c_str(), &cols, &rows, &channels) && std::max(cols, rows) > gl::LargeTexture::MaxTileSize) {
+		std::shared_ptr<std::string> error = std::make_shared<std::string>();
+		gl::TextureLoader::Default().enqueue(
+			[path, error]() -> size_t {
+				try {
+					gl::LargeTexture::BuildTileCache(path);
+				}
+				catch (std::exception& ex) {
+					*error = ex.what();
+				}
+				return 0;
+			},
+			[this, token, path, error]() {
+				if (token.expired()) {
+					return;
+				}
+				mLoading = false;
+				if (error->empty()) {
+					mPreviewTexture = std::make_unique<gl::LargeTexture>(path, true, gl::TextureFlags_No_Mipmap | gl::TextureFlags_Lazy_Init);
+				}
+			});
+		return;
+	}
+
+	gl::TextureLoader::Default().loadImage(path, true, [this, token](std::shared_ptr<gl::ImageData> image) {
+		if (token.expired()) {
+			return;
+		}
+		mLoading = false;
+		if (image != nullptr) {
+			mPreviewTexture = std::make_unique<gl::LargeTexture>(image->cols, image->rows, image->format, image->type, gl::TextureFlags_No_Mipmap);
+			mPreviewTexture->setDataAsync(image->pixels.data());
+		}
+	});
 }
 
 void ImGui::ImagePreview::draw()
@@ -671,6 +710,9 @@ void ImGui::ImagePreview::draw()
 		float s = std::min(1.0f, space.x / mPreviewTexture->cols);
 		ImGui::Image(mPreviewTexture.get(), ImVec2(mPreviewTexture->cols, mPreviewTexture->rows) * s);
 	}
+	else if (mLoading) {
+		ImGui::TextUnformatted("Loading image...");
+	}
 	else {
 		ImGui::TextUnformatted("Could not load image");
 	}
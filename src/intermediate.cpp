@@ -1,4 +1,5 @@
 #include "glpp/intermediate.h"
+#include "glpp/reduction.hpp"
 
 const std::string vertex_display_shader = R"(
 #version 430
@@ -123,3 +124,45 @@ void gl::displayScalars(int x, int y, int width, int height, gl::Texture& tex, g
         "cmax", maxColor);
 }
 
+
+void gl::displayScalars(int x, int y, int width, int height, std::shared_ptr<gl::Texture> tex, AutoRange& range, glm::vec4 minColor, glm::vec4 maxColor, glm::vec2 uvmin, glm::vec2 uvmax)
+{
+    displayScalars(x, y, width, height, tex, range.update(*tex), minColor, maxColor, uvmin, uvmax);
+}
+
+void gl::displayScalars(int x, int y, int width, int height, gl::Texture& tex, AutoRange& range, glm::vec4 minColor, glm::vec4 maxColor, glm::vec2 uvmin, glm::vec2 uvmax)
+{
+    displayScalars(x, y, width, height, tex, range.update(tex), minColor, maxColor, uvmin, uvmax);
+}
+
+gl::AutoRange::AutoRange(glm::vec2 initial) :
+    mState(std::make_shared<State>())
+{
+    mState->range = initial;
+}
+
+glm::vec2 gl::AutoRange::update(gl::Texture& tex)
+{
+    if (!mState->pending) {
+        mState->pending = true;
+        // The callback owns the state, so the range may be destroyed while the reduction is in flight
+        std::shared_ptr<State> state = mState;
+        gl::Reduction::Default().reduce(tex, 0, [state](const gl::ReductionResult& result) {
+            state->pending = false;
+            if (result.count.x == 0) {
+                return;
+            }
+            state->range = glm::vec2(result.min.x, result.max.x);
+            // An empty range would divide by zero in the scalar shader
+            if (state->range.y <= state->range.x) {
+                state->range.y = state->range.x + 1e-6f;
+            }
+        });
+    }
+    return mState->range;
+}
+
+glm::vec2 gl::AutoRange::range() const
+{
+    return mState->range;
+}
@@ -0,0 +1,118 @@
+#include "glpp/mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+gl::MappedFile::MappedFile(const std::string& path, bool writable) :
+	mData(nullptr),
+	mSize(0),
+	mWritable(writable),
+	mFile(-1),
+	mMapping(0)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Could not open " + path);
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx(file, &size);
+	mSize = static_cast<size_t>(size.QuadPart);
+	HANDLE mapping = mSize > 0 ? CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	if (mSize > 0 && mapping == nullptr) {
+		CloseHandle(file);
+		throw std::runtime_error("Could not map " + path);
+	}
+	mFile = reinterpret_cast<intptr_t>(file);
+	mMapping = reinterpret_cast<intptr_t>(mapping);
+	if (mapping != nullptr) {
+		mData = static_cast<unsigned char*>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+	}
+#else
+	const int file = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+	if (file < 0) {
+		throw std::runtime_error("Could not open " + path);
+	}
+	struct stat status;
+	fstat(file, &status);
+	mSize = static_cast<size_t>(status.st_size);
+	mFile = file;
+	if (mSize > 0) {
+		void* data = mmap(nullptr, mSize, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+		mData = data != MAP_FAILED ? static_cast<unsigned char*>(data) : nullptr;
+	}
+#endif
+	if (mSize > 0 && mData == nullptr) {
+		close();
+		throw std::runtime_error("Could not map " + path);
+	}
+}
+
+gl::MappedFile::~MappedFile()
+{
+	close();
+}
+
+void gl::MappedFile::close()
+{
+#ifdef _WIN32
+	if (mData != nullptr) {
+		UnmapViewOfFile(mData);
+	}
+	if (mMapping != 0) {
+		CloseHandle(reinterpret_cast<HANDLE>(mMapping));
+	}
+	if (mFile != -1) {
+		CloseHandle(reinterpret_cast<HANDLE>(mFile));
+	}
+#else
+	if (mData != nullptr) {
+		munmap(mData, mSize);
+	}
+	if (mFile != -1) {
+		::close(static_cast<int>(mFile));
+	}
+#endif
+	mData = nullptr;
+	mMapping = 0;
+	mFile = -1;
+}
+
+const unsigned char* gl::MappedFile::data() const
+{
+	return mData;
+}
+
+unsigned char* gl::MappedFile::data()
+{
+	return mData;
+}
+
+size_t gl::MappedFile::size() const
+{
+	return mSize;
+}
+
+void gl::MappedFile::flush()
+{
+	if (mData == nullptr || !mWritable) {
+		return;
+	}
+#ifdef _WIN32
+	FlushViewOfFile(mData, 0);
+	FlushFileBuffers(reinterpret_cast<HANDLE>(mFile));
+#else
+	msync(mData, mSize, MS_SYNC);
+#endif
+}
@@ -35,5 +35,5 @@ void gl::CoordinateFrame::render(const std::shared_ptr<gl::Camera> camera)
 	glDrawArrays(GL_POINTS, 0, 1);
 	mVAO.unbind();
 
-	glUseProgram(0);
+	gl::StateCache::Current().useProgram(0);
 }
\ No newline at end of file
@@ -0,0 +1,632 @@
+#include "glpp/meshes/isosurface_mesh.hpp"
+
+#include "glpp/pixel_buffer.hpp"
+#include "../shaders/isosurface.glsl.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace impl {
+	// Triangles of every marching cubes case as cell edges, padded with -1. Corners and edges are numbered like
+	// CORNERS and EDGE_OWNERS in the shaders, triangles are counter-clockwise seen from below the iso value.
+	// Faces with two diagonal corners above the iso value always separate those corners, so neighboring cells agree
+	// on every face and the surface has no holes
+	const int TriangleTable[256][16] = {
+		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 1, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 10, 0, 10, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 9, 2, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 11, 0, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 11, 1, 11, 8, 1, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 11, 1, 11, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 10, 0, 10, 11, 0, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 10, 0, 10, 11, 0, 11, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 9, 10, 8, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 7, 1, 7, 4, 1, 4, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 2, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 4, 1, 10, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 10, 0, 10, 2, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 7, 2, 7, 4, 2, 4, 9, 2, 9, 10, -1, -1, -1, -1 },
+		{ 2, 11, 3, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 11, 0, 11, 7, 0, 7, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 2, 11, 3, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 11, 1, 11, 7, 1, 7, 4, 1, 4, 9, -1, -1, -1, -1 },
+		{ 1, 10, 11, 1, 11, 3, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 10, 0, 10, 11, 0, 11, 7, 0, 7, 4, -1, -1, -1, -1 },
+		{ 0, 9, 10, 0, 10, 11, 0, 11, 3, 4, 8, 7, -1, -1, -1, -1 },
+		{ 4, 9, 10, 4, 10, 11, 4, 11, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 5, 0, 5, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 1, 8, 4, 1, 4, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 2, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 1, 10, 2, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 5, 0, 5, 10, 0, 10, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 4, 2, 4, 5, 2, 5, 10, -1, -1, -1, -1 },
+		{ 2, 11, 3, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 11, 0, 11, 8, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 5, 0, 5, 1, 2, 11, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 11, 1, 11, 8, 1, 8, 4, 1, 4, 5, -1, -1, -1, -1 },
+		{ 1, 10, 11, 1, 11, 3, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 10, 0, 10, 11, 0, 11, 8, 4, 5, 9, -1, -1, -1, -1 },
+		{ 0, 4, 5, 0, 5, 10, 0, 10, 11, 0, 11, 3, -1, -1, -1, -1 },
+		{ 4, 5, 10, 4, 10, 11, 4, 11, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 9, 8, 5, 8, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 5, 0, 5, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 7, 0, 7, 5, 0, 5, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 2, 5, 9, 8, 5, 8, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 5, 0, 5, 9, 1, 10, 2, -1, -1, -1, -1 },
+		{ 0, 8, 7, 0, 7, 5, 0, 5, 10, 0, 10, 2, -1, -1, -1, -1 },
+		{ 2, 3, 7, 2, 7, 5, 2, 5, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 11, 3, 5, 9, 8, 5, 8, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 11, 0, 11, 7, 0, 7, 5, 0, 5, 9, -1, -1, -1, -1 },
+		{ 0, 8, 7, 0, 7, 5, 0, 5, 1, 2, 11, 3, -1, -1, -1, -1 },
+		{ 1, 2, 11, 1, 11, 7, 1, 7, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 11, 1, 11, 3, 5, 9, 8, 5, 8, 7, -1, -1, -1, -1 },
+		{ 0, 1, 10, 0, 10, 11, 0, 11, 7, 0, 7, 5, 0, 5, 9, -1 },
+		{ 0, 8, 7, 0, 7, 5, 0, 5, 10, 0, 10, 11, 0, 11, 3, -1 },
+		{ 5, 10, 11, 5, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 1, 8, 9, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 5, 6, 1, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 1, 5, 6, 1, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 5, 0, 5, 6, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 9, 2, 9, 5, 2, 5, 6, -1, -1, -1, -1 },
+		{ 2, 11, 3, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 11, 0, 11, 8, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 2, 11, 3, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 11, 1, 11, 8, 1, 8, 9, 5, 6, 10, -1, -1, -1, -1 },
+		{ 1, 5, 6, 1, 6, 11, 1, 11, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 5, 0, 5, 6, 0, 6, 11, 0, 11, 8, -1, -1, -1, -1 },
+		{ 0, 9, 5, 0, 5, 6, 0, 6, 11, 0, 11, 3, -1, -1, -1, -1 },
+		{ 5, 6, 11, 5, 11, 8, 5, 8, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 8, 7, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 4, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 4, 8, 7, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 7, 1, 7, 4, 1, 4, 9, 5, 6, 10, -1, -1, -1, -1 },
+		{ 1, 5, 6, 1, 6, 2, 4, 8, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2, -1, -1, -1, -1 },
+		{ 0, 9, 5, 0, 5, 6, 0, 6, 2, 4, 8, 7, -1, -1, -1, -1 },
+		{ 2, 3, 7, 2, 7, 4, 2, 4, 9, 2, 9, 5, 2, 5, 6, -1 },
+		{ 2, 11, 3, 4, 8, 7, 5, 6, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 11, 0, 11, 7, 0, 7, 4, 5, 6, 10, -1, -1, -1, -1 },
+		{ 0, 9, 1, 2, 11, 3, 4, 8, 7, 5, 6, 10, -1, -1, -1, -1 },
+		{ 1, 2, 11, 1, 11, 7, 1, 7, 4, 1, 4, 9, 5, 6, 10, -1 },
+		{ 1, 5, 6, 1, 6, 11, 1, 11, 3, 4, 8, 7, -1, -1, -1, -1 },
+		{ 0, 1, 5, 0, 5, 6, 0, 6, 11, 0, 11, 7, 0, 7, 4, -1 },
+		{ 0, 9, 5, 0, 5, 6, 0, 6, 11, 0, 11, 3, 4, 8, 7, -1 },
+		{ 4, 9, 5, 4, 5, 6, 4, 6, 11, 4, 11, 7, -1, -1, -1, -1 },
+		{ 4, 6, 10, 4, 10, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 4, 6, 10, 4, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 6, 0, 6, 10, 0, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 1, 8, 4, 1, 4, 6, 1, 6, 10, -1, -1, -1, -1 },
+		{ 1, 9, 4, 1, 4, 6, 1, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 1, 9, 4, 1, 4, 6, 1, 6, 2, -1, -1, -1, -1 },
+		{ 0, 4, 6, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 4, 2, 4, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 11, 3, 4, 6, 10, 4, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 11, 0, 11, 8, 4, 6, 10, 4, 10, 9, -1, -1, -1, -1 },
+		{ 0, 4, 6, 0, 6, 10, 0, 10, 1, 2, 11, 3, -1, -1, -1, -1 },
+		{ 1, 2, 11, 1, 11, 8, 1, 8, 4, 1, 4, 6, 1, 6, 10, -1 },
+		{ 1, 9, 4, 1, 4, 6, 1, 6, 11, 1, 11, 3, -1, -1, -1, -1 },
+		{ 0, 1, 9, 0, 9, 4, 0, 4, 6, 0, 6, 11, 0, 11, 8, -1 },
+		{ 0, 4, 6, 0, 6, 11, 0, 11, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 6, 11, 4, 11, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 10, 9, 6, 9, 8, 6, 8, 7, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 6, 0, 6, 10, 0, 10, 9, -1, -1, -1, -1 },
+		{ 0, 8, 7, 0, 7, 6, 0, 6, 10, 0, 10, 1, -1, -1, -1, -1 },
+		{ 1, 3, 7, 1, 7, 6, 1, 6, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 8, 1, 8, 7, 1, 7, 6, 1, 6, 2, -1, -1, -1, -1 },
+		{ 0, 3, 7, 0, 7, 6, 0, 6, 2, 0, 2, 1, 0, 1, 9, -1 },
+		{ 0, 8, 7, 0, 7, 6, 0, 6, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 7, 2, 7, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 11, 3, 6, 10, 9, 6, 9, 8, 6, 8, 7, -1, -1, -1, -1 },
+		{ 0, 2, 11, 0, 11, 7, 0, 7, 6, 0, 6, 10, 0, 10, 9, -1 },
+		{ 0, 8, 7, 0, 7, 6, 0, 6, 10, 0, 10, 1, 2, 11, 3, -1 },
+		{ 1, 2, 11, 1, 11, 7, 1, 7, 6, 1, 6, 10, -1, -1, -1, -1 },
+		{ 1, 9, 8, 1, 8, 7, 1, 7, 6, 1, 6, 11, 1, 11, 3, -1 },
+		{ 0, 1, 9, 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 7, 0, 7, 6, 0, 6, 11, 0, 11, 3, -1, -1, -1, -1 },
+		{ 6, 11, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 1, 8, 9, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 2, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 1, 10, 2, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 10, 0, 10, 2, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 9, 2, 9, 10, 6, 7, 11, -1, -1, -1, -1 },
+		{ 2, 6, 7, 2, 7, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 6, 0, 6, 7, 0, 7, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 2, 6, 7, 2, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 2, 6, 1, 6, 7, 1, 7, 8, 1, 8, 9, -1, -1, -1, -1 },
+		{ 1, 10, 6, 1, 6, 7, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 10, 0, 10, 6, 0, 6, 7, 0, 7, 8, -1, -1, -1, -1 },
+		{ 0, 9, 10, 0, 10, 6, 0, 6, 7, 0, 7, 3, -1, -1, -1, -1 },
+		{ 6, 7, 8, 6, 8, 9, 6, 9, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 8, 11, 4, 11, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 11, 0, 11, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 4, 8, 11, 4, 11, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 11, 1, 11, 6, 1, 6, 4, 1, 4, 9, -1, -1, -1, -1 },
+		{ 1, 10, 2, 4, 8, 11, 4, 11, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 11, 0, 11, 6, 0, 6, 4, 1, 10, 2, -1, -1, -1, -1 },
+		{ 0, 9, 10, 0, 10, 2, 4, 8, 11, 4, 11, 6, -1, -1, -1, -1 },
+		{ 2, 3, 11, 2, 11, 6, 2, 6, 4, 2, 4, 9, 2, 9, 10, -1 },
+		{ 2, 6, 4, 2, 4, 8, 2, 8, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 2, 6, 4, 2, 4, 8, 2, 8, 3, -1, -1, -1, -1 },
+		{ 1, 2, 6, 1, 6, 4, 1, 4, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 6, 1, 6, 4, 1, 4, 8, 1, 8, 3, -1, -1, -1, -1 },
+		{ 0, 1, 10, 0, 10, 6, 0, 6, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 10, 0, 10, 6, 0, 6, 4, 0, 4, 8, 0, 8, 3, -1 },
+		{ 4, 9, 10, 4, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 5, 9, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 4, 5, 9, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 4, 5, 0, 5, 1, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 1, 8, 4, 1, 4, 5, 6, 7, 11, -1, -1, -1, -1 },
+		{ 1, 10, 2, 4, 5, 9, 6, 7, 11, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 1, 10, 2, 4, 5, 9, 6, 7, 11, -1, -1, -1, -1 },
+		{ 0, 4, 5, 0, 5, 10, 0, 10, 2, 6, 7, 11, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 4, 2, 4, 5, 2, 5, 10, 6, 7, 11, -1 },
+		{ 2, 6, 7, 2, 7, 3, 4, 5, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 6, 0, 6, 7, 0, 7, 8, 4, 5, 9, -1, -1, -1, -1 },
+		{ 0, 4, 5, 0, 5, 1, 2, 6, 7, 2, 7, 3, -1, -1, -1, -1 },
+		{ 1, 2, 6, 1, 6, 7, 1, 7, 8, 1, 8, 4, 1, 4, 5, -1 },
+		{ 1, 10, 6, 1, 6, 7, 1, 7, 3, 4, 5, 9, -1, -1, -1, -1 },
+		{ 0, 1, 10, 0, 10, 6, 0, 6, 7, 0, 7, 8, 4, 5, 9, -1 },
+		{ 0, 4, 5, 0, 5, 10, 0, 10, 6, 0, 6, 7, 0, 7, 3, -1 },
+		{ 4, 5, 10, 4, 10, 6, 4, 6, 7, 4, 7, 8, -1, -1, -1, -1 },
+		{ 5, 9, 8, 5, 8, 11, 5, 11, 6, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 11, 0, 11, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1 },
+		{ 0, 8, 11, 0, 11, 6, 0, 6, 5, 0, 5, 1, -1, -1, -1, -1 },
+		{ 1, 3, 11, 1, 11, 6, 1, 6, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 2, 5, 9, 8, 5, 8, 11, 5, 11, 6, -1, -1, -1, -1 },
+		{ 0, 3, 11, 0, 11, 6, 0, 6, 5, 0, 5, 9, 1, 10, 2, -1 },
+		{ 0, 8, 11, 0, 11, 6, 0, 6, 5, 0, 5, 10, 0, 10, 2, -1 },
+		{ 2, 3, 11, 2, 11, 6, 2, 6, 5, 2, 5, 10, -1, -1, -1, -1 },
+		{ 2, 6, 5, 2, 5, 9, 2, 9, 8, 2, 8, 3, -1, -1, -1, -1 },
+		{ 0, 2, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 0, 3, 2, 0, 2, 6, 0, 6, 5, 0, 5, 1, -1 },
+		{ 1, 2, 6, 1, 6, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 10, 6, 1, 6, 5, 1, 5, 9, 1, 9, 8, 1, 8, 3, -1 },
+		{ 0, 1, 10, 0, 10, 6, 0, 6, 5, 0, 5, 9, -1, -1, -1, -1 },
+		{ 0, 8, 3, 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 10, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 7, 11, 5, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 5, 7, 11, 5, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 5, 7, 11, 5, 11, 10, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 1, 8, 9, 5, 7, 11, 5, 11, 10, -1, -1, -1, -1 },
+		{ 1, 5, 7, 1, 7, 11, 1, 11, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 1, 5, 7, 1, 7, 11, 1, 11, 2, -1, -1, -1, -1 },
+		{ 0, 9, 5, 0, 5, 7, 0, 7, 11, 0, 11, 2, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 9, 2, 9, 5, 2, 5, 7, 2, 7, 11, -1 },
+		{ 2, 10, 5, 2, 5, 7, 2, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 10, 0, 10, 5, 0, 5, 7, 0, 7, 8, -1, -1, -1, -1 },
+		{ 0, 9, 1, 2, 10, 5, 2, 5, 7, 2, 7, 3, -1, -1, -1, -1 },
+		{ 1, 2, 10, 1, 10, 5, 1, 5, 7, 1, 7, 8, 1, 8, 9, -1 },
+		{ 1, 5, 7, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 5, 0, 5, 7, 0, 7, 8, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 5, 0, 5, 7, 0, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 5, 7, 8, 5, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 8, 11, 4, 11, 10, 4, 10, 5, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 11, 0, 11, 10, 0, 10, 5, 0, 5, 4, -1, -1, -1, -1 },
+		{ 0, 9, 1, 4, 8, 11, 4, 11, 10, 4, 10, 5, -1, -1, -1, -1 },
+		{ 1, 3, 11, 1, 11, 10, 1, 10, 5, 1, 5, 4, 1, 4, 9, -1 },
+		{ 1, 5, 4, 1, 4, 8, 1, 8, 11, 1, 11, 2, -1, -1, -1, -1 },
+		{ 0, 3, 11, 0, 11, 2, 0, 2, 1, 0, 1, 5, 0, 5, 4, -1 },
+		{ 0, 9, 5, 0, 5, 4, 0, 4, 8, 0, 8, 11, 0, 11, 2, -1 },
+		{ 2, 3, 11, 4, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 10, 5, 2, 5, 4, 2, 4, 8, 2, 8, 3, -1, -1, -1, -1 },
+		{ 0, 2, 10, 0, 10, 5, 0, 5, 4, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 1, 2, 10, 5, 2, 5, 4, 2, 4, 8, 2, 8, 3, -1 },
+		{ 1, 2, 10, 1, 10, 5, 1, 5, 4, 1, 4, 9, -1, -1, -1, -1 },
+		{ 1, 5, 4, 1, 4, 8, 1, 8, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 5, 0, 5, 4, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 9, 5, 0, 5, 4, 0, 4, 8, 0, 8, 3, -1, -1, -1, -1 },
+		{ 4, 9, 5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 7, 11, 4, 11, 10, 4, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 8, 4, 7, 11, 4, 11, 10, 4, 10, 9, -1, -1, -1, -1 },
+		{ 0, 4, 7, 0, 7, 11, 0, 11, 10, 0, 10, 1, -1, -1, -1, -1 },
+		{ 1, 3, 8, 1, 8, 4, 1, 4, 7, 1, 7, 11, 1, 11, 10, -1 },
+		{ 1, 9, 4, 1, 4, 7, 1, 7, 11, 1, 11, 2, -1, -1, -1, -1 },
+		{ 0, 3, 8, 1, 9, 4, 1, 4, 7, 1, 7, 11, 1, 11, 2, -1 },
+		{ 0, 4, 7, 0, 7, 11, 0, 11, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 8, 2, 8, 4, 2, 4, 7, 2, 7, 11, -1, -1, -1, -1 },
+		{ 2, 10, 9, 2, 9, 4, 2, 4, 7, 2, 7, 3, -1, -1, -1, -1 },
+		{ 0, 2, 10, 0, 10, 9, 0, 9, 4, 0, 4, 7, 0, 7, 8, -1 },
+		{ 0, 4, 7, 0, 7, 3, 0, 3, 2, 0, 2, 10, 0, 10, 1, -1 },
+		{ 1, 2, 10, 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 4, 1, 4, 7, 1, 7, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, 0, 9, 4, 0, 4, 7, 0, 7, 8, -1, -1, -1, -1 },
+		{ 0, 4, 7, 0, 7, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 4, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 8, 11, 10, 8, 10, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 11, 0, 11, 10, 0, 10, 9, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 11, 0, 11, 10, 0, 10, 1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 3, 11, 1, 11, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 8, 1, 8, 11, 1, 11, 2, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 3, 11, 0, 11, 2, 0, 2, 1, 0, 1, 9, -1, -1, -1, -1 },
+		{ 0, 8, 11, 0, 11, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 3, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 2, 10, 9, 2, 9, 8, 2, 8, 3, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 2, 10, 0, 10, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, 0, 3, 2, 0, 2, 10, 0, 10, 1, -1, -1, -1, -1 },
+		{ 1, 2, 10, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 1, 9, 8, 1, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 1, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ 0, 8, 3, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+		{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+	};
+
+	// Values of the prefix sum scanned by a single workgroup
+	constexpr size_t ScanItemsPerGroup = 1024;
+	// Position and normal
+	constexpr size_t FloatsPerVertex = 6;
+
+	GLuint dispatchSize(size_t count, size_t groupSize) {
+		return static_cast<GLuint>(std::max<size_t>(1, (count + groupSize - 1) / groupSize));
+	}
+
+	// Grows a buffer without keeping its content
+	void reserveBuffer(GLuint& buffer, size_t& capacity, size_t sizeInBytes) {
+		if (buffer == 0) {
+			glGenBuffers(1, &buffer);
+		}
+		if (capacity < sizeInBytes) {
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, sizeInBytes, nullptr, GL_DYNAMIC_COPY);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			capacity = sizeInBytes;
+		}
+	}
+}
+
+gl::IsosurfaceMesh::IsosurfaceMesh(std::shared_ptr<gl::Texture> volume, float isoValue) :
+	Mesh(),
+	isoValue(isoValue),
+	extent(1.0f),
+	color(0.7f, 0.8f, 0.7f, 1.0f),
+	mCountShader(std::string("#version 430\n") + ISOSURFACE_COMMON_GLSL + ISOSURFACE_COUNT_CS),
+	mScanShader(ISOSURFACE_SCAN_CS),
+	mScanAddShader(ISOSURFACE_SCAN_ADD_CS),
+	mCompactShader(ISOSURFACE_COMPACT_CS),
+	mGenerateShader(std::string("#version 430\n") + ISOSURFACE_COMMON_GLSL + ISOSURFACE_GENERATE_CS),
+	mSurfaceShader({ { GL_VERTEX_SHADER, ISOSURFACE_VS }, { GL_FRAGMENT_SHADER, ISOSURFACE_FS } }),
+	mTriangleTable(0),
+	mRows(0),
+	mActiveRows(0),
+	mCommands(0),
+	mVertices(0),
+	mIndices(0),
+	mRowBytes(0),
+	mActiveRowBytes(0),
+	mMaxVertices(0),
+	mMaxTriangles(0),
+	mDirty(true),
+	mExtractedIsoValue(isoValue),
+	mExtractedExtent(1.0f),
+	mExtraction(0),
+	mReadback(std::make_shared<Readback>())
+{
+	name = "Isosurface";
+
+	glGenBuffers(1, &mTriangleTable);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mTriangleTable);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(::impl::TriangleTable), ::impl::TriangleTable, GL_STATIC_DRAW);
+	// Nothing is drawn before the first extraction
+	const GLuint commands[9] = { 0 };
+	glGenBuffers(1, &mCommands);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, mCommands);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(commands), commands, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glGenBuffers(1, &mVertices);
+	glGenBuffers(1, &mIndices);
+	reserve(1 << 16, 1 << 17);
+
+	gl::StateCache::Current().bindVertexArray(mVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, mVertices);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, ::impl::FloatsPerVertex * sizeof(float), nullptr);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, ::impl::FloatsPerVertex * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndices);
+	gl::StateCache::Current().bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	setVolume(volume);
+}
+
+gl::IsosurfaceMesh::~IsosurfaceMesh()
+{
+	for (GLuint buffer : { mTriangleTable, mRows, mActiveRows, mCommands, mVertices, mIndices }) {
+		glDeleteBuffers(1, &buffer);
+	}
+	glDeleteBuffers(static_cast<GLsizei>(mScanSums.size()), mScanSums.data());
+}
+
+void gl::IsosurfaceMesh::setVolume(std::shared_ptr<gl::Texture> volume)
+{
+	if (volume == nullptr || volume->type != TextureType::D3) {
+		throw std::invalid_argument("Isosurfaces can only be extracted from 3D textures");
+	}
+	mVolume = volume;
+	const float longestSide = static_cast<float>(std::max({ volume->cols, volume->rows, volume->depth }));
+	extent = glm::vec3(volume->cols, volume->rows, volume->depth) / longestSide;
+	invalidate();
+}
+
+std::shared_ptr<gl::Texture> gl::IsosurfaceMesh::getVolume() const
+{
+	return mVolume;
+}
+
+void gl::IsosurfaceMesh::invalidate()
+{
+	mDirty = true;
+	// Viewports that render on demand have to render again for the extraction to happen
+	gl::Mesh::invalidate();
+}
+
+void gl::IsosurfaceMesh::extract()
+{
+	const size_t rows = static_cast<size_t>(mVolume->rows) * mVolume->depth;
+	::impl::reserveBuffer(mRows, mRowBytes, rows * sizeof(glm::uvec4));
+	::impl::reserveBuffer(mActiveRows, mActiveRowBytes, rows * sizeof(GLuint));
+	const unsigned int maxVertices = static_cast<unsigned int>(mMaxVertices);
+	const unsigned int maxTriangles = static_cast<unsigned int>(mMaxTriangles);
+
+	mVolume->bind(0);
+	mCountShader.use();
+	mCountShader.setUniform("volume", 0);
+	mCountShader.setUniform("isoValue", isoValue);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mRows);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mTriangleTable);
+	mCountShader.dispatch(::impl::dispatchSize(rows, 64));
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	const GLuint totals = scan(mRows, rows);
+
+	mCompactShader.use();
+	mCompactShader.setUniform("count", static_cast<unsigned int>(rows));
+	mCompactShader.setUniform("maxVertices", maxVertices);
+	mCompactShader.setUniform("maxTriangles", maxTriangles);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mRows);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, totals);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mActiveRows);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, mCommands);
+	mCompactShader.dispatch(::impl::dispatchSize(rows, 64));
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+	mGenerateShader.use();
+	mGenerateShader.setUniform("volume", 0);
+	mGenerateShader.setUniform("isoValue", isoValue);
+	mGenerateShader.setUniform("maxVertices", maxVertices);
+	mGenerateShader.setUniform("maxTriangles", maxTriangles);
+	mGenerateShader.setUniform("extent", extent);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mRows);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mTriangleTable);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mActiveRows);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, totals);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, mVertices);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, mIndices);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, mCommands);
+	glDispatchComputeIndirect(0);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	for (GLuint binding = 0; binding <= 5; ++binding) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+	}
+	mVolume->unbind();
+	gl::StateCache::Current().useProgram(0);
+
+	mDirty = false;
+	mExtractedIsoValue = isoValue;
+	mExtractedExtent = extent;
+	++mExtraction;
+	readCounts(totals);
+}
+
+std::future<std::shared_ptr<gl::TriangleMesh>> gl::IsosurfaceMesh::download(Callback onFinished)
+{
+	auto promise = std::make_shared<std::promise<std::shared_ptr<gl::TriangleMesh>>>();
+	std::future<std::shared_ptr<gl::TriangleMesh>> future = promise->get_future();
+	const glm::uvec4& counts = mReadback->counts;
+	if (!mDirty && mReadback->extraction == mExtraction && counts.x <= mMaxVertices && counts.y <= mMaxTriangles) {
+		issueDownload(promise, onFinished);
+	}
+	else {
+		mReadback->downloads.push_back([this, promise, onFinished]() {
+			issueDownload(promise, onFinished);
+		});
+	}
+	return future;
+}
+
+size_t gl::IsosurfaceMesh::numVertices() const
+{
+	return mReadback->counts.x;
+}
+
+size_t gl::IsosurfaceMesh::numTriangles() const
+{
+	return mReadback->counts.y;
+}
+
+void gl::IsosurfaceMesh::render(const std::shared_ptr<gl::Camera> camera)
+{
+	if (mDirty || isoValue != mExtractedIsoValue || extent != mExtractedExtent) {
+		extract();
+	}
+
+	const glm::mat4 MVP = camera->GetProjectionMatrix() * camera->viewMatrix * ModelMatrix;
+	mSurfaceShader.use();
+	mSurfaceShader.setUniform("MVP", MVP);
+	mSurfaceShader.setUniform("M", ModelMatrix);
+	mSurfaceShader.setUniform("color", color);
+	mSurfaceShader.setUniform("cameraPosition", camera->position());
+
+	gl::StateCache::Current().bindVertexArray(mVAO);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, mCommands);
+	// The draw command follows the dispatch command in the buffer
+	glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<void*>(4 * sizeof(GLuint)));
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	gl::StateCache::Current().bindVertexArray(0);
+	gl::StateCache::Current().useProgram(0);
+}
+
+void gl::IsosurfaceMesh::drawOutliner()
+{
+	ImGui::Text("Vertices %d | Triangles %d", static_cast<int>(numVertices()), static_cast<int>(numTriangles()));
+	ImGui::DragFloat("Iso Value", &isoValue, 0.001f);
+	ImGui::ColorEdit4("Color", &color.x);
+}
+
+GLuint gl::IsosurfaceMesh::scan(GLuint buffer, size_t count, size_t level)
+{
+	const GLuint groups = ::impl::dispatchSize(count, ::impl::ScanItemsPerGroup);
+	if (mScanSums.size() <= level) {
+		mScanSums.push_back(0);
+		mScanBytes.push_back(0);
+	}
+	::impl::reserveBuffer(mScanSums[level], mScanBytes[level], groups * sizeof(glm::uvec4));
+	const GLuint sums = mScanSums[level];
+
+	mScanShader.use();
+	mScanShader.setUniform("count", static_cast<unsigned int>(count));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sums);
+	mScanShader.dispatch(groups);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	if (groups == 1) {
+		return sums;
+	}
+
+	// Scan the totals of the groups and add them to the values of each group
+	const GLuint totals = scan(sums, groups, level + 1);
+	mScanAddShader.use();
+	mScanAddShader.setUniform("count", static_cast<unsigned int>(count));
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sums);
+	mScanAddShader.dispatch(::impl::dispatchSize(count, 256));
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	return totals;
+}
+
+void gl::IsosurfaceMesh::readCounts(GLuint totals)
+{
+	DownloadQueue& queue = DownloadQueue::Default();
+	const int slot = queue.acquire(sizeof(glm::uvec4));
+	glBindBuffer(GL_COPY_READ_BUFFER, totals);
+	queue.ring().bind(slot);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_PIXEL_PACK_BUFFER, 0, 0, sizeof(glm::uvec4));
+	queue.ring().unbind();
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	std::shared_ptr<glm::uvec4> counts = std::make_shared<glm::uvec4>(0);
+	std::weak_ptr<Readback> token = mReadback;
+	const int extraction = mExtraction;
+	queue.push(slot, sizeof(glm::uvec4), counts.get(), [this, token, counts, extraction]() {
+		if (token.expired()) { return; }
+		mReadback->counts = *counts;
+		mReadback->extraction = extraction;
+		onCounts(extraction);
+	});
+}
+
+void gl::IsosurfaceMesh::onCounts(int extraction)
+{
+	// A newer extraction is on its way and serves the pending downloads
+	if (extraction != mExtraction) {
+		return;
+	}
+	const glm::uvec4 counts = mReadback->counts;
+	if (counts.x > mMaxVertices || counts.y > mMaxTriangles) {
+		reserve(counts.x + counts.x / 4, counts.y + counts.y / 4);
+		invalidate();
+		return;
+	}
+	std::vector<std::function<void()>> downloads;
+	downloads.swap(mReadback->downloads);
+	for (const std::function<void()>& download : downloads) {
+		download();
+	}
+}
+
+void gl::IsosurfaceMesh::issueDownload(std::shared_ptr<std::promise<std::shared_ptr<gl::TriangleMesh>>> promise, Callback onFinished)
+{
+	const size_t vertices = mReadback->counts.x;
+	const size_t triangles = mReadback->counts.y;
+	const glm::mat4 model = ModelMatrix;
+	if (vertices == 0 || triangles == 0) {
+		std::shared_ptr<gl::TriangleMesh> mesh = std::make_shared<gl::TriangleMesh>();
+		mesh->ModelMatrix = model;
+		promise->set_value(mesh);
+		if (onFinished) {
+			onFinished(mesh);
+		}
+		return;
+	}
+
+	const size_t vertexBytes = vertices * ::impl::FloatsPerVertex * sizeof(float);
+	const size_t indexBytes = triangles * 3 * sizeof(GLuint);
+	DownloadQueue& queue = DownloadQueue::Default();
+	const int slot = queue.acquire(vertexBytes + indexBytes);
+	queue.ring().bind(slot);
+	glBindBuffer(GL_COPY_READ_BUFFER, mVertices);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_PIXEL_PACK_BUFFER, 0, 0, vertexBytes);
+	glBindBuffer(GL_COPY_READ_BUFFER, mIndices);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_PIXEL_PACK_BUFFER, 0, vertexBytes, indexBytes);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	queue.ring().unbind();
+
+	std::shared_ptr<std::vector<unsigned char>> data = std::make_shared<std::vector<unsigned char>>(vertexBytes + indexBytes);
+	queue.push(slot, data->size(), data->data(), [data, vertices, triangles, vertexBytes, model, promise, onFinished]() {
+		const float* vertexData = reinterpret_cast<const float*>(data->data());
+		const GLuint* indexData = reinterpret_cast<const GLuint*>(data->data() + vertexBytes);
+		std::vector<glm::vec3> positions(vertices);
+		for (size_t i = 0; i < vertices; ++i) {
+			const float* v = vertexData + i * ::impl::FloatsPerVertex;
+			positions[i] = glm::vec3(v[0], v[1], v[2]);
+		}
+		std::vector<glm::ivec3> faces(triangles);
+		for (size_t i = 0; i < triangles; ++i) {
+			faces[i] = glm::ivec3(indexData[3 * i], indexData[3 * i + 1], indexData[3 * i + 2]);
+		}
+		std::shared_ptr<gl::TriangleMesh> mesh = std::make_shared<gl::TriangleMesh>(positions, faces);
+		mesh->ModelMatrix = model;
+		promise->set_value(mesh);
+		if (onFinished) {
+			onFinished(mesh);
+		}
+	});
+}
+
+void gl::IsosurfaceMesh::reserve(size_t vertices, size_t triangles)
+{
+	if (vertices > mMaxVertices) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, mVertices);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, vertices * ::impl::FloatsPerVertex * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+		mMaxVertices = vertices;
+	}
+	if (triangles > mMaxTriangles) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, mIndices);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, triangles * 3 * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+		mMaxTriangles = triangles;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
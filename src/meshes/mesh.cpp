@@ -6,7 +6,8 @@ gl::Mesh::Mesh() :
 	mShowInOutliner(true),
 	visible(true),
 	name("Mesh"),
-	ModelMatrix(1)
+	ModelMatrix(1),
+	mGeneration(0)
 {
 }
 
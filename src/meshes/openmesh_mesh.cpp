@@ -64,7 +64,7 @@ void gl::OpenMeshMesh::render(const std::shared_ptr<gl::Camera> camera)
 	glm::mat4 P = camera->GetProjectionMatrix();
 	glm::mat4 V = camera->viewMatrix;
 	glm::mat4 MVP = P * V * ModelMatrix;
-	glDisable(GL_BLEND);
+	gl::StateCache::Current().disable(GL_BLEND);
 	
 	Mesh::render(mShader,
 		"MVP", MVP,
@@ -74,12 +74,12 @@ void gl::OpenMeshMesh::render(const std::shared_ptr<gl::Camera> camera)
 
 	if (drawEdges) {
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		glEnable(GL_POLYGON_OFFSET_LINE);
+		gl::StateCache::Current().enable(GL_POLYGON_OFFSET_LINE);
 		glPolygonOffset(-1.f, 1.f);
 		Mesh::render(mShader,
 			"MVP", MVP, 
 			"color", edgeColor);
-		glDisable(GL_POLYGON_OFFSET_LINE);
+		gl::StateCache::Current().disable(GL_POLYGON_OFFSET_LINE);
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	}
 }
@@ -57,8 +57,9 @@ void gl::CatmullRomSpline::render(const std::shared_ptr<gl::Camera> camera)
 	glm::mat4  VP = P * V;
 
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		gl::StateCache& state = gl::StateCache::Current();
+		state.enable(GL_BLEND);
+		state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		auto _ = mShader.use();
 		
@@ -80,7 +81,7 @@ void gl::CatmullRomSpline::render(const std::shared_ptr<gl::Camera> camera)
 		glDrawElements(GL_PATCHES, n, GL_UNSIGNED_INT, 0);
 		mVAO.unbind();
 
-		glDisable(GL_BLEND);
+		state.disable(GL_BLEND);
 	}
 	
 }
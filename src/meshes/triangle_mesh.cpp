@@ -1,6 +1,7 @@
 #include "glpp/meshes/triangle_mesh.hpp"
 
 #include "glpp/renderer.hpp"
+#include "glpp/render_queue.hpp"
 #include "glpp/logging.hpp"
 
 #include <glm/gtx/matrix_cross_product.hpp>
@@ -74,6 +75,23 @@ void gl::TriangleMesh::render(const std::shared_ptr<gl::Camera> camera)
 		"color", mColor);
 }
 
+bool gl::TriangleMesh::submit(gl::RenderQueue& queue, const std::shared_ptr<gl::Camera> camera)
+{
+	glm::mat4 V = camera->viewMatrix;
+	glm::mat4 MVP = camera->GetProjectionMatrix() * V * ModelMatrix;
+
+	gl::DrawPacket packet = mBatch.packet(visualizeNormals ? mNormalShader : mShader);
+	packet.depth = glm::length(glm::vec3(V * ModelMatrix[3]));
+	// The normal shader does not declare gl_Position invariant
+	packet.depthPrepass = !visualizeNormals;
+	packet.MVP = MVP;
+	packet.uniforms = [MVP, M = ModelMatrix, color = mColor](gl::Shader& shader) {
+		shader.setUniforms("MVP", MVP, "M", M, "color", color);
+	};
+	queue.submit(std::move(packet));
+	return true;
+}
+
 void gl::TriangleMesh::drawOutliner()
 {
 	ImGui::Text("Vertices %d| Faces %d", (int)numVertices(), (int)numFaces());
@@ -0,0 +1,338 @@
+#include "glpp/meshes/volume_mesh.hpp"
+
+#include "glpp/renderer.hpp"
+#include "glpp/intermediate.h"
+#include "../shaders/volume.glsl.h"
+#include "../shaders/bricked_volume.glsl.h"
+#include "../shaders/display_shader.glsl.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace impl {
+	// Internal linkage, other translation units define the same helper
+	static GLuint groups(int size, int groupSize) {
+		return static_cast<GLuint>((size + groupSize - 1) / groupSize);
+	}
+
+	std::shared_ptr<gl::Texture> defaultTransferFunction() {
+		const int size = 256;
+		std::vector<glm::vec4> entries(size);
+		for (int i = 0; i < size; ++i) {
+			const float v = static_cast<float>(i) / (size - 1);
+			entries[i] = glm::vec4(v, v, v, 0.1f * v);
+		}
+		auto transferFunction = std::make_shared<gl::Texture>(size, gl::PixelFormat::RGBA, gl::PixelType::Float, gl::TextureFlags_No_Mipmap);
+		transferFunction->setData(entries.data());
+		return transferFunction;
+	}
+}
+
+gl::VolumeMesh::VolumeMesh(std::shared_ptr<gl::Texture> volume, std::shared_ptr<gl::Texture> transferFunction, int cellSize) :
+	VolumeMesh(cellSize, transferFunction)
+{
+	setVolume(volume);
+}
+
+gl::VolumeMesh::VolumeMesh(std::shared_ptr<gl::BrickedVolume> volume, std::shared_ptr<gl::Texture> transferFunction) :
+	VolumeMesh(BrickedVolume::BrickPayload, transferFunction)
+{
+	setVolume(volume);
+}
+
+gl::VolumeMesh::VolumeMesh(int cellSize, std::shared_ptr<gl::Texture> transferFunction) :
+	Mesh(),
+	extent(1.0f),
+	valueRange(0.0f, 1.0f),
+	stepSize(0.5f),
+	emptyOpacity(0.0f),
+	terminationAlpha(0.99f),
+	adaptiveSteps(true),
+	halfResolution(false),
+	mCellSize(std::max(cellSize, 1)),
+	mMacrocellShader(MACROCELL_CS),
+	mOccupancyShader(OCCUPANCY_CS),
+	mCompositeShader({ { GL_VERTEX_SHADER, DISPLAY_VS }, { GL_FRAGMENT_SHADER, VOLUME_COMPOSITE_FS } }),
+	mOccupancyValid(false)
+{
+	name = "Volume";
+	// The proxy geometry is the unit cube in texture space
+	auto positions = mBatch.addVertexAttributes<glm::vec3>();
+	for (int i = 0; i < 8; ++i) {
+		positions->push_back(glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+	}
+	for (unsigned int index : { 0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,  0, 1, 4, 1, 5, 4,  2, 6, 3, 3, 6, 7,  0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5 }) {
+		mBatch.indexBuffer->push_back(index);
+	}
+	setTransferFunction(transferFunction);
+}
+
+void gl::VolumeMesh::setVolume(std::shared_ptr<gl::Texture> volume)
+{
+	if (volume == nullptr || volume->type != TextureType::D3) {
+		throw std::invalid_argument("Volumes have to be 3D textures");
+	}
+	if (mVolume == nullptr) {
+		createShader(false);
+	}
+	mVolume = volume;
+	mBrickedVolume = nullptr;
+	buildMacrocells();
+}
+
+void gl::VolumeMesh::setVolume(std::shared_ptr<gl::BrickedVolume> volume)
+{
+	if (volume == nullptr) {
+		throw std::invalid_argument("The bricked volume must not be null");
+	}
+	if (mBrickedVolume == nullptr) {
+		createShader(true);
+	}
+	mBrickedVolume = volume;
+	mVolume = nullptr;
+	// The bricks are the macrocells
+	mCellSize = BrickedVolume::BrickPayload;
+	buildMacrocells();
+}
+
+void gl::VolumeMesh::setTransferFunction(std::shared_ptr<gl::Texture> transferFunction)
+{
+	if (transferFunction == nullptr) {
+		transferFunction = ::impl::defaultTransferFunction();
+	}
+	if (transferFunction->type != TextureType::D1 && transferFunction->type != TextureType::D2) {
+		throw std::invalid_argument("Transfer functions must be 1D or 2D textures");
+	}
+	mTransferFunction = transferFunction;
+	updateDefines();
+	mOccupancyValid = false;
+}
+
+std::shared_ptr<gl::Texture> gl::VolumeMesh::getVolume() const
+{
+	return mVolume;
+}
+
+std::shared_ptr<gl::BrickedVolume> gl::VolumeMesh::getBrickedVolume() const
+{
+	return mBrickedVolume;
+}
+
+std::shared_ptr<gl::Texture> gl::VolumeMesh::getTransferFunction() const
+{
+	return mTransferFunction;
+}
+
+void gl::VolumeMesh::createShader(bool bricked)
+{
+	std::string fragmentShader = VOLUME_FS;
+	if (bricked) {
+		const size_t version = fragmentShader.find('\n', fragmentShader.find("#version")) + 1;
+		fragmentShader.insert(version, std::string("#define BRICKED\n") + BRICKED_VOLUME_GLSL);
+	}
+	mShader = gl::Shader({ { GL_VERTEX_SHADER, VOLUME_VS }, { GL_FRAGMENT_SHADER, fragmentShader } });
+	if (mTransferFunction != nullptr) {
+		updateDefines();
+	}
+}
+
+glm::ivec3 gl::VolumeMesh::volumeSize() const
+{
+	return mBrickedVolume != nullptr ? mBrickedVolume->size() : glm::ivec3(mVolume->cols, mVolume->rows, mVolume->depth);
+}
+
+void gl::VolumeMesh::buildMacrocells()
+{
+	const glm::ivec3 size = volumeSize();
+	const float longestSide = static_cast<float>(std::max({ size.x, size.y, size.z }));
+	extent = glm::vec3(size) / longestSide;
+
+	const int cols = ::impl::groups(size.x, mCellSize);
+	const int rows = ::impl::groups(size.y, mCellSize);
+	const int depth = ::impl::groups(size.z, mCellSize);
+	if (mMacrocells == nullptr || mMacrocells->cols != cols || mMacrocells->rows != rows || mMacrocells->depth != depth) {
+		mMacrocells = std::make_unique<gl::Texture>(cols, rows, depth, PixelFormat::RG, PixelType::Float, TextureFlags_FrameBuffer_Texture);
+		mOccupancy = std::make_unique<gl::Texture>(cols, rows, depth, PixelFormat::Red, PixelType::UByte, TextureFlags_FrameBuffer_Texture);
+	}
+	mOccupancyValid = false;
+
+	if (mBrickedVolume != nullptr) {
+		// The ranges of the bricks were computed while building the brick cache
+		mMacrocells->setData(mBrickedVolume->brickRanges().data());
+		return;
+	}
+
+	mMacrocellShader.use();
+	mVolume->bind(0);
+	mMacrocellShader.setUniform("volume", 0);
+	mMacrocellShader.setUniform("cellSize", mCellSize);
+	mMacrocells->bindAsImage(0, gl::Access::WriteOnly);
+	mMacrocellShader.dispatch(::impl::groups(cols, 4), ::impl::groups(rows, 4), ::impl::groups(depth, 4));
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+	mVolume->unbind();
+	gl::StateCache::Current().useProgram(0);
+}
+
+void gl::VolumeMesh::updateOccupancy()
+{
+	mOccupancyShader.use();
+	mMacrocells->bind(0);
+	mOccupancyShader.setUniform("macrocells", 0);
+	mTransferFunction->bind(1);
+	mOccupancyShader.setUniform("transferFunction", 1);
+	mOccupancyShader.setUniform("lutSize", mTransferFunction->cols);
+	mOccupancyShader.setUniform("range", valueRange);
+	mOccupancyShader.setUniform("threshold", emptyOpacity);
+	mOccupancy->bindAsImage(0, gl::Access::WriteOnly);
+	mOccupancyShader.dispatch(::impl::groups(mOccupancy->cols, 4), ::impl::groups(mOccupancy->rows, 4), ::impl::groups(mOccupancy->depth, 4));
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+	mTransferFunction->unbind();
+	gl::StateCache::Current().activeTexture(0);
+	mMacrocells->unbind();
+	gl::StateCache::Current().useProgram(0);
+
+	mOccupancyValid = true;
+	mOccupancyRange = valueRange;
+	mOccupancyThreshold = emptyOpacity;
+}
+
+void gl::VolumeMesh::updateDefines()
+{
+	for (gl::Shader* shader : { static_cast<gl::Shader*>(&mOccupancyShader), &mShader }) {
+		if (mTransferFunction->type == TextureType::D1) {
+			shader->setDefineFlag("LUT_1D");
+		}
+		else {
+			shader->removeDefine("LUT_1D");
+		}
+	}
+	if (adaptiveSteps) {
+		mShader.setDefineFlag("ADAPTIVE");
+	}
+	else {
+		mShader.removeDefine("ADAPTIVE");
+	}
+	mOccupancyShader.update();
+	mShader.update();
+}
+
+void gl::VolumeMesh::render(const std::shared_ptr<gl::Camera> camera)
+{
+	if (!mOccupancyValid || mOccupancyRange != valueRange || mOccupancyThreshold != emptyOpacity) {
+		updateOccupancy();
+	}
+	if (adaptiveSteps != mShader.hasDefine("ADAPTIVE")) {
+		updateDefines();
+	}
+	if (mBrickedVolume != nullptr) {
+		const glm::mat4 box = glm::scale(glm::translate(glm::mat4(1.0f), -0.5f * extent), extent);
+		mBrickedVolume->update(camera, ModelMatrix * box);
+	}
+
+	gl::StateCache& state = gl::StateCache::Current();
+	const bool blendEnabled = state.isEnabled(GL_BLEND);
+	const bool cullingEnabled = state.isEnabled(GL_CULL_FACE);
+	const bool depthTestEnabled = state.isEnabled(GL_DEPTH_TEST);
+	const bool depthWriteEnabled = state.depthMask();
+
+	state.enable(GL_CULL_FACE);
+	glCullFace(GL_FRONT);
+	state.disable(GL_DEPTH_TEST);
+	state.depthMask(false);
+	state.enable(GL_BLEND);
+	state.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	if (halfResolution) {
+		const GLuint previousFramebuffer = state.framebuffer(GL_DRAW_FRAMEBUFFER);
+		const glm::ivec4 viewport = state.viewport();
+
+		const int cols = std::max(viewport[2] / 2, 1);
+		const int rows = std::max(viewport[3] / 2, 1);
+		if (mHalfResolutionBuffer == nullptr) {
+			mHalfResolutionBuffer = std::make_unique<gl::Framebuffer>(cols, rows);
+			// Linear filtering does the upsampling
+			mHalfResolutionBuffer->setRenderTexture(0, std::make_shared<gl::Texture>(cols, rows, PixelFormat::RGBA, PixelType::Half, TextureFlags_No_Mipmap));
+		}
+		else {
+			mHalfResolutionBuffer->resize(cols, rows);
+		}
+		mHalfResolutionBuffer->bind();
+		mHalfResolutionBuffer->clearColorAttachment(0);
+		march(camera);
+
+		state.bindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+		state.disable(GL_CULL_FACE);
+		mHalfResolutionBuffer->getRenderTexture(0)->bind(0);
+		gl::fullscreenTriangle(viewport[0], viewport[1], viewport[2], viewport[3], mCompositeShader, "image", 0);
+	}
+	else {
+		march(camera);
+	}
+
+	glCullFace(GL_BACK);
+	state.setEnabled(GL_CULL_FACE, cullingEnabled);
+	state.setEnabled(GL_BLEND, blendEnabled);
+	state.setEnabled(GL_DEPTH_TEST, depthTestEnabled);
+	state.depthMask(depthWriteEnabled);
+}
+
+void gl::VolumeMesh::march(const std::shared_ptr<gl::Camera> camera)
+{
+	// Texture space to model space
+	const glm::mat4 box = glm::scale(glm::translate(glm::mat4(1.0f), -0.5f * extent), extent);
+	const glm::mat4 M = ModelMatrix * box;
+	const glm::mat4 MVP = camera->GetProjectionMatrix() * camera->viewMatrix * M;
+	const glm::vec3 cameraPosition = glm::inverse(M) * glm::vec4(camera->position(), 1.0f);
+
+	const glm::vec3 voxels(volumeSize());
+	const glm::vec3 cells(mOccupancy->cols, mOccupancy->rows, mOccupancy->depth);
+	// Steps are measured along the longest side, so they stay the same for every direction
+	const float voxelSize = 1.0f / std::max({ voxels.x, voxels.y, voxels.z });
+
+	if (mBrickedVolume != nullptr) {
+		mShader.use();
+		mBrickedVolume->bind(mShader, 0, 3);
+	}
+	else {
+		mVolume->bind(0);
+	}
+	mOccupancy->bind(1);
+	mTransferFunction->bind(2);
+	mBatch.execute(mShader,
+		"MVP", MVP,
+		"volume", 0,
+		"occupancy", 1,
+		"transferFunction", 2,
+		"lutSize", mTransferFunction->cols,
+		"range", valueRange,
+		"cameraPosition", cameraPosition,
+		"cellExtent", glm::vec3(static_cast<float>(mCellSize)) / voxels,
+		"cells", cells,
+		"stepSize", std::max(stepSize, 0.05f) * voxelSize,
+		"referenceStep", voxelSize,
+		"terminationAlpha", terminationAlpha);
+	mTransferFunction->unbind();
+	gl::StateCache::Current().activeTexture(1);
+	mOccupancy->unbind();
+	if (mBrickedVolume != nullptr) {
+		mBrickedVolume->unbind(0, 3);
+	}
+	else {
+		gl::StateCache::Current().activeTexture(0);
+		mVolume->unbind();
+	}
+}
+
+void gl::VolumeMesh::drawOutliner()
+{
+	ImGui::DragFloatRange2("Value Range", &valueRange.x, &valueRange.y, 0.01f);
+	ImGui::DragFloat("Step Size (Voxels)", &stepSize, 0.01f, 0.05f, 4.0f);
+	ImGui::DragFloat("Empty Opacity", &emptyOpacity, 0.001f, 0.0f, 1.0f);
+	ImGui::DragFloat("Termination Alpha", &terminationAlpha, 0.001f, 0.5f, 1.0f);
+	ImGui::Checkbox("Adaptive Steps", &adaptiveSteps);
+	ImGui::Checkbox("Half Resolution", &halfResolution);
+}
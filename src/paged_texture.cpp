@@ -1,22 +1,225 @@
 #include "glpp/texture.hpp"
+#include "glpp/pixel_buffer.hpp"
+#include "glpp/texture_loader.hpp"
+#include "glpp/logging.hpp"
+#include "glpp/pixel_conversion.hpp"
+#include "glpp/state_cache.hpp"
 
-#include "3rdparty/stb_image.h"
-
-#include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <type_traits>
+
+namespace fs = std::filesystem;
+
+struct gl::LargeTexture::PageTable {
+	enum class TileState : unsigned char { Missing, Loading, Resident };
+
+	std::string cacheFile;
+	bool ownsCacheFile = false;
+	std::vector<uint64_t> tileOffsets;
+	std::vector<TileState> states;
+	std::vector<int> lastUsed;
+	size_t budget = 512 * 1024 * 1024;
+	size_t residentBytes = 0;
+};
+
+namespace impl {
+	// Layout of a tile cache file: header followed by the tiles of all pyramid levels,
+	// starting with the full resolution level. The tiles of a level are stored in row major order
+	// and every tile is stored tightly packed in the pixel format and type given by the header.
+	struct TileCacheHeader {
+		char magic[8];
+		int32_t cols, rows;
+		uint32_t format, type;
+		int32_t tileSize;
+		int32_t levels;
+	};
+	constexpr char TileCacheMagic[8] = { 'G', 'L', 'T', 'I', 'L', 'E', 'S', '2' };
+
+	// Deleted tiles are unbound, so the state cache has to forget them
+	void tilesDeleted(const std::vector<GLuint>& ids) {
+		gl::StateCache& state = gl::StateCache::Current();
+		for (GLuint id : ids) {
+			if (id != 0) {
+				state.textureDeleted(id);
+			}
+		}
+	}
+
+	int currentFrame() {
+		return ImGui::GetCurrentContext() != nullptr ? ImGui::GetFrameCount() : 0;
+	}
+
+	// Sizes of all pyramid levels. Every level halves the previous one until it fits into a single tile
+	std::vector<std::pair<int, int>> levelSizes(int cols, int rows) {
+		std::vector<std::pair<int, int>> sizes = { { cols, rows } };
+		while (std::max(cols, rows) > gl::LargeTexture::MaxTileSize) {
+			cols = (cols + 1) / 2;
+			rows = (rows + 1) / 2;
+			sizes.push_back({ cols, rows });
+		}
+		return sizes;
+	}
+
+	fs::path tileCacheDirectory() {
+		return fs::temp_directory_path() / "glpp_tile_cache";
+	}
+
+	std::string tileCacheFile(const std::string& path, bool flipY) {
+		// The key changes whenever the source file changes, so outdated caches are never used
+		std::error_code ec;
+		const fs::path file = fs::absolute(path, ec);
+		const auto size = fs::file_size(file, ec);
+		const auto time = fs::last_write_time(file, ec).time_since_epoch().count();
+		const size_t key = std::hash<std::string>()(
+			file.string() + "|" + std::to_string(size) + "|" + std::to_string(time) + "|" + (flipY ? "1" : "0"));
+		return (tileCacheDirectory() / (std::to_string(key) + ".tiles")).string();
+	}
+
+	std::string anonymousTileCacheFile() {
+		// Caches of textures filled by setData are owned by the texture and removed together with it
+		static const unsigned int session = std::random_device()();
+		static std::atomic<int> counter(0);
+		return (tileCacheDirectory() / ("anonymous_" + std::to_string(session) + "_" + std::to_string(counter++) + ".tiles")).string();
+	}
+
+	bool readTileCacheHeader(const std::string& file, TileCacheHeader& header) {
+		std::ifstream in(file, std::ios::binary);
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(TileCacheHeader))) {
+			return false;
+		}
+		return std::memcmp(header.magic, TileCacheMagic, sizeof(TileCacheMagic)) == 0;
+	}
+
+	template<typename T>
+	void downsample(const T* src, int cols, int rows, int channels, int factor, T* dst, int dstCols, int dstRows) {
+		typedef typename std::conditional<std::is_floating_point<T>::value, double, uint64_t>::type Accumulator;
+		std::vector<Accumulator> sum(channels);
+		for (int y = 0; y < dstRows; ++y) {
+			const int y0 = y * factor;
+			const int y1 = std::min(y0 + factor, rows);
+			for (int x = 0; x < dstCols; ++x) {
+				const int x0 = x * factor;
+				const int x1 = std::min(x0 + factor, cols);
+				std::fill(sum.begin(), sum.end(), Accumulator(0));
+				for (int v = y0; v < y1; ++v) {
+					const T* row = src + ((size_t)v * cols + x0) * channels;
+					for (int u = 0; u < (x1 - x0) * channels; ++u) {
+						sum[u % channels] += row[u];
+					}
+				}
+				const Accumulator n = static_cast<Accumulator>((y1 - y0) * (x1 - x0));
+				for (int c = 0; c < channels; ++c) {
+					dst[((size_t)y * dstCols + x) * channels + c] = static_cast<T>(std::is_floating_point<T>::value ? sum[c] / n : (sum[c] + n / 2) / n);
+				}
+			}
+		}
+	}
+
+	std::vector<unsigned char> downsample(const void* src, int cols, int rows, gl::PixelFormat format, gl::PixelType type, int factor, int& dstCols, int& dstRows) {
+		dstCols = (cols + factor - 1) / factor;
+		dstRows = (rows + factor - 1) / factor;
+		const int channels = gl::getChannelsForFormat(format);
+		std::vector<unsigned char> dst(gl::getPixelSize(format, type) * dstCols * dstRows);
+		switch (type) {
+		case gl::PixelType::UByte:
+			downsample(static_cast<const unsigned char*>(src), cols, rows, channels, factor, dst.data(), dstCols, dstRows);
+			break;
+		case gl::PixelType::UShort:
+			downsample(static_cast<const uint16_t*>(src), cols, rows, channels, factor, reinterpret_cast<uint16_t*>(dst.data()), dstCols, dstRows);
+			break;
+		case gl::PixelType::Float:
+			downsample(static_cast<const float*>(src), cols, rows, channels, factor, reinterpret_cast<float*>(dst.data()), dstCols, dstRows);
+			break;
+		case gl::PixelType::Half: {
+			// Averaging is done in single precision
+			std::vector<float> full((size_t)cols * rows * channels);
+			std::vector<float> reduced((size_t)dstCols * dstRows * channels);
+			gl::halfToFloat(static_cast<const uint16_t*>(src), full.data(), full.size());
+			downsample(full.data(), cols, rows, channels, factor, reduced.data(), dstCols, dstRows);
+			gl::floatToHalf(reduced.data(), reinterpret_cast<uint16_t*>(dst.data()), reduced.size());
+			break;
+		}
+		case gl::PixelType::UInt:
+			downsample(static_cast<const uint32_t*>(src), cols, rows, channels, factor, reinterpret_cast<uint32_t*>(dst.data()), dstCols, dstRows);
+			break;
+		default:
+			throw std::runtime_error("Paged textures do not support this data type");
+		}
+		return dst;
+	}
+
+	void writeTileCache(const std::string& file, const void* data, int cols, int rows, gl::PixelFormat format, gl::PixelType type) {
+		constexpr int T = gl::LargeTexture::MaxTileSize;
+		const size_t pixelSize = gl::getPixelSize(format, type);
+		const std::vector<std::pair<int, int>> levels = levelSizes(cols, rows);
+
+		TileCacheHeader header;
+		std::memcpy(header.magic, TileCacheMagic, sizeof(TileCacheMagic));
+		header.cols = cols;
+		header.rows = rows;
+		header.format = static_cast<uint32_t>(format);
+		header.type = static_cast<uint32_t>(type);
+		header.tileSize = T;
+		header.levels = static_cast<int32_t>(levels.size());
+
+		std::error_code ec;
+		fs::create_directories(fs::path(file).parent_path(), ec);
+		// Write to a temporary file first, so a partially written cache is never picked up
+		const std::string partial = file + "." + std::to_string(std::hash<const void*>()(data)) + ".part";
+		{
+			std::ofstream out(partial, std::ios::binary);
+			out.write(reinterpret_cast<const char*>(&header), sizeof(TileCacheHeader));
+			std::vector<unsigned char> level;
+			const unsigned char* src = static_cast<const unsigned char*>(data);
+			for (size_t k = 0; k < levels.size(); ++k) {
+				auto [levelCols, levelRows] = levels[k];
+				if (k > 0) {
+					int dstCols, dstRows;
+					level = downsample(src, levels[k - 1].first, levels[k - 1].second, format, type, 2, dstCols, dstRows);
+					src = level.data();
+				}
+				for (int j = 0; j < levelRows; j += T) {
+					for (int i = 0; i < levelCols; i += T) {
+						const int w = std::min(T, levelCols - i);
+						const int h = std::min(T, levelRows - j);
+						for (int y = j; y < j + h; ++y) {
+							out.write(reinterpret_cast<const char*>(src + ((size_t)y * levelCols + i) * pixelSize), w * pixelSize);
+						}
+					}
+				}
+			}
+			if (!out) {
+				out.close();
+				fs::remove(partial, ec);
+				throw std::runtime_error("Could not write tile cache \"" + file + "\"");
+			}
+		}
+		fs::rename(partial, file, ec);
+		if (ec) {
+			fs::remove(partial, ec);
+		}
+	}
+}
 
 gl::LargeTexture::LargeTexture(int cols, int rows, PixelFormat pixelFormat, gl::PixelType dataType, TextureFlags flags) :
 	TextureBase(TextureType::D2, pixelFormat, dataType, flags),
 	rowTiles(mRowTiles),
 	colTiles(mColTiles)
 {
-	// We always do a force init (FIXME)
-	if (flags & TextureFlags_Lazy_Init) {
-		std::cerr << "WARNING: Requested lazy init for a large texture but this is not implemented.\n";
-	}
-
 	mRows = rows;
 	mCols = cols;
+	if (flags & TextureFlags_Lazy_Init) {
+		// Tiles are paged in once setData provided the content
+		mPages = std::make_shared<PageTable>();
+	}
 	init();
 	
 }
@@ -26,64 +229,61 @@ gl::LargeTexture::LargeTexture(std::string path, bool flipY, TextureFlags flags)
 	rowTiles(mRowTiles),
 	colTiles(mColTiles)
 {
-	// We always do a force init (FIXME)
 	if (flags & TextureFlags_Lazy_Init) {
-		std::cerr << "WARNING: Requested lazy init for a large texture but this is not implemented.\n";
-	}
-
-	int channels;
-	stbi_set_flip_vertically_on_load(flipY);
-	unsigned char* data = stbi_load(path.c_str(), &mCols, &mRows, &channels, 0);
-	if (data == NULL) {
-		throw std::runtime_error("Could not load texture from \"" + path + "\"");
-	}
-	if (channels == 1) {
-		mPixelFormat = PixelFormat::Red;
-	}
-	else if (channels == 2) {
-		mPixelFormat = PixelFormat::RG;
-	}
-	else if (channels == 4) {
-		mPixelFormat = PixelFormat::RGBA;
+		initPages(BuildTileCache(path, flipY), false);
+		return;
 	}
 
+	ImageData image = decodeImage(path, flipY);
+	mCols = image.cols;
+	mRows = image.rows;
+	mPixelFormat = image.format;
+	mDataType = image.type;
 	init();
-	setData(data);
-	stbi_image_free(data);
+	setData(image.pixels.data());
 }
 
 gl::LargeTexture::~LargeTexture()
 {
-	glDeleteTextures(numTiles(), mIds.data());	// FIXME: Do we need to check that all ids are valid?
+	glDeleteTextures((GLsizei)mIds.size(), mIds.data());	// Ids of tiles that are not resident are 0 and silently ignored
+	impl::tilesDeleted(mIds);
 	mIds.clear();
+	if (mPages != nullptr && mPages->ownsCacheFile) {
+		std::error_code ec;
+		fs::remove(mPages->cacheFile, ec);
+	}
 }
 
 void gl::LargeTexture::setData(const void* data, PixelFormat pixelFormat)
 {
-	GLenum format = pixelFormat == gl::PixelFormat::Default ? glFormat() : getGLFormat(pixelFormat);
-	GLint oldAlign;
-	glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlign);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glPixelStorei(GL_UNPACK_ROW_LENGTH, mCols);
-	for (int j = 0; j < mRowTiles; ++j) {
-		for (int i = 0; i < mColTiles; ++i) {
-			glBindTexture(GL_TEXTURE_2D, mIds[j * mColTiles + i]);
-			auto [w, h] = tileSize(i, j);
-			glPixelStorei(GL_UNPACK_SKIP_PIXELS, i * MaxTileSize);
-			glPixelStorei(GL_UNPACK_SKIP_ROWS, j * MaxTileSize);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, format, static_cast<GLenum>(mDataType), data);
-		}
-	}
-	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
-	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
-	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlign);
+	const PixelFormat sourceFormat = pixelFormat == gl::PixelFormat::Default ? mPixelFormat : pixelFormat;
+	if (mPages != nullptr) {
+		if (sourceFormat != mPixelFormat) {
+			throw std::invalid_argument("Paged textures expect data in their own pixel format");
+		}
+		const std::string cacheFile = impl::anonymousTileCacheFile();
+		impl::writeTileCache(cacheFile, data, mCols, mRows, mPixelFormat, mDataType);
+		initPages(cacheFile, true);
+		return;
+	}
+	uploadLevels(data, sourceFormat, false);
+}
+
+void gl::LargeTexture::setDataAsync(const void* data, PixelFormat pixelFormat)
+{
+	if (mPages != nullptr) {
+		// Paged textures upload their tiles on demand anyway
+		setData(data, pixelFormat);
+		return;
+	}
+	uploadLevels(data, pixelFormat == gl::PixelFormat::Default ? mPixelFormat : pixelFormat, true);
 }
 
 void gl::LargeTexture::setFilters(gl::FilterType minFilter, gl::FilterType magFilter)
 {
 	for (GLuint id : mIds) {
-		glBindTexture(GL_TEXTURE_2D, id);
+		if (id == 0) { continue; }
+		gl::StateCache::Current().bindTexture(GL_TEXTURE_2D, id);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLenum>(minFilter));
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLenum>(magFilter));
 	}
@@ -94,7 +294,8 @@ void gl::LargeTexture::setFilters(gl::FilterType minFilter, gl::FilterType magFi
 void gl::LargeTexture::setWrapping(gl::WrapType s, gl::WrapType t, gl::WrapType r)
 {
 	for (GLuint id : mIds) {
-		glBindTexture(GL_TEXTURE_2D, id);
+		if (id == 0) { continue; }
+		gl::StateCache::Current().bindTexture(GL_TEXTURE_2D, id);
 		if (s != WrapType::None) {
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLenum>(s));
 			mWrapType[0] = s;
@@ -120,44 +321,402 @@ size_t gl::LargeTexture::numTiles() const
 	return mRowTiles * mColTiles;
 }
 
-std::pair<int, int> gl::LargeTexture::tileSize(int i, int j) const
+std::pair<int, int> gl::LargeTexture::tileSize(int i, int j, int level) const
 {
+	const Level& l = mLevels[level];
 	const int i0 = i * MaxTileSize;
-	const int i1 = std::min(i0 + MaxTileSize, mCols);
+	const int i1 = std::min(i0 + MaxTileSize, l.cols);
 	const int j0 = j * MaxTileSize;
-	const int j1 = std::min(j0 + MaxTileSize, mRows);
+	const int j1 = std::min(j0 + MaxTileSize, l.rows);
 	return { i1 - i0, j1 - j0 };
 }
 
-ImTextureID gl::LargeTexture::getTileID(int i, int j) const
+ImTextureID gl::LargeTexture::getTileID(int i, int j, int level) const
 {
-	return (ImTextureID)mIds[j * mColTiles + i];
+	return (ImTextureID)mIds[tileIndex(i, j, level)];
 }
 
-ImVec2 gl::LargeTexture::getRelativePos(int i, int j) const
+ImVec2 gl::LargeTexture::getRelativePos(int i, int j, int level) const
 {
+	const Level& l = mLevels[level];
 	return ImVec2(
-		(float)(i * MaxTileSize) / mCols,
-		(float)(j * MaxTileSize) / mRows);
+		(float)(i * MaxTileSize) / l.cols,
+		(float)(j * MaxTileSize) / l.rows);
+}
+
+int gl::LargeTexture::numLevels() const
+{
+	return static_cast<int>(mLevels.size());
+}
+
+int gl::LargeTexture::levelColTiles(int level) const
+{
+	return mLevels[level].colTiles;
+}
+
+int gl::LargeTexture::levelRowTiles(int level) const
+{
+	return mLevels[level].rowTiles;
+}
+
+int gl::LargeTexture::selectLevel(ImVec2 screenSize) const
+{
+	// Every level halves the resolution, so the level follows from the minification of the full resolution
+	const float scale = std::min(screenSize.x / mCols, screenSize.y / mRows);
+	if (!(scale > 0.0f) || scale >= 1.0f) {
+		return 0;
+	}
+	return std::clamp((int)std::floor(std::log2(1.0f / scale)), 0, numLevels() - 1);
+}
+
+bool gl::LargeTexture::isPaged() const
+{
+	return mPages != nullptr;
+}
+
+bool gl::LargeTexture::isTileResident(int i, int j, int level) const
+{
+	return mIds[tileIndex(i, j, level)] != 0;
+}
+
+void gl::LargeTexture::requestTile(int i, int j, int level)
+{
+	if (mPages == nullptr || mPages->cacheFile.empty()) { return; }
+	PageTable& pages = *mPages;
+	const int tile = tileIndex(i, j, level);
+	pages.lastUsed[tile] = impl::currentFrame();
+	if (pages.states[tile] != PageTable::TileState::Missing) {
+		return;
+	}
+
+	pages.states[tile] = PageTable::TileState::Loading;
+	auto [w, h] = tileSize(i, j, level);
+	const size_t size = getPixelSize(mPixelFormat, mDataType) * w * h;
+	const uint64_t offset = pages.tileOffsets[tile];
+	const std::string file = pages.cacheFile;
+	std::shared_ptr<std::vector<unsigned char>> pixels = std::make_shared<std::vector<unsigned char>>();
+	// The page table is replaced whenever the content changes, so outdated loads can detect that they expired
+	std::weak_ptr<PageTable> token = mPages;
+	TextureLoader::Default().enqueue(
+		[file, offset, size, pixels]() -> size_t {
+			std::ifstream in(file, std::ios::binary);
+			pixels->resize(size);
+			if (!in.seekg(offset) || !in.read(reinterpret_cast<char*>(pixels->data()), size)) {
+				pixels->clear();
+			}
+			return pixels->size();
+		},
+		[this, token, tile, pixels]() {
+			if (token.expired()) { return; }
+			onTileLoaded(tile, *pixels);
+		});
+}
+
+void gl::LargeTexture::requestRegion(ImVec2 min, ImVec2 max, int level)
+{
+	if (mPages == nullptr) { return; }
+	const Level& l = mLevels[level];
+	const int i0 = std::clamp((int)(min.x * l.cols) / MaxTileSize, 0, l.colTiles - 1);
+	const int i1 = std::clamp((int)(max.x * l.cols) / MaxTileSize, 0, l.colTiles - 1);
+	const int j0 = std::clamp((int)(min.y * l.rows) / MaxTileSize, 0, l.rowTiles - 1);
+	const int j1 = std::clamp((int)(max.y * l.rows) / MaxTileSize, 0, l.rowTiles - 1);
+	for (int j = j0; j <= j1; ++j) {
+		for (int i = i0; i <= i1; ++i) {
+			requestTile(i, j, level);
+		}
+	}
+}
+
+ImTextureID gl::LargeTexture::getOverviewID() const
+{
+	return (ImTextureID)mIds[mLevels.back().firstTile];
+}
+
+void gl::LargeTexture::setResidencyBudget(size_t bytes)
+{
+	if (mPages == nullptr) { return; }
+	mPages->budget = bytes;
+	evictTiles();
+}
+
+size_t gl::LargeTexture::residencyBudget() const
+{
+	return mPages != nullptr ? mPages->budget : 0;
+}
+
+size_t gl::LargeTexture::residentBytes() const
+{
+	if (mPages != nullptr) {
+		return mPages->residentBytes;
+	}
+	size_t bytes = 0;
+	for (const Level& level : mLevels) {
+		bytes += (size_t)level.cols * level.rows * getPixelSize(mPixelFormat, mDataType);
+	}
+	return bytes;
+}
+
+std::string gl::LargeTexture::BuildTileCache(const std::string& path, bool flipY)
+{
+	const std::string cacheFile = impl::tileCacheFile(path, flipY);
+	impl::TileCacheHeader header;
+	if (!impl::readTileCacheHeader(cacheFile, header)) {
+		ImageData image = decodeImage(path, flipY);
+		impl::writeTileCache(cacheFile, image.pixels.data(), image.cols, image.rows, image.format, image.type);
+	}
+	return cacheFile;
 }
 
 void gl::LargeTexture::init()
 {
-	// Compute number of tiles
-	mColTiles = (mCols + MaxTileSize - 1) / MaxTileSize;
-	mRowTiles = (mRows + MaxTileSize - 1) / MaxTileSize;
+	// Compute number of tiles of every level
+	mLevels.clear();
+	int firstTile = 0;
+	for (auto [cols, rows] : impl::levelSizes(mCols, mRows)) {
+		Level level;
+		level.cols = cols;
+		level.rows = rows;
+		level.colTiles = (cols + MaxTileSize - 1) / MaxTileSize;
+		level.rowTiles = (rows + MaxTileSize - 1) / MaxTileSize;
+		level.firstTile = firstTile;
+		firstTile += level.colTiles * level.rowTiles;
+		mLevels.push_back(level);
+	}
+	mColTiles = mLevels[0].colTiles;
+	mRowTiles = mLevels[0].rowTiles;
+
+	mIds.assign(firstTile, 0);
+	if (mPages != nullptr) {
+		// Tiles of paged textures are created once they become resident
+		return;
+	}
+	for (int tile = 0; tile < (int)mIds.size(); ++tile) {
+		auto [w, h] = tileSize(tile);
+		mIds[tile] = createTile(w, h);
+	}
+}
+
+void gl::LargeTexture::initPages(const std::string& cacheFile, bool ownsCacheFile)
+{
+	impl::TileCacheHeader header;
+	if (!impl::readTileCacheHeader(cacheFile, header)) {
+		throw std::runtime_error("Invalid tile cache \"" + cacheFile + "\"");
+	}
+
+	// Drop the tiles of the previous content
+	glDeleteTextures((GLsizei)mIds.size(), mIds.data());
+	impl::tilesDeleted(mIds);
+	std::shared_ptr<PageTable> pages = std::make_shared<PageTable>();
+	if (mPages != nullptr) {
+		pages->budget = mPages->budget;
+		if (mPages->ownsCacheFile && mPages->cacheFile != cacheFile) {
+			std::error_code ec;
+			fs::remove(mPages->cacheFile, ec);
+		}
+	}
+	mPages = pages;
+	mPages->cacheFile = cacheFile;
+	mPages->ownsCacheFile = ownsCacheFile;
+
+	mCols = header.cols;
+	mRows = header.rows;
+	mPixelFormat = static_cast<PixelFormat>(header.format);
+	mDataType = static_cast<PixelType>(header.type);
+	init();
+
+	const size_t pixelSize = getPixelSize(mPixelFormat, mDataType);
+	uint64_t offset = sizeof(impl::TileCacheHeader);
+	mPages->tileOffsets.resize(mIds.size());
+	for (int tile = 0; tile < (int)mIds.size(); ++tile) {
+		auto [w, h] = tileSize(tile);
+		mPages->tileOffsets[tile] = offset;
+		offset += pixelSize * w * h;
+	}
+	mPages->states.assign(mIds.size(), PageTable::TileState::Missing);
+	mPages->lastUsed.assign(mIds.size(), -1);
+
+	// The coarsest level is loaded right away and never evicted, so there is always something to draw
+	std::ifstream in(cacheFile, std::ios::binary);
+	for (int tile = mLevels.back().firstTile; tile < (int)mIds.size(); ++tile) {
+		auto [w, h] = tileSize(tile);
+		std::vector<unsigned char> pixels(pixelSize * w * h);
+		in.seekg(mPages->tileOffsets[tile]);
+		if (!in.read(reinterpret_cast<char*>(pixels.data()), pixels.size())) {
+			throw std::runtime_error("Invalid tile cache \"" + cacheFile + "\"");
+		}
+		mIds[tile] = createTile(w, h);
+		uploadTile(tile, pixels.data(), w, mPixelFormat, false);
+		mPages->states[tile] = PageTable::TileState::Resident;
+		mPages->residentBytes += pixels.size();
+	}
+}
+
+void gl::LargeTexture::uploadLevels(const void* data, PixelFormat format, bool async)
+{
+	mLevelsToken = std::make_shared<int>(0);
+	const unsigned char* src = static_cast<const unsigned char*>(data);
+	uploadLevel(0, src, format, async);
+	if (numLevels() == 1) {
+		return;
+	}
+
+	if (!async) {
+		// Every level is filtered from the previous one, which is cheaper than starting from full resolution
+		std::vector<unsigned char> level;
+		for (int k = 1; k < numLevels(); ++k) {
+			int cols, rows;
+			level = impl::downsample(src, mLevels[k - 1].cols, mLevels[k - 1].rows, format, mDataType, 2, cols, rows);
+			src = level.data();
+			uploadLevel(k, src, format, false);
+		}
+		return;
+	}
+
+	// Filtering takes much longer than streaming the tiles, so the levels are built on a worker. data is only valid
+	// during this call, so the worker gets a copy
+	const size_t size = getPixelSize(format, mDataType) * mCols * mRows;
+	auto levels = std::make_shared<std::vector<std::vector<unsigned char>>>(numLevels());
+	(*levels)[0].assign(src, src + size);
+	std::vector<Level> sizes = mLevels;
+	const gl::PixelType type = mDataType;
+	std::weak_ptr<int> token = mLevelsToken;
+	TextureLoader::Default().enqueue(
+		[levels, sizes, format, type]() -> size_t {
+			size_t bytes = 0;
+			for (size_t k = 1; k < levels->size(); ++k) {
+				int cols, rows;
+				(*levels)[k] = impl::downsample((*levels)[k - 1].data(), sizes[k - 1].cols, sizes[k - 1].rows, format, type, 2, cols, rows);
+				bytes += (*levels)[k].size();
+			}
+			(*levels)[0].clear();
+			(*levels)[0].shrink_to_fit();
+			return bytes;
+		},
+		[this, token, levels, format]() {
+			if (token.expired()) { return; }
+			for (int k = 1; k < numLevels(); ++k) {
+				uploadLevel(k, (*levels)[k].data(), format, true);
+			}
+		});
+}
+
+void gl::LargeTexture::uploadLevel(int level, const unsigned char* data, PixelFormat format, bool async)
+{
+	const size_t pixelSize = getPixelSize(format, mDataType);
+	const Level& l = mLevels[level];
+	for (int j = 0; j < l.rowTiles; ++j) {
+		for (int i = 0; i < l.colTiles; ++i) {
+			const unsigned char* tileSrc = data + ((size_t)j * MaxTileSize * l.cols + (size_t)i * MaxTileSize) * pixelSize;
+			uploadTile(tileIndex(i, j, level), tileSrc, l.cols, format, async);
+		}
+	}
+}
+
+void gl::LargeTexture::uploadTile(int tile, const void* data, size_t rowLength, PixelFormat format, bool async)
+{
+	auto [w, h] = tileSize(tile);
+	const size_t pixelSize = getPixelSize(format, mDataType);
+	GLint oldAlign;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlign);
+	gl::StateCache::Current().bindTexture(GL_TEXTURE_2D, mIds[tile]);
+	if (async) {
+		// Stream the tile through the upload ring, so the render thread does not wait for the driver copy.
+		// Tiles are packed tightly in the buffer, so the upload does not need a row length
+		PixelBufferRing& ring = PixelBufferRing::Uploads();
+		const size_t tileRowSize = pixelSize * w;
+		const int slot = ring.acquire(tileRowSize * h);
+		unsigned char* dst = static_cast<unsigned char*>(ring.map(slot));
+		const unsigned char* src = static_cast<const unsigned char*>(data);
+		for (int y = 0; y < h; ++y) {
+			std::memcpy(dst + y * tileRowSize, src + y * rowLength * pixelSize, tileRowSize);
+		}
+		ring.unmap(slot);
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, tileRowSize % 4 == 0 ? 4 : 1);
+		ring.bind(slot);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, getGLFormat(format, mDataType), static_cast<GLenum>(mDataType), nullptr);
+		ring.unbind();
+		ring.fence(slot);
+	}
+	else {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, (rowLength * pixelSize) % 4 == 0 ? 4 : 1);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)rowLength);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, getGLFormat(format, mDataType), static_cast<GLenum>(mDataType), data);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlign);
+}
+
+void gl::LargeTexture::onTileLoaded(int tile, const std::vector<unsigned char>& pixels)
+{
+	PageTable& pages = *mPages;
+	if (pixels.empty()) {
+		LOG_WARNING("Could not read tile %d from \"%s\"", tile, pages.cacheFile.c_str());
+		pages.states[tile] = PageTable::TileState::Missing;
+		return;
+	}
 
-	mIds.resize(mColTiles * mRowTiles, 0);
-	glGenTextures(mColTiles * mRowTiles, mIds.data());
-	// Set size of all images
-	for (size_t j = 0; j < mRowTiles; ++j) {
-		for (size_t i = 0; i < mColTiles; ++i) {
-			glBindTexture(GL_TEXTURE_2D, mIds[j * mColTiles + i]);
-			auto [w, h] = tileSize(i, j);
-			glTexImage2D(GL_TEXTURE_2D, 0, glSizedFormat(), w, h, 0, glFormat(), static_cast<GLenum>(mDataType), nullptr);
+	auto [w, h] = tileSize(tile);
+	mIds[tile] = createTile(w, h);
+	uploadTile(tile, pixels.data(), w, mPixelFormat, true);
+	pages.states[tile] = PageTable::TileState::Resident;
+	pages.residentBytes += pixels.size();
+	evictTiles();
+}
+
+void gl::LargeTexture::evictTiles()
+{
+	PageTable& pages = *mPages;
+	const int frame = impl::currentFrame();
+	const size_t pixelSize = getPixelSize(mPixelFormat, mDataType);
+	// The coarsest level is pinned
+	const int pinned = mLevels.back().firstTile;
+	while (pages.residentBytes > pages.budget) {
+		// Tiles used in the current frame are never evicted, even if that exceeds the budget
+		int victim = -1;
+		for (int tile = 0; tile < pinned; ++tile) {
+			if (mIds[tile] != 0 && pages.lastUsed[tile] != frame && (victim < 0 || pages.lastUsed[tile] < pages.lastUsed[victim])) {
+				victim = tile;
+			}
 		}
+		if (victim < 0) {
+			break;
+		}
+		auto [w, h] = tileSize(victim);
+		glDeleteTextures(1, &mIds[victim]);
+		gl::StateCache::Current().textureDeleted(mIds[victim]);
+		mIds[victim] = 0;
+		pages.states[victim] = PageTable::TileState::Missing;
+		pages.residentBytes -= pixelSize * w * h;
 	}
+}
+
+GLuint gl::LargeTexture::createTile(int w, int h)
+{
+	GLuint id;
+	glGenTextures(1, &id);
+	gl::StateCache::Current().bindTexture(GL_TEXTURE_2D, id);
+	glTexImage2D(GL_TEXTURE_2D, 0, glSizedFormat(), w, h, 0, glFormat(), static_cast<GLenum>(mDataType), nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLenum>(mMinFilterType));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLenum>(mMagFilterType));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLenum>(mWrapType[0]));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLenum>(mWrapType[1]));
+	return id;
+}
 
-	setFilters(mMinFilterType, mMagFilterType);
-	setWrapping(mWrapType[0], mWrapType[1], mWrapType[2]);
+int gl::LargeTexture::tileIndex(int i, int j, int level) const
+{
+	const Level& l = mLevels[level];
+	return l.firstTile + j * l.colTiles + i;
+}
+
+std::pair<int, int> gl::LargeTexture::tileSize(int tile) const
+{
+	// Find the level of the tile. There are only a handful of levels
+	int level = numLevels() - 1;
+	while (mLevels[level].firstTile > tile) {
+		level--;
+	}
+	const int local = tile - mLevels[level].firstTile;
+	return tileSize(local % mLevels[level].colTiles, local / mLevels[level].colTiles, level);
 }
@@ -0,0 +1,276 @@
+#include "glpp/pixel_buffer.hpp"
+#include "glpp/context.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace impl {
+	bool supportsPersistentMapping() {
+#ifdef GL_MAP_PERSISTENT_BIT
+		return gl::hasVersion(4, 4) || gl::hasExtension("GL_ARB_buffer_storage");
+#else
+		return false;
+#endif
+	}
+}
+
+gl::PixelBufferRing::PixelBufferRing(GLenum target, int slots) :
+	mTarget(target),
+	mPersistent(impl::supportsPersistentMapping()),
+	mNext(0),
+	mSlots(slots)
+{
+	if (target != GL_PIXEL_UNPACK_BUFFER && target != GL_PIXEL_PACK_BUFFER) {
+		throw std::invalid_argument("A pixel buffer ring must either target GL_PIXEL_UNPACK_BUFFER or GL_PIXEL_PACK_BUFFER");
+	}
+	if (slots < 1) {
+		throw std::invalid_argument("A pixel buffer ring needs at least one slot");
+	}
+}
+
+gl::PixelBufferRing::~PixelBufferRing()
+{
+	for (Slot& slot : mSlots) {
+		release(slot);
+	}
+}
+
+int gl::PixelBufferRing::acquire(size_t sizeInBytes)
+{
+	const int index = mNext;
+	mNext = (mNext + 1) % static_cast<int>(mSlots.size());
+
+	wait(index);
+	Slot& slot = mSlots[index];
+	if (slot.capacity < sizeInBytes) {
+		release(slot);
+		allocate(slot, sizeInBytes);
+	}
+	return index;
+}
+
+void* gl::PixelBufferRing::map(int index)
+{
+	Slot& slot = mSlots[index];
+	if (slot.mapped == nullptr) {
+		// The fence of the slot was already waited on, so there is no need for the driver to synchronize
+		const GLbitfield access = mTarget == GL_PIXEL_UNPACK_BUFFER
+			? GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+			: GL_MAP_READ_BIT;
+		glBindBuffer(mTarget, slot.id);
+		slot.mapped = glMapBufferRange(mTarget, 0, slot.capacity, access);
+		glBindBuffer(mTarget, 0);
+	}
+	return slot.mapped;
+}
+
+void gl::PixelBufferRing::unmap(int index)
+{
+	Slot& slot = mSlots[index];
+	if (!mPersistent && slot.mapped != nullptr) {
+		glBindBuffer(mTarget, slot.id);
+		glUnmapBuffer(mTarget);
+		glBindBuffer(mTarget, 0);
+		slot.mapped = nullptr;
+	}
+}
+
+void gl::PixelBufferRing::fence(int index)
+{
+	Slot& slot = mSlots[index];
+	if (slot.fence != nullptr) {
+		glDeleteSync(slot.fence);
+	}
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool gl::PixelBufferRing::isSignaled(int index)
+{
+	Slot& slot = mSlots[index];
+	if (slot.fence == nullptr) {
+		return true;
+	}
+	GLint status = GL_UNSIGNALED;
+	glGetSynciv(slot.fence, GL_SYNC_STATUS, 1, nullptr, &status);
+	if (status == GL_SIGNALED) {
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		return true;
+	}
+	return false;
+}
+
+void gl::PixelBufferRing::wait(int index)
+{
+	Slot& slot = mSlots[index];
+	if (slot.fence == nullptr) {
+		return;
+	}
+	// The first wait flushes the command queue, otherwise the fence may never be signaled
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	while (true) {
+		GLenum result = glClientWaitSync(slot.fence, flags, 1000000);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+			break;
+		}
+		flags = 0;
+	}
+	glDeleteSync(slot.fence);
+	slot.fence = nullptr;
+}
+
+void gl::PixelBufferRing::bind(int index) const
+{
+	glBindBuffer(mTarget, mSlots[index].id);
+}
+
+void gl::PixelBufferRing::unbind() const
+{
+	glBindBuffer(mTarget, 0);
+}
+
+bool gl::PixelBufferRing::isPersistent() const
+{
+	return mPersistent;
+}
+
+GLenum gl::PixelBufferRing::target() const
+{
+	return mTarget;
+}
+
+size_t gl::PixelBufferRing::capacity(int index) const
+{
+	return mSlots[index].capacity;
+}
+
+int gl::PixelBufferRing::slots() const
+{
+	return static_cast<int>(mSlots.size());
+}
+
+gl::PixelBufferRing& gl::PixelBufferRing::Uploads()
+{
+	// Leaked on purpose: Its destructor unmaps and deletes the buffers, there is no current context left for that at exit
+	static PixelBufferRing* ring = new PixelBufferRing(GL_PIXEL_UNPACK_BUFFER);
+	return *ring;
+}
+
+void gl::PixelBufferRing::allocate(Slot& slot, size_t sizeInBytes)
+{
+	assert(slot.id == 0);
+	glGenBuffers(1, &slot.id);
+	glBindBuffer(mTarget, slot.id);
+#ifdef GL_MAP_PERSISTENT_BIT
+	if (mPersistent) {
+		const GLbitfield access = GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT
+			| (mTarget == GL_PIXEL_UNPACK_BUFFER ? GL_MAP_WRITE_BIT : GL_MAP_READ_BIT);
+		glBufferStorage(mTarget, sizeInBytes, nullptr, access);
+		slot.mapped = glMapBufferRange(mTarget, 0, sizeInBytes, access);
+	}
+	else
+#endif
+	{
+		glBufferData(mTarget, sizeInBytes, nullptr, mTarget == GL_PIXEL_UNPACK_BUFFER ? GL_STREAM_DRAW : GL_STREAM_READ);
+	}
+	glBindBuffer(mTarget, 0);
+	slot.capacity = sizeInBytes;
+}
+
+void gl::PixelBufferRing::release(Slot& slot)
+{
+	if (slot.id == 0) {
+		return;
+	}
+	wait(static_cast<int>(&slot - mSlots.data()));
+	if (slot.mapped != nullptr) {
+		glBindBuffer(mTarget, slot.id);
+		glUnmapBuffer(mTarget);
+		glBindBuffer(mTarget, 0);
+		slot.mapped = nullptr;
+	}
+	glDeleteBuffers(1, &slot.id);
+	slot.id = 0;
+	slot.capacity = 0;
+}
+
+gl::DownloadQueue::DownloadQueue(int slots) :
+	mRing(GL_PIXEL_PACK_BUFFER, slots)
+{
+}
+
+int gl::DownloadQueue::acquire(size_t sizeInBytes)
+{
+	// Reads occupy consecutive slots, so the next slot of a full ring belongs to the oldest read
+	while (mReads.size() >= static_cast<size_t>(mRing.slots())) {
+		mRing.wait(mReads.front().slot);
+		finish(mReads.front());
+		mReads.pop_front();
+	}
+	return mRing.acquire(sizeInBytes);
+}
+
+std::future<void> gl::DownloadQueue::push(int slot, size_t sizeInBytes, void* dst, std::function<void()> onFinished, bool background)
+{
+	mRing.fence(slot);
+	Read read;
+	read.slot = slot;
+	read.size = sizeInBytes;
+	read.dst = dst;
+	read.onFinished = onFinished;
+	read.background = background;
+	std::future<void> future = read.promise.get_future();
+	mReads.push_back(std::move(read));
+	return future;
+}
+
+void gl::DownloadQueue::poll()
+{
+	while (!mReads.empty() && mRing.isSignaled(mReads.front().slot)) {
+		finish(mReads.front());
+		mReads.pop_front();
+	}
+}
+
+void gl::DownloadQueue::flush()
+{
+	while (!mReads.empty()) {
+		mRing.wait(mReads.front().slot);
+		finish(mReads.front());
+		mReads.pop_front();
+	}
+}
+
+size_t gl::DownloadQueue::pending(bool includeBackground) const
+{
+	if (includeBackground) {
+		return mReads.size();
+	}
+	return std::count_if(mReads.begin(), mReads.end(), [](const Read& read) { return !read.background; });
+}
+
+gl::PixelBufferRing& gl::DownloadQueue::ring()
+{
+	return mRing;
+}
+
+gl::DownloadQueue& gl::DownloadQueue::Default()
+{
+	// Leaked on purpose like the upload ring: Destroying it would delete the pack buffers of reads that may still be
+	// in flight, after the context is gone
+	// Picking, reductions and exposure metering each keep a read or two in flight every frame
+	static DownloadQueue* queue = new DownloadQueue(8);
+	return *queue;
+}
+
+void gl::DownloadQueue::finish(Read& read)
+{
+	std::memcpy(read.dst, mRing.map(read.slot), read.size);
+	mRing.unmap(read.slot);
+	read.promise.set_value();
+	if (read.onFinished) {
+		read.onFinished();
+	}
+}
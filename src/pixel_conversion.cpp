@@ -0,0 +1,135 @@
+#include "glpp/pixel_conversion.hpp"
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define GL_PIXEL_CONVERSION_SSSE3
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GL_PIXEL_CONVERSION_NEON
+#endif
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#define GL_PIXEL_CONVERSION_F16C
+#endif
+
+#include <cstring>
+
+namespace impl {
+	uint32_t floatBits(float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(float));
+		return bits;
+	}
+
+	float bitsToFloat(uint32_t bits) {
+		float value;
+		std::memcpy(&value, &bits, sizeof(float));
+		return value;
+	}
+
+	uint16_t floatToHalf(float value) {
+		uint32_t x = floatBits(value);
+		const uint32_t sign = x & 0x80000000u;
+		x ^= sign;
+		uint16_t half;
+		if (x >= 0x47800000u) {
+			// Too large for a half (or infinity / NaN)
+			half = x > 0x7f800000u ? 0x7e00 : 0x7c00;
+		}
+		else if (x < 0x38800000u) {
+			// Subnormal half: Adding a magic number moves the mantissa bits into place and rounds them correctly
+			half = static_cast<uint16_t>(floatBits(bitsToFloat(x) + bitsToFloat(126u << 23)) - (126u << 23));
+		}
+		else {
+			// Rebias the exponent and round to nearest even
+			const uint32_t odd = (x >> 13) & 1;
+			x += ((15u - 127u) << 23) + 0xfff + odd;
+			half = static_cast<uint16_t>(x >> 13);
+		}
+		return static_cast<uint16_t>((sign >> 16) | half);
+	}
+
+	float halfToFloat(uint16_t half) {
+		constexpr uint32_t exponentMask = 0x7c00u << 13;
+		uint32_t x = (half & 0x7fffu) << 13;
+		const uint32_t exponent = x & exponentMask;
+		x += (127u - 15u) << 23;
+		if (exponent == exponentMask) {
+			// Infinity / NaN
+			x += (128u - 16u) << 23;
+		}
+		else if (exponent == 0) {
+			// Zero / subnormal
+			x += 1u << 23;
+			x = floatBits(bitsToFloat(x) - bitsToFloat(113u << 23));
+		}
+		return bitsToFloat(x | (static_cast<uint32_t>(half & 0x8000u) << 16));
+	}
+}
+
+void gl::expandRGBToRGBA(const unsigned char* src, unsigned char* dst, size_t pixels, unsigned char alpha)
+{
+	size_t i = 0;
+#if defined(GL_PIXEL_CONVERSION_SSSE3)
+	// Every iteration converts 4 pixels but loads 16 bytes, so stop early enough to never read past the end
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(static_cast<unsigned int>(alpha) << 24));
+	for (; i + 6 <= pixels; i += 4) {
+		__m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i));
+		__m128i rgba = _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alphaMask);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), rgba);
+	}
+#elif defined(GL_PIXEL_CONVERSION_NEON)
+	const uint8x16_t alphaLane = vdupq_n_u8(alpha);
+	for (; i + 16 <= pixels; i += 16) {
+		uint8x16x3_t rgb = vld3q_u8(src + 3 * i);
+		uint8x16x4_t rgba;
+		rgba.val[0] = rgb.val[0];
+		rgba.val[1] = rgb.val[1];
+		rgba.val[2] = rgb.val[2];
+		rgba.val[3] = alphaLane;
+		vst4q_u8(dst + 4 * i, rgba);
+	}
+#endif
+	for (; i < pixels; ++i) {
+		dst[4 * i + 0] = src[3 * i + 0];
+		dst[4 * i + 1] = src[3 * i + 1];
+		dst[4 * i + 2] = src[3 * i + 2];
+		dst[4 * i + 3] = alpha;
+	}
+}
+
+void gl::floatToHalf(const float* src, uint16_t* dst, size_t count)
+{
+	size_t i = 0;
+#if defined(GL_PIXEL_CONVERSION_F16C)
+	for (; i + 8 <= count; i += 8) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+	}
+#elif defined(GL_PIXEL_CONVERSION_NEON) && defined(__aarch64__)
+	for (; i + 4 <= count; i += 4) {
+		vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+	}
+#endif
+	for (; i < count; ++i) {
+		dst[i] = impl::floatToHalf(src[i]);
+	}
+}
+
+void gl::halfToFloat(const uint16_t* src, float* dst, size_t count)
+{
+	size_t i = 0;
+#if defined(GL_PIXEL_CONVERSION_F16C)
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+	}
+#elif defined(GL_PIXEL_CONVERSION_NEON) && defined(__aarch64__)
+	for (; i + 4 <= count; i += 4) {
+		vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+	}
+#endif
+	for (; i < count; ++i) {
+		dst[i] = impl::halfToFloat(src[i]);
+	}
+}
@@ -0,0 +1,271 @@
+#include "glpp/post_processing.hpp"
+
+#include "glpp/intermediate.h"
+#include "glpp/render_target_pool.hpp"
+#include "glpp/state_cache.hpp"
+
+#include <algorithm>
+
+#include "../shaders/display_shader.glsl.h"
+#include "../shaders/post_processing.glsl.h"
+
+gl::PostEffect gl::PostEffect::Tonemapping()
+{
+	PostEffect effect;
+	effect.name = "tonemapping";
+	effect.source = TONEMAPPING_EFFECT;
+	return effect;
+}
+
+gl::PostEffect gl::PostEffect::GammaCorrection()
+{
+	PostEffect effect;
+	effect.name = "gammaCorrection";
+	effect.source = GAMMA_EFFECT;
+	return effect;
+}
+
+gl::PostEffect gl::PostEffect::Sharpen()
+{
+	PostEffect effect;
+	effect.name = "sharpen";
+	effect.source = SHARPEN_EFFECT;
+	effect.samplesNeighbours = true;
+	return effect;
+}
+
+gl::PostEffect gl::PostEffect::FXAA()
+{
+	PostEffect effect;
+	effect.name = "fxaa";
+	effect.source = FXAA_EFFECT;
+	effect.samplesNeighbours = true;
+	return effect;
+}
+
+gl::PostProcessingChain::PostProcessingChain() :
+	mBuiltSRGB(false),
+	mDirty(true),
+	mSRGBOutput(false),
+	mFramebuffer(0),
+	mSampler(0),
+	mOutputView(0),
+	mViewedId(0)
+{
+}
+
+gl::PostProcessingChain::~PostProcessingChain()
+{
+	releaseOutputView();
+	if (mFramebuffer != 0) {
+		glDeleteFramebuffers(1, &mFramebuffer);
+		gl::StateCache::Current().framebufferDeleted(mFramebuffer);
+	}
+	if (mSampler != 0) {
+		glDeleteSamplers(1, &mSampler);
+	}
+}
+
+gl::PostEffect& gl::PostProcessingChain::add(PostEffect effect)
+{
+	mEffects.push_back(std::make_unique<PostEffect>(std::move(effect)));
+	mDirty = true;
+	return *mEffects.back();
+}
+
+gl::PostEffect* gl::PostProcessingChain::find(const std::string& name)
+{
+	auto it = std::find_if(mEffects.begin(), mEffects.end(), [&](const std::unique_ptr<PostEffect>& effect) {
+		return effect->name == name;
+	});
+	return it != mEffects.end() ? it->get() : nullptr;
+}
+
+void gl::PostProcessingChain::setEnabled(const std::string& name, bool enabled)
+{
+	if (PostEffect* effect = find(name)) {
+		effect->enabled = enabled;
+	}
+}
+
+void gl::PostProcessingChain::setDefine(const std::string& name, int value)
+{
+	const std::string text = std::to_string(value);
+	auto it = mDefines.find(name);
+	if (it == mDefines.end() || it->second != text) {
+		mDefines[name] = text;
+		mDirty = true;
+	}
+}
+
+void gl::PostProcessingChain::setDefineFlag(const std::string& name, bool set)
+{
+	const bool isSet = mDefines.count(name) != 0;
+	if (set && !isSet) {
+		mDefines[name] = "";
+		mDirty = true;
+	}
+	else if (!set && isSet) {
+		mDefines.erase(name);
+		mDirty = true;
+	}
+}
+
+void gl::PostProcessingChain::setSRGBOutput(bool enabled)
+{
+	mSRGBOutput = enabled;
+}
+
+bool gl::PostProcessingChain::sRGBOutput() const
+{
+	return mSRGBOutput;
+}
+
+void gl::PostProcessingChain::execute(gl::Texture& input, glm::vec2 texCoordScale, std::shared_ptr<gl::Texture> output, int width, int height)
+{
+	const GLuint view = mSRGBOutput ? outputView(output) : 0;
+	const bool encodeSRGB = mSRGBOutput && view == 0;
+
+	std::vector<PostEffect*> enabled;
+	for (const std::unique_ptr<PostEffect>& effect : mEffects) {
+		if (effect->enabled) {
+			enabled.push_back(effect.get());
+		}
+	}
+	if (mDirty || enabled != mBuiltEffects || encodeSRGB != mBuiltSRGB) {
+		build(encodeSRGB);
+	}
+
+	if (mFramebuffer == 0) {
+		glGenFramebuffers(1, &mFramebuffer);
+		// Effects that sample between pixels (like FXAA) need linear filtering, render targets are created nearest
+		glGenSamplers(1, &mSampler);
+		glSamplerParameteri(mSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glSamplerParameteri(mSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	gl::StateCache& state = gl::StateCache::Current();
+	const GLuint previousFramebuffer = state.framebuffer(GL_DRAW_FRAMEBUFFER);
+	state.bindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glBindSampler(0, mSampler);
+
+	gl::Texture* source = &input;
+	glm::vec2 scale = texCoordScale;
+	// Keeps the target of the previous pass alive while it is read
+	std::shared_ptr<gl::Texture> intermediate;
+	for (size_t i = 0; i < mPasses.size(); ++i) {
+		Pass& pass = mPasses[i];
+		const bool last = i + 1 == mPasses.size();
+
+		std::shared_ptr<gl::Texture> target = last ? output
+			: gl::RenderTargetPool::Default().acquire(width, height, gl::PixelFormat::RGBA, gl::PixelType::Half);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, last && view != 0 ? view : target->id, 0);
+		state.setEnabled(GL_FRAMEBUFFER_SRGB, last && view != 0);
+
+		auto _ = pass.shader->use();
+		pass.shader->bindTexture("sourceTexture", 0, *source);
+		pass.shader->setUniform("texCoordScale", scale);
+		pass.shader->setUniform("sourceTexelSize", glm::vec2(1.0f / source->cols, 1.0f / source->rows));
+		for (PostEffect* effect : pass.effects) {
+			if (effect->uniforms) {
+				effect->uniforms(*pass.shader);
+			}
+		}
+		gl::fullscreenTriangle(0, 0, width, height, *pass.shader);
+
+		if (!last) {
+			intermediate = target;
+			source = intermediate.get();
+			scale = glm::vec2(width / static_cast<float>(target->cols), height / static_cast<float>(target->rows));
+		}
+	}
+
+	state.disable(GL_FRAMEBUFFER_SRGB);
+	glBindSampler(0, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+	state.bindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+}
+
+int gl::PostProcessingChain::passes() const
+{
+	return static_cast<int>(mPasses.size());
+}
+
+void gl::PostProcessingChain::build(bool encodeSRGB)
+{
+	mPasses.clear();
+	mBuiltEffects.clear();
+	for (const std::unique_ptr<PostEffect>& effect : mEffects) {
+		if (!effect->enabled) {
+			continue;
+		}
+		// Pixel local effects are fused into the pass before them
+		if (mPasses.empty() || (effect->samplesNeighbours && !mPasses.back().effects.empty())) {
+			mPasses.emplace_back();
+		}
+		mPasses.back().effects.push_back(effect.get());
+		mBuiltEffects.push_back(effect.get());
+	}
+	// Without effects the input is copied
+	if (mPasses.empty()) {
+		mPasses.emplace_back();
+	}
+
+	for (size_t i = 0; i < mPasses.size(); ++i) {
+		Pass& pass = mPasses[i];
+		std::string source = "#version 430\n";
+		for (const auto& [name, value] : mDefines) {
+			source += "#define " + name + " " + value + "\n";
+		}
+		source += POST_PROCESSING_FS;
+		for (PostEffect* effect : pass.effects) {
+			source += effect->source + "\n";
+		}
+		source += "void main() {\n\tvec4 color = sourceColor(texCoord);\n";
+		for (PostEffect* effect : pass.effects) {
+			source += "\tcolor = " + effect->name + "(color, texCoord);\n";
+		}
+		if (encodeSRGB && i + 1 == mPasses.size()) {
+			source += "\tcolor.rgb = linearToSRGB(color.rgb);\n";
+		}
+		source += "\tFragColor = color;\n}\n";
+
+		pass.shader = std::make_unique<gl::Shader>(std::initializer_list<std::pair<GLenum, std::string>>{
+			{ GL_VERTEX_SHADER, DISPLAY_VS },
+			{ GL_FRAGMENT_SHADER, source } });
+	}
+	mBuiltSRGB = encodeSRGB;
+	mDirty = false;
+}
+
+GLuint gl::PostProcessingChain::outputView(const std::shared_ptr<gl::Texture>& output)
+{
+	// Resizing immutable textures replaces their id
+	if (output == mViewedOutput && output->id == mViewedId) {
+		return mOutputView;
+	}
+	releaseOutputView();
+	mViewedOutput = output;
+	mViewedId = output->id;
+	// Views need immutable storage of a format of the same class as GL_SRGB8_ALPHA8
+	if (output->type != gl::TextureType::D2 || output->pixelFormat != gl::PixelFormat::RGBA
+		|| output->pixelType != gl::PixelType::UByte || !output->hasImmutableStorage()) {
+		return 0;
+	}
+	glGenTextures(1, &mOutputView);
+	glTextureView(mOutputView, GL_TEXTURE_2D, output->id, GL_SRGB8_ALPHA8, 0, 1, 0, 1);
+	return mOutputView;
+}
+
+void gl::PostProcessingChain::releaseOutputView()
+{
+	if (mOutputView != 0) {
+		glDeleteTextures(1, &mOutputView);
+		gl::StateCache::Current().textureDeleted(mOutputView);
+		mOutputView = 0;
+	}
+	mViewedOutput = nullptr;
+	mViewedId = 0;
+}
@@ -0,0 +1,183 @@
+#include "glpp/reduction.hpp"
+#include "glpp/pixel_buffer.hpp"
+#include "glpp/shadermanager.hpp"
+#include "glpp/shader_storage_buffer.hpp"
+#include "glpp/texture.hpp"
+
+#include "../shaders/reduction.glsl.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace impl {
+	// Matches the layout of Partial in the reduction shader (std430)
+	struct Partial {
+		float minValue[4];
+		float maxValue[4];
+		float sum[4];
+		uint32_t nonZero[4];
+		uint32_t count[4];
+	};
+
+	constexpr uint32_t GroupSize = 256;
+	// Items each workgroup reduces. Eight per invocation hide the memory latency without starving small inputs
+	constexpr uint32_t ItemsPerGroup = 8 * GroupSize;
+
+	uint32_t numGroups(size_t count) {
+		return static_cast<uint32_t>(std::max<size_t>(1, (count + ItemsPerGroup - 1) / ItemsPerGroup));
+	}
+
+	gl::ReductionResult toResult(const Partial& partial) {
+		gl::ReductionResult result;
+		for (int c = 0; c < 4; ++c) {
+			result.min[c] = partial.minValue[c];
+			result.max[c] = partial.maxValue[c];
+			result.sum[c] = partial.sum[c];
+			result.nonZero[c] = partial.nonZero[c];
+			result.count[c] = partial.count[c];
+			result.mean[c] = partial.count[c] > 0 ? partial.sum[c] / partial.count[c] : 0.0f;
+		}
+		return result;
+	}
+}
+
+gl::Reduction::Reduction() :
+	mPartials{ 0, 0 },
+	mCapacity{ 0, 0 }
+{
+}
+
+gl::Reduction::~Reduction()
+{
+	glDeleteBuffers(2, mPartials);
+}
+
+std::future<gl::ReductionResult> gl::Reduction::reduce(gl::Texture& texture, int level, Callback onFinished)
+{
+	if (texture.type != TextureType::D2) {
+		throw std::invalid_argument("Only 2D textures can be reduced");
+	}
+	if (texture.pixelType != PixelType::Float && texture.pixelType != PixelType::Half && texture.pixelType != PixelType::UByte) {
+		throw std::invalid_argument("Only float, half float and 8 bit textures can be reduced");
+	}
+	const size_t count = static_cast<size_t>(std::max(1, texture.cols >> level)) * std::max(1, texture.rows >> level);
+	const uint32_t groups = ::impl::numGroups(count);
+	reserve(0, groups * sizeof(::impl::Partial));
+
+	gl::ComputeShader& program = shader("SOURCE_TEXTURE", texture.channels());
+	program.use();
+	texture.bind(0);
+	program.setUniform("source", 0);
+	program.setUniform("level", level);
+	program.setUniform("count", static_cast<unsigned int>(count));
+	program.setUniform("itemsPerGroup", ::impl::ItemsPerGroup);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mPartials[0]);
+	glDispatchCompute(groups, 1, 1);
+	texture.unbind();
+
+	return finish(groups, onFinished);
+}
+
+std::future<gl::ReductionResult> gl::Reduction::reduce(GLuint buffer, size_t count, int channels, size_t offset, size_t stride, Callback onFinished)
+{
+	if (channels < 1 || channels > 4) {
+		throw std::invalid_argument("Buffers can only be reduced with 1 to 4 channels");
+	}
+	const uint32_t groups = ::impl::numGroups(count);
+	reserve(0, groups * sizeof(::impl::Partial));
+
+	gl::ComputeShader& program = shader("SOURCE_BUFFER", channels);
+	program.use();
+	program.setUniform("firstValue", static_cast<unsigned int>(offset));
+	program.setUniform("stride", static_cast<unsigned int>(stride == 0 ? channels : stride));
+	program.setUniform("count", static_cast<unsigned int>(count));
+	program.setUniform("itemsPerGroup", ::impl::ItemsPerGroup);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mPartials[0]);
+	glDispatchCompute(groups, 1, 1);
+
+	return finish(groups, onFinished);
+}
+
+std::future<gl::ReductionResult> gl::Reduction::reduce(gl::ShaderStorageBuffer& buffer, size_t count, int channels, size_t offset, size_t stride, Callback onFinished)
+{
+	return reduce(buffer.id(), count, channels, offset, stride, onFinished);
+}
+
+gl::Reduction& gl::Reduction::Default()
+{
+	// Leaked on purpose: The destructor deletes the partial sum buffers and the shaders their programs, which needs a
+	// current context that no longer exists at exit
+	static Reduction* reduction = new Reduction();
+	return *reduction;
+}
+
+gl::ComputeShader& gl::Reduction::shader(const std::string& source, int channels)
+{
+	const std::string defines = "#define " + source + "\n#define CHANNELS " + std::to_string(channels) + "\n";
+	auto it = mShaders.find(defines);
+	if (it == mShaders.end()) {
+		it = mShaders.emplace(defines, std::make_unique<gl::ComputeShader>("#version 430\n" + defines + REDUCTION_CS)).first;
+	}
+	return *it->second;
+}
+
+std::future<gl::ReductionResult> gl::Reduction::finish(size_t partials, Callback onFinished)
+{
+	// Reduce the partial results until a single one is left, ping-ponging between both buffers
+	int src = 0;
+	while (partials > 1) {
+		const uint32_t groups = ::impl::numGroups(partials);
+		reserve(1 - src, groups * sizeof(::impl::Partial));
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		gl::ComputeShader& program = shader("SOURCE_PARTIALS", 4);
+		program.use();
+		program.setUniform("count", static_cast<unsigned int>(partials));
+		program.setUniform("itemsPerGroup", ::impl::ItemsPerGroup);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mPartials[src]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mPartials[1 - src]);
+		glDispatchCompute(groups, 1, 1);
+
+		partials = groups;
+		src = 1 - src;
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	// Copy the result into a pixel pack buffer and let the download queue pick it up once the GPU is done
+	DownloadQueue& queue = DownloadQueue::Default();
+	const int slot = queue.acquire(sizeof(::impl::Partial));
+	glBindBuffer(GL_COPY_READ_BUFFER, mPartials[src]);
+	queue.ring().bind(slot);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_PIXEL_PACK_BUFFER, 0, 0, sizeof(::impl::Partial));
+	queue.ring().unbind();
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	std::shared_ptr<::impl::Partial> partial = std::make_shared<::impl::Partial>();
+	std::shared_ptr<std::promise<ReductionResult>> promise = std::make_shared<std::promise<ReductionResult>>();
+	std::future<ReductionResult> future = promise->get_future();
+	queue.push(slot, sizeof(::impl::Partial), partial.get(), [partial, promise, onFinished]() {
+		const ReductionResult result = ::impl::toResult(*partial);
+		promise->set_value(result);
+		if (onFinished) {
+			onFinished(result);
+		}
+	});
+	return future;
+}
+
+void gl::Reduction::reserve(int buffer, size_t sizeInBytes)
+{
+	if (mPartials[buffer] == 0) {
+		glGenBuffers(1, &mPartials[buffer]);
+	}
+	if (mCapacity[buffer] < sizeInBytes) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, mPartials[buffer]);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeInBytes, nullptr, GL_DYNAMIC_COPY);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		mCapacity[buffer] = sizeInBytes;
+	}
+}
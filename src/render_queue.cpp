@@ -0,0 +1,220 @@
+#include "glpp/render_queue.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../shaders/render_queue.glsl.h"
+
+namespace impl {
+	constexpr int PassShift = 60;
+
+	// The bits of a non negative float grow monotonically with its value, so its upper bits are a key with
+	// logarithmic precision that needs no near and far plane
+	uint64_t depthBits(float depth) {
+		const float d = std::max(depth, 0.0f);
+		uint32_t bits;
+		std::memcpy(&bits, &d, sizeof(bits));
+		return bits >> 7;
+	}
+}
+
+gl::RenderQueue::RenderQueue() :
+	mSorted(true),
+	mPrepassed(false),
+	mDepthMVPLocation(-1)
+{
+}
+
+void gl::RenderQueue::clear()
+{
+	mPackets.clear();
+	mEntries.clear();
+	mSorted = true;
+	mPrepassed = false;
+	mStatistics = Statistics();
+}
+
+void gl::RenderQueue::submit(DrawPacket packet)
+{
+	if (packet.shader == nullptr || packet.count == 0) {
+		return;
+	}
+	mEntries.push_back({ makeKey(packet), static_cast<uint32_t>(mPackets.size()) });
+	mPackets.push_back(std::move(packet));
+	mSorted = false;
+}
+
+void gl::RenderQueue::sort()
+{
+	if (mSorted) {
+		return;
+	}
+	mSorted = true;
+	const size_t n = mEntries.size();
+	if (n < 2) {
+		return;
+	}
+
+	// Least significant digit first with 8 bit digits. All histograms are built in a single sweep and digits
+	// that are the same for all keys (e.g. the pass) are skipped
+	size_t offsets[8][256] = {};
+	for (const SortEntry& entry : mEntries) {
+		for (int digit = 0; digit < 8; ++digit) {
+			++offsets[digit][(entry.key >> (8 * digit)) & 0xFF];
+		}
+	}
+	mScratch.resize(n);
+	for (int digit = 0; digit < 8; ++digit) {
+		const int shift = 8 * digit;
+		if (offsets[digit][(mEntries[0].key >> shift) & 0xFF] == n) {
+			continue;
+		}
+		size_t offset = 0;
+		for (size_t& bucket : offsets[digit]) {
+			const size_t count = bucket;
+			bucket = offset;
+			offset += count;
+		}
+		for (const SortEntry& entry : mEntries) {
+			mScratch[offsets[digit][(entry.key >> shift) & 0xFF]++] = entry;
+		}
+		mEntries.swap(mScratch);
+	}
+}
+
+void gl::RenderQueue::executeDepthPrepass()
+{
+	sort();
+	if (mDepthShader == nullptr) {
+		mDepthShader = std::make_unique<gl::Shader>(std::initializer_list<std::pair<GLenum, std::string>>{
+			{ GL_VERTEX_SHADER, DEPTH_PREPASS_VS },
+			{ GL_FRAGMENT_SHADER, DEPTH_PREPASS_FS } });
+		mDepthMVPLocation = glGetUniformLocation(mDepthShader->program(), "MVP");
+	}
+
+	gl::StateCache& state = gl::StateCache::Current();
+	const glm::bvec4 colorMask = state.colorMask();
+	state.colorMask(false, false, false, false);
+
+	auto _ = mDepthShader->use();
+	++mStatistics.programs;
+	GLuint vao = 0;
+	// Opaque packets of a shader are already ordered front to back
+	const auto [first, last] = range(RenderPass::Opaque);
+	for (size_t i = first; i < last; ++i) {
+		const DrawPacket& packet = mPackets[mEntries[i].index];
+		if (!packet.depthPrepass || packet.primitiveType == GL_PATCHES) {
+			continue;
+		}
+		if (packet.vao != vao) {
+			vao = packet.vao;
+			state.bindVertexArray(vao);
+			++mStatistics.vertexArrays;
+		}
+		glUniformMatrix4fv(mDepthMVPLocation, 1, GL_FALSE, &packet.MVP[0][0]);
+		glDrawElements(packet.primitiveType, packet.count, packet.indexType, reinterpret_cast<void*>(packet.indexOffset));
+		++mStatistics.draws;
+	}
+
+	state.bindVertexArray(0);
+	state.colorMask(colorMask.x, colorMask.y, colorMask.z, colorMask.w);
+	mPrepassed = true;
+}
+
+void gl::RenderQueue::execute(RenderPass pass)
+{
+	sort();
+	const auto [first, last] = range(pass);
+	if (first == last) {
+		return;
+	}
+
+	gl::StateCache& state = gl::StateCache::Current();
+	const bool prepassed = mPrepassed && pass == RenderPass::Opaque;
+	const GLenum depthFunc = state.depthFunc();
+	if (prepassed) {
+		state.depthFunc(GL_LEQUAL);
+	}
+	const bool depthWrites = state.depthMask();
+
+	// The requirements of a shader stay enabled until the next shader is used
+	gl::Shader* shader = nullptr;
+	std::unique_ptr<ShaderRequirements> requirements;
+	GLuint vao = 0;
+	int patchSize = 0;
+	gl::Texture* textures[DrawPacket::MaxTextures] = {};
+
+	for (size_t i = first; i < last; ++i) {
+		DrawPacket& packet = mPackets[mEntries[i].index];
+		if (packet.shader != shader) {
+			shader = packet.shader;
+			requirements.reset();
+			requirements.reset(new ShaderRequirements(shader->use()));
+			++mStatistics.programs;
+		}
+		if (prepassed) {
+			state.depthMask(depthWrites && !packet.depthPrepass);
+		}
+		for (int unit = 0; unit < DrawPacket::MaxTextures; ++unit) {
+			if (packet.textures[unit] != nullptr && packet.textures[unit] != textures[unit]) {
+				textures[unit] = packet.textures[unit];
+				textures[unit]->bind(unit);
+				++mStatistics.textures;
+			}
+		}
+		if (packet.uniforms) {
+			packet.uniforms(*shader);
+		}
+		if (packet.vao != vao) {
+			vao = packet.vao;
+			state.bindVertexArray(vao);
+			++mStatistics.vertexArrays;
+		}
+		if (packet.primitiveType == GL_PATCHES && packet.patchSize != patchSize) {
+			patchSize = packet.patchSize;
+			glPatchParameteri(GL_PATCH_VERTICES, patchSize);
+		}
+		glDrawElements(packet.primitiveType, packet.count, packet.indexType, reinterpret_cast<void*>(packet.indexOffset));
+		++mStatistics.draws;
+	}
+
+	state.bindVertexArray(0);
+	requirements.reset();
+	if (prepassed) {
+		state.depthMask(depthWrites);
+		state.depthFunc(depthFunc);
+	}
+}
+
+size_t gl::RenderQueue::size() const
+{
+	return mPackets.size();
+}
+
+const gl::RenderQueue::Statistics& gl::RenderQueue::statistics() const
+{
+	return mStatistics;
+}
+
+uint64_t gl::RenderQueue::makeKey(const DrawPacket& packet)
+{
+	// Opaque:      pass (4) | shader (16) | material (20) | depth (24)
+	// Transparent: pass (4) | inverted depth (24) | shader (16) | material (20)
+	const uint64_t pass = static_cast<uint64_t>(packet.pass) & 0xF;
+	const uint64_t shader = packet.shader != nullptr ? packet.shader->program() & 0xFFFF : 0;
+	const uint64_t material = packet.material & 0xFFFFF;
+	const uint64_t depth = ::impl::depthBits(packet.depth) & 0xFFFFFF;
+	if (packet.pass == RenderPass::Transparent) {
+		return (pass << ::impl::PassShift) | ((0xFFFFFF - depth) << 36) | (shader << 20) | material;
+	}
+	return (pass << ::impl::PassShift) | (shader << 44) | (material << 24) | depth;
+}
+
+std::pair<size_t, size_t> gl::RenderQueue::range(RenderPass pass) const
+{
+	const uint64_t p = static_cast<uint64_t>(pass);
+	auto passOf = [](const SortEntry& entry) { return entry.key >> ::impl::PassShift; };
+	auto first = std::partition_point(mEntries.begin(), mEntries.end(), [&](const SortEntry& e) { return passOf(e) < p; });
+	auto last = std::partition_point(first, mEntries.end(), [&](const SortEntry& e) { return passOf(e) <= p; });
+	return { static_cast<size_t>(first - mEntries.begin()), static_cast<size_t>(last - mEntries.begin()) };
+}
@@ -0,0 +1,85 @@
+#include "glpp/render_target_pool.hpp"
+
+#include <algorithm>
+
+gl::RenderTargetPool::RenderTargetPool(int shrinkDelay) :
+	shrinkDelay(shrinkDelay),
+	mFrame(0)
+{
+}
+
+std::shared_ptr<gl::Texture> gl::RenderTargetPool::acquire(int width, int height, PixelFormat pixelFormat, PixelType dataType)
+{
+	const int cols = bucketSize(width);
+	const int rows = bucketSize(height);
+	for (Target& target : mTargets) {
+		const std::shared_ptr<gl::Texture>& texture = target.texture;
+		if (texture.use_count() == 1 && texture->cols == cols && texture->rows == rows
+			&& texture->pixelFormat == pixelFormat && texture->pixelType == dataType) {
+			target.lastUsed = mFrame;
+			return texture;
+		}
+	}
+	std::shared_ptr<gl::Texture> texture = std::make_shared<gl::Texture>(cols, rows, pixelFormat, dataType,
+		TextureFlags_FrameBuffer_Texture | TextureFlags_Immutable_Storage);
+	mTargets.push_back({ texture, mFrame });
+	return texture;
+}
+
+void gl::RenderTargetPool::update()
+{
+	++mFrame;
+	for (Target& target : mTargets) {
+		if (target.texture.use_count() > 1) {
+			target.lastUsed = mFrame;
+		}
+	}
+	mTargets.erase(std::remove_if(mTargets.begin(), mTargets.end(),
+		[this](const Target& target) { return mFrame - target.lastUsed > shrinkDelay; }), mTargets.end());
+}
+
+void gl::RenderTargetPool::trim()
+{
+	mTargets.erase(std::remove_if(mTargets.begin(), mTargets.end(),
+		[](const Target& target) { return target.texture.use_count() == 1; }), mTargets.end());
+}
+
+size_t gl::RenderTargetPool::size() const
+{
+	return mTargets.size();
+}
+
+size_t gl::RenderTargetPool::inUse() const
+{
+	return std::count_if(mTargets.begin(), mTargets.end(),
+		[](const Target& target) { return target.texture.use_count() > 1; });
+}
+
+size_t gl::RenderTargetPool::memory() const
+{
+	size_t bytes = 0;
+	for (const Target& target : mTargets) {
+		const gl::Texture& texture = *target.texture;
+		bytes += getPixelSize(texture.pixelFormat, texture.pixelType) * texture.cols * texture.rows;
+	}
+	return bytes;
+}
+
+int gl::RenderTargetPool::bucketSize(int size)
+{
+	int powerOfTwo = 1;
+	while (powerOfTwo < size) {
+		powerOfTwo <<= 1;
+	}
+	// Less than a quarter of each side is wasted, apart from the minimum step of 64 pixels
+	const int step = std::max(64, powerOfTwo / 8);
+	return std::max(step, (size + step - 1) / step * step);
+}
+
+gl::RenderTargetPool& gl::RenderTargetPool::Default()
+{
+	// Leaked on purpose: Framebuffers keep a pointer to it and may be destroyed after it during static destruction,
+	// and deleting the targets at exit would need a context
+	static RenderTargetPool* pool = new RenderTargetPool();
+	return *pool;
+}
@@ -11,10 +11,26 @@
 #include <glpp/imgui3d/imgui_3d.h>
 #include <glpp/intermediate.h>
 #include <glpp/meshes.hpp>
+#include <glpp/pixel_buffer.hpp>
+#include <glpp/render_target_pool.hpp>
 #include <glpp/shadermanager.hpp>
+#include <glpp/state_cache.hpp>
+#include <glpp/texture_loader.hpp>
 
 #include <GLFW/glfw3.h>
 
+namespace impl {
+	// ImGui needs a few frames after an input event until hover, active and focus states stop changing
+	constexpr int SettleFrames = 3;
+
+	// The user pointer of the window is the event counter of its editor
+	void countEvent(GLFWwindow* window) {
+		if (uint64_t* events = static_cast<uint64_t*>(glfwGetWindowUserPointer(window))) {
+			++*events;
+		}
+	}
+}
+
 gl::Editor::Editor() :
 	mContext(nullptr),
 	showOutliner(true),
@@ -22,8 +38,20 @@ gl::Editor::Editor() :
 	gammaCorrection(true),
 	toneMapping(ToneMapping::Reinhard),
 	gamma(1.2f),
+	autoExposure(false),
+	exposureKey(0.18f),
 	clearColor(0.24f, 0.24f, 0.24f, 1.0f),
+	eventDriven(true),
+	maxFrameRate(0.0f),
+	backgroundFrameRate(10.0f),
+	idleTimeout(0.5f),
 	mForceUiResetOnNextDraw(false),
+	mAnimationRequested(false),
+	mInvalidationPosted(false),
+	mSettleFrames(::impl::SettleFrames),
+	mLastFrameTime(0.0),
+	mInputEvents(0),
+	mHandledInputEvents(0),
 	mEventSystem(),
 	eventSystem(mEventSystem)
 {
@@ -44,12 +72,30 @@ gl::Editor::Editor(const std::string& title, EditorFlags flags) :
 	initialize(flags);
 }
 
+gl::Editor::~Editor()
+{
+	// Workers must not wake up a loop that is gone
+	if (mContext != nullptr) {
+		gl::TextureLoader::Default().setOnJobReady(mPreviousOnJobReady);
+		glfwSetWindowUserPointer(*mContext, nullptr);
+	}
+}
+
 bool gl::Editor::startFrame()
 {
 	mContext->makeCurrent();
+	// Applications may have changed the GL state since the last frame
+	gl::StateCache::Current().invalidate();
 	glfwPollEvents();
 
 	if (mContext->isMinified()) { return false; }
+
+	// Upload textures that finished decoding in the background
+	gl::TextureLoader::Default().update();
+	// Hand out downloads the GPU finished
+	gl::DownloadQueue::Default().poll();
+	// Release render targets no viewport used for a while
+	gl::RenderTargetPool::Default().update();
 	
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
@@ -105,11 +151,76 @@ void gl::Editor::endFrame()
 void gl::Editor::run()
 {
 	while (!mContext->shouldClose()) {
+		waitForFrame();
 		startFrame();
 		endFrame();
 	}
 }
 
+void gl::Editor::waitForFrame()
+{
+	const bool minimized = mContext->isMinified();
+	const bool background = minimized || !mContext->isFocused();
+
+	// Frame cap. Waiting for events instead of sleeping keeps the window responsive to the OS
+	const float frameRate = background ? backgroundFrameRate : maxFrameRate;
+	if (frameRate > 0.0f) {
+		const double deadline = mLastFrameTime + 1.0 / frameRate;
+		for (double now = glfwGetTime(); now < deadline; now = glfwGetTime()) {
+			glfwWaitEventsTimeout(deadline - now);
+		}
+	}
+
+	handleEvents();
+	bool due = !eventDriven || mAnimationRequested || mSettleFrames > 0
+		|| gl::TextureLoader::Default().ready() > 0 || gl::DownloadQueue::Default().pending(false) > 0;
+	// Viewports that redrew in the last frame are likely to change again (e.g. camera inertia, exposure adaption)
+	for (auto viewport : getEditorWindows<gl::ViewportEditorWindow>()) {
+		due = due || viewport->needsFrame();
+	}
+	// Minimized windows draw nothing, so there is nothing to settle either
+	if (minimized) {
+		due = !eventDriven;
+	}
+
+	mAnimationRequested = false;
+	if (!due) {
+		if (idleTimeout > 0.0f) {
+			glfwWaitEventsTimeout(idleTimeout);
+		}
+		else {
+			glfwWaitEvents();
+		}
+		handleEvents();
+	}
+	mSettleFrames = std::max(mSettleFrames - 1, 0);
+	mLastFrameTime = glfwGetTime();
+}
+
+void gl::Editor::handleEvents()
+{
+	if (mInvalidationPosted.exchange(false)) {
+		invalidateViewports("Posted invalidation");
+	}
+	// Timeouts and empty events do not change the UI, so they do not need further frames
+	if (mInputEvents != mHandledInputEvents) {
+		mHandledInputEvents = mInputEvents;
+		mSettleFrames = ::impl::SettleFrames;
+	}
+}
+
+void gl::Editor::requestAnimationFrame()
+{
+	mAnimationRequested = true;
+	invalidateViewports("Animation");
+}
+
+void gl::Editor::postInvalidation()
+{
+	mInvalidationPosted = true;
+	glfwPostEmptyEvent();
+}
+
 bool gl::Editor::shouldClose() const
 {
 	return mContext->shouldClose();
@@ -146,6 +257,13 @@ void gl::Editor::removeObjectIf(std::function<bool(std::shared_ptr<gl::Mesh>)> c
 		mObjects.end());
 }
 
+void gl::Editor::invalidateViewports(const char* reason)
+{
+	for (auto viewport : getEditorWindows<gl::ViewportEditorWindow>()) {
+		viewport->invalidate(reason);
+	}
+}
+
 const std::vector<std::shared_ptr<gl::Mesh>>& gl::Editor::getObjects() const
 {
 	return mObjects;
@@ -238,6 +356,18 @@ void gl::Editor::initialize(EditorFlags flags)
 	ImGui::CreateContext();
 	ImPlot::CreateContext();
 	ImGui::StyleColorsDark();		// FIXME: Nicer style
+	// Count the events the loop of run() wakes up for. Installed before ImGui, which chains to them
+	GLFWwindow* window = *mContext;
+	glfwSetWindowUserPointer(window, &mInputEvents);
+	glfwSetCursorPosCallback(window, [](GLFWwindow* w, double, double) { ::impl::countEvent(w); });
+	glfwSetCursorEnterCallback(window, [](GLFWwindow* w, int) { ::impl::countEvent(w); });
+	glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int, int, int) { ::impl::countEvent(w); });
+	glfwSetScrollCallback(window, [](GLFWwindow* w, double, double) { ::impl::countEvent(w); });
+	glfwSetKeyCallback(window, [](GLFWwindow* w, int, int, int, int) { ::impl::countEvent(w); });
+	glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int) { ::impl::countEvent(w); });
+	glfwSetWindowFocusCallback(window, [](GLFWwindow* w, int) { ::impl::countEvent(w); });
+	glfwSetWindowSizeCallback(window, [](GLFWwindow* w, int, int) { ::impl::countEvent(w); });
+	glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) { ::impl::countEvent(w); });
 	ImGui_ImplGlfw_InitForOpenGL(*mContext, true);
 	ImGui_ImplOpenGL3_Init(NULL);
 
@@ -252,6 +382,16 @@ void gl::Editor::initialize(EditorFlags flags)
 	std::string fontFile = std::string(GL_FRAMEWORK_FONT_DIR) + FONT_ICON_FILE_NAME_FAS;
 	io.Fonts->AddFontFromFileTTF(fontFile.c_str(), 13.0f, &icons_config, icons_ranges);
 
+	// Wake up an idle render loop once decoded textures can be uploaded
+	gl::TextureLoader& loader = gl::TextureLoader::Default();
+	mPreviousOnJobReady = loader.setOnJobReady(nullptr);
+	loader.setOnJobReady([previous = mPreviousOnJobReady]() {
+		if (previous) {
+			previous();
+		}
+		glfwPostEmptyEvent();
+	});
+
 	// Add the default windows "Debug" and "Outliner"
 	if ((flags & EditorFlags_NoDefaultOutliner) == 0x0) {
 		mEditorWindows.push_back(std::make_shared<OutlinerEditorWindow>());
@@ -7,12 +7,25 @@
 #include <glpp/camera.hpp>
 #include <glpp/controls.hpp>
 #include <glpp/framebuffer.hpp>
+#include <glpp/auto_exposure.hpp>
 #include <glpp/intermediate.h>
 #include <glpp/logging.hpp>
 #include <glpp/meshes.hpp>
+#include <glpp/render_target_pool.hpp>
 #include <glpp/shadermanager.hpp>
-
-#include "../shaders/display_shader.glsl.h"
+#include <glpp/state_cache.hpp>
+#include <glpp/texture_loader.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace impl {
+	// Frames the auto exposure keeps adapting after the image changed
+	constexpr int ExposureSettleFrames = 120;
+	// Seconds without camera movement before dynamic resolution returns to full resolution
+	constexpr double CameraStillDelay = 0.2;
+}
 
 gl::EditorWindow::EditorWindow(const std::string& title, EditorWindowRegion defaultRegion) :
 	title(title),
@@ -107,6 +120,13 @@ void gl::DebugEditorWindow::onDraw(Editor* editor)
 	
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 
+	if (ImGui::TreeNode("Render loop")) {
+		ImGui::Checkbox("Event Driven", &editor->eventDriven);
+		ImGui::DragFloat("Frame Cap", &editor->maxFrameRate, 1.0f, 0.0f, 500.0f, editor->maxFrameRate > 0.0f ? "%.0f FPS" : "Off");
+		ImGui::DragFloat("Background Frame Cap", &editor->backgroundFrameRate, 1.0f, 0.0f, 500.0f, editor->backgroundFrameRate > 0.0f ? "%.0f FPS" : "Off");
+		ImGui::TreePop();
+	}
+
 	if (ImGui::TreeNodeEx("Post processing", ImGuiTreeNodeFlags_DefaultOpen)) {
 		if (ImGui::BeginCombo("HDR Mapping", hdrmappings[(int)editor->toneMapping])) {
 			for (int i = 0; i < IM_ARRAYSIZE(hdrmappings); ++i) {
@@ -124,6 +144,10 @@ void gl::DebugEditorWindow::onDraw(Editor* editor)
 		if (editor->gammaCorrection) {
 			ImGui::DragFloat("Gamma", &editor->gamma, .1f, 0.1f, 4.0f);
 		}
+		ImGui::Checkbox("Auto Exposure", &editor->autoExposure);
+		if (editor->autoExposure) {
+			ImGui::DragFloat("Exposure Key", &editor->exposureKey, .01f, 0.01f, 1.0f);
+		}
 		ImGui::TreePop();
 	}
 
@@ -140,10 +164,49 @@ void gl::DebugEditorWindow::onDraw(Editor* editor)
 				ImGui::Image((GLuint*)tid, ImVec2((float)width, (float)height) * s, uv0, uv1, tint_color);
 			};
 
+			int samples = viewports[i]->mGeometrySamples;
+			if (ImGui::SliderInt("MSAA Samples", &samples, 1, 8)) {
+				viewports[i]->setGeometrySamples(samples);
+			}
+			bool depthPrepass = viewports[i]->mDepthPrepass;
+			if (ImGui::Checkbox("Depth Pre-Pass", &depthPrepass)) {
+				viewports[i]->setDepthPrepass(depthPrepass);
+			}
+			bool renderOnDemand = viewports[i]->mRenderOnDemand;
+			if (ImGui::Checkbox("Render On Demand", &renderOnDemand)) {
+				viewports[i]->setRenderOnDemand(renderOnDemand);
+			}
+			ImGui::SameLine();
+			ImGui::Checkbox("Show Redraw Reason", &viewports[i]->showRedrawReason);
+			ImGui::Text("Redraw: %s", viewports[i]->mRedrawReason != nullptr ? viewports[i]->mRedrawReason : "none, cached image");
+			if (gl::PostEffect* fxaa = viewports[i]->mPostProcessing.find("fxaa")) {
+				ImGui::Checkbox("FXAA", &fxaa->enabled);
+			}
+			gl::DynamicResolution& resolution = viewports[i]->mDynamicResolution;
+			ImGui::Checkbox("Dynamic Resolution", &resolution.enabled);
+			if (resolution.enabled) {
+				ImGui::DragFloat("Frame Budget", &resolution.targetFrameTime, 0.1f, 1.0f, 100.0f, "%.1f ms");
+				ImGui::DragFloatRange2("Render Scale", &resolution.minScale, &resolution.maxScale, 0.01f, 0.25f, 1.0f);
+				ImGui::SliderFloat("Sharpness", &resolution.sharpness, 0.0f, 1.0f);
+				ImGui::Text("Scale %.2f, GPU %.2f ms (%.2f ms at full resolution)", viewports[i]->mRenderScale,
+					resolution.gpuTime(), resolution.fullResolutionTime());
+			}
+			ImGui::Text("Post processing: %d full screen pass(es)", viewports[i]->mPostProcessing.passes());
+			const gl::FrameGraph::Report& graph = viewports[i]->mFrameGraph.report();
+			ImGui::Text("Frame graph: %d passes (%d culled), %d imported, %d transients in %d textures, %.1f MB (%.1f MB without aliasing)",
+				graph.passes, graph.culledPasses, graph.imported, graph.transients, graph.physicalTextures,
+				graph.memory / (1024.0 * 1024.0), graph.memoryWithoutAliasing / (1024.0 * 1024.0));
+			const gl::RenderQueue::Statistics& queue = viewports[i]->mRenderQueue.statistics();
+			ImGui::Text("Render queue: %d draws, %d shader / %d vertex array / %d texture changes",
+				queue.draws, queue.programs, queue.vertexArrays, queue.textures);
 			std::shared_ptr<gl::Texture> colorTexture = frambuffer->getRenderTexture(0);
-			std::shared_ptr<gl::Texture> idTexture = frambuffer->getRenderTexture(1);
-			AspectImage(colorTexture->id, colorTexture->cols, colorTexture->rows, ImVec2(500, 500), ImVec2(0, 1), ImVec2(1, 0));
-			AspectImage(idTexture->id, colorTexture->cols, colorTexture->rows, ImVec2(500, 500), ImVec2(0, 1), ImVec2(1, 0));
+			const glm::vec2 scale = frambuffer->textureScale();
+			AspectImage(colorTexture->id, frambuffer->width(), frambuffer->height(), ImVec2(500, 500), ImVec2(0, scale.y), ImVec2(scale.x, 0));
+			ImGui::Text("Render targets: %zu (%zu in use), %.1f MB", gl::RenderTargetPool::Default().size(),
+				gl::RenderTargetPool::Default().inUse(), gl::RenderTargetPool::Default().memory() / (1024.0 * 1024.0));
+			const gl::StateCache::Statistics& state = gl::StateCache::Current().statistics();
+			ImGui::Text("GL state: %zu changes, %zu skipped (%.0f%%), %zu queries answered", state.calls, state.skipped,
+				state.calls > 0 ? 100.0 * state.skipped / state.calls : 0.0, state.queries);
 
 			// Get color under the cursor
 			/*ImVec2 mouse = ImGui::GetIO().MousePos;
@@ -174,7 +237,7 @@ void gl::DebugEditorWindow::onDraw(Editor* editor)
 			}
 
 			ImGui3D::ImGui3DContext& g = *ImGui3D::GImGui3D;
-			ImGui::Text("Active id: %d (color: %d, %d, %d)", g.ActiveId, g.ActiveIdColor.r, g.ActiveIdColor.g, g.ActiveIdColor.b);*/
+			ImGui::Text("Active id: %d (hovered: %d)", g.ActiveId, g.HoveredId);*/
 
 			ImGui::TreePop();
 
@@ -184,9 +247,30 @@ void gl::DebugEditorWindow::onDraw(Editor* editor)
 
 gl::ViewportEditorWindow::ViewportEditorWindow(const std::string& title, EditorWindowRegion defaultRegion) :
 	EditorWindow(title, defaultRegion),
+	showRedrawReason(false),
 	mFrameBuffer(nullptr),
 	mGeometryFrameBuffer(nullptr),
-	mLastTonemapping(ToneMapping::Reinhard)
+	mGeometryPixelType(gl::PixelType::Half),
+	mGeometrySamples(1),
+	mDepthPrepass(false),
+	mRenderOnDemand(true),
+	mInvalidation("First frame"),
+	mRedrawReason(nullptr),
+	mFramesSinceRedraw(0),
+	mFramesSinceChange(0),
+	mLastView(1),
+	mLastProjection(1),
+	mLastSettings(),
+	mLastFinishedJobs(0),
+	mLastHoveredId(0),
+	mLastUIActive(false),
+	mLastAutoExposure(false),
+	mRenderScale(1.0f),
+	mLastCameraMove(0.0)
+{
+}
+
+gl::ViewportEditorWindow::~ViewportEditorWindow()
 {
 }
 
@@ -195,46 +279,231 @@ void gl::ViewportEditorWindow::registerRenderHook(gl::RenderHook hook, gl::Rende
 	mRenderHoodks[hook].push_back(fn);
 }
 
+void gl::ViewportEditorWindow::registerFrameGraphHook(gl::FrameGraphHookFn fn)
+{
+	mFrameGraphHooks.push_back(fn);
+}
+
+void gl::ViewportEditorWindow::setGeometryPixelType(gl::PixelType type)
+{
+	mGeometryPixelType = type;
+	invalidate("Settings");
+	if (mGeometryFrameBuffer != nullptr) {
+		mGeometryFrameBuffer->setRenderTexture(0, gl::PixelFormat::RGBA, mGeometryPixelType);
+	}
+}
+
+void gl::ViewportEditorWindow::setGeometrySamples(int samples)
+{
+	mGeometrySamples = samples;
+	invalidate("Settings");
+	if (mGeometryFrameBuffer != nullptr) {
+		mGeometryFrameBuffer->setSamples(mGeometrySamples);
+	}
+}
+
+void gl::ViewportEditorWindow::setDepthPrepass(bool enabled)
+{
+	mDepthPrepass = enabled;
+	invalidate("Settings");
+}
+
+void gl::ViewportEditorWindow::setRenderOnDemand(bool enabled)
+{
+	mRenderOnDemand = enabled;
+}
+
+void gl::ViewportEditorWindow::invalidate(const char* reason)
+{
+	if (mInvalidation == nullptr) {
+		mInvalidation = reason;
+	}
+}
+
+const char* gl::ViewportEditorWindow::redrawReason() const
+{
+	return mRedrawReason;
+}
+
+bool gl::ViewportEditorWindow::needsFrame() const
+{
+	return mRedrawReason != nullptr || mRenderScale != 1.0f;
+}
+
+gl::PostProcessingChain& gl::ViewportEditorWindow::postProcessing()
+{
+	return mPostProcessing;
+}
+
+gl::DynamicResolution& gl::ViewportEditorWindow::dynamicResolution()
+{
+	return mDynamicResolution;
+}
+
+float gl::ViewportEditorWindow::renderScale() const
+{
+	return mRenderScale;
+}
+
+float gl::ViewportEditorWindow::targetRenderScale() const
+{
+	const bool moving = ImGui::GetTime() - mLastCameraMove < ::impl::CameraStillDelay;
+	return mDynamicResolution.enabled && moving ? mDynamicResolution.scale() : 1.0f;
+}
+
+void gl::ViewportEditorWindow::resizeGeometry()
+{
+	mGeometryFrameBuffer->resize(
+		std::max(1, static_cast<int>(std::lround(mFrameBuffer->width() * mRenderScale))),
+		std::max(1, static_cast<int>(std::lround(mFrameBuffer->height() * mRenderScale))));
+}
+
+void gl::ViewportEditorWindow::updateOverlayDepth()
+{
+	// Attaching a texture resizes it to the storage of the framebuffer, which only matches if the sizes do
+	const std::shared_ptr<gl::Texture> depth = mGeometryFrameBuffer->getDepthTexture();
+	const bool shared = mGeometryFrameBuffer->width() == mFrameBuffer->width() && mGeometryFrameBuffer->height() == mFrameBuffer->height()
+		&& mGeometryFrameBuffer->textureScale() == mFrameBuffer->textureScale();
+	if (shared && mFrameBuffer->getDepthTexture() != depth) {
+		mFrameBuffer->setDepthTexture(depth);
+	}
+	else if (!shared && mFrameBuffer->getDepthTexture() == depth) {
+		mFrameBuffer->setDepthTexture(nullptr);
+	}
+}
+
 void gl::ViewportEditorWindow::initialize(Editor* editor) {
-	// Initialize framebuffers
+	// Initialize framebuffers. Their render targets are pooled, so dragging a splitter does not reallocate them
 	int w = (int)size.x;
 	int h = (int)size.y;
-	mGeometryFrameBuffer = std::make_shared<gl::Framebuffer>(w, h);
-	mGeometryFrameBuffer->setRenderTexture(0, nullptr);
+	mGeometryFrameBuffer = std::make_shared<gl::Framebuffer>(w, h, &gl::RenderTargetPool::Default());
+	mGeometryFrameBuffer->setRenderTexture(0, gl::PixelFormat::RGBA, mGeometryPixelType);
 	auto depthTexture = mGeometryFrameBuffer->setDepthTexture(nullptr);
-	mFrameBuffer = std::make_shared<gl::Framebuffer>(w, h);
+	mGeometryFrameBuffer->setSamples(mGeometrySamples);
+	mFrameBuffer = std::make_shared<gl::Framebuffer>(w, h, &gl::RenderTargetPool::Default());
 	mFrameBuffer->setRenderTexture(0, nullptr);
-	mFrameBuffer->appendRenderTexture(nullptr);
+	mFrameBuffer->appendRenderTexture(gl::PixelFormat::Red, gl::PixelType::UInt);
 	mFrameBuffer->setDepthTexture(depthTexture);
 
-	// Initialize postporcessing shader
-	//mTonemappingShader = std::make_unique<gl::Shader>(std::string(GL_FRAMEWORK_SHADER_DIR) + "displayShader.glsl");
-	mTonemappingShader = std::make_unique<gl::Shader>(std::initializer_list<std::pair<GLenum, std::string>>{
-		{ GL_VERTEX_SHADER, DISPLAY_VS },
-		{ GL_FRAGMENT_SHADER, DISPLAY_FS }}
-		);
-	mTonemappingShader->setDefine("HDR_MAPPING_TYPE", static_cast<int>(editor->toneMapping));
-	mTonemappingShader->update();
-	mLastTonemapping = editor->toneMapping;
+	// Initialize postprocessing, the effects are fused into as few passes as possible. Sharpening comes first so it
+	// reads the geometry at its own resolution
+	gl::PostEffect& sharpen = mPostProcessing.add(gl::PostEffect::Sharpen());
+	sharpen.enabled = false;
+	sharpen.uniforms = [this](gl::Shader& shader) {
+		shader.setUniform("sharpness", mRenderScale < 1.0f ? mDynamicResolution.sharpness : 0.0f);
+	};
+	mPostProcessing.add(gl::PostEffect::Tonemapping());
+	gl::PostEffect& gamma = mPostProcessing.add(gl::PostEffect::GammaCorrection());
+	gamma.uniforms = [editor](gl::Shader& shader) {
+		shader.setUniform("gamma", editor->gamma);
+	};
+	mPostProcessing.add(gl::PostEffect::FXAA()).enabled = false;
+	mLastAutoExposure = editor->autoExposure;
+	mAutoExposure = std::make_unique<gl::AutoExposure>();
 
 	// Initialize ImGui3D
 	mImGui3DContext = ImGui3D::CreateContext();
-	mImGui3DContext->GetHoveredIdImpl = [&](ImVec2 mouse) -> glm::uvec4 {
+	mImGui3DContext->GetCursorPixelImpl = [](ImVec2 mouse) -> glm::ivec2 {
 		if (ImGui::IsWindowHovered() && ImGui::IsWindowFocused()) {
 			ImVec2 windowPos = ImGui::GetWindowPos();
-			return mFrameBuffer->readColorPixel(mouse.x - windowPos.x, mouse.y - windowPos.y, 1);
+			return glm::ivec2(mouse.x - windowPos.x, mouse.y - windowPos.y);
 		}
 		else {
-			return glm::uvec4(0, 0, 0, 255);
+			return glm::ivec2(-1);
 		}
 	};
+	mImGui3DContext->GetHoveredIdImpl = [&](glm::ivec2 pixel) -> ImGuiID {
+		return mFrameBuffer->latestColorPixel(pixel.x, pixel.y, 1).r;
+	};
 }
 
 void gl::ViewportEditorWindow::onResize(ImVec2 position, ImVec2 size, Editor* editor) {
 	camera->ScreenWidth  = (int)size.x;
 	camera->ScreenHeight = (int)size.y;
+	invalidate("Resize");
 	mFrameBuffer->resize((int)size.x, (int)size.y);
-	mGeometryFrameBuffer->resize((int)size.x, (int)size.y);
+	resizeGeometry();
+	// The geometry pass may have exchanged its depth target
+	updateOverlayDepth();
+}
+
+bool gl::ViewportEditorWindow::DisplaySettings::operator==(const DisplaySettings& other) const
+{
+	return toneMapping == other.toneMapping && gammaCorrection == other.gammaCorrection && gamma == other.gamma
+		&& autoExposure == other.autoExposure && exposureKey == other.exposureKey && clearColor == other.clearColor;
+}
+
+bool gl::ViewportEditorWindow::MeshState::operator==(const MeshState& other) const
+{
+	return mesh == other.mesh && generation == other.generation && model == other.model && visible == other.visible;
+}
+
+const char* gl::ViewportEditorWindow::findRedrawReason(Editor* editor)
+{
+	const char* reason = mInvalidation;
+	mInvalidation = nullptr;
+	auto check = [&reason](bool changed, const char* why) {
+		if (changed && reason == nullptr) {
+			reason = why;
+		}
+	};
+
+	const glm::mat4 projection = camera->GetProjectionMatrix();
+	const bool cameraMoved = camera->viewMatrix != mLastView || projection != mLastProjection;
+	if (cameraMoved) {
+		mLastCameraMove = ImGui::GetTime();
+	}
+	check(cameraMoved, "Camera");
+	mLastView = camera->viewMatrix;
+	mLastProjection = projection;
+	// Includes returning to full resolution once the camera stands still
+	check(targetRenderScale() != mRenderScale, "Render scale");
+
+	const DisplaySettings settings = { editor->toneMapping, editor->gammaCorrection, editor->gamma,
+		editor->autoExposure, editor->exposureKey, editor->clearColor };
+	check(!(settings == mLastSettings), "Display settings");
+	mLastSettings = settings;
+
+	// Added or removed meshes, moved ones and the ones that were invalidated
+	mMeshes.clear();
+	for (const auto& mesh : editor->getObjects()) {
+		mMeshes.push_back({ mesh.get(), mesh->generation(), mesh->ModelMatrix, mesh->visible });
+	}
+	check(mMeshes != mLastMeshes, "Meshes");
+	mMeshes.swap(mLastMeshes);
+
+	const size_t finishedJobs = gl::TextureLoader::Default().finished();
+	check(finishedJobs != mLastFinishedJobs, "Textures loaded");
+	mLastFinishedJobs = finishedJobs;
+
+	// The id under the cursor arrives a frame or two after it was rendered and changes the highlighted widget
+	const ImGui3D::ImGui3DContext& g = *mImGui3DContext;
+	check(g.KeepCaptureFocus, "Gizmo");
+	check(g.HoveredId != mLastHoveredId, "Hover");
+	mLastHoveredId = g.HoveredId;
+
+	const ImGuiIO& io = ImGui::GetIO();
+	check(ImGui::IsWindowHovered() && (io.MouseDelta.x != 0.0f || io.MouseDelta.y != 0.0f || io.MouseWheel != 0.0f
+		|| ImGui::IsAnyMouseDown()), "Mouse");
+	check(ImGui::IsWindowFocused() && std::any_of(std::begin(io.KeysDown), std::end(io.KeysDown), [](bool down) { return down; }),
+		"Keyboard");
+	// Widgets of other windows (e.g. the outliner) change meshes and settings without notice. Their changes may land
+	// after this viewport was drawn, so the frame after the interaction is rendered as well
+	const bool uiActive = ImGui::IsAnyItemActive();
+	check(uiActive || mLastUIActive, "UI interaction");
+	mLastUIActive = uiActive;
+
+	check(!mRenderOnDemand, "Continuous rendering");
+
+	// The auto exposure needs a few more frames to adapt to a changed image
+	if (reason != nullptr) {
+		mFramesSinceChange = 0;
+	}
+	else {
+		++mFramesSinceChange;
+	}
+	check(editor->autoExposure && mFramesSinceChange < ::impl::ExposureSettleFrames, "Exposure adaptation");
+	return reason;
 }
 
 void gl::ViewportEditorWindow::onDraw(Editor* editor)
@@ -248,79 +517,182 @@ void gl::ViewportEditorWindow::onDraw(Editor* editor)
 	mOldImGui3DContext = ImGui3D::GImGui3D;
 	ImGui3D::SetContext(mImGui3DContext);
 	ImGui3D::NewFrame(camera->viewMatrix, camera->GetProjectionMatrix(), ImGui::GetCurrentWindow()->ID);
-	glViewport(0, 0, (int)size.x, (int)size.y);
-
-	mGeometryFrameBuffer->bind();
-	mGeometryFrameBuffer->clearColorAttachment(0, editor->clearColor);
-	mGeometryFrameBuffer->clearDepthBuffer();
 
 	// Update viewport camera
 	if (ImGui::IsWindowHovered()) {
 		controls->update(camera, true);
 	}
 
-	for (const auto hook : mRenderHoodks[gl::RenderHook::PreMeshDrawing]) {
-		hook(this);
-	}
+	// Without changes the image of the last frame is displayed again
+	mDynamicResolution.update();
+	mRedrawReason = findRedrawReason(editor);
+	if (mRedrawReason != nullptr) {
+		mFramesSinceRedraw = 0;
+		const float renderScale = targetRenderScale();
+		if (renderScale != mRenderScale) {
+			mRenderScale = renderScale;
+			resizeGeometry();
+			updateOverlayDepth();
+		}
 
-	glEnable(GL_DEPTH_TEST);
-	for (auto mesh : editor->getObjects()) {
-		if (mesh->visible) {
-			mesh->render(camera);
-			mesh->handleIO(camera, ImGui::GetIO());
+		// The frame is described as a graph. Passes whose results are never used are culled and the transients of the
+		// hooks share textures wherever their lifetimes allow it. HDR color and depth stay imported: They are the
+		// (resolve) targets of the possibly multisampled geometry framebuffer and the depth is shared with the overlay
+		// framebuffer, exchanging them every frame would recreate both framebuffers and the multisample storage
+		mFrameGraph.clear();
+		ViewportFrameResources frame;
+		frame.hdr = mFrameGraph.import("HDR color", mGeometryFrameBuffer->getRenderTexture(0), mGeometryFrameBuffer->textureScale());
+		frame.depth = mFrameGraph.import("Depth", mGeometryFrameBuffer->getDepthTexture(), mGeometryFrameBuffer->textureScale());
+		frame.display = mFrameGraph.import("Display", mFrameBuffer->getRenderTexture(0), mFrameBuffer->textureScale());
+
+		mFrameGraph.addPass("Geometry",
+			[&](gl::FrameGraph::Builder& builder) {
+				builder.write(frame.hdr);
+				builder.write(frame.depth);
+			},
+			[&](gl::FrameGraph::Resources&) {
+				gl::StateCache::Current().viewport(0, 0, mGeometryFrameBuffer->width(), mGeometryFrameBuffer->height());
+				mGeometryFrameBuffer->bind();
+				mGeometryFrameBuffer->clearColorAttachment(0, editor->clearColor);
+				mGeometryFrameBuffer->clearDepthBuffer();
+
+				for (const auto hook : mRenderHoodks[gl::RenderHook::PreMeshDrawing]) {
+					hook(this);
+				}
+
+				gl::StateCache::Current().enable(GL_DEPTH_TEST);
+				// Meshes that support it are drawn sorted by state and depth, the others in insertion order after the opaque packets
+				const auto& objects = editor->getObjects();
+				mRenderQueue.clear();
+				mUnqueuedMeshes.clear();
+				for (auto mesh : objects) {
+					if (mesh->visible && !mesh->submit(mRenderQueue, camera)) {
+						mUnqueuedMeshes.push_back(mesh);
+					}
+				}
+				if (mDepthPrepass) {
+					mRenderQueue.executeDepthPrepass();
+				}
+				mRenderQueue.execute(gl::RenderPass::Opaque);
+				for (auto mesh : mUnqueuedMeshes) {
+					mesh->render(camera);
+				}
+				mRenderQueue.execute(gl::RenderPass::Transparent);
+				for (auto mesh : objects) {
+					if (mesh->visible) {
+						mesh->handleIO(camera, ImGui::GetIO());
+					}
+				}
+
+				for (const auto hook : mRenderHoodks[gl::RenderHook::PostMeshDrawing]) {
+					hook(this);
+				}
+				// The depth is resolved as well, ImGui3D is depth tested against it
+				mGeometryFrameBuffer->resolve();
+			});
+
+		for (const auto& hook : mFrameGraphHooks) {
+			hook(this, mFrameGraph, frame);
 		}
-	}
 
-	for (const auto hook : mRenderHoodks[gl::RenderHook::PostMeshDrawing]) {
-		hook(this);
-	}
+		// Measure the HDR image on the GPU, the tonemapper reads the exposure straight from the buffer
+		if (editor->autoExposure) {
+			mFrameGraph.addPass("Auto exposure",
+				[&](gl::FrameGraph::Builder& builder) {
+					builder.read(frame.hdr);
+					builder.sideEffect();
+				},
+				[&](gl::FrameGraph::Resources&) {
+					if (!mLastAutoExposure) {
+						mAutoExposure->reset();
+					}
+					mAutoExposure->keyValue = editor->exposureKey;
+					mAutoExposure->update(*mGeometryFrameBuffer->getRenderTexture(0), ImGui::GetIO().DeltaTime,
+						mGeometryFrameBuffer->width(), mGeometryFrameBuffer->height());
+				});
+		}
 
-	mFrameBuffer->bind();
-	if (mLastTonemapping != editor->toneMapping) {
-		mTonemappingShader->setDefine("HDR_MAPPING_TYPE", static_cast<int>(editor->toneMapping));
-		mTonemappingShader->update();
-	}
-	if (editor->toneMapping != ToneMapping::Linear || editor->gammaCorrection) {
-		fullscreenTriangle(0, 0, camera->ScreenWidth, camera->ScreenHeight,
-			*mTonemappingShader,
-			"gamma", editor->gammaCorrection ? editor->gamma : 1.0f,
-			"hdr", editor->hdr,
-			"renderTexture", mGeometryFrameBuffer->getRenderTexture(0));
-	}
-	else {
-		displayTexture(0, 0, camera->ScreenWidth, camera->ScreenHeight, mGeometryFrameBuffer->getRenderTexture(0));
-	}
-	for (const auto hook : mRenderHoodks[gl::RenderHook::PostToneMapping]) {
-		hook(this);
-	}
+		mFrameGraph.addPass("Post processing",
+			[&](gl::FrameGraph::Builder& builder) {
+				builder.read(frame.hdr);
+				builder.write(frame.display);
+			},
+			[&](gl::FrameGraph::Resources&) {
+				// A gamma of 2.2 is left to the sRGB conversion of the hardware. The curve of Hejl and Burgess-Dawson includes it
+				const bool gammaInCurve = editor->toneMapping == ToneMapping::JimHejlRicharBurgessDawson;
+				const bool srgb = editor->gammaCorrection && !gammaInCurve && std::abs(editor->gamma - 2.2f) < 0.05f;
+				mPostProcessing.setDefine("HDR_MAPPING_TYPE", static_cast<int>(editor->toneMapping));
+				mPostProcessing.setDefineFlag("AUTO_EXPOSURE", editor->autoExposure);
+				mPostProcessing.setEnabled("tonemapping", editor->toneMapping != ToneMapping::Linear || editor->autoExposure);
+				mPostProcessing.setEnabled("gammaCorrection", editor->gammaCorrection && !gammaInCurve && !srgb);
+				mPostProcessing.setSRGBOutput(srgb);
+				mPostProcessing.setEnabled("sharpen", mDynamicResolution.enabled);
+				if (editor->autoExposure) {
+					mAutoExposure->bind(3);
+				}
+				mPostProcessing.execute(*mGeometryFrameBuffer->getRenderTexture(0), mGeometryFrameBuffer->textureScale(),
+					mFrameBuffer->getRenderTexture(0), mFrameBuffer->width(), mFrameBuffer->height());
+			});
+
+		mFrameGraph.addPass("Overlays",
+			[&](gl::FrameGraph::Builder& builder) {
+				builder.read(frame.depth);
+				builder.write(frame.display);
+			},
+			[&](gl::FrameGraph::Resources&) {
+				if (mFrameBuffer->getDepthTexture() != mGeometryFrameBuffer->getDepthTexture()) {
+					mGeometryFrameBuffer->blitDepth(*mFrameBuffer);
+				}
+				mFrameBuffer->bind();
+				for (const auto hook : mRenderHoodks[gl::RenderHook::PostToneMapping]) {
+					hook(this);
+				}
 
-	// Clear id map and render ImGui3D stuff
-	mFrameBuffer->clearColorAttachment(1, glm::vec4(0, 0, 0, 1));
-	for (auto mesh : editor->getObjects()) {
-		if (mesh->visible) {
-			mesh->drawViewportUI(camera);
-			if (std::dynamic_pointer_cast<gl::TriangleMesh>(mesh) != nullptr) {
-				ImGui3D::TransformGizmo(mesh->ModelMatrix);
-			}
+				// Render ImGui3D stuff, which also clears the ids around the cursor
+				for (auto mesh : editor->getObjects()) {
+					if (mesh->visible) {
+						mesh->drawViewportUI(camera);
+						if (std::dynamic_pointer_cast<gl::TriangleMesh>(mesh) != nullptr) {
+							ImGui3D::TransformGizmo(mesh->ModelMatrix);
+						}
+					}
+				}
+				mFrameBuffer->clearDepthBuffer();
+				for (const auto hook : mRenderHoodks[gl::RenderHook::PreImGui3D]) {
+					hook(this);
+				}
+				ImGui3D::Render();
+				for (const auto hook : mRenderHoodks[gl::RenderHook::PostImGui3D]) {
+					hook(this);
+				}
+				mFrameBuffer->unbind();
+			});
+
+		if (mDynamicResolution.enabled) {
+			mDynamicResolution.begin();
 		}
+		mFrameGraph.execute();
+		mDynamicResolution.end();
+		mLastAutoExposure = editor->autoExposure;
 	}
-	mFrameBuffer->clearDepthBuffer();
-	for (const auto hook : mRenderHoodks[gl::RenderHook::PreImGui3D]) {
-		hook(this);
-	}
-	ImGui3D::Render();
-	for (const auto hook : mRenderHoodks[gl::RenderHook::PostImGui3D]) {
-		hook(this);
+	else {
+		++mFramesSinceRedraw;
 	}
-	mFrameBuffer->unbind();
 
 	splitter.SetCurrentChannel(ImGui::GetWindowDrawList(), 0);
+	const glm::vec2 scale = mFrameBuffer->textureScale();
 	ImGui::GetWindowDrawList()->AddImage(
 		*mFrameBuffer->getRenderTexture(0),
 		ImGui::GetWindowPos(),
 		ImGui::GetWindowPos() + ImGui::GetWindowSize(),
-		ImVec2(0, 1), ImVec2(1, 0));
+		ImVec2(0, scale.y), ImVec2(scale.x, 0));
 	splitter.Merge(ImGui::GetWindowDrawList());
+	if (showRedrawReason) {
+		const std::string text = mRedrawReason != nullptr ? std::string("Redraw: ") + mRedrawReason
+			: "Cached image (" + std::to_string(mFramesSinceRedraw) + " frames)";
+		ImGui::GetWindowDrawList()->AddText(ImGui::GetWindowPos() + ImGui::GetWindowContentRegionMin() + ImVec2(4, 4),
+			IM_COL32(255, 255, 0, 255), text.c_str());
+	}
 
 	for (const auto hook : mRenderHoodks[gl::RenderHook::ImGuiDrawing]) {
 		hook(this);
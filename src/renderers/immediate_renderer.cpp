@@ -6,6 +6,9 @@
 #include <glpp/framebuffer.hpp>
 #include <glpp/intermediate.h>
 #include <glpp/meshes.hpp>
+#include <glpp/pixel_buffer.hpp>
+#include <glpp/state_cache.hpp>
+#include <glpp/texture_loader.hpp>
 
 #include <glpp/imgui.hpp>
 #include <imgui_impl_glfw.h>
@@ -42,9 +45,16 @@ gl::ImmediateRenderer::ImmediateRenderer(const std::string& title, std::shared_p
 bool gl::ImmediateRenderer::startFrame()
 {
 	mContext->makeCurrent();
+	// Applications may have changed the GL state since the last frame
+	gl::StateCache::Current().invalidate();
 	glfwPollEvents();
 
 	if (mContext->isMinified()) { return false; }
+
+	// Upload textures that finished decoding in the background
+	gl::TextureLoader::Default().update();
+	// Hand out downloads the GPU finished
+	gl::DownloadQueue::Default().poll();
 	
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
@@ -90,11 +100,11 @@ bool gl::ImmediateRenderer::startFrame()
 	mFrameBuffer->bind();
 
 
-	glViewport(0, 0, (int)w, (int)h);
-	glEnable(GL_DEPTH_TEST);
+	gl::StateCache& state = gl::StateCache::Current();
+	state.viewport(0, 0, (int)w, (int)h);
+	state.enable(GL_DEPTH_TEST);
 	glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 	mFrameBuffer->clearColorAttachment(0, clearColor);
-	mFrameBuffer->clearColorAttachment(1, glm::vec4(0, 0, 0, 1));
 
 }
 
@@ -123,7 +133,7 @@ bool gl::ImmediateRenderer::shouldClose() const
 
 void gl::ImmediateRenderer::renderObjects(std::shared_ptr<Camera>) const
 {
-	glEnable(GL_DEPTH_TEST);
+	gl::StateCache::Current().enable(GL_DEPTH_TEST);
 	for (auto obj : objects) {
 		if (obj->visible) {
 			obj->render(viewportCamera);
@@ -163,10 +173,14 @@ void gl::ImmediateRenderer::initialize()
 	auto [w, h] = mContext->getWindowSize();
 	mFrameBuffer = std::make_shared<gl::Framebuffer>(w, h);
 	mFrameBuffer->setRenderTexture(0, nullptr);
-	mFrameBuffer->appendRenderTexture(nullptr);
+	// Ids of ImGui3D, which clears and fills them only around the cursor
+	mFrameBuffer->appendRenderTexture(gl::PixelFormat::Red, gl::PixelType::UInt);
 	mImGui3DContext = ImGui3D::CreateContext();
-	mImGui3DContext->GetHoveredIdImpl = [&](ImVec2 mouse) -> glm::uvec4 {
-		return mFrameBuffer->readColorPixel(mouse.x, mouse.y, 1);
+	mImGui3DContext->GetCursorPixelImpl = [](ImVec2 mouse) -> glm::ivec2 {
+		return glm::ivec2(mouse.x, mouse.y);
+	};
+	mImGui3DContext->GetHoveredIdImpl = [&](glm::ivec2 pixel) -> ImGuiID {
+		return mFrameBuffer->latestColorPixel(pixel.x, pixel.y, 1).r;
 	};
 }
 
@@ -2,25 +2,30 @@
 
 #include <glpp/context.hpp>
 #include <glpp/framebuffer.hpp>
+#include <glpp/state_cache.hpp>
 
 #include <stdexcept>
 
-gl::OffscreenRenderer::OffscreenRenderer(int width, int height) :
+gl::OffscreenRenderer::OffscreenRenderer(int width, int height, int samples) :
 	mContext(nullptr),
 	framebuffer(nullptr)
 {
 	mContext = std::make_shared<gl::OffscreenContext>(width, height);
 	framebuffer = std::make_shared<gl::Framebuffer>(width, height);
+	framebuffer->setSamples(samples);
 	clearColors = { {0, 0, 0, 1} };
 }
 
 void gl::OffscreenRenderer::startRender(int width, int height, bool clear)
 {
 	mContext->makeCurrent();
+	gl::StateCache::Current().invalidate();
 	if (framebuffer != nullptr) {
 		if (framebuffer->width() != width || framebuffer->height() != height) {
 			framebuffer->resize(width, height);
 		}
+		// Clears go to the bound framebuffer, which is the multisampled one if there is one
+		framebuffer->bind();
 		if (clear) {
 			if (framebuffer->numColorAttachments() != clearColors.size()) {
 				throw std::runtime_error("Different number of color attachments and clear colors");
@@ -30,6 +35,13 @@ void gl::OffscreenRenderer::startRender(int width, int height, bool clear)
 				framebuffer->clearColorAttachment((int)i, clearColors[i]);
 			}
 		}
-		framebuffer->bind();
+	}
+}
+
+void gl::OffscreenRenderer::endRender()
+{
+	mContext->makeCurrent();
+	if (framebuffer != nullptr) {
+		framebuffer->resolve();
 	}
 }
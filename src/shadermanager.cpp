@@ -268,6 +268,23 @@ std::pair<bool, GLuint> loadAndCompileShader(const ShaderCode& src, GLenum type,
 	return std::make_pair(true, shader);
 }
 
+// Inserts the defines right after the #version directive, which has to stay the first statement
+static std::string injectDefines(const std::string& src, const std::unordered_map<std::string, std::string>& defines) {
+	if (defines.empty()) {
+		return src;
+	}
+	std::stringstream lines;
+	for (const auto& [name, value] : defines) {
+		lines << "#define " << name << " " << value << std::endl;
+	}
+	size_t pos = src.find("#version");
+	pos = pos == std::string::npos ? 0 : src.find('\n', pos);
+	if (pos == std::string::npos) {
+		return src + "\n" + lines.str();
+	}
+	return src.substr(0, pos + 1) + lines.str() + src.substr(pos + 1);
+}
+
 static std::pair<bool, GLuint> compileShader(std::string src, GLenum type) {
 	GLuint shader = glCreateShader(type);
 	const GLchar* src_ptr = (const GLchar*)src.c_str();
@@ -527,14 +544,42 @@ Shader::Shader(std::string path) :
 gl::Shader::Shader(std::initializer_list<std::pair<GLenum, std::string>> stages) 
 	: Shader()
 {
+	mStages.assign(stages.begin(), stages.end());
+	compileFromStages();
+}
+
+Shader::~Shader() {
+	glDeleteProgram(mProgram);
+}
+
+ShaderRequirements gl::Shader::use()
+{
+	if (!mSourceFiles.empty() && requiresUpdate()) {
+		update();
+	}
+	auto requirements = require();
+	gl::StateCache::Current().useProgram(mProgram);
+	return requirements;
+}
+
+bool gl::Shader::requiresUpdate() const
+{
+	for (const std::string& srcFile : mSourceFiles) {
+		if (std::filesystem::last_write_time(srcFile).time_since_epoch().count() > mLastUpdated)
+			return true;
+	}
+	return false;
+}
+
+bool gl::Shader::compileFromStages() {
 	auto t1 = std::chrono::high_resolution_clock::now();
 
 	LOG("Compiling shader from raw strings");
 
 	std::vector<GLuint> shaders;
 	bool allValid = true;
-	for (auto [type, src] : stages) {
-		auto [valid, sid] = compileShader(src, type);
+	for (auto [type, src] : mStages) {
+		auto [valid, sid] = compileShader(injectDefines(src, mDefines), type);
 		shaders.push_back(sid);
 		allValid = allValid && valid;
 	}
@@ -542,6 +587,7 @@ gl::Shader::Shader(std::initializer_list<std::pair<GLenum, std::string>> stages)
 	GLint success = 0;
 	if (allValid) {
 		// clean old program
+		glDeleteProgram(mProgram);
 		mProgram = glCreateProgram();
 		for (GLuint shader : shaders) 
 			glAttachShader(mProgram, shader);
@@ -563,6 +609,10 @@ gl::Shader::Shader(std::initializer_list<std::pair<GLenum, std::string>> stages)
 			LOG_ERROR("failed to validate shader");
 		}
 	}
+	else {
+		for (GLuint shader : shaders) glDeleteShader(shader);
+	}
+	mLastUpdated = 1;
 
 	auto t2 = std::chrono::high_resolution_clock::now();
 	std::chrono::duration<float> elapsed = t2 - t1;
@@ -570,30 +620,7 @@ gl::Shader::Shader(std::initializer_list<std::pair<GLenum, std::string>> stages)
 	if (success && allValid) {
 		LOG_SUCCESS("Compilation sucessfull (Compile time: %.1f ms)", (float)elapsed.count() * 1e-3f);
 	}
-
-}
-
-Shader::~Shader() {
-	glDeleteProgram(mProgram);
-}
-
-ShaderRequirements gl::Shader::use()
-{
-	if (!mSourceFiles.empty() && requiresUpdate()) {
-		update();
-	}
-	auto requirements = require();
-	glUseProgram(mProgram);
-	return requirements;
-}
-
-bool gl::Shader::requiresUpdate() const
-{
-	for (const std::string& srcFile : mSourceFiles) {
-		if (std::filesystem::last_write_time(srcFile).time_since_epoch().count() > mLastUpdated)
-			return true;
-	}
-	return false;
+	return success && allValid;
 }
 
 bool gl::Shader::compileFromFile() {
@@ -676,7 +703,13 @@ bool gl::Shader::compileFromFile() {
 }
 
 void Shader::update() {
-	if (mSourceFiles.empty()) return;	// No name given -> shader was probably compield from constant char *
+	if (mSourceFiles.empty()) {
+		// No name given -> shader was compiled from strings, which only have to be recompiled if a define changed
+		if (!mStages.empty() && mLastUpdated == 0) {
+			compileFromStages();
+		}
+		return;
+	}
 
 	auto t1 = std::chrono::high_resolution_clock::now();
 
@@ -729,6 +762,8 @@ void gl::Shader::setDefineFlag(const std::string& name)
 void gl::Shader::removeDefine(const std::string& name)
 {
 	mDefines.erase(name);
+	// Force update
+	mLastUpdated = 0;
 }
 
 bool gl::Shader::hasDefine(const std::string& name)
@@ -743,9 +778,9 @@ gl::ComputeShader::ComputeShader() :
 	gl::Shader() {}
 
 gl::ComputeShader::ComputeShader(const std::string& fileOrCode) {
-	// Is this a file?
+	// Is this a file? Code always spans multiple lines, as the #version directive needs a line of its own
 	std::filesystem::path path(fileOrCode);
-	if (path.has_extension()) {
+	if (fileOrCode.find('\n') == std::string::npos) {
 		LOG_WARNING_IF(path.extension() != ".glsl" && path.extension() != ".compute", "You should use extension .glsl or .compute for compute shaders");
 		if (std::filesystem::exists(path)) {
 			mSourceFiles.push_back(fileOrCode);
@@ -756,41 +791,8 @@ gl::ComputeShader::ComputeShader(const std::string& fileOrCode) {
 		}
 	}
 	else {
-		auto t1 = std::chrono::high_resolution_clock::now();
-
-		LOG("Compiling compute shader from raw strings");
-
-		auto [valid, shader] = compileShader(fileOrCode, GL_COMPUTE_SHADER);
-		GLint success = 0;
-		if (valid) {
-			// clean old program
-			mProgram = glCreateProgram();
-			glAttachShader(mProgram, shader);
-			glLinkProgram(mProgram);
-			glDeleteShader(shader);
-
-			glGetProgramiv(mProgram, GL_LINK_STATUS, &success);
-			if (!success)
-			{
-				GLchar infoLog[1024];
-				glGetProgramInfoLog(mProgram, 1024, NULL, infoLog);
-				LOG_ERROR("failed to link shader:\n%s", infoLog);
-			}
-
-			glValidateProgram(mProgram);
-			glGetProgramiv(mProgram, GL_VALIDATE_STATUS, &success);
-			if (!success)
-			{
-				LOG_ERROR("failed to validate compute shader");
-			}
-		}
-
-		auto t2 = std::chrono::high_resolution_clock::now();
-		long long duration = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
-
-		if (success && valid) {
-			LOG_SUCCESS("Compilation sucessfull (Compile time: %ll ms)", duration);
-		}
+		mStages.emplace_back(GL_COMPUTE_SHADER, fileOrCode);
+		compileFromStages();
 	}
 }
 
@@ -0,0 +1,355 @@
+#include "glpp/state_cache.hpp"
+
+#include "glpp/context.hpp"
+
+gl::StateCache::StateCache()
+{
+}
+
+void gl::StateCache::invalidate()
+{
+	mProgram.known = false;
+	mVertexArray.known = false;
+	mDrawFramebuffer.known = false;
+	mReadFramebuffer.known = false;
+	mActiveTexture.known = false;
+	mTextures.clear();
+	mCapabilities.clear();
+	mBlendFunc.known = false;
+	mDepthFunc.known = false;
+	mDepthMask.known = false;
+	for (Cached<glm::bvec4>& mask : mColorMasks) {
+		mask.known = false;
+	}
+	mViewport.known = false;
+}
+
+void gl::StateCache::useProgram(GLuint program)
+{
+	if (!unchanged(mProgram, program)) {
+		glUseProgram(program);
+	}
+}
+
+GLuint gl::StateCache::program()
+{
+	if (mProgram.known) {
+		++mStatistics.queries;
+		return mProgram.value;
+	}
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	mProgram = { static_cast<GLuint>(program), true };
+	return mProgram.value;
+}
+
+void gl::StateCache::bindVertexArray(GLuint vertexArray)
+{
+	if (!unchanged(mVertexArray, vertexArray)) {
+		glBindVertexArray(vertexArray);
+	}
+}
+
+GLuint gl::StateCache::vertexArray()
+{
+	if (mVertexArray.known) {
+		++mStatistics.queries;
+		return mVertexArray.value;
+	}
+	GLint vertexArray = 0;
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+	mVertexArray = { static_cast<GLuint>(vertexArray), true };
+	return mVertexArray.value;
+}
+
+void gl::StateCache::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	if (target == GL_FRAMEBUFFER) {
+		++mStatistics.calls;
+		if (mDrawFramebuffer.known && mReadFramebuffer.known
+			&& mDrawFramebuffer.value == framebuffer && mReadFramebuffer.value == framebuffer) {
+			++mStatistics.skipped;
+			return;
+		}
+		mDrawFramebuffer = { framebuffer, true };
+		mReadFramebuffer = { framebuffer, true };
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		return;
+	}
+	if (!unchanged(target == GL_READ_FRAMEBUFFER ? mReadFramebuffer : mDrawFramebuffer, framebuffer)) {
+		glBindFramebuffer(target, framebuffer);
+	}
+}
+
+GLuint gl::StateCache::framebuffer(GLenum target)
+{
+	Cached<GLuint>& cached = target == GL_READ_FRAMEBUFFER ? mReadFramebuffer : mDrawFramebuffer;
+	if (cached.known) {
+		++mStatistics.queries;
+		return cached.value;
+	}
+	GLint framebuffer = 0;
+	glGetIntegerv(target == GL_READ_FRAMEBUFFER ? GL_READ_FRAMEBUFFER_BINDING : GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+	cached = { static_cast<GLuint>(framebuffer), true };
+	return cached.value;
+}
+
+void gl::StateCache::activeTexture(int unit)
+{
+	if (!unchanged(mActiveTexture, unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+}
+
+int gl::StateCache::activeTexture()
+{
+	if (mActiveTexture.known) {
+		++mStatistics.queries;
+		return mActiveTexture.value;
+	}
+	GLint unit = GL_TEXTURE0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &unit);
+	mActiveTexture = { unit - GL_TEXTURE0, true };
+	return mActiveTexture.value;
+}
+
+void gl::StateCache::bindTexture(GLenum target, GLuint texture, int unit)
+{
+	if (unit < 0) {
+		unit = activeTexture();
+	}
+	if (!unchanged(mTextures[textureKey(target, unit)], texture)) {
+		activeTexture(unit);
+		glBindTexture(target, texture);
+	}
+}
+
+GLuint gl::StateCache::texture(GLenum target, int unit)
+{
+	if (unit < 0) {
+		unit = activeTexture();
+	}
+	Cached<GLuint>& cached = mTextures[textureKey(target, unit)];
+	if (cached.known) {
+		++mStatistics.queries;
+		return cached.value;
+	}
+
+	GLenum binding = 0;
+	switch (target) {
+	case GL_TEXTURE_1D: binding = GL_TEXTURE_BINDING_1D; break;
+	case GL_TEXTURE_2D: binding = GL_TEXTURE_BINDING_2D; break;
+	case GL_TEXTURE_3D: binding = GL_TEXTURE_BINDING_3D; break;
+	case GL_TEXTURE_1D_ARRAY: binding = GL_TEXTURE_BINDING_1D_ARRAY; break;
+	case GL_TEXTURE_2D_ARRAY: binding = GL_TEXTURE_BINDING_2D_ARRAY; break;
+	case GL_TEXTURE_CUBE_MAP: binding = GL_TEXTURE_BINDING_CUBE_MAP; break;
+	case GL_TEXTURE_2D_MULTISAMPLE: binding = GL_TEXTURE_BINDING_2D_MULTISAMPLE; break;
+	default: return 0;
+	}
+	activeTexture(unit);
+	GLint texture = 0;
+	glGetIntegerv(binding, &texture);
+	cached = { static_cast<GLuint>(texture), true };
+	return cached.value;
+}
+
+void gl::StateCache::enable(GLenum cap)
+{
+	setEnabled(cap, true);
+}
+
+void gl::StateCache::disable(GLenum cap)
+{
+	setEnabled(cap, false);
+}
+
+void gl::StateCache::setEnabled(GLenum cap, bool enabled)
+{
+	if (!unchanged(mCapabilities[cap], enabled)) {
+		if (enabled) {
+			glEnable(cap);
+		}
+		else {
+			glDisable(cap);
+		}
+	}
+}
+
+bool gl::StateCache::isEnabled(GLenum cap)
+{
+	Cached<bool>& cached = mCapabilities[cap];
+	if (cached.known) {
+		++mStatistics.queries;
+		return cached.value;
+	}
+	cached = { glIsEnabled(cap) == GL_TRUE, true };
+	return cached.value;
+}
+
+void gl::StateCache::blendFunc(GLenum src, GLenum dst)
+{
+	if (!unchanged(mBlendFunc, std::make_pair(src, dst))) {
+		glBlendFunc(src, dst);
+	}
+}
+
+std::pair<GLenum, GLenum> gl::StateCache::blendFunc()
+{
+	if (mBlendFunc.known) {
+		++mStatistics.queries;
+		return mBlendFunc.value;
+	}
+	GLint src = GL_ONE, dst = GL_ZERO;
+	glGetIntegerv(GL_BLEND_SRC_RGB, &src);
+	glGetIntegerv(GL_BLEND_DST_RGB, &dst);
+	mBlendFunc = { std::make_pair(static_cast<GLenum>(src), static_cast<GLenum>(dst)), true };
+	return mBlendFunc.value;
+}
+
+void gl::StateCache::depthFunc(GLenum func)
+{
+	if (!unchanged(mDepthFunc, func)) {
+		glDepthFunc(func);
+	}
+}
+
+GLenum gl::StateCache::depthFunc()
+{
+	if (mDepthFunc.known) {
+		++mStatistics.queries;
+		return mDepthFunc.value;
+	}
+	GLint func = GL_LESS;
+	glGetIntegerv(GL_DEPTH_FUNC, &func);
+	mDepthFunc = { static_cast<GLenum>(func), true };
+	return mDepthFunc.value;
+}
+
+void gl::StateCache::depthMask(bool enabled)
+{
+	if (!unchanged(mDepthMask, enabled)) {
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	}
+}
+
+bool gl::StateCache::depthMask()
+{
+	if (mDepthMask.known) {
+		++mStatistics.queries;
+		return mDepthMask.value;
+	}
+	GLboolean enabled = GL_TRUE;
+	glGetBooleanv(GL_DEPTH_WRITEMASK, &enabled);
+	mDepthMask = { enabled == GL_TRUE, true };
+	return mDepthMask.value;
+}
+
+void gl::StateCache::colorMask(bool r, bool g, bool b, bool a)
+{
+	const glm::bvec4 mask(r, g, b, a);
+	++mStatistics.calls;
+	bool same = true;
+	for (Cached<glm::bvec4>& cached : mColorMasks) {
+		same = same && cached.known && cached.value == mask;
+		cached = { mask, true };
+	}
+	if (same) {
+		++mStatistics.skipped;
+		return;
+	}
+	glColorMask(r, g, b, a);
+}
+
+void gl::StateCache::colorMask(GLuint buffer, bool r, bool g, bool b, bool a)
+{
+	if (buffer >= MaxDrawBuffers) {
+		glColorMaski(buffer, r, g, b, a);
+		return;
+	}
+	if (!unchanged(mColorMasks[buffer], glm::bvec4(r, g, b, a))) {
+		glColorMaski(buffer, r, g, b, a);
+	}
+}
+
+glm::bvec4 gl::StateCache::colorMask(GLuint buffer)
+{
+	GLboolean mask[4] = { GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE };
+	if (buffer >= MaxDrawBuffers) {
+		glGetBooleani_v(GL_COLOR_WRITEMASK, buffer, mask);
+		return glm::bvec4(mask[0], mask[1], mask[2], mask[3]);
+	}
+	Cached<glm::bvec4>& cached = mColorMasks[buffer];
+	if (cached.known) {
+		++mStatistics.queries;
+		return cached.value;
+	}
+	glGetBooleani_v(GL_COLOR_WRITEMASK, buffer, mask);
+	cached = { glm::bvec4(mask[0], mask[1], mask[2], mask[3]), true };
+	return cached.value;
+}
+
+void gl::StateCache::viewport(int x, int y, int width, int height)
+{
+	if (!unchanged(mViewport, glm::ivec4(x, y, width, height))) {
+		glViewport(x, y, width, height);
+	}
+}
+
+glm::ivec4 gl::StateCache::viewport()
+{
+	if (mViewport.known) {
+		++mStatistics.queries;
+		return mViewport.value;
+	}
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	mViewport = { glm::ivec4(viewport[0], viewport[1], viewport[2], viewport[3]), true };
+	return mViewport.value;
+}
+
+void gl::StateCache::textureDeleted(GLuint texture)
+{
+	for (auto& [key, cached] : mTextures) {
+		if (cached.known && cached.value == texture) {
+			cached.value = 0;
+		}
+	}
+}
+
+void gl::StateCache::vertexArrayDeleted(GLuint vertexArray)
+{
+	if (mVertexArray.known && mVertexArray.value == vertexArray) {
+		mVertexArray.value = 0;
+	}
+}
+
+void gl::StateCache::framebufferDeleted(GLuint framebuffer)
+{
+	if (mDrawFramebuffer.known && mDrawFramebuffer.value == framebuffer) {
+		mDrawFramebuffer.value = 0;
+	}
+	if (mReadFramebuffer.known && mReadFramebuffer.value == framebuffer) {
+		mReadFramebuffer.value = 0;
+	}
+}
+
+const gl::StateCache::Statistics& gl::StateCache::statistics() const
+{
+	return mStatistics;
+}
+
+void gl::StateCache::resetStatistics()
+{
+	mStatistics = Statistics();
+}
+
+gl::StateCache& gl::StateCache::Current()
+{
+	if (gl::Context* context = gl::Context::GetCurrentContext()) {
+		return context->stateCache();
+	}
+	// Fallback without a gl::Context. It is leaked because GL objects destroyed during static destruction still report
+	// their deletion to it
+	static StateCache* cache = new StateCache();
+	return *cache;
+}
@@ -1,9 +1,17 @@
 #include "glpp/texture.hpp"
+#include "glpp/pixel_buffer.hpp"
+#include "glpp/texture_loader.hpp"
+#include "glpp/texture_compression.hpp"
+#include "glpp/logging.hpp"
+#include "glpp/pixel_conversion.hpp"
+#include "glpp/state_cache.hpp"
 
 #include <algorithm>
 #include <stdexcept>
 #include <string>
 #include <cassert>
+#include <cctype>
+#include <cstring>
 
 #include <filesystem>
 
@@ -45,6 +53,27 @@ namespace impl {
 		}
 	}
 
+	// Framebuffer used to read regions of textures. Every read reattaches it, so one is enough for the whole program
+	// and it is released together with the context
+	GLuint readFramebuffer() {
+		static GLuint fbo = 0;
+		if (fbo == 0) {
+			glGenFramebuffers(1, &fbo);
+		}
+		return fbo;
+	}
+
+	GLenum attachmentForFormat(gl::PixelFormat format) {
+		switch (format) {
+		case gl::PixelFormat::DEPTH:
+			return GL_DEPTH_ATTACHMENT;
+		case gl::PixelFormat::DEPTH_STENCIL:
+			return GL_DEPTH_STENCIL_ATTACHMENT;
+		default:
+			return GL_COLOR_ATTACHMENT0;
+		}
+	}
+
 	GLenum getFormat(int channels) {
 		switch (channels) {
 		case 1:
@@ -76,7 +105,8 @@ gl::TextureBase::TextureBase(TextureType type, PixelFormat pixelFormat, PixelTyp
 	mDepth(1),
 	mMinFilterType(FilterType::Linear),
 	mMagFilterType(FilterType::Linear),
-	mWrapType()
+	mWrapType(),
+	mCompression(CompressedFormat::None)
 {
 	int filterType = _flags & TextureFlags_Filter_Nearest_Linear;
 	int wrapType = _flags & (0x7 << 3);
@@ -127,12 +157,15 @@ GLenum gl::TextureBase::glType() const
 
 GLenum gl::TextureBase::glSizedFormat() const
 {
+	if (mCompression != CompressedFormat::None) {
+		return getGlSizedFormat(mCompression);
+	}
 	return getGlSizedFormat(mPixelFormat, mDataType);
 }
 
 GLenum gl::TextureBase::glFormat() const
 {
-	return static_cast<GLenum>(mPixelFormat);
+	return getGLFormat(mPixelFormat, mDataType);
 }
 
 int gl::TextureBase::channels() const
@@ -148,6 +181,7 @@ int gl::TextureBase::dimensions() const
 	case TextureType::D2:
 		return 2;
 	case TextureType::D3:
+	case TextureType::D2Array:
 		return 3;
 	default:
 		throw std::runtime_error("Invalid texture type");
@@ -169,6 +203,16 @@ gl::FilterType gl::TextureBase::minFilter() const
 {
 	return mMinFilterType;
 }
+
+gl::CompressedFormat gl::TextureBase::compression() const
+{
+	return mCompression;
+}
+
+bool gl::TextureBase::isCompressed() const
+{
+	return mCompression != CompressedFormat::None;
+}
 #pragma endregion
 
 #pragma region Texture
@@ -176,9 +220,12 @@ gl::FilterType gl::TextureBase::minFilter() const
 gl::Texture::Texture(TextureType type, PixelFormat pixelFormat, gl::PixelType dataType, int flags) :
 	TextureBase(type, pixelFormat, dataType, flags),
 	mId(0),
-	id(mId)	
+	id(mId),
+	mMipmapDirty(false)
 {
 	mCreateMipmap = (static_cast<int>(flags) & TextureFlags_No_Mipmap) == 0x0;
+	mDeferMipmap = (static_cast<int>(flags) & TextureFlags_Deferred_Mipmap) != 0x0;
+	mImmutable = (static_cast<int>(flags) & TextureFlags_Immutable_Storage) != 0x0;
 }
 
 gl::Texture::Texture(int cols, PixelFormat pixelFormat, gl::PixelType dataType, int flags) :
@@ -214,62 +261,160 @@ gl::Texture::Texture(int cols, int rows, int depth, PixelFormat pixelFormat, gl:
 	}
 }
 
+gl::Texture::Texture(TextureType type, int cols, int rows, int depth, PixelFormat pixelFormat, gl::PixelType dataType, TextureFlags flags) :
+	Texture(type, pixelFormat, dataType, flags)
+{
+	mCols = cols;
+	mRows = type == TextureType::D1 ? 1 : rows;
+	mDepth = type == TextureType::D3 || type == TextureType::D2Array ? depth : 1;
+	if (!(flags & TextureFlags_Lazy_Init)) {
+		init();
+	}
+}
+
 gl::Texture::Texture(std::string path, bool flipY, TextureFlags flags) :
 	Texture(TextureType::D2, PixelFormat::RGB, PixelType::UByte, flags)
 {
-	int channels;
-	void* data = NULL;
-	stbi_set_flip_vertically_on_load(flipY);
-	if (std::filesystem::path(path).extension() == ".hdr") {
-		data = static_cast<void*>(stbi_loadf(path.c_str(), &mCols, &mRows, &channels, 0));
-		mDataType = gl::PixelType::Float;
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+	if (extension == ".dds" || extension == ".ktx" || (flags & TextureFlags_Compress)) {
+		loadCompressed(path, flipY, flags);
+		return;
 	}
-	else {
-		data = static_cast<void*>(stbi_load(path.c_str(), &mCols, &mRows, &channels, 0));
-	}
-	if(data == NULL) {
-		throw std::runtime_error("Could not load texture from \"" + path + "\"");
-	}
-	if (std::max(mCols, mRows) > 2048) {
+
+	ImageData image = decodeImage(path, flipY);
+	if (std::max(image.cols, image.rows) > 2048) {
 		throw std::runtime_error("This is texture is to large!");
 	}
-	if (channels == 1) {
-		mPixelFormat = PixelFormat::Red;
-	}
-	else if (channels == 2) {
-		mPixelFormat = PixelFormat::RG;
-	}
-	else if (channels == 4) {
-		mPixelFormat = PixelFormat::RGBA;
+	mCols = image.cols;
+	mRows = image.rows;
+	mPixelFormat = image.format;
+	mDataType = image.type;
+	setData(image.pixels.data());
+}
+
+gl::Texture::Texture(int cols, int rows, CompressedFormat compression, TextureFlags flags) :
+	Texture(TextureType::D2, getDecodedFormat(compression), PixelType::UByte, flags)
+{
+	mCols = cols;
+	mRows = rows;
+	mDepth = 1;
+	mCompression = compression;
+	if (!(flags & TextureFlags_Lazy_Init)) {
+		init();
 	}
-	setData(data);
-	stbi_image_free(data);
 }
 
 gl::Texture::~Texture()
 {
 	if (mId != 0) {
 		glDeleteTextures(1, &mId);
+		gl::StateCache::Current().textureDeleted(mId);
 		mId = 0;
 	}
 }
 
 void gl::Texture::createMipmap(bool shouldCreate)
 {
-	if (shouldCreate) {
+	// Compressed formats can not be rendered to, so their mip levels are uploaded by setData instead
+	if (shouldCreate && !isCompressed()) {
 		bind();
 		glGenerateMipmap(static_cast<GLenum>(mTextureType));
+		mMipmapDirty = false;
 	}
 	mCreateMipmap = shouldCreate;
 }
 
 void gl::Texture::setData(const void* data, PixelFormat pixelFormat)
 {
+	if (isCompressed()) {
+		const PixelFormat sourceFormat = pixelFormat == gl::PixelFormat::Default ? mPixelFormat : pixelFormat;
+		CompressedImage image = compressImage(data, mCols, mRows, sourceFormat, mCompression, mCreateMipmap);
+		for (int level = 0; level < (int)image.levels.size(); ++level) {
+			setCompressedData(image.levels[level].data(), image.levels[level].size(), level);
+		}
+		return;
+	}
 	bind();
-	GLenum format = pixelFormat == gl::PixelFormat::Default ? glFormat() : getGLFormat(pixelFormat);
+	upload(data, pixelFormat);
+	gl::StateCache::Current().bindTexture(static_cast<GLenum>(mTextureType), 0);
+}
+
+void gl::Texture::setSubData(const void* data, int x, int y, int z, int w, int h, PixelFormat pixelFormat)
+{
+	if (mTextureType != TextureType::D2 && mTextureType != TextureType::D2Array) {
+		throw std::invalid_argument("Regions can only be set for 2D and array textures");
+	}
+	const PixelFormat sourceFormat = pixelFormat == gl::PixelFormat::Default ? mPixelFormat : pixelFormat;
+	const bool aligned = (getPixelSize(sourceFormat, mDataType) * w) % 4 == 0;
 	GLint oldAlign;
 	glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlign);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, aligned ? 4 : 1);
+	bind();
+	if (mTextureType == TextureType::D2) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, getGLFormat(sourceFormat, mDataType), static_cast<GLenum>(mDataType), data);
+	}
+	else {
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, z, w, h, 1, getGLFormat(sourceFormat, mDataType), static_cast<GLenum>(mDataType), data);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlign);
+	if (mDeferMipmap) {
+		mMipmapDirty = mCreateMipmap;
+	}
+	else {
+		createMipmap(mCreateMipmap);
+	}
+	unbind();
+}
+
+void gl::Texture::setFloatData(const float* data, PixelFormat pixelFormat)
+{
+	if (mDataType == PixelType::Float) {
+		setData(data, pixelFormat);
+		return;
+	}
+	if (mDataType != PixelType::Half) {
+		throw std::runtime_error("Float data can only be uploaded to float and half float textures");
+	}
+	const PixelFormat format = pixelFormat == gl::PixelFormat::Default ? mPixelFormat : pixelFormat;
+	const size_t count = static_cast<size_t>(getChannelsForFormat(format)) * mCols * mRows * mDepth;
+	std::vector<uint16_t> halfs(count);
+	floatToHalf(data, halfs.data(), count);
+	setData(halfs.data(), format);
+}
+
+void gl::Texture::setDataAsync(const void* data, PixelFormat pixelFormat)
+{
+	if (isCompressed()) {
+		// Encoding the blocks takes far longer than the upload, so there is nothing to gain here
+		setData(data, pixelFormat);
+		return;
+	}
+	const PixelFormat format = pixelFormat == gl::PixelFormat::Default ? mPixelFormat : pixelFormat;
+	const size_t size = getPixelSize(format, mDataType) * mCols * mRows * mDepth;
+
+	PixelBufferRing& ring = PixelBufferRing::Uploads();
+	const int slot = ring.acquire(size);
+	std::memcpy(ring.map(slot), data, size);
+	ring.unmap(slot);
+
+	bind();
+	ring.bind(slot);
+	upload(nullptr, format);
+	ring.unbind();
+	ring.fence(slot);
+	gl::StateCache::Current().bindTexture(static_cast<GLenum>(mTextureType), 0);
+}
+
+void gl::Texture::upload(const void* data, PixelFormat pixelFormat)
+{
+	const PixelFormat sourceFormat = pixelFormat == gl::PixelFormat::Default ? mPixelFormat : pixelFormat;
+	GLenum format = getGLFormat(sourceFormat, mDataType);
+	// An unpack alignment of 1 forces most drivers onto a slow copy path, so only use it if rows are not 4 byte aligned
+	const bool aligned = (getPixelSize(sourceFormat, mDataType) * mCols) % 4 == 0;
+	GLint oldAlign;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlign);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, aligned ? 4 : 1);
 
 	switch (mTextureType) {
 	case TextureType::D1:
@@ -281,14 +426,19 @@ void gl::Texture::setData(const void* data, PixelFormat pixelFormat)
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 		break;
 	case TextureType::D3:
-		glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, mCols, mRows, mDepth, format, static_cast<GLenum>(mDataType), data);
+	case TextureType::D2Array:
+		glTexSubImage3D(static_cast<GLenum>(mTextureType), 0, 0, 0, 0, mCols, mRows, mDepth, format, static_cast<GLenum>(mDataType), data);
 		break;
 	default:
 		throw std::runtime_error("Invalid number of dimensions");
 	}
-	createMipmap(mCreateMipmap);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlign);
-	glBindTexture(static_cast<GLenum>(mTextureType), 0);
+	if (mDeferMipmap) {
+		mMipmapDirty = mCreateMipmap;
+	}
+	else {
+		createMipmap(mCreateMipmap);
+	}
 }
 
 void gl::Texture::setFilters(gl::FilterType minFilter, gl::FilterType magFilter)
@@ -328,6 +478,22 @@ void gl::Texture::resize(int cols, int rows, int depth)
 		mDepth = depth;
 	}
 
+	if (isCompressed()) {
+		// All levels are allocated up front, because compressed textures can not generate their mipmaps
+		for (int level = 0; level < numLevels(); ++level) {
+			const int w = std::max(1, mCols >> level);
+			const int h = std::max(1, mRows >> level);
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, glSizedFormat(), w, h, 0, (GLsizei)getCompressedSize(mCompression, w, h), nullptr);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels() - 1);
+		return;
+	}
+
+	if (mImmutable) {
+		allocateStorage();
+		return;
+	}
+
 	switch (mTextureType) {
 	case TextureType::D1:
 		glTexImage1D(GL_TEXTURE_1D, 0, glSizedFormat(), mCols, 0, glFormat(), static_cast<GLenum>(mDataType), nullptr);
@@ -336,37 +502,167 @@ void gl::Texture::resize(int cols, int rows, int depth)
 		glTexImage2D(GL_TEXTURE_2D, 0, glSizedFormat(), mCols, mRows, 0, glFormat(), static_cast<GLenum>(mDataType), nullptr);
 		break;
 	case TextureType::D3:
-		glTexImage3D(GL_TEXTURE_3D, 0, glSizedFormat(), mCols, mRows, mDepth, 0, glFormat(), static_cast<GLenum>(mDataType), nullptr);
+	case TextureType::D2Array:
+		glTexImage3D(static_cast<GLenum>(mTextureType), 0, glSizedFormat(), mCols, mRows, mDepth, 0, glFormat(), static_cast<GLenum>(mDataType), nullptr);
 		break;
 	}
 }
 
+void gl::Texture::allocateStorage()
+{
+	GLint immutable = GL_FALSE;
+	glGetTexParameteriv(static_cast<GLenum>(mTextureType), GL_TEXTURE_IMMUTABLE_FORMAT, &immutable);
+	if (immutable) {
+		// Immutable storage can not be specified again, so the texture object is replaced
+		unbind();
+		glDeleteTextures(1, &mId);
+		gl::StateCache::Current().textureDeleted(mId);
+		glGenTextures(1, &mId);
+		setFilters(mMinFilterType, mMagFilterType);
+		setWrapping(mWrapType[0], mWrapType[1], mWrapType[2]);
+	}
+
+	switch (mTextureType) {
+	case TextureType::D1:
+		glTexStorage1D(GL_TEXTURE_1D, numLevels(), glSizedFormat(), mCols);
+		break;
+	case TextureType::D2:
+		glTexStorage2D(GL_TEXTURE_2D, numLevels(), glSizedFormat(), mCols, mRows);
+		break;
+	case TextureType::D3:
+	case TextureType::D2Array:
+		glTexStorage3D(static_cast<GLenum>(mTextureType), numLevels(), glSizedFormat(), mCols, mRows, mDepth);
+		break;
+	}
+}
+
+void gl::Texture::reallocate(int cols, int rows, PixelFormat pixelFormat, gl::PixelType dataType)
+{
+	mCompression = CompressedFormat::None;
+	mPixelFormat = pixelFormat;
+	mDataType = dataType;
+	resize(cols, rows);
+}
+
 void gl::Texture::download(void* dst, gl::PixelFormat _format, int level)
 {
 	bind();
-	GLenum format = _format == gl::PixelFormat::Default ? glFormat() : getGLFormat(_format);
+	GLenum format = _format == gl::PixelFormat::Default ? glFormat() : getGLFormat(_format, mDataType);
 	glGetTexImage(static_cast<GLenum>(mTextureType), level, format, static_cast<GLenum>(mDataType), dst);
 }
 
+void gl::Texture::downloadFloat(float* dst, gl::PixelFormat _format, int level)
+{
+	if (mDataType == PixelType::Float) {
+		download(dst, _format, level);
+		return;
+	}
+	if (mDataType != PixelType::Half) {
+		throw std::runtime_error("Only float and half float textures can be downloaded as floats");
+	}
+	const PixelFormat format = _format == gl::PixelFormat::Default ? mPixelFormat : _format;
+	const size_t count = static_cast<size_t>(getChannelsForFormat(format)) * std::max(1, mCols >> level) * std::max(1, mRows >> level) * std::max(1, mDepth >> level);
+	std::vector<uint16_t> halfs(count);
+	GLint oldAlign;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &oldAlign);
+	glPixelStorei(GL_PACK_ALIGNMENT, 2);
+	download(halfs.data(), format, level);
+	glPixelStorei(GL_PACK_ALIGNMENT, oldAlign);
+	halfToFloat(halfs.data(), dst, count);
+}
+
+std::future<void> gl::Texture::downloadAsync(void* dst, int level, gl::PixelFormat format, std::function<void()> onFinished)
+{
+	return downloadAsync(dst, 0, 0, std::max(1, mCols >> level), std::max(1, mRows >> level), level, format, onFinished);
+}
+
+std::future<void> gl::Texture::downloadAsync(void* dst, int x, int y, int w, int h, int level, gl::PixelFormat _format, std::function<void()> onFinished)
+{
+	const PixelFormat format = _format == gl::PixelFormat::Default ? mPixelFormat : _format;
+	const bool wholeLevel = x == 0 && y == 0 && w == std::max(1, mCols >> level) && h == std::max(1, mRows >> level);
+	if (!wholeLevel && mTextureType != TextureType::D2) {
+		throw std::invalid_argument("Only regions of 2D textures can be downloaded");
+	}
+	const size_t rowSize = getPixelSize(format, mDataType) * w;
+	const size_t size = rowSize * h * (wholeLevel ? std::max(1, mDepth >> level) : 1);
+
+	DownloadQueue& queue = DownloadQueue::Default();
+	const int slot = queue.acquire(size);
+	GLint oldAlign;
+	glGetIntegerv(GL_PACK_ALIGNMENT, &oldAlign);
+	glPixelStorei(GL_PACK_ALIGNMENT, rowSize % 4 == 0 ? 4 : 1);
+	queue.ring().bind(slot);
+	if (wholeLevel) {
+		bind();
+		glGetTexImage(static_cast<GLenum>(mTextureType), level, getGLFormat(format, mDataType), static_cast<GLenum>(mDataType), nullptr);
+		unbind();
+	}
+	else {
+		// glGetTextureSubImage needs OpenGL 4.5, so regions are read through a framebuffer
+		gl::StateCache& state = gl::StateCache::Current();
+		const GLuint oldFramebuffer = state.framebuffer(GL_READ_FRAMEBUFFER);
+		const GLenum attachment = impl::attachmentForFormat(mPixelFormat);
+		state.bindFramebuffer(GL_READ_FRAMEBUFFER, impl::readFramebuffer());
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, mId, level);
+		if (attachment == GL_COLOR_ATTACHMENT0) {
+			glReadBuffer(GL_COLOR_ATTACHMENT0);
+		}
+		glReadPixels(x, y, w, h, getGLFormat(format, mDataType), static_cast<GLenum>(mDataType), nullptr);
+		glFramebufferTexture2D(GL_READ_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+		state.bindFramebuffer(GL_READ_FRAMEBUFFER, oldFramebuffer);
+	}
+	queue.ring().unbind();
+	glPixelStorei(GL_PACK_ALIGNMENT, oldAlign);
+	return queue.push(slot, size, dst, onFinished);
+}
+
+void gl::Texture::setCompressedData(const void* blocks, size_t sizeInBytes, int level)
+{
+	if (!isCompressed()) {
+		throw std::runtime_error("Compressed data can only be uploaded to compressed textures");
+	}
+	bind();
+	const int w = std::max(1, mCols >> level);
+	const int h = std::max(1, mRows >> level);
+	glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h, glSizedFormat(), (GLsizei)sizeInBytes, blocks);
+	gl::StateCache::Current().bindTexture(GL_TEXTURE_2D, 0);
+}
+
+void gl::Texture::updateMipmap()
+{
+	if (mMipmapDirty) {
+		createMipmap(true);
+	}
+}
+
 void gl::Texture::bind(int slot)
 {
 	if (mId == 0) {
 		init();
 	}
+	gl::StateCache& state = gl::StateCache::Current();
+	state.bindTexture(static_cast<GLenum>(mTextureType), mId, slot);
+	// The cache skips binding textures that are bound already, but unbind() and the mipmaps below use the active unit
 	if (slot >= 0) {
-		glActiveTexture(GL_TEXTURE0 + slot);
+		state.activeTexture(slot);
+	}
+	// The texture is about to be sampled, so deferred mipmaps have to be generated now
+	if (slot >= 0 && mMipmapDirty) {
+		glGenerateMipmap(static_cast<GLenum>(mTextureType));
+		mMipmapDirty = false;
 	}
-	glBindTexture(static_cast<GLenum>(mTextureType), mId);
 }
 
 void gl::Texture::bindAsImage(int slot, gl::Access access)
 {
-	glBindImageTexture(slot, mId, 0, GL_FALSE, 0, static_cast<GLenum>(access), glSizedFormat());
+	// All layers of array and 3D textures are bound, so shaders can use image2DArray and image3D
+	const GLboolean layered = mTextureType == TextureType::D2Array || mTextureType == TextureType::D3 ? GL_TRUE : GL_FALSE;
+	glBindImageTexture(slot, mId, 0, layered, 0, static_cast<GLenum>(access), glSizedFormat());
 }
 
 void gl::Texture::unbind()
 {
-	glBindTexture(static_cast<GLenum>(mTextureType), 0);
+	gl::StateCache::Current().bindTexture(static_cast<GLenum>(mTextureType), 0);
 }
 
 bool gl::Texture::hasMipmap() const
@@ -374,6 +670,11 @@ bool gl::Texture::hasMipmap() const
 	return mCreateMipmap;
 }
 
+bool gl::Texture::hasImmutableStorage() const
+{
+	return mImmutable;
+}
+
 void gl::Texture::init()
 {
 	glGenTextures(1, &mId);
@@ -383,6 +684,60 @@ void gl::Texture::init()
 	createMipmap(mCreateMipmap);
 }
 
+void gl::Texture::loadCompressed(const std::string& path, bool flipY, TextureFlags flags)
+{
+	CompressedImage image;
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+	if (extension == ".dds" || extension == ".ktx") {
+		image = loadCompressedImage(path);
+	}
+	else {
+		ImageData decoded = decodeImage(path, flipY);
+		if (decoded.type != PixelType::UByte) {
+			LOG_WARNING("Only 8 bit images can be compressed, keeping \"%s\" uncompressed", path.c_str());
+			mCols = decoded.cols;
+			mRows = decoded.rows;
+			mPixelFormat = decoded.format;
+			mDataType = decoded.type;
+			setData(decoded.pixels.data());
+			return;
+		}
+		image = compressImageCached(decoded.pixels.data(), decoded.cols, decoded.rows, decoded.format, getDefaultCompression(decoded.format), mCreateMipmap);
+	}
+
+	mCols = image.cols;
+	mRows = image.rows;
+	mDepth = 1;
+	mCompression = image.format;
+	mPixelFormat = getDecodedFormat(image.format);
+	mDataType = PixelType::UByte;
+	mCreateMipmap = image.levels.size() > 1;
+	init();
+	const int levels = std::min(numLevels(), (int)image.levels.size());
+	for (int level = 0; level < levels; ++level) {
+		setCompressedData(image.levels[level].data(), image.levels[level].size(), level);
+	}
+	if (levels < numLevels()) {
+		// Files do not always contain the full mip chain
+		bind();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		unbind();
+	}
+}
+
+int gl::Texture::numLevels() const
+{
+	if (!mCreateMipmap) {
+		return 1;
+	}
+	int levels = 1;
+	for (int size = std::max(mCols, mRows); size > 1; size >>= 1) {
+		levels++;
+	}
+	return levels;
+}
+
 GLenum gl::getGlSizedFormat(PixelFormat pixelFormat, PixelType pixelType)
 {
 	if (pixelType == PixelType::Float) {
@@ -404,6 +759,22 @@ GLenum gl::getGlSizedFormat(PixelFormat pixelFormat, PixelType pixelType)
 			throw std::runtime_error("Invalid dataype and pixel format combination");
 		}
 	}
+	else if (pixelType == PixelType::Half) {
+		switch (pixelFormat) {
+		case PixelFormat::BGR:
+		case PixelFormat::RGB:
+			return GL_RGB16F;
+		case PixelFormat::Red:
+			return GL_R16F;
+		case PixelFormat::RG:
+			return GL_RG16F;
+		case PixelFormat::RGBA:
+		case PixelFormat::BGRA:
+			return GL_RGBA16F;
+		default:
+			throw std::runtime_error("Invalid dataype and pixel format combination");
+		}
+	}
 	else if (pixelType == PixelType::UByte) {
 		switch (pixelFormat) {
 		case PixelFormat::BGR:
@@ -420,6 +791,22 @@ GLenum gl::getGlSizedFormat(PixelFormat pixelFormat, PixelType pixelType)
 			throw std::runtime_error("Invalid dataype and pixel format combination");
 		}
 	}
+	else if (pixelType == PixelType::UShort) {
+		switch (pixelFormat) {
+		case PixelFormat::BGR:
+		case PixelFormat::RGB:
+			return GL_RGB16;
+		case PixelFormat::Red:
+			return GL_R16;
+		case PixelFormat::RG:
+			return GL_RG16;
+		case PixelFormat::RGBA:
+		case PixelFormat::BGRA:
+			return GL_RGBA16;
+		default:
+			throw std::runtime_error("Invalid dataype and pixel format combination");
+		}
+	}
 	else if (pixelType == PixelType::UInt) {
 		switch (pixelFormat) {
 		case PixelFormat::BGR:
@@ -469,4 +856,22 @@ int gl::getChannelsForFormat(PixelFormat format)
 	}
 }
 
+size_t gl::getPixelSize(PixelFormat format, PixelType type)
+{
+	switch (type) {
+	case PixelType::UByte:
+		return getChannelsForFormat(format);
+	case PixelType::Half:
+	case PixelType::UShort:
+		return 2 * getChannelsForFormat(format);
+	case PixelType::Float:
+	case PixelType::UInt:
+		return 4 * getChannelsForFormat(format);
+	case PixelType::UIntByte:
+		return 4;
+	default:
+		throw std::runtime_error("Unknown data type");
+	}
+}
+
 #pragma endregion
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "glpp/texture_atlas.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace impl {
+	// A shelf is only used for images that cover at least this part of its height, unless the layer is full
+	constexpr float MinShelfFill = 0.75f;
+}
+
+gl::TextureAtlas::TextureAtlas(int pageSize, PixelFormat pixelFormat, PixelType dataType, int maxLayers, int padding, TextureFlags flags) :
+	mPageSize(pageSize),
+	mMaxLayers(std::max(1, maxLayers)),
+	mPadding(std::max(0, padding)),
+	// Every insert changes the base level, the mipmaps are generated once when the atlas is bound for drawing
+	mFlags(static_cast<TextureFlags>(flags | TextureFlags_Deferred_Mipmap)),
+	mPixelFormat(pixelFormat),
+	mDataType(dataType),
+	mUsedArea(0),
+	mSize(0)
+{
+	if (pageSize <= 0) {
+		throw std::invalid_argument("The page size of an atlas must be positive");
+	}
+	grow();
+}
+
+gl::TextureAtlas::Handle gl::TextureAtlas::insert(int cols, int rows, const void* data, PixelFormat format)
+{
+	const int width = cols + 2 * mPadding;
+	const int height = rows + 2 * mPadding;
+	if (cols <= 0 || rows <= 0 || width > mPageSize || height > mPageSize) {
+		return InvalidHandle;
+	}
+
+	Handle handle;
+	if (!mFreeHandles.empty()) {
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}
+	else {
+		handle = static_cast<Handle>(mEntries.size());
+		mEntries.emplace_back();
+	}
+
+	bool placed = false;
+	for (int layer = 0; layer < layers() && !placed; ++layer) {
+		placed = place(layer, width, height, handle);
+	}
+	while (!placed && layers() < mMaxLayers) {
+		const int firstNewLayer = layers();
+		grow();
+		placed = place(firstNewLayer, width, height, handle);
+	}
+	if (!placed) {
+		mFreeHandles.push_back(handle);
+		return InvalidHandle;
+	}
+
+	Entry& entry = mEntries[handle];
+	entry.cols = cols;
+	entry.rows = rows;
+	upload(entry, data, format == PixelFormat::Default ? mPixelFormat : format);
+	mUsedArea += (size_t)width * height;
+	mSize++;
+	return handle;
+}
+
+void gl::TextureAtlas::remove(Handle handle)
+{
+	if (!contains(handle)) {
+		return;
+	}
+	Entry& entry = mEntries[handle];
+	std::vector<Shelf>& shelves = mShelves[entry.layer];
+	Shelf& shelf = shelves[entry.shelf];
+	auto slot = std::find_if(shelf.slots.begin(), shelf.slots.end(), [handle](const Slot& s) { return s.handle == handle; });
+	slot->handle = InvalidHandle;
+
+	// Merge with free neighbours, so larger images fit into the gap again
+	if (slot + 1 != shelf.slots.end() && (slot + 1)->handle == InvalidHandle) {
+		slot->width += (slot + 1)->width;
+		slot = shelf.slots.erase(slot + 1) - 1;
+	}
+	if (slot != shelf.slots.begin() && (slot - 1)->handle == InvalidHandle) {
+		(slot - 1)->width += slot->width;
+		shelf.slots.erase(slot);
+	}
+	// Free space at the end of the shelf is not tracked by slots
+	while (!shelf.slots.empty() && shelf.slots.back().handle == InvalidHandle) {
+		shelf.slots.pop_back();
+	}
+	shelf.end = shelf.slots.empty() ? 0 : shelf.slots.back().x + shelf.slots.back().width;
+	// Empty shelves at the top of a layer give their rows back, so they can be used with another height
+	while (!shelves.empty() && shelves.back().slots.empty()) {
+		shelves.pop_back();
+	}
+
+	mUsedArea -= (size_t)(entry.cols + 2 * mPadding) * (entry.rows + 2 * mPadding);
+	mSize--;
+	entry = Entry();
+	mFreeHandles.push_back(handle);
+}
+
+bool gl::TextureAtlas::contains(Handle handle) const
+{
+	return handle >= 0 && handle < (Handle)mEntries.size() && mEntries[handle].layer >= 0;
+}
+
+glm::vec4 gl::TextureAtlas::uvRect(Handle handle) const
+{
+	const Entry& entry = mEntries[handle];
+	const float scale = 1.0f / mPageSize;
+	return glm::vec4(
+		(entry.x + mPadding) * scale,
+		(entry.y + mPadding) * scale,
+		(entry.x + mPadding + entry.cols) * scale,
+		(entry.y + mPadding + entry.rows) * scale);
+}
+
+int gl::TextureAtlas::layer(Handle handle) const
+{
+	return mEntries[handle].layer;
+}
+
+std::shared_ptr<gl::Texture> gl::TextureAtlas::texture() const
+{
+	return mTexture;
+}
+
+int gl::TextureAtlas::pageSize() const
+{
+	return mPageSize;
+}
+
+int gl::TextureAtlas::layers() const
+{
+	return static_cast<int>(mShelves.size());
+}
+
+int gl::TextureAtlas::size() const
+{
+	return mSize;
+}
+
+float gl::TextureAtlas::occupancy() const
+{
+	return static_cast<float>(mUsedArea) / (static_cast<float>(mPageSize) * mPageSize * layers());
+}
+
+bool gl::TextureAtlas::place(int layer, int width, int height, Handle handle)
+{
+	std::vector<Shelf>& shelves = mShelves[layer];
+	Entry& entry = mEntries[handle];
+
+	// Best fit: the lowest shelf the image fits into wastes the least rows
+	auto findShelf = [&](bool limitWaste) {
+		int best = -1;
+		for (int i = 0; i < (int)shelves.size(); ++i) {
+			const Shelf& shelf = shelves[i];
+			if (shelf.height < height || (best >= 0 && shelves[best].height <= shelf.height)
+				|| (limitWaste && height < shelf.height * ::impl::MinShelfFill)) {
+				continue;
+			}
+			const bool fitsGap = std::any_of(shelf.slots.begin(), shelf.slots.end(), [width](const Slot& s) { return s.handle == InvalidHandle && s.width >= width; });
+			if (fitsGap || mPageSize - shelf.end >= width) {
+				best = i;
+			}
+		}
+		return best;
+	};
+	const int top = shelves.empty() ? 0 : shelves.back().y + shelves.back().height;
+	int best = findShelf(true);
+	// Without rows left for a new shelf, a much taller one is better than no place at all
+	if (best < 0 && top + height > mPageSize) {
+		best = findShelf(false);
+	}
+	if (best < 0) {
+		if (top + height > mPageSize) {
+			return false;
+		}
+		Shelf shelf;
+		shelf.y = top;
+		shelf.height = height;
+		shelf.end = 0;
+		shelves.push_back(shelf);
+		best = static_cast<int>(shelves.size()) - 1;
+	}
+
+	Shelf& shelf = shelves[best];
+	auto gap = std::find_if(shelf.slots.begin(), shelf.slots.end(), [width](const Slot& s) { return s.handle == InvalidHandle && s.width >= width; });
+	if (gap != shelf.slots.end()) {
+		const Slot rest = { gap->x + width, gap->width - width, InvalidHandle };
+		gap->width = width;
+		gap->handle = handle;
+		entry.x = gap->x;
+		if (rest.width > 0) {
+			shelf.slots.insert(gap + 1, rest);
+		}
+	}
+	else {
+		shelf.slots.push_back({ shelf.end, width, handle });
+		entry.x = shelf.end;
+		shelf.end += width;
+	}
+	entry.layer = layer;
+	entry.shelf = best;
+	entry.y = shelf.y;
+	return true;
+}
+
+void gl::TextureAtlas::grow()
+{
+	const int oldLayers = layers();
+	const int newLayers = std::min(mMaxLayers, std::max(1, 2 * oldLayers));
+	std::shared_ptr<gl::Texture> texture = std::make_shared<gl::Texture>(TextureType::D2Array, mPageSize, mPageSize, newLayers, mPixelFormat, mDataType, mFlags);
+	if (mTexture != nullptr) {
+		glCopyImageSubData(
+			mTexture->id, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+			texture->id, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+			mPageSize, mPageSize, oldLayers);
+	}
+	mTexture = texture;
+	mShelves.resize(newLayers);
+}
+
+void gl::TextureAtlas::upload(const Entry& entry, const void* data, PixelFormat format)
+{
+	if (mPadding == 0) {
+		mTexture->setSubData(data, entry.x, entry.y, entry.layer, entry.cols, entry.rows, format);
+		return;
+	}
+
+	// Repeat the border of the image in the padding
+	const size_t pixelSize = getPixelSize(format, mDataType);
+	const int width = entry.cols + 2 * mPadding;
+	const int height = entry.rows + 2 * mPadding;
+	const unsigned char* src = static_cast<const unsigned char*>(data);
+	std::vector<unsigned char> padded(pixelSize * width * height);
+	for (int y = 0; y < height; ++y) {
+		const int sy = std::clamp(y - mPadding, 0, entry.rows - 1);
+		for (int x = 0; x < width; ++x) {
+			const int sx = std::clamp(x - mPadding, 0, entry.cols - 1);
+			std::memcpy(&padded[((size_t)y * width + x) * pixelSize], src + ((size_t)sy * entry.cols + sx) * pixelSize, pixelSize);
+		}
+	}
+	mTexture->setSubData(padded.data(), entry.x, entry.y, entry.layer, width, height, format);
+}
@@ -0,0 +1,724 @@
+#include "glpp/texture_compression.hpp"
+#include "glpp/pixel_conversion.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GL_TEXTURE_COMPRESSION_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GL_TEXTURE_COMPRESSION_NEON
+#endif
+
+namespace fs = std::filesystem;
+
+namespace impl {
+	// 4x4 RGBA pixels stored row by row
+	struct Block {
+		unsigned char rgba[16 * 4];
+	};
+
+	void loadBlock(const unsigned char* rgba, int cols, int rows, int bx, int by, Block& block) {
+		// Blocks at the border repeat the last row and column, which does not change the endpoints
+		for (int y = 0; y < 4; ++y) {
+			const int sy = std::min(by * 4 + y, rows - 1);
+			for (int x = 0; x < 4; ++x) {
+				const int sx = std::min(bx * 4 + x, cols - 1);
+				std::memcpy(block.rgba + (y * 4 + x) * 4, rgba + ((size_t)sy * cols + sx) * 4, 4);
+			}
+		}
+	}
+
+	void boundingBox(const Block& block, unsigned char minColor[4], unsigned char maxColor[4]) {
+#if defined(GL_TEXTURE_COMPRESSION_SSE2)
+		const __m128i* src = reinterpret_cast<const __m128i*>(block.rgba);
+		const __m128i p0 = _mm_loadu_si128(src + 0);
+		const __m128i p1 = _mm_loadu_si128(src + 1);
+		const __m128i p2 = _mm_loadu_si128(src + 2);
+		const __m128i p3 = _mm_loadu_si128(src + 3);
+		__m128i mn = _mm_min_epu8(_mm_min_epu8(p0, p1), _mm_min_epu8(p2, p3));
+		__m128i mx = _mm_max_epu8(_mm_max_epu8(p0, p1), _mm_max_epu8(p2, p3));
+		// Reduce the four pixels of a register to one
+		mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 8));
+		mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 8));
+		mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 4));
+		mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 4));
+		const int minBits = _mm_cvtsi128_si32(mn);
+		const int maxBits = _mm_cvtsi128_si32(mx);
+		std::memcpy(minColor, &minBits, 4);
+		std::memcpy(maxColor, &maxBits, 4);
+#elif defined(GL_TEXTURE_COMPRESSION_NEON)
+		uint8x16_t mn = vminq_u8(vminq_u8(vld1q_u8(block.rgba), vld1q_u8(block.rgba + 16)), vminq_u8(vld1q_u8(block.rgba + 32), vld1q_u8(block.rgba + 48)));
+		uint8x16_t mx = vmaxq_u8(vmaxq_u8(vld1q_u8(block.rgba), vld1q_u8(block.rgba + 16)), vmaxq_u8(vld1q_u8(block.rgba + 32), vld1q_u8(block.rgba + 48)));
+		// Reduce the four pixels of a register to one
+		uint8x8_t mn2 = vmin_u8(vget_low_u8(mn), vget_high_u8(mn));
+		uint8x8_t mx2 = vmax_u8(vget_low_u8(mx), vget_high_u8(mx));
+		mn2 = vmin_u8(mn2, vreinterpret_u8_u32(vrev64_u32(vreinterpret_u32_u8(mn2))));
+		mx2 = vmax_u8(mx2, vreinterpret_u8_u32(vrev64_u32(vreinterpret_u32_u8(mx2))));
+		const uint32_t minBits = vget_lane_u32(vreinterpret_u32_u8(mn2), 0);
+		const uint32_t maxBits = vget_lane_u32(vreinterpret_u32_u8(mx2), 0);
+		std::memcpy(minColor, &minBits, 4);
+		std::memcpy(maxColor, &maxBits, 4);
+#else
+		for (int c = 0; c < 4; ++c) {
+			minColor[c] = 255;
+			maxColor[c] = 0;
+		}
+		for (int i = 0; i < 16; ++i) {
+			for (int c = 0; c < 4; ++c) {
+				minColor[c] = std::min(minColor[c], block.rgba[i * 4 + c]);
+				maxColor[c] = std::max(maxColor[c], block.rgba[i * 4 + c]);
+			}
+		}
+#endif
+	}
+
+	// The bounding box only gives the extent per channel. Channels that decrease while green increases
+	// are swapped, so the endpoints lie on the diagonal the colors are actually spread along.
+	void alignDiagonal(const Block& block, int channels, int minColor[4], int maxColor[4]) {
+		int center[4];
+		for (int c = 0; c < channels; ++c) {
+			center[c] = (minColor[c] + maxColor[c]) / 2;
+		}
+		for (int c = 0; c < channels; ++c) {
+			if (c == 1) { continue; }
+			int covariance = 0;
+			for (int i = 0; i < 16; ++i) {
+				covariance += (block.rgba[i * 4 + c] - center[c]) * (block.rgba[i * 4 + 1] - center[1]);
+			}
+			if (covariance < 0) {
+				std::swap(minColor[c], maxColor[c]);
+			}
+		}
+	}
+
+	int squaredDistance(const unsigned char* a, const int* b, int channels) {
+		int sum = 0;
+		for (int c = 0; c < channels; ++c) {
+			const int d = a[c] - b[c];
+			sum += d * d;
+		}
+		return sum;
+	}
+
+	void storeLE(unsigned char* out, uint64_t value, int bytes) {
+		for (int i = 0; i < bytes; ++i) {
+			out[i] = static_cast<unsigned char>(value >> (8 * i));
+		}
+	}
+
+	uint16_t toRGB565(const int* c) {
+		const int r = (std::clamp(c[0], 0, 255) * 31 + 127) / 255;
+		const int g = (std::clamp(c[1], 0, 255) * 63 + 127) / 255;
+		const int b = (std::clamp(c[2], 0, 255) * 31 + 127) / 255;
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void fromRGB565(uint16_t v, int* c) {
+		const int r = (v >> 11) & 31;
+		const int g = (v >> 5) & 63;
+		const int b = v & 31;
+		c[0] = (r << 3) | (r >> 2);
+		c[1] = (g << 2) | (g >> 4);
+		c[2] = (b << 3) | (b >> 2);
+	}
+
+	void encodeBC1(const Block& block, unsigned char* out) {
+		unsigned char mn[4], mx[4];
+		boundingBox(block, mn, mx);
+		int lo[4] = { mn[0], mn[1], mn[2], mn[3] };
+		int hi[4] = { mx[0], mx[1], mx[2], mx[3] };
+		alignDiagonal(block, 3, lo, hi);
+		// Insetting the box by 1/16 moves the interpolated colors closer to the bulk of the pixels
+		for (int c = 0; c < 3; ++c) {
+			const int inset = (hi[c] - lo[c]) / 16;
+			lo[c] += inset;
+			hi[c] -= inset;
+		}
+
+		uint16_t c0 = toRGB565(hi);
+		uint16_t c1 = toRGB565(lo);
+		// c0 > c1 selects the four color mode
+		if (c0 < c1) {
+			std::swap(c0, c1);
+		}
+		uint32_t indices = 0;
+		if (c0 != c1) {
+			int palette[4][3];
+			fromRGB565(c0, palette[0]);
+			fromRGB565(c1, palette[1]);
+			for (int c = 0; c < 3; ++c) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			for (int i = 0; i < 16; ++i) {
+				int best = 0;
+				int bestDistance = squaredDistance(block.rgba + i * 4, palette[0], 3);
+				for (int k = 1; k < 4; ++k) {
+					const int distance = squaredDistance(block.rgba + i * 4, palette[k], 3);
+					if (distance < bestDistance) {
+						best = k;
+						bestDistance = distance;
+					}
+				}
+				indices |= static_cast<uint32_t>(best) << (2 * i);
+			}
+		}
+		storeLE(out, c0, 2);
+		storeLE(out + 2, c1, 2);
+		storeLE(out + 4, indices, 4);
+	}
+
+	void encodeBC4(const Block& block, int channel, unsigned char* out) {
+		int lo = 255, hi = 0;
+		for (int i = 0; i < 16; ++i) {
+			lo = std::min(lo, (int)block.rgba[i * 4 + channel]);
+			hi = std::max(hi, (int)block.rgba[i * 4 + channel]);
+		}
+		uint64_t indices = 0;
+		if (hi > lo) {
+			for (int i = 0; i < 16; ++i) {
+				// Nearest of the 8 steps between lo (0) and hi (7). Index 0 is hi, 1 is lo and 2 to 7 go from hi towards lo
+				const int v = block.rgba[i * 4 + channel];
+				const int step = ((v - lo) * 14 + (hi - lo)) / (2 * (hi - lo));
+				const int index = step == 7 ? 0 : (step == 0 ? 1 : 8 - step);
+				indices |= static_cast<uint64_t>(index) << (3 * i);
+			}
+		}
+		out[0] = static_cast<unsigned char>(hi);
+		out[1] = static_cast<unsigned char>(lo);
+		storeLE(out + 2, indices, 6);
+	}
+
+	void encodeBC7(const Block& block, unsigned char* out) {
+		// Mode 6: one subset with RGBA endpoints of 7 bits, a p-bit per endpoint and 4 bit indices
+		unsigned char mn[4], mx[4];
+		boundingBox(block, mn, mx);
+		int endpoints[2][4] = { { mn[0], mn[1], mn[2], mn[3] }, { mx[0], mx[1], mx[2], mx[3] } };
+		alignDiagonal(block, 4, endpoints[0], endpoints[1]);
+
+		// Pick the p-bit with the smaller error. The decoded endpoint is (q << 1) | p
+		int quantized[2][4], pbits[2], decoded[2][4];
+		for (int e = 0; e < 2; ++e) {
+			int bestError = -1;
+			for (int p = 0; p < 2; ++p) {
+				int q[4], error = 0;
+				for (int c = 0; c < 4; ++c) {
+					q[c] = std::clamp((endpoints[e][c] - p + 1) / 2, 0, 127);
+					const int d = ((q[c] << 1) | p) - endpoints[e][c];
+					error += d * d;
+				}
+				if (bestError < 0 || error < bestError) {
+					bestError = error;
+					pbits[e] = p;
+					for (int c = 0; c < 4; ++c) {
+						quantized[e][c] = q[c];
+						decoded[e][c] = (q[c] << 1) | p;
+					}
+				}
+			}
+		}
+
+		static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		int palette[16][4];
+		for (int k = 0; k < 16; ++k) {
+			for (int c = 0; c < 4; ++c) {
+				palette[k][c] = ((64 - weights[k]) * decoded[0][c] + weights[k] * decoded[1][c] + 32) >> 6;
+			}
+		}
+		int indices[16];
+		for (int i = 0; i < 16; ++i) {
+			int bestDistance = squaredDistance(block.rgba + i * 4, palette[0], 4);
+			indices[i] = 0;
+			for (int k = 1; k < 16; ++k) {
+				const int distance = squaredDistance(block.rgba + i * 4, palette[k], 4);
+				if (distance < bestDistance) {
+					indices[i] = k;
+					bestDistance = distance;
+				}
+			}
+		}
+		// The most significant bit of the first index is implicitly 0. The weights are symmetric,
+		// so swapping the endpoints and mirroring all indices gives the same colors
+		if (indices[0] & 8) {
+			for (int c = 0; c < 4; ++c) {
+				std::swap(quantized[0][c], quantized[1][c]);
+			}
+			std::swap(pbits[0], pbits[1]);
+			for (int i = 0; i < 16; ++i) {
+				indices[i] = 15 - indices[i];
+			}
+		}
+
+		std::memset(out, 0, 16);
+		int pos = 0;
+		auto write = [&](uint32_t value, int count) {
+			for (int i = 0; i < count; ++i, ++pos) {
+				if ((value >> i) & 1) {
+					out[pos >> 3] |= static_cast<unsigned char>(1 << (pos & 7));
+				}
+			}
+		};
+		write(1 << 6, 7);
+		for (int c = 0; c < 4; ++c) {
+			write(quantized[0][c], 7);
+			write(quantized[1][c], 7);
+		}
+		write(pbits[0], 1);
+		write(pbits[1], 1);
+		write(indices[0], 3);
+		for (int i = 1; i < 16; ++i) {
+			write(indices[i], 4);
+		}
+	}
+
+	void encodeBlock(const Block& block, gl::CompressedFormat compression, unsigned char* out) {
+		switch (compression) {
+		case gl::CompressedFormat::BC1:
+			encodeBC1(block, out);
+			break;
+		case gl::CompressedFormat::BC3:
+			encodeBC4(block, 3, out);
+			encodeBC1(block, out + 8);
+			break;
+		case gl::CompressedFormat::BC4:
+			encodeBC4(block, 0, out);
+			break;
+		case gl::CompressedFormat::BC5:
+			encodeBC4(block, 0, out);
+			encodeBC4(block, 1, out + 8);
+			break;
+		case gl::CompressedFormat::BC7:
+			encodeBC7(block, out);
+			break;
+		default:
+			throw std::invalid_argument("Unknown compressed format");
+		}
+	}
+
+	std::vector<unsigned char> encodeLevel(const unsigned char* rgba, int cols, int rows, gl::CompressedFormat compression, int numThreads) {
+		const int blockCols = (cols + 3) / 4;
+		const int blockRows = (rows + 3) / 4;
+		const size_t blockSize = gl::getBlockSize(compression);
+		std::vector<unsigned char> blocks(blockSize * blockCols * blockRows);
+
+		// Rows of blocks are handed out one by one, so threads finishing early pick up the remaining work
+		std::atomic<int> nextRow(0);
+		auto work = [&]() {
+			Block block;
+			for (int by = nextRow++; by < blockRows; by = nextRow++) {
+				for (int bx = 0; bx < blockCols; ++bx) {
+					loadBlock(rgba, cols, rows, bx, by, block);
+					encodeBlock(block, compression, blocks.data() + ((size_t)by * blockCols + bx) * blockSize);
+				}
+			}
+		};
+		std::vector<std::thread> threads;
+		for (int i = 1; i < std::min(numThreads, blockRows); ++i) {
+			threads.emplace_back(work);
+		}
+		work();
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		return blocks;
+	}
+
+	std::vector<unsigned char> toRGBA(const void* pixels, int cols, int rows, gl::PixelFormat format) {
+		const size_t count = (size_t)cols * rows;
+		const unsigned char* src = static_cast<const unsigned char*>(pixels);
+		std::vector<unsigned char> rgba(4 * count);
+		switch (format) {
+		case gl::PixelFormat::RGBA:
+			std::memcpy(rgba.data(), src, rgba.size());
+			break;
+		case gl::PixelFormat::RGB:
+			gl::expandRGBToRGBA(src, rgba.data(), count);
+			break;
+		case gl::PixelFormat::BGRA:
+		case gl::PixelFormat::BGR: {
+			const int channels = gl::getChannelsForFormat(format);
+			for (size_t i = 0; i < count; ++i) {
+				rgba[4 * i + 0] = src[channels * i + 2];
+				rgba[4 * i + 1] = src[channels * i + 1];
+				rgba[4 * i + 2] = src[channels * i + 0];
+				rgba[4 * i + 3] = channels == 4 ? src[channels * i + 3] : 255;
+			}
+			break;
+		}
+		case gl::PixelFormat::Red:
+		case gl::PixelFormat::RG: {
+			const int channels = gl::getChannelsForFormat(format);
+			for (size_t i = 0; i < count; ++i) {
+				rgba[4 * i + 0] = src[channels * i];
+				rgba[4 * i + 1] = channels == 2 ? src[channels * i + 1] : 0;
+				rgba[4 * i + 2] = 0;
+				rgba[4 * i + 3] = 255;
+			}
+			break;
+		}
+		default:
+			throw std::invalid_argument("Only color formats can be compressed");
+		}
+		return rgba;
+	}
+
+	// Next mip level using a 2x2 box filter. Sizes are rounded down like OpenGL does
+	std::vector<unsigned char> halve(const std::vector<unsigned char>& rgba, int cols, int rows, int& dstCols, int& dstRows) {
+		dstCols = std::max(1, cols / 2);
+		dstRows = std::max(1, rows / 2);
+		std::vector<unsigned char> dst(4 * (size_t)dstCols * dstRows);
+		for (int y = 0; y < dstRows; ++y) {
+			const int y0 = std::min(2 * y, rows - 1);
+			const int y1 = std::min(2 * y + 1, rows - 1);
+			for (int x = 0; x < dstCols; ++x) {
+				const int x0 = std::min(2 * x, cols - 1);
+				const int x1 = std::min(2 * x + 1, cols - 1);
+				for (int c = 0; c < 4; ++c) {
+					const int sum = rgba[((size_t)y0 * cols + x0) * 4 + c] + rgba[((size_t)y0 * cols + x1) * 4 + c]
+						+ rgba[((size_t)y1 * cols + x0) * 4 + c] + rgba[((size_t)y1 * cols + x1) * 4 + c];
+					dst[((size_t)y * dstCols + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+		return dst;
+	}
+
+	// FNV-1a working on 8 bytes at a time, which is fast enough to hash large images on every load
+	uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+		constexpr uint64_t prime = 1099511628211ull;
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8) {
+			uint64_t word;
+			std::memcpy(&word, bytes + i, 8);
+			hash = (hash ^ word) * prime;
+		}
+		for (; i < size; ++i) {
+			hash = (hash ^ bytes[i]) * prime;
+		}
+		return hash;
+	}
+
+	constexpr uint32_t fourCC(char a, char b, char c, char d) {
+		return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+	}
+
+	struct DDSPixelFormat {
+		uint32_t size, flags, fourCC, rgbBitCount, rBitMask, gBitMask, bBitMask, aBitMask;
+	};
+	struct DDSHeader {
+		uint32_t size, flags, height, width, pitchOrLinearSize, depth, mipMapCount, reserved1[11];
+		DDSPixelFormat pixelFormat;
+		uint32_t caps, caps2, caps3, caps4, reserved2;
+	};
+	struct DDSHeaderDX10 {
+		uint32_t dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2;
+	};
+	static_assert(sizeof(DDSHeader) == 124, "Unexpected DDS header size");
+
+	constexpr uint32_t DDSFlagMipMapCount = 0x20000;
+
+	struct KTXHeader {
+		unsigned char identifier[12];
+		uint32_t endianness, glType, glTypeSize, glFormat, glInternalFormat, glBaseInternalFormat;
+		uint32_t pixelWidth, pixelHeight, pixelDepth, numberOfArrayElements, numberOfFaces, numberOfMipmapLevels, bytesOfKeyValueData;
+	};
+	constexpr unsigned char KTXIdentifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	gl::CompressedFormat fromDXGI(uint32_t format) {
+		switch (format) {
+		case 71: return gl::CompressedFormat::BC1;
+		case 77: return gl::CompressedFormat::BC3;
+		case 80: return gl::CompressedFormat::BC4;
+		case 83: return gl::CompressedFormat::BC5;
+		case 98: return gl::CompressedFormat::BC7;
+		default: return gl::CompressedFormat::None;
+		}
+	}
+
+	uint32_t toDXGI(gl::CompressedFormat format) {
+		switch (format) {
+		case gl::CompressedFormat::BC1: return 71;
+		case gl::CompressedFormat::BC3: return 77;
+		case gl::CompressedFormat::BC4: return 80;
+		case gl::CompressedFormat::BC5: return 83;
+		case gl::CompressedFormat::BC7: return 98;
+		default: throw std::invalid_argument("Unknown compressed format");
+		}
+	}
+
+	gl::CompressedFormat fromFourCC(uint32_t code) {
+		if (code == fourCC('D', 'X', 'T', '1')) { return gl::CompressedFormat::BC1; }
+		if (code == fourCC('D', 'X', 'T', '5')) { return gl::CompressedFormat::BC3; }
+		if (code == fourCC('A', 'T', 'I', '1') || code == fourCC('B', 'C', '4', 'U')) { return gl::CompressedFormat::BC4; }
+		if (code == fourCC('A', 'T', 'I', '2') || code == fourCC('B', 'C', '5', 'U')) { return gl::CompressedFormat::BC5; }
+		return gl::CompressedFormat::None;
+	}
+
+	gl::CompressedFormat fromGLFormat(uint32_t format) {
+		switch (format) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT + 1:	// GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, the alpha bit is ignored
+			return gl::CompressedFormat::BC1;
+		case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+			return gl::CompressedFormat::BC3;
+		case GL_COMPRESSED_RED_RGTC1:
+			return gl::CompressedFormat::BC4;
+		case GL_COMPRESSED_RG_RGTC2:
+			return gl::CompressedFormat::BC5;
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			return gl::CompressedFormat::BC7;
+		default:
+			return gl::CompressedFormat::None;
+		}
+	}
+
+	void readLevels(std::ifstream& in, gl::CompressedImage& image, int numLevels, const std::string& path) {
+		for (int level = 0; level < numLevels; ++level) {
+			const int w = std::max(1, image.cols >> level);
+			const int h = std::max(1, image.rows >> level);
+			std::vector<unsigned char> blocks(gl::getCompressedSize(image.format, w, h));
+			if (!in.read(reinterpret_cast<char*>(blocks.data()), blocks.size())) {
+				throw std::runtime_error("Unexpected end of file in \"" + path + "\"");
+			}
+			image.levels.push_back(std::move(blocks));
+		}
+	}
+
+	gl::CompressedImage loadDDS(std::ifstream& in, const std::string& path) {
+		DDSHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(DDSHeader)) || header.size != sizeof(DDSHeader)) {
+			throw std::runtime_error("Invalid DDS header in \"" + path + "\"");
+		}
+		gl::CompressedImage image;
+		image.cols = static_cast<int>(header.width);
+		image.rows = static_cast<int>(header.height);
+		if (header.pixelFormat.fourCC == fourCC('D', 'X', '1', '0')) {
+			DDSHeaderDX10 extension;
+			if (!in.read(reinterpret_cast<char*>(&extension), sizeof(DDSHeaderDX10))) {
+				throw std::runtime_error("Invalid DDS header in \"" + path + "\"");
+			}
+			if (extension.resourceDimension != 3 || extension.arraySize > 1) {
+				throw std::runtime_error("Only single 2D images are supported (\"" + path + "\")");
+			}
+			image.format = fromDXGI(extension.dxgiFormat);
+		}
+		else {
+			image.format = fromFourCC(header.pixelFormat.fourCC);
+		}
+		if (image.format == gl::CompressedFormat::None) {
+			throw std::runtime_error("Unsupported DDS format in \"" + path + "\"");
+		}
+		const int levels = (header.flags & DDSFlagMipMapCount) != 0 ? std::max(1u, header.mipMapCount) : 1;
+		readLevels(in, image, levels, path);
+		return image;
+	}
+
+	gl::CompressedImage loadKTX(std::ifstream& in, const std::string& path) {
+		KTXHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(KTXHeader)) || std::memcmp(header.identifier, KTXIdentifier, sizeof(KTXIdentifier)) != 0) {
+			throw std::runtime_error("Invalid KTX header in \"" + path + "\"");
+		}
+		if (header.endianness != 0x04030201) {
+			throw std::runtime_error("KTX files with swapped endianness are not supported (\"" + path + "\")");
+		}
+		if (header.pixelDepth > 1 || header.numberOfArrayElements > 1 || header.numberOfFaces != 1) {
+			throw std::runtime_error("Only single 2D images are supported (\"" + path + "\")");
+		}
+		gl::CompressedImage image;
+		image.cols = static_cast<int>(header.pixelWidth);
+		image.rows = static_cast<int>(header.pixelHeight);
+		image.format = fromGLFormat(header.glInternalFormat);
+		if (image.format == gl::CompressedFormat::None) {
+			throw std::runtime_error("Unsupported KTX format in \"" + path + "\"");
+		}
+		in.seekg(header.bytesOfKeyValueData, std::ios::cur);
+		// Every level is prefixed with its size. Block sizes are multiples of 4, so there is no padding
+		for (uint32_t level = 0; level < std::max(1u, header.numberOfMipmapLevels); ++level) {
+			uint32_t imageSize;
+			if (!in.read(reinterpret_cast<char*>(&imageSize), sizeof(uint32_t))) {
+				throw std::runtime_error("Unexpected end of file in \"" + path + "\"");
+			}
+			const int w = std::max(1, image.cols >> level);
+			const int h = std::max(1, image.rows >> level);
+			if (imageSize != gl::getCompressedSize(image.format, w, h)) {
+				throw std::runtime_error("Unexpected level size in \"" + path + "\"");
+			}
+			std::vector<unsigned char> blocks(imageSize);
+			if (!in.read(reinterpret_cast<char*>(blocks.data()), blocks.size())) {
+				throw std::runtime_error("Unexpected end of file in \"" + path + "\"");
+			}
+			image.levels.push_back(std::move(blocks));
+		}
+		return image;
+	}
+}
+
+size_t gl::getBlockSize(CompressedFormat format)
+{
+	switch (format) {
+	case CompressedFormat::BC1:
+	case CompressedFormat::BC4:
+		return 8;
+	case CompressedFormat::BC3:
+	case CompressedFormat::BC5:
+	case CompressedFormat::BC7:
+		return 16;
+	default:
+		throw std::invalid_argument("Unknown compressed format");
+	}
+}
+
+size_t gl::getCompressedSize(CompressedFormat format, int cols, int rows)
+{
+	return getBlockSize(format) * ((cols + 3) / 4) * ((rows + 3) / 4);
+}
+
+gl::PixelFormat gl::getDecodedFormat(CompressedFormat format)
+{
+	switch (format) {
+	case CompressedFormat::BC4:
+		return PixelFormat::Red;
+	case CompressedFormat::BC5:
+		return PixelFormat::RG;
+	default:
+		return PixelFormat::RGBA;
+	}
+}
+
+gl::CompressedFormat gl::getDefaultCompression(PixelFormat format)
+{
+	switch (format) {
+	case PixelFormat::Red:
+		return CompressedFormat::BC4;
+	case PixelFormat::RG:
+		return CompressedFormat::BC5;
+	default:
+		return CompressedFormat::BC7;
+	}
+}
+
+gl::CompressedImage gl::compressImage(const void* pixels, int cols, int rows, PixelFormat format, CompressedFormat compression, bool mipmaps, int numThreads)
+{
+	if (compression == CompressedFormat::None) {
+		throw std::invalid_argument("No compressed format given");
+	}
+	if (numThreads <= 0) {
+		numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+
+	CompressedImage image;
+	image.format = compression;
+	image.cols = cols;
+	image.rows = rows;
+	std::vector<unsigned char> rgba = impl::toRGBA(pixels, cols, rows, format);
+	int levelCols = cols, levelRows = rows;
+	while (true) {
+		image.levels.push_back(impl::encodeLevel(rgba.data(), levelCols, levelRows, compression, numThreads));
+		if (!mipmaps || (levelCols == 1 && levelRows == 1)) {
+			break;
+		}
+		rgba = impl::halve(rgba, levelCols, levelRows, levelCols, levelRows);
+	}
+	return image;
+}
+
+gl::CompressedImage gl::compressImageCached(const void* pixels, int cols, int rows, PixelFormat format, CompressedFormat compression, bool mipmaps)
+{
+	// Bump the version whenever the encoder changes, so outdated results are not used anymore
+	constexpr int EncoderVersion = 1;
+	const int parameters[] = { EncoderVersion, cols, rows, static_cast<int>(format), static_cast<int>(compression), mipmaps ? 1 : 0 };
+	uint64_t key = impl::hashBytes(parameters, sizeof(parameters));
+	key = impl::hashBytes(pixels, getPixelSize(format, PixelType::UByte) * cols * rows, key);
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.dds", static_cast<unsigned long long>(key));
+	const fs::path file = fs::temp_directory_path() / "glpp_texture_cache" / name;
+
+	std::error_code ec;
+	if (fs::exists(file, ec)) {
+		try {
+			return loadCompressedImage(file.string());
+		}
+		catch (std::exception&) {
+			// A broken cache entry is simply replaced
+		}
+	}
+
+	CompressedImage image = compressImage(pixels, cols, rows, format, compression, mipmaps);
+	fs::create_directories(file.parent_path(), ec);
+	// Write to a temporary file first, so a partially written cache entry is never picked up
+	const std::string partial = file.string() + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".part";
+	try {
+		saveDDS(partial, image);
+		fs::rename(partial, file, ec);
+	}
+	catch (std::exception&) {
+		// The cache is only an optimization
+	}
+	fs::remove(partial, ec);
+	return image;
+}
+
+gl::CompressedImage gl::loadCompressedImage(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		throw std::runtime_error("Could not open \"" + path + "\"");
+	}
+	char magic[4];
+	if (!in.read(magic, 4)) {
+		throw std::runtime_error("Could not read \"" + path + "\"");
+	}
+	if (std::memcmp(magic, "DDS ", 4) == 0) {
+		return impl::loadDDS(in, path);
+	}
+	if (std::memcmp(magic, impl::KTXIdentifier, 4) == 0) {
+		in.seekg(0);
+		return impl::loadKTX(in, path);
+	}
+	throw std::runtime_error("\"" + path + "\" is neither a DDS nor a KTX file");
+}
+
+void gl::saveDDS(const std::string& path, const CompressedImage& image)
+{
+	impl::DDSHeader header = {};
+	header.size = sizeof(impl::DDSHeader);
+	// Caps, height, width, pixel format, mip map count and linear size
+	header.flags = 0x1 | 0x2 | 0x4 | 0x1000 | impl::DDSFlagMipMapCount | 0x80000;
+	header.height = image.rows;
+	header.width = image.cols;
+	header.pitchOrLinearSize = static_cast<uint32_t>(image.levels.empty() ? 0 : image.levels[0].size());
+	header.mipMapCount = static_cast<uint32_t>(image.levels.size());
+	header.pixelFormat.size = sizeof(impl::DDSPixelFormat);
+	header.pixelFormat.flags = 0x4;	// Four CC
+	header.pixelFormat.fourCC = impl::fourCC('D', 'X', '1', '0');
+	header.caps = 0x1000 | (image.levels.size() > 1 ? 0x8 | 0x400000 : 0);
+
+	impl::DDSHeaderDX10 extension = {};
+	extension.dxgiFormat = impl::toDXGI(image.format);
+	extension.resourceDimension = 3;	// Texture 2D
+	extension.arraySize = 1;
+
+	std::ofstream out(path, std::ios::binary);
+	out.write("DDS ", 4);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(&extension), sizeof(extension));
+	for (const std::vector<unsigned char>& level : image.levels) {
+		out.write(reinterpret_cast<const char*>(level.data()), level.size());
+	}
+	if (!out) {
+		throw std::runtime_error("Could not write \"" + path + "\"");
+	}
+}
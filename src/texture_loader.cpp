@@ -0,0 +1,233 @@
+#include "glpp/texture_loader.hpp"
+#include "glpp/logging.hpp"
+#include "glpp/pixel_conversion.hpp"
+
+#include "3rdparty/stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+gl::ImageData gl::decodeImage(const std::string& path, bool flipY)
+{
+	ImageData image;
+	int channels;
+	stbi_set_flip_vertically_on_load_thread(flipY);
+	if (std::filesystem::path(path).extension() == ".hdr") {
+		float* data = stbi_loadf(path.c_str(), &image.cols, &image.rows, &channels, 0);
+		if (data == NULL) {
+			throw std::runtime_error("Could not load texture from \"" + path + "\"");
+		}
+		const size_t size = sizeof(float) * image.cols * image.rows * channels;
+		image.type = PixelType::Float;
+		image.pixels.resize(size);
+		std::memcpy(image.pixels.data(), data, size);
+		stbi_image_free(data);
+	}
+	else {
+		unsigned char* data = stbi_load(path.c_str(), &image.cols, &image.rows, &channels, 0);
+		if (data == NULL) {
+			throw std::runtime_error("Could not load texture from \"" + path + "\"");
+		}
+		image.type = PixelType::UByte;
+		const size_t pixels = (size_t)image.cols * image.rows;
+		if (channels == 3) {
+			image.pixels.resize(4 * pixels);
+			expandRGBToRGBA(data, image.pixels.data(), pixels);
+			channels = 4;
+		}
+		else {
+			image.pixels.assign(data, data + channels * pixels);
+		}
+		stbi_image_free(data);
+	}
+
+	switch (channels) {
+	case 1:
+		image.format = PixelFormat::Red;
+		break;
+	case 2:
+		image.format = PixelFormat::RG;
+		break;
+	case 3:
+		image.format = PixelFormat::RGB;
+		break;
+	default:
+		image.format = PixelFormat::RGBA;
+		break;
+	}
+	return image;
+}
+
+gl::TextureLoader::TextureLoader(int numThreads) :
+	uploadBudget(16 * 1024 * 1024),
+	mNumThreads(numThreads),
+	mPending(0),
+	mFinishedJobs(0),
+	mShutdown(false)
+{
+	if (mNumThreads <= 0) {
+		mNumThreads = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+}
+
+gl::TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+	}
+	mCondition.notify_all();
+	for (std::thread& worker : mWorkers) {
+		worker.join();
+	}
+}
+
+std::shared_ptr<gl::Texture> gl::TextureLoader::load(const std::string& path, bool flipY, TextureFlags flags, TextureCallback onLoaded)
+{
+	std::shared_ptr<gl::Texture> texture = std::make_shared<gl::Texture>(1, 1, PixelFormat::RGBA, PixelType::UByte, flags);
+	const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+	texture->setData(placeholder);
+
+	loadImage(path, flipY, [texture, onLoaded](std::shared_ptr<gl::ImageData> image) {
+		if (image != nullptr) {
+			texture->reallocate(image->cols, image->rows, image->format, image->type);
+			texture->setDataAsync(image->pixels.data());
+		}
+		if (onLoaded) {
+			onLoaded(texture, image != nullptr);
+		}
+	});
+	return texture;
+}
+
+void gl::TextureLoader::loadImage(const std::string& path, bool flipY, ImageCallback onDecoded)
+{
+	std::shared_ptr<gl::ImageData> image = std::make_shared<gl::ImageData>();
+	std::shared_ptr<std::string> error = std::make_shared<std::string>();
+	enqueue(
+		[path, flipY, image, error]() -> size_t {
+			try {
+				*image = decodeImage(path, flipY);
+			}
+			catch (std::exception& ex) {
+				*error = ex.what();
+			}
+			return image->pixels.size();
+		},
+		[image, error, onDecoded]() {
+			if (!error->empty()) {
+				LOG_WARNING("%s", error->c_str());
+			}
+			if (onDecoded) {
+				onDecoded(error->empty() ? image : nullptr);
+			}
+		});
+}
+
+void gl::TextureLoader::enqueue(std::function<size_t()> work, std::function<void()> onFinished)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mWorkers.empty()) {
+			startWorkers();
+		}
+		Job job;
+		job.work = work;
+		job.onFinished = onFinished;
+		mQueued.push_back(std::move(job));
+		mPending++;
+	}
+	mCondition.notify_one();
+}
+
+void gl::TextureLoader::update()
+{
+	size_t uploaded = 0;
+	bool first = true;
+	while (true) {
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mFinished.empty() || (!first && uploaded + mFinished.front().uploadSize > uploadBudget)) {
+				break;
+			}
+			job = std::move(mFinished.front());
+			mFinished.pop_front();
+		}
+		first = false;
+		uploaded += job.uploadSize;
+		if (job.onFinished) {
+			job.onFinished();
+		}
+		mPending--;
+		++mFinishedJobs;
+	}
+}
+
+size_t gl::TextureLoader::pending() const
+{
+	return mPending;
+}
+
+size_t gl::TextureLoader::finished() const
+{
+	return mFinishedJobs;
+}
+
+size_t gl::TextureLoader::ready() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mFinished.size();
+}
+
+std::function<void()> gl::TextureLoader::setOnJobReady(std::function<void()> onJobReady)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::swap(mOnJobReady, onJobReady);
+	return onJobReady;
+}
+
+gl::TextureLoader& gl::TextureLoader::Default()
+{
+	// This is never deleted on purpose: Finishing jobs during static destruction would require a valid context
+	static TextureLoader* loader = new TextureLoader();
+	return *loader;
+}
+
+void gl::TextureLoader::startWorkers()
+{
+	for (int i = 0; i < mNumThreads; ++i) {
+		mWorkers.emplace_back(&TextureLoader::workerLoop, this);
+	}
+}
+
+void gl::TextureLoader::workerLoop()
+{
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() { return mShutdown || !mQueued.empty(); });
+			if (mShutdown) {
+				return;
+			}
+			job = std::move(mQueued.front());
+			mQueued.pop_front();
+		}
+
+		job.uploadSize = job.work ? job.work() : 0;
+
+		// The callback is copied, so it can be exchanged while it runs
+		std::function<void()> onJobReady;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFinished.push_back(std::move(job));
+			onJobReady = mOnJobReady;
+		}
+		if (onJobReady) {
+			onJobReady();
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#include "glpp/texture_pool.hpp"
+
+#include <algorithm>
+
+gl::TexturePool::TexturePool(TextureFlags flags) :
+	mFlags(flags)
+{
+}
+
+std::shared_ptr<gl::Texture> gl::TexturePool::acquire(int cols, int rows, PixelFormat pixelFormat, PixelType dataType)
+{
+	for (const std::shared_ptr<gl::Texture>& texture : mTextures) {
+		if (texture.use_count() == 1 && texture->cols == cols && texture->rows == rows
+			&& texture->pixelFormat == pixelFormat && texture->pixelType == dataType) {
+			return texture;
+		}
+	}
+	mTextures.push_back(std::make_shared<gl::Texture>(cols, rows, pixelFormat, dataType, mFlags));
+	return mTextures.back();
+}
+
+void gl::TexturePool::trim()
+{
+	mTextures.erase(std::remove_if(mTextures.begin(), mTextures.end(),
+		[](const std::shared_ptr<gl::Texture>& texture) { return texture.use_count() == 1; }), mTextures.end());
+}
+
+size_t gl::TexturePool::size() const
+{
+	return mTextures.size();
+}
+
+size_t gl::TexturePool::inUse() const
+{
+	return std::count_if(mTextures.begin(), mTextures.end(),
+		[](const std::shared_ptr<gl::Texture>& texture) { return texture.use_count() > 1; });
+}
+
+gl::TexturePool& gl::TexturePool::Default()
+{
+	// Leaked on purpose: Destroying the pool deletes the free textures, at exit there is usually no context for that
+	static TexturePool* pool = new TexturePool();
+	return *pool;
+}
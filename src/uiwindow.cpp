@@ -93,7 +93,6 @@ void gl::RendererDebugWindow::onDraw(Renderer* env)
 	};
 
 	std::shared_ptr<gl::Texture> colorTexture = env->mFrameBuffer->getRenderTexture(0);
-	std::shared_ptr<gl::Texture> idTexture = env->mFrameBuffer->getRenderTexture(1);
 
 	if (ImGui::BeginCombo("HDR Mapping", hdrmappings[(int)env->toneMapping()])) {
 		for (int i = 0; i < IM_ARRAYSIZE(hdrmappings); ++i) {
@@ -114,14 +113,10 @@ void gl::RendererDebugWindow::onDraw(Renderer* env)
 	
 	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
 	impl::AspectImage(colorTexture->id, colorTexture->cols, colorTexture->rows, ImVec2(500, 500), ImVec2(0, 1), ImVec2(1, 0));
-	impl::AspectImage(idTexture->id, colorTexture->cols, colorTexture->rows, ImVec2(500, 500), ImVec2(0, 1), ImVec2(1, 0));
 
-	// Get color under the cursor
+	// Ids are read by ImGui3D, reading them here again would interleave with its reads
 	ImVec2 mouse = ImGui::GetIO().MousePos;
-	glm::uvec4 color = env->mFrameBuffer->readColorPixel((int)mouse.x, (int)mouse.y, 1);
-	ImGuiID id = ImGui3D::ColorToID(color.r, color.g, color.b);
-
-	ImGui::Text("Mouse at (%d, %d) over color [%d, %d, %d], Id: %d", (int)mouse.x, (int)mouse.y, color.x, color.y, color.z, id);
+	ImGui::Text("Mouse at (%d, %d) over id %d", (int)mouse.x, (int)mouse.y, ImGui3D::GImGui3D->HoveredId);
 
 	{
 		unsigned int id = 1615879;
@@ -145,5 +140,5 @@ void gl::RendererDebugWindow::onDraw(Renderer* env)
 	}
 
 	ImGui3D::ImGui3DContext& g = *ImGui3D::GImGui3D;
-	ImGui::Text("Active id: %d (color: %d, %d, %d)", g.ActiveId, g.ActiveIdColor.r, g.ActiveIdColor.g, g.ActiveIdColor.b);
+	ImGui::Text("Active id: %d (hovered: %d)", g.ActiveId, g.HoveredId);
 }